@@ -0,0 +1,9 @@
+macro(bench_case)
+  set(trgt ${ARGV0})
+  set(libs ${ARGV})
+  list(REMOVE_AT libs 0 0)
+
+  add_executable(${trgt} "${trgt}_bench.cpp")
+  target_link_libraries(${trgt} PRIVATE ${libs})
+  set_target_properties(${trgt} PROPERTIES FOLDER test/bench)
+endmacro()
@@ -1,21 +1,43 @@
 #version 120
 
+attribute float blobBrightness;
+
+uniform mat3 m;
+uniform vec3 offset;
+uniform mat3 viewMat;
+uniform float size;
+uniform float alphaScale;
 uniform sampler2D colorTex;
 
+const float spriteScaleFactor = 1.0f / 1.55f;
+
 varying vec4 color;
 varying vec2 texCoord;
 
 void main(void)
 {
+    vec3 p = m * gl_Vertex.xyz;
+
+    // sprites get smaller with each power of two of the blob index,
+    // gl_MultiTexCoord0.w is the exponent
+    float s = size * pow(spriteScaleFactor, gl_MultiTexCoord0.w);
+    float screenFrac = s / length(p + offset);
+    if (screenFrac >= 0.1f)
+    {
+        // Sprites too close to the viewer aren't drawn; the corners all
+        // end up at the same point outside the view.
+        gl_Position = vec4(0.0f, 0.0f, 2.0f, 1.0f);
+        return;
+    }
+
     // we pass color index as short int
     // reusing gl_MultiTexCoord0.z
     // we use 255 only because we have 256 color indices
     float t = gl_MultiTexCoord0.z / 255.0f; // [0, 255] -> [0, 1]
-    // we pass alpha values as as short int
-    // reusing gl_MultiTexCoord0.w
-    // we use 65535 for better precision
-    float a = gl_MultiTexCoord0.w / 65535.0f; // [0, 65535] -> [0, 1]
+    float a = min(alphaScale * (0.1f - screenFrac) * blobBrightness, 1.0f);
     color = vec4(texture2D(colorTex, vec2(t, 0.0f)).rgb, a);
     texCoord = gl_MultiTexCoord0.st;
-    gl_Position = ftransform();
+
+    vec2 corner = gl_MultiTexCoord0.st * 2.0f - 1.0f;
+    gl_Position = gl_ModelViewProjectionMatrix * vec4(p + viewMat * vec3(corner * s, 0.0f), 1.0f);
 }
@@ -5,6 +5,7 @@
 #include <celutil/winutil.h>
 #else
 #include <sys/stat.h>
+#include <unistd.h>
 #endif
 
 
@@ -411,5 +412,25 @@ bool is_directory(const path& p)
     return r;
 }
 
+
+void current_path(const path& p, std::error_code& ec) noexcept
+{
+#ifdef _WIN32
+    if (!SetCurrentDirectoryW(p.c_str()))
+        ec = std::error_code(GetLastError(), std::system_category());
+#else
+    if (chdir(p.c_str()) != 0)
+        ec = std::error_code(errno, std::system_category());
+#endif
+}
+
+void current_path(const path& p)
+{
+    std::error_code ec;
+    current_path(p, ec);
+    if (ec)
+        throw filesystem_error(ec, "celfs::current_path error");
+}
+
 }
 }
@@ -408,5 +408,8 @@ bool exists(const path& p, std::error_code& ec) noexcept;
 
 bool is_directory(const path& p);
 bool is_directory(const path& p, std::error_code& ec) noexcept;
+
+void current_path(const path& p);
+void current_path(const path& p, std::error_code& ec) noexcept;
 };
 };
@@ -0,0 +1,61 @@
+#pragma once
+
+#if __cplusplus >= 202002L
+#include <span>
+namespace celestia
+{
+namespace compat
+{
+using std::span;
+}
+}
+#else
+#include <cstddef>
+#include <type_traits>
+
+namespace celestia
+{
+namespace compat
+{
+// The subset of std::span with a dynamic extent used by Celestia: a view of
+// a contiguous range of elements, such as an array or a std::vector.
+template<typename T> class span
+{
+ public:
+    using element_type = T;
+    using value_type = typename std::remove_cv<T>::type;
+    using iterator = T*;
+
+    constexpr span() noexcept = default;
+    constexpr span(T* data, size_t size) noexcept : m_data(data), m_size(size) {}
+    template<size_t N> constexpr span(T (&array)[N]) noexcept : m_data(array), m_size(N) {}
+
+    // Containers with data() and size(), such as std::vector
+    template<typename C,
+             typename = typename std::enable_if<std::is_convertible<decltype(std::declval<C&>().data()), T*>::value>::type>
+    constexpr span(C& c) noexcept : m_data(c.data()), m_size(c.size()) {}
+
+    // Conversion of span<U> to span<const U>
+    template<typename U,
+             typename = typename std::enable_if<std::is_convertible<U(*)[], T(*)[]>::value>::type>
+    constexpr span(const span<U>& s) noexcept : m_data(s.data()), m_size(s.size()) {}
+
+    constexpr T* data() const noexcept { return m_data; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+    constexpr iterator begin() const noexcept { return m_data; }
+    constexpr iterator end() const noexcept { return m_data + m_size; }
+    constexpr T& operator[](size_t i) const { return m_data[i]; }
+
+    constexpr span subspan(size_t offset, size_t count) const
+    {
+        return span(m_data + offset, count);
+    }
+
+ private:
+    T* m_data{ nullptr };
+    size_t m_size{ 0 };
+};
+}
+}
+#endif
@@ -0,0 +1,79 @@
+#pragma once
+
+#if __cplusplus >= 201703L
+#include <string_view>
+namespace celestia
+{
+namespace compat
+{
+using std::string_view;
+}
+}
+#else
+#include <algorithm>
+#include <cstring>
+#include <iostream>
+#include <string>
+
+namespace celestia
+{
+namespace compat
+{
+// The subset of std::string_view used by Celestia. Where C++17 code would
+// construct a string from a view, use std::string(view), which works with
+// both.
+class string_view
+{
+ public:
+    using const_iterator = const char*;
+
+    constexpr string_view() noexcept = default;
+    constexpr string_view(const char* s, size_t n) noexcept : m_data(s), m_size(n) {}
+    string_view(const char* s) noexcept : m_data(s), m_size(std::strlen(s)) {}
+    string_view(const std::string& s) noexcept : m_data(s.data()), m_size(s.size()) {}
+
+    explicit operator std::string() const { return std::string(m_data, m_size); }
+
+    constexpr const char* data() const noexcept { return m_data; }
+    constexpr size_t size() const noexcept { return m_size; }
+    constexpr size_t length() const noexcept { return m_size; }
+    constexpr bool empty() const noexcept { return m_size == 0; }
+    constexpr const_iterator begin() const noexcept { return m_data; }
+    constexpr const_iterator end() const noexcept { return m_data + m_size; }
+    constexpr char operator[](size_t i) const { return m_data[i]; }
+
+    int compare(string_view s) const noexcept
+    {
+        int r = m_size == 0 || s.m_size == 0 ? 0 : std::memcmp(m_data, s.m_data, std::min(m_size, s.m_size));
+        if (r != 0)
+            return r;
+        return m_size < s.m_size ? -1 : (m_size > s.m_size ? 1 : 0);
+    }
+
+ private:
+    const char* m_data{ nullptr };
+    size_t m_size{ 0 };
+};
+
+inline bool operator==(string_view a, string_view b) noexcept
+{
+    return a.size() == b.size() && a.compare(b) == 0;
+}
+
+inline bool operator!=(string_view a, string_view b) noexcept
+{
+    return !(a == b);
+}
+
+inline bool operator<(string_view a, string_view b) noexcept
+{
+    return a.compare(b) < 0;
+}
+
+inline std::ostream& operator<<(std::ostream& out, string_view s)
+{
+    return out.write(s.data(), s.size());
+}
+}
+}
+#endif
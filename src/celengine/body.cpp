@@ -968,7 +968,12 @@ void Body::computeLocations()
         return;
     Geometry* g = GetGeometryManager()->find(geometry);
     if (!g)
+    {
+        // Try again once the mesh is loaded in the background
+        if (GetGeometryManager()->getState(geometry) == ResourceLoading)
+            locationsComputed = false;
         return;
+    }
 
     // TODO: Implement separate radius and bounding radius so that this hack is
     // not necessary.
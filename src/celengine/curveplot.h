@@ -104,6 +104,7 @@ class CurvePlot
     bool empty() const { return m_samples.empty(); }
 
     unsigned int sampleCount() const { return m_samples.size(); }
+    const std::deque<CurvePlotSample>& samples() const { return m_samples; }
 
  private:
     std::deque<CurvePlotSample> m_samples;
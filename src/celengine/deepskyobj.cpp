@@ -77,6 +77,21 @@ void DeepSkyObject::setInfoURL(const string& s)
     infoURL = s;
 }
 
+void DeepSkyObject::setInfoURL(const string& s, const fs::path& resPath)
+{
+    infoURL = s;
+    if (infoURL.find(':') == string::npos && !resPath.empty())
+    {
+        // Relative URL, the base directory is the current one,
+        // not the main installation directory
+        if (resPath.c_str()[1] == ':')
+            // Absolute Windows path, file:/// is required
+            infoURL = "file:///" + resPath.string() + "/" + infoURL;
+        else
+            infoURL = resPath.string() + "/" + infoURL;
+    }
+}
+
 
 bool DeepSkyObject::pick(const Ray3d& ray,
                          double& distanceToPicker,
@@ -186,19 +201,7 @@ bool DeepSkyObject::load(AssociativeArray* params, const fs::path& resPath)
 
     string infoURL; // FIXME: infourl class
     if (params->getString("InfoURL", infoURL))
-    {
-        if (infoURL.find(':') == string::npos)
-        {
-            // Relative URL, the base directory is the current one,
-            // not the main installation directory
-            if (resPath.c_str()[1] == ':')
-                // Absolute Windows path, file:/// is required
-                infoURL = "file:///" + resPath.string() + "/" + infoURL;
-            else if (!resPath.empty())
-                infoURL = resPath.string() + "/" + infoURL;
-        }
-        setInfoURL(infoURL);
-    }
+        setInfoURL(infoURL, resPath);
 
     bool visible = true;
     if (params->getBoolean("Visible", visible))
@@ -73,6 +73,8 @@ class DeepSkyObject : public AstroObject
 
     const std::string& getInfoURL() const;
     void setInfoURL(const std::string&);
+    // Set the info URL, relative URLs being resolved against resPath
+    void setInfoURL(const std::string&, const fs::path& resPath);
 
     bool isVisible() const { return visible; }
     void setVisible(bool _visible) { visible = _visible; }
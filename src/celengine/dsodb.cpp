@@ -13,12 +13,16 @@
 #include <cmath>
 #include <cstdlib>
 #include <cassert>
+#include <cstring>
+#include <iterator>
 #include <algorithm>
+#include <thread>
 #include <celutil/debug.h>
 #include <celmath/mathlib.h>
 #include <celutil/gettext.h>
 #include <celutil/bytes.h>
 #include <celutil/utf8.h>
+#include <celutil/profiler.h>
 #include <celengine/dsodb.h>
 #include <config.h>
 #include "astro.h"
@@ -101,13 +105,13 @@ DeepSkyObject* DSODatabase::find(const string& name) const
 }
 
 
-vector<string> DSODatabase::getCompletion(const string& name) const
+vector<string> DSODatabase::getCompletion(const string& name, size_t maxCompletions) const
 {
     vector<string> completion;
 
     // only named DSOs are supported by completion.
     if (!name.empty() && namesDB != nullptr)
-        return namesDB->getCompletion(name);
+        return namesDB->getCompletion(name, true, maxCompletions);
     else
         return completion;
 }
@@ -120,12 +124,13 @@ string DSODatabase::getDSOName(const DeepSkyObject* const & dso, bool i18n) cons
     if (namesDB != nullptr)
     {
         DSONameDatabase::NumberIndex::const_iterator iter   = namesDB->getFirstNameIter(catalogNumber);
-        if (iter != namesDB->getFinalNameIter() && iter->first == catalogNumber)
+        if (iter != namesDB->getFinalNameIter() && iter->catalogNumber == catalogNumber)
         {
-            if (i18n && iter->second != _(iter->second.c_str()))
-                return _(iter->second.c_str());
+            const char* name = namesDB->getName(*iter);
+            if (i18n)
+                return _(name);
             else
-                return iter->second;
+                return name;
         }
     }
 
@@ -142,12 +147,12 @@ string DSODatabase::getDSONameList(const DeepSkyObject* const & dso, const unsig
     DSONameDatabase::NumberIndex::const_iterator iter  = namesDB->getFirstNameIter(catalogNumber);
 
     unsigned int count = 0;
-    while (iter != namesDB->getFinalNameIter() && iter->first == catalogNumber && count < maxNames)
+    while (iter != namesDB->getFinalNameIter() && iter->catalogNumber == catalogNumber && count < maxNames)
     {
         if (count != 0)
             dsoNames   += " / ";
 
-        dsoNames   += iter->second;
+        dsoNames   += namesDB->getName(*iter);
         ++iter;
         ++count;
     }
@@ -164,6 +169,8 @@ void DSODatabase::findVisibleDSOs(DSOHandler&    dsoHandler,
                                   float limitingMag,
                                   OctreeProcStats *stats) const
 {
+    PROFILE_SCOPE("DSODatabase::findVisibleDSOs");
+
     // Compute the bounding planes of an infinite view frustum
     Hyperplane<double, 3> frustumPlanes[5];
     Vector3d  planeNormals[5];
@@ -198,6 +205,8 @@ void DSODatabase::findCloseDSOs(DSOHandler&     dsoHandler,
                                 const Vector3d& obsPos,
                                 float           radius) const
 {
+    PROFILE_SCOPE("DSODatabase::findCloseDSOs");
+
     octreeRoot->processCloseObjects(dsoHandler,
                                     obsPos,
                                     radius,
@@ -217,15 +226,71 @@ void DSODatabase::setNameDatabase(DSONameDatabase* _namesDB)
 }
 
 
+// Check for the header of a binary catalog, leaving the stream position
+// unchanged.
+static bool isBinaryCatalog(istream& in)
+{
+    constexpr size_t headerLength = sizeof(FILE_HEADER) - 1;
+    char header[headerLength];
+
+    auto pos = in.tellg();
+    in.read(header, headerLength);
+    bool binary = in.gcount() == (streamsize) headerLength &&
+                  memcmp(header, FILE_HEADER, headerLength) == 0;
+    in.clear();
+    in.seekg(pos);
+
+    return binary;
+}
+
+
 bool DSODatabase::load(istream& in, const fs::path& resourcePath)
 {
+    ParsedDSOCatalog catalog;
+    parse(in, catalog);
+    return load(catalog, resourcePath);
+}
+
+
+// Read the whole remaining contents of a stream
+static vector<char> readStream(istream& in)
+{
+    return vector<char>((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+}
+
+
+void DSODatabase::parse(istream& in, ParsedDSOCatalog& catalog)
+{
+    if (isBinaryCatalog(in))
+    {
+        catalog.binaryData = readStream(in);
+        if (in.bad())
+            catalog.error = "Error reading binary deep sky catalog.\n";
+        return;
+    }
+
     Tokenizer tokenizer(&in);
-    Parser    parser(&tokenizer);
+    parse(tokenizer, catalog);
+}
 
-#ifdef ENABLE_NLS
-    const char *d = resourcePath.string().c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
-#endif
+
+void DSODatabase::parse(const char* data, size_t size, ParsedDSOCatalog& catalog)
+{
+    constexpr size_t headerLength = sizeof(FILE_HEADER) - 1;
+    if (size >= headerLength && memcmp(data, FILE_HEADER, headerLength) == 0)
+    {
+        catalog.binaryData.assign(data, data + size);
+        return;
+    }
+
+    Tokenizer tokenizer(data, size);
+    parse(tokenizer, catalog);
+}
+
+
+void DSODatabase::parse(Tokenizer& tokenizer, ParsedDSOCatalog& catalog)
+{
+    Parser    parser(&tokenizer, catalog.getPool());
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
@@ -234,29 +299,22 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
 
         if (tokenizer.getTokenType() != Tokenizer::TokenName)
         {
-            DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog file.\n");
-            return false;
+            catalog.error = "Error parsing deep sky catalog file.\n";
+            return;
         }
         objType = tokenizer.getNameValue();
 
-        bool autoGenCatalogNumber = true;
         AstroCatalog::IndexNumber objCatalogNumber = AstroCatalog::InvalidIndex;
         if (tokenizer.getTokenType() == Tokenizer::TokenNumber)
         {
-            autoGenCatalogNumber   = false;
             objCatalogNumber       = (AstroCatalog::IndexNumber) tokenizer.getNumberValue();
             tokenizer.nextToken();
         }
 
-        if (autoGenCatalogNumber)
-        {
-            objCatalogNumber   = nextAutoCatalogNumber--;
-        }
-
         if (tokenizer.nextToken() != Tokenizer::TokenString)
         {
-            DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog file: bad name.\n");
-            return false;
+            catalog.error = "Error parsing deep sky catalog file: bad name.\n";
+            return;
         }
         objName = tokenizer.getStringValue();
 
@@ -264,11 +322,45 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
         if (objParamsValue == nullptr ||
             objParamsValue->getType() != Value::HashType)
         {
-            DPRINTF(LOG_LEVEL_ERROR, "Error parsing deep sky catalog entry %s\n", objName.c_str());
-            return false;
+            catalog.error = fmt::sprintf("Error parsing deep sky catalog entry %s\n", objName);
+            delete objParamsValue;
+            return;
+        }
+
+        catalog.entries.push_back({ objType, objCatalogNumber, objName,
+                                    unique_ptr<Value>(objParamsValue) });
+    }
+}
+
+
+/*! Add the objects of a parsed deep sky catalog to the database. The
+ *  object definitions are consumed.
+ */
+bool DSODatabase::load(ParsedDSOCatalog& catalog, const fs::path& resourcePath)
+{
+    if (!catalog.binaryData.empty())
+    {
+        bool ok = loadBinary(catalog.binaryData, resourcePath);
+        catalog.binaryData.clear();
+        return ok;
+    }
+
+#ifdef ENABLE_NLS
+    const char *d = resourcePath.string().c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+#endif
+
+    for (auto& entry : catalog.entries)
+    {
+        const string& objType = entry.objType;
+
+        AstroCatalog::IndexNumber objCatalogNumber = entry.catalogNumber;
+        if (objCatalogNumber == AstroCatalog::InvalidIndex)
+        {
+            objCatalogNumber   = nextAutoCatalogNumber--;
         }
 
-        Hash* objParams    = objParamsValue->getHash();
+        Hash* objParams    = entry.objParams->getHash();
         assert(objParams != nullptr);
 
         DeepSkyObject* obj = nullptr;
@@ -284,76 +376,344 @@ bool DSODatabase::load(istream& in, const fs::path& resourcePath)
         if (obj != nullptr && obj->load(objParams, resourcePath))
         {
             obj->loadCategories(objParams, DataDisposition::Add, resourcePath.string());
-            delete objParamsValue;
+            entry.objParams.reset();
 
-            // Ensure that the DSO array is large enough
-            if (nDSOs == capacity)
-            {
-                // Grow the array by 5%--this may be too little, but the
-                // assumption here is that there will be small numbers of
-                // DSOs in text files added to a big collection loaded from
-                // a binary file.
-                capacity = (int) (capacity * 1.05);
-
-                // 100 DSOs seems like a reasonable minimum
-                if (capacity < 100)
-                    capacity = 100;
-
-                DeepSkyObject** newDSOs = new DeepSkyObject*[capacity];
-
-                if (DSOs != nullptr)
-                {
-                    copy(DSOs, DSOs + nDSOs, newDSOs);
-                    delete[] DSOs;
-                }
-                DSOs = newDSOs;
-            }
+            addDSO(obj, objCatalogNumber, entry.objName);
+        }
+        else
+        {
+            DPRINTF(LOG_LEVEL_WARNING, "Bad Deep Sky Object definition--will continue parsing file.\n");
+            delete obj;
+            entry.objParams.reset();
+            return false;
+        }
+    }
+
+    if (!catalog.error.empty())
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "%s", catalog.error.c_str());
+        return false;
+    }
+
+    return true;
+}
+
+
+void DSODatabase::addDSO(DeepSkyObject* obj,
+                         AstroCatalog::IndexNumber catalogNumber,
+                         const string& names)
+{
+    // Ensure that the DSO array is large enough
+    if (nDSOs == capacity)
+    {
+        // Grow the array by 5%--this may be too little, but the
+        // assumption here is that there will be small numbers of
+        // DSOs in text files added to a big collection loaded from
+        // a binary file.
+        capacity = (int) (capacity * 1.05);
+
+        // 100 DSOs seems like a reasonable minimum
+        if (capacity < 100)
+            capacity = 100;
+
+        DeepSkyObject** newDSOs = new DeepSkyObject*[capacity];
+
+        if (DSOs != nullptr)
+        {
+            copy(DSOs, DSOs + nDSOs, newDSOs);
+            delete[] DSOs;
+        }
+        DSOs = newDSOs;
+    }
 
-            DSOs[nDSOs++] = obj;
+    DSOs[nDSOs++] = obj;
 
-            obj->setIndex(objCatalogNumber);
+    obj->setIndex(catalogNumber);
 
-            if (namesDB != nullptr && !objName.empty())
+    if (namesDB != nullptr && !names.empty())
+    {
+        // List of names will replace any that already exist for
+        // this DSO.
+        namesDB->erase(catalogNumber);
+
+        // Iterate through the string for names delimited
+        // by ':', and insert them into the DSO database.
+        // Note that db->add() will skip empty names.
+        string::size_type startPos   = 0;
+        while (startPos != string::npos)
+        {
+            string::size_type next    = names.find(':', startPos);
+            string::size_type length  = string::npos;
+            if (next != string::npos)
             {
-                // List of names will replace any that already exist for
-                // this DSO.
-                namesDB->erase(objCatalogNumber);
-
-                // Iterate through the string for names delimited
-                // by ':', and insert them into the DSO database.
-                // Note that db->add() will skip empty names.
-                string::size_type startPos   = 0;
-                while (startPos != string::npos)
-                {
-                    string::size_type next    = objName.find(':', startPos);
-                    string::size_type length  = string::npos;
-                    if (next != string::npos)
-                    {
-                        length = next - startPos;
-                        ++next;
-                    }
-                    string DSOName = objName.substr(startPos, length);
-                    namesDB->add(objCatalogNumber, DSOName);
-                    if (DSOName != _(DSOName.c_str()))
-                        namesDB->add(objCatalogNumber, _(DSOName.c_str()));
-                    startPos   = next;
-                }
+                length = next - startPos;
+                ++next;
             }
+            string DSOName = names.substr(startPos, length);
+            namesDB->add(catalogNumber, DSOName);
+            if (DSOName != _(DSOName.c_str()))
+                namesDB->add(catalogNumber, _(DSOName.c_str()));
+            startPos   = next;
         }
-        else
+    }
+}
+
+
+// Sequential reader of the little endian fields of a binary catalog held
+// in memory. Reading past the end of the data returns zeros and clears the
+// good flag.
+class BinaryCatalogReader
+{
+ public:
+    BinaryCatalogReader(const char* _data, size_t _size) :
+        data(_data), end(_data + _size)
+    {
+    }
+
+    bool good() const { return ok; }
+
+    uint8_t readUint8()
+    {
+        uint8_t n = 0;
+        read(&n, sizeof n);
+        return n;
+    }
+
+    uint16_t readUint16()
+    {
+        uint16_t n = 0;
+        read(&n, sizeof n);
+        LE_TO_CPU_INT16(n, n);
+        return n;
+    }
+
+    uint32_t readUint32()
+    {
+        uint32_t n = 0;
+        read(&n, sizeof n);
+        LE_TO_CPU_INT32(n, n);
+        return n;
+    }
+
+    float readFloat()
+    {
+        float f = 0.0f;
+        read(&f, sizeof f);
+        LE_TO_CPU_FLOAT(f, f);
+        return f;
+    }
+
+    double readDouble()
+    {
+        double d = 0.0;
+        read(&d, sizeof d);
+        LE_TO_CPU_DOUBLE(d, d);
+        return d;
+    }
+
+    string readString()
+    {
+        uint16_t length = readUint16();
+        if (!ok || (size_t) (end - data) < length)
         {
-            DPRINTF(LOG_LEVEL_WARNING, "Bad Deep Sky Object definition--will continue parsing file.\n");
-            delete objParamsValue;
-            return false;
+            ok = false;
+            return string();
         }
+        string s(data, length);
+        data += length;
+        return s;
     }
-    return true;
+
+ private:
+    void read(void* dest, size_t size)
+    {
+        if (!ok || (size_t) (end - data) < size)
+        {
+            ok = false;
+            return;
+        }
+        memcpy(dest, data, size);
+        data += size;
+    }
+
+    const char* data;
+    const char* end;
+    bool ok{ true };
+};
+
+
+/*! Load a binary deep sky catalog, as written by makedsodb. The objects
+ *  are recreated with the values that the text catalog loader computes
+ *  from the catalog entries, so both produce the same database.
+ *
+ *  File layout, all values little endian:
+ *    char[8]  "CEL_DSOs"
+ *    uint16   version
+ *    uint32   number of objects
+ *  followed by one record per object:
+ *    uint8    object type (BinaryObjectType)
+ *    uint32   catalog number, InvalidIndex for automatic numbering
+ *    string   names separated by ':'
+ *    double   position x, y, z (light years)
+ *    float    orientation w, x, y, z
+ *    float    radius (light years)
+ *    float    absolute magnitude
+ *    uint8    flags (BinaryRecordFlags)
+ *    string   info URL, if BinaryHasInfoURL is set
+ *    uint8    number of categories, followed by their names
+ *  and the object type specific fields:
+ *    Galaxy:   float detail, string type, string custom template if
+ *              BinaryHasCustomTemplate is set
+ *    Globular: float detail, float core radius (arcmin) and float King
+ *              concentration, each applied only when its flag is set
+ *    Nebula:   string mesh file name, if BinaryHasMesh is set
+ *  Strings are stored as a uint16 byte count followed by UTF-8 text.
+ */
+bool DSODatabase::loadBinary(istream& in, const fs::path& resourcePath)
+{
+    // Read the whole catalog with a single read
+    vector<char> data = readStream(in);
+    if (in.bad())
+        return false;
+
+    return loadBinary(data, resourcePath);
 }
 
 
-bool DSODatabase::loadBinary(istream&)
+bool DSODatabase::loadBinary(const vector<char>& data, const fs::path& resourcePath)
 {
-    // TODO: define a binary dso file format
+    constexpr size_t headerLength = sizeof(FILE_HEADER) - 1;
+    if (data.size() < headerLength || memcmp(data.data(), FILE_HEADER, headerLength) != 0)
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Bad header for binary deep sky catalog.\n");
+        return false;
+    }
+
+    BinaryCatalogReader reader(data.data() + headerLength, data.size() - headerLength);
+    uint16_t version = reader.readUint16();
+    if (version != BinaryFileVersion)
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Unsupported binary deep sky catalog version %x.\n", version);
+        return false;
+    }
+
+    uint32_t nDSOsInFile = reader.readUint32();
+    if (!reader.good())
+        return false;
+
+#ifdef ENABLE_NLS
+    string domain = resourcePath.string();
+    bindtextdomain(domain.c_str(), domain.c_str()); // domain name is the same as resource path
+#endif
+
+    for (uint32_t i = 0; i < nDSOsInFile; i++)
+    {
+        uint8_t objType = reader.readUint8();
+        AstroCatalog::IndexNumber objCatalogNumber = reader.readUint32();
+        string objName = reader.readString();
+
+        Vector3d position;
+        position.x() = reader.readDouble();
+        position.y() = reader.readDouble();
+        position.z() = reader.readDouble();
+        float qw = reader.readFloat();
+        float qx = reader.readFloat();
+        float qy = reader.readFloat();
+        float qz = reader.readFloat();
+        float radius = reader.readFloat();
+        float absMag = reader.readFloat();
+
+        uint8_t flags = reader.readUint8();
+        string infoURL;
+        if ((flags & BinaryHasInfoURL) != 0)
+            infoURL = reader.readString();
+
+        vector<string> categories(reader.readUint8());
+        for (auto& category : categories)
+            category = reader.readString();
+
+        if (!reader.good())
+        {
+            DPRINTF(LOG_LEVEL_ERROR, "Truncated binary deep sky catalog, object #%u.\n", i);
+            return false;
+        }
+
+        // Apply the parameters in the same order as the load() methods of
+        // the object classes do, as some of the setters depend on the
+        // others.
+        DeepSkyObject* obj = nullptr;
+        Galaxy* galaxy = nullptr;
+        Globular* globular = nullptr;
+        Nebula* nebula = nullptr;
+        switch (objType)
+        {
+        case BinaryGalaxy:
+            obj = galaxy = new Galaxy();
+            galaxy->setDetail(reader.readFloat());
+            {
+                string typeName = reader.readString();
+                if ((flags & BinaryHasCustomTemplate) != 0)
+                    galaxy->setCustomTmpName(reader.readString());
+                galaxy->setType(typeName);
+            }
+            break;
+        case BinaryGlobular:
+            obj = globular = new Globular();
+            break;
+        case BinaryNebula:
+            obj = nebula = new Nebula();
+            if ((flags & BinaryHasMesh) != 0)
+            {
+                fs::path geometryFileName(reader.readString());
+                ResourceHandle geometryHandle =
+                    GetGeometryManager()->getHandle(GeometryInfo(geometryFileName, resourcePath));
+                nebula->setGeometry(geometryHandle);
+            }
+            break;
+        case BinaryOpenCluster:
+            obj = new OpenCluster();
+            break;
+        default:
+            DPRINTF(LOG_LEVEL_ERROR, "Bad object type %u in binary deep sky catalog.\n", objType);
+            return false;
+        }
+
+        if (objCatalogNumber == AstroCatalog::InvalidIndex)
+            objCatalogNumber = nextAutoCatalogNumber--;
+
+        obj->setPosition(position);
+        obj->setOrientation(Quaternionf(qw, qx, qy, qz));
+        obj->setRadius(radius);
+        obj->setAbsoluteMagnitude(absMag);
+        if ((flags & BinaryHasInfoURL) != 0)
+            obj->setInfoURL(infoURL, resourcePath);
+        obj->setVisible((flags & BinaryVisible) != 0);
+        obj->setClickable((flags & BinaryClickable) != 0);
+
+        if (globular != nullptr)
+        {
+            globular->setDetail(reader.readFloat());
+            float coreRadius = reader.readFloat();
+            float concentration = reader.readFloat();
+            if ((flags & BinaryHasCoreRadius) != 0)
+                globular->setCoreRadius(coreRadius);
+            if ((flags & BinaryHasConcentration) != 0)
+                globular->setConcentration(concentration);
+        }
+
+        if (!reader.good())
+        {
+            DPRINTF(LOG_LEVEL_ERROR, "Truncated binary deep sky catalog, object #%u.\n", i);
+            delete obj;
+            return false;
+        }
+
+        for (const auto& category : categories)
+            obj->addToCategory(category, true, resourcePath.string());
+
+        addDSO(obj, objCatalogNumber, objName);
+    }
+
     return true;
 }
 
@@ -384,10 +744,12 @@ void DSODatabase::buildOctree()
     // objects end up straddling the base level nodes when the center of the
     // octree is at the origin.
     DynamicDSOOctree* root   = new DynamicDSOOctree(Vector3d::Zero(), absMag);
+    std::vector<DeepSkyObject* const*> objects;
+    objects.reserve(nDSOs);
     for (int i = 0; i < nDSOs; ++i)
-    {
-        root->insertObject(DSOs[i], DSO_OCTREE_ROOT_SIZE);
-    }
+        objects.push_back(&DSOs[i]);
+    root->insertObjects(objects, DSO_OCTREE_ROOT_SIZE,
+                        std::thread::hardware_concurrency());
 
     DPRINTF(LOG_LEVEL_INFO, "Spatially sorting DSOs for improved locality of reference . . .\n");
     DeepSkyObject** sortedDSOs    = new DeepSkyObject*[nDSOs];
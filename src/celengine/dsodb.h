@@ -19,6 +19,7 @@
 #include <celengine/deepskyobj.h>
 #include <celengine/dsooctree.h>
 #include <celengine/parser.h>
+#include <celengine/parsedcatalog.h>
 
 
 constexpr const unsigned int MAX_DSO_NAMES = 10;
@@ -40,7 +41,7 @@ class DSODatabase
     DeepSkyObject* find(const AstroCatalog::IndexNumber catalogNumber) const;
     DeepSkyObject* find(const std::string&) const;
 
-    std::vector<std::string> getCompletion(const std::string&) const;
+    std::vector<std::string> getCompletion(const std::string&, size_t maxCompletions = SIZE_MAX) const;
 
     void findVisibleDSOs(DSOHandler& dsoHandler,
                          const Eigen::Vector3d& obsPosition,
@@ -60,15 +61,63 @@ class DSODatabase
     DSONameDatabase* getNameDatabase() const;
     void setNameDatabase(DSONameDatabase*);
 
+    // An entry of a text deep sky catalog
+    struct CatalogEntry
+    {
+        std::string objType;
+        AstroCatalog::IndexNumber catalogNumber;
+        std::string objName;
+        std::unique_ptr<Value> objParams;
+    };
+    struct ParsedDSOCatalog : ParsedCatalog<CatalogEntry>
+    {
+        // The contents of a binary catalog, which has no entries
+        std::vector<char> binaryData;
+    };
+
+    // Parse a text deep sky catalog, or read a binary one, without
+    // modifying any database, so that several catalogs can be parsed in
+    // parallel
+    static void parse(std::istream&, ParsedDSOCatalog&);
+    static void parse(const char* data, size_t size, ParsedDSOCatalog&);
+
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
-    bool loadBinary(std::istream&);
+    bool load(ParsedDSOCatalog&, const fs::path& resourcePath = fs::path());
+    bool loadBinary(std::istream&, const fs::path& resourcePath = fs::path());
     void finish();
 
     static DSODatabase* read(std::istream&);
 
     double getAverageAbsoluteMagnitude() const;
 
+    // Binary catalog records, see loadBinary()
+    static const uint16_t BinaryFileVersion = 0x0100;
+
+    enum BinaryObjectType : uint8_t
+    {
+        BinaryGalaxy      = 0,
+        BinaryGlobular    = 1,
+        BinaryNebula      = 2,
+        BinaryOpenCluster = 3,
+    };
+
+    enum BinaryRecordFlags : uint8_t
+    {
+        BinaryVisible           = 0x01,
+        BinaryClickable         = 0x02,
+        BinaryHasInfoURL        = 0x04,
+        BinaryHasCustomTemplate = 0x08,
+        BinaryHasCoreRadius     = 0x10,
+        BinaryHasConcentration  = 0x20,
+        BinaryHasMesh           = 0x40,
+    };
+
 private:
+    static void parse(Tokenizer&, ParsedDSOCatalog&);
+    bool loadBinary(const std::vector<char>& data, const fs::path& resourcePath);
+    void addDSO(DeepSkyObject* obj,
+                AstroCatalog::IndexNumber catalogNumber,
+                const std::string& names);
     void buildIndexes();
     void buildOctree();
     void calcAvgAbsMag();
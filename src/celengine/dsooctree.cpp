@@ -52,7 +52,7 @@ DynamicDSOOctree* DynamicDSOOctree::getChild(DeepSkyObject* const & _obj, const
     child     |= objPos.y() < cellCenterPos.y() ? 0 : YPos;
     child     |= objPos.z() < cellCenterPos.z() ? 0 : ZPos;
 
-    return _children[child];
+    return &_children[child];
 }
 
 
@@ -67,48 +67,45 @@ template<> DynamicDSOOctree::ExclusionFactorDecayFunction*
 
 // total specialization of the StaticOctree template process*() methods for DSOs:
 template<>
-void DSOOctree::processVisibleObjects(DSOHandler&    processor,
-                                      const PointType& obsPosition,
-                                      const Hyperplane<double, 3>*  frustumPlanes,
-                                      float          limitingFactor,
-                                      double         scale,
-                                      OctreeProcStats *stats) const
+void DSOOctree::processVisibleNode(uint32_t       nodeIndex,
+                                   DSOHandler&    processor,
+                                   const PointType& obsPosition,
+                                   const OctreeFrustum<double>& frustum,
+                                   float          limitingFactor,
+                                   double         scale,
+                                   OctreeProcStats *stats,
+                                   bool            processChildren) const
 {
-#ifdef OCTREE_DEBUG
-    size_t h;
+    const Node& node = nodes[nodeIndex];
+
+    size_t h = 0;
     if (stats != nullptr)
     {
         h = stats->height + 1;
         stats->nodes++;
     }
-#endif
-    // See if this node lies within the view frustum
 
-    // Test the cubic octree node against each one of the five
-    // planes that define the infinite view frustum.
-    for (unsigned int i = 0; i < 5; ++i)
-    {
-        const Hyperplane<double, 3>& plane = frustumPlanes[i];
+    // See if this node lies within the view frustum
 
-        double r = scale * plane.normal().cwiseAbs().sum();
-        if (plane.signedDistance(cellCenterPos) < -r)
-            return;
-    }
+    // Test the cubic octree node against the five planes that define the
+    // infinite view frustum.
+    if (frustum.cullsNode(node.cellCenterPos, scale))
+        return;
 
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
-    double minDistance = (obsPosition - cellCenterPos).norm() - scale * DSOOctree::SQRT3;
+    double minDistance = (obsPosition - node.cellCenterPos).norm() - scale * DSOOctree::SQRT3;
 
     // Process the objects in this node
     double dimmest     = minDistance > 0.0 ? astro::appToAbsMag((double) limitingFactor, minDistance) : 1000.0;
 
-    for (unsigned int i=0; i<nObjects; ++i)
+    if (stats != nullptr)
+        stats->objects += node.nObjects;
+
+    DeepSkyObject* const* firstObject = _objects + node.firstObject;
+    for (unsigned int i=0; i<node.nObjects; ++i)
     {
-#ifdef OCTREE_DEBUG
-        if (stats != nullptr)
-            stats->objects++;
-#endif
-        DeepSkyObject* _obj = _firstObject[i];
+        DeepSkyObject* _obj = firstObject[i];
         float  absMag      = _obj->getAbsoluteMagnitude();
         if (absMag < dimmest)
         {
@@ -122,42 +119,44 @@ void DSOOctree::processVisibleObjects(DSOHandler&    processor,
 
     // See if any of the objects in child nodes are potentially included
     // that we need to recurse deeper.
-    if (minDistance <= 0.0 || astro::absToAppMag((double) exclusionFactor, minDistance) <= limitingFactor)
+    if (processChildren &&
+        (minDistance <= 0.0 || astro::absToAppMag((double) node.exclusionFactor, minDistance) <= limitingFactor))
     {
         // Recurse into the child nodes
-        if (_children != nullptr)
+        if (node.firstChild != 0)
         {
-            for (int i = 0; i < 8; ++i)
+            for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
             {
-                _children[i]->processVisibleObjects(processor,
-                                                    obsPosition,
-                                                    frustumPlanes,
-                                                    limitingFactor,
-                                                    scale * 0.5f,
-                                                    stats);
-#ifdef OCTREE_DEBUG
+                processVisibleNode(i,
+                                   processor,
+                                   obsPosition,
+                                   frustum,
+                                   limitingFactor,
+                                   scale * 0.5f,
+                                   stats,
+                                   true);
                 if (stats != nullptr && stats->height > h)
                     h = stats->height;
-#endif
             }
-#ifdef OCTREE_DEBUG
             if (stats != nullptr)
                 stats->height = h;
-#endif
         }
     }
 }
 
 
 template<>
-void DSOOctree::processCloseObjects(DSOHandler&    processor,
-                                    const PointType& obsPosition,
-                                    double         boundingRadius,
-                                    double         scale) const
+void DSOOctree::processCloseNode(uint32_t       nodeIndex,
+                                 DSOHandler&    processor,
+                                 const PointType& obsPosition,
+                                 double         boundingRadius,
+                                 double         scale) const
 {
+    const Node& node = nodes[nodeIndex];
+
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
-    double nodeDistance    = (obsPosition - cellCenterPos).norm() - scale * DSOOctree::SQRT3;    //
+    double nodeDistance    = (obsPosition - node.cellCenterPos).norm() - scale * DSOOctree::SQRT3;    //
 
     if (nodeDistance > boundingRadius)
         return;
@@ -170,9 +169,10 @@ void DSOOctree::processCloseObjects(DSOHandler&    processor,
     double radiusSquared    = boundingRadius * boundingRadius;    //
 
     // Check all the objects in the node.
-    for (unsigned int i=0; i<nObjects; ++i)
+    DeepSkyObject* const* firstObject = _objects + node.firstObject;
+    for (unsigned int i=0; i<node.nObjects; ++i)
     {
-        DeepSkyObject* _obj = _firstObject[i];        //
+        DeepSkyObject* _obj = firstObject[i];        //
 
         if ((obsPosition - _obj->getPosition()).squaredNorm() < radiusSquared)    //
         {
@@ -184,14 +184,15 @@ void DSOOctree::processCloseObjects(DSOHandler&    processor,
     }
 
     // Recurse into the child nodes
-    if (_children != nullptr)
+    if (node.firstChild != 0)
     {
-        for (int i = 0; i < 8; ++i)
+        for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
         {
-            _children[i]->processCloseObjects(processor,
-                                              obsPosition,
-                                              boundingRadius,
-                                              scale * 0.5f);
+            processCloseNode(i,
+                             processor,
+                             obsPosition,
+                             boundingRadius,
+                             scale * 0.5f);
         }
     }
 }
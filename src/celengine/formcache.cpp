@@ -0,0 +1,237 @@
+// formcache.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <config.h>
+#include <cstring>
+#include <fstream>
+#include <iostream>
+#include <celutil/bytes.h>
+#include <celutil/gettext.h>
+#include <fmt/printf.h>
+#include "formcache.h"
+
+using namespace std;
+
+
+// The file starts with a header, followed by records of a form each: the
+// length of its name, the name, the key, the number of values and the
+// values. Records are appended as forms are generated; when a form is
+// stored twice, the last record is the one used. Once such stale records
+// make up most of the file, it's written again without them.
+static const char FORM_CACHE_HEADER[] = "CELFORMS";
+static const uint16_t FORM_CACHE_VERSION = 1;
+static const uint64_t FORM_CACHE_HEADER_SIZE = sizeof FORM_CACHE_HEADER - 1 + sizeof FORM_CACHE_VERSION;
+
+
+static bool readUint(istream& in, uint32_t& n)
+{
+    in.read(reinterpret_cast<char*>(&n), sizeof n);
+    LE_TO_CPU_INT32(n, n);
+    return in.good();
+}
+
+
+static void writeUint(ostream& out, uint32_t n)
+{
+    LE_TO_CPU_INT32(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+
+static uint64_t recordSize(const string& name, const vector<float>& values)
+{
+    return sizeof(uint32_t) + name.size() + sizeof(uint64_t) + sizeof(uint32_t) +
+           values.size() * sizeof(float);
+}
+
+
+static void writeForm(ostream& out, const string& name, uint64_t key, const vector<float>& values)
+{
+    writeUint(out, (uint32_t) name.size());
+    out.write(name.data(), name.size());
+    LE_TO_CPU_INT64(key, key);
+    out.write(reinterpret_cast<char*>(&key), sizeof key);
+    writeUint(out, (uint32_t) values.size());
+    for (float f : values)
+    {
+        LE_TO_CPU_FLOAT(f, f);
+        out.write(reinterpret_cast<char*>(&f), sizeof f);
+    }
+}
+
+
+FormCache& FormCache::get()
+{
+    static FormCache cache;
+    return cache;
+}
+
+
+void FormCache::setFile(const fs::path& _filename)
+{
+    lock_guard<std::mutex> lock(mutex);
+    filename = _filename;
+    fileRead = false;
+    fileValid = false;
+    fileSize = 0;
+    staleSize = 0;
+    forms.clear();
+}
+
+
+void FormCache::hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+}
+
+
+void FormCache::readFile()
+{
+    fileRead = true;
+
+    ifstream in(filename.string(), ios::in | ios::binary);
+    if (!in.good())
+        return;
+
+    // Lengths read from the file are checked against the bytes left in it,
+    // so that a damaged file can't make huge allocations.
+    in.seekg(0, ios::end);
+    auto size = (uint64_t) in.tellg();
+    in.seekg(0, ios::beg);
+    auto bytesLeft = [&in, size]() { return size - (uint64_t) in.tellg(); };
+
+    char header[sizeof FORM_CACHE_HEADER - 1];
+    uint16_t version;
+    in.read(header, sizeof header);
+    in.read(reinterpret_cast<char*>(&version), sizeof version);
+    LE_TO_CPU_INT16(version, version);
+    if (!in.good() || strncmp(header, FORM_CACHE_HEADER, sizeof header) != 0 ||
+        version != FORM_CACHE_VERSION)
+    {
+        return;
+    }
+
+    for (;;)
+    {
+        uint32_t nameLength;
+        if (!readUint(in, nameLength))
+        {
+            // Only a clean end of file means that nothing is damaged
+            fileValid = in.eof() && in.gcount() == 0;
+            fileSize = size;
+            return;
+        }
+
+        if ((uint64_t) nameLength + sizeof(uint64_t) + sizeof(uint32_t) > bytesLeft())
+            return;
+
+        string name(nameLength, '\0');
+        Form form;
+        uint32_t nValues;
+        in.read(&name[0], nameLength);
+        in.read(reinterpret_cast<char*>(&form.key), sizeof form.key);
+        LE_TO_CPU_INT64(form.key, form.key);
+        if (!readUint(in, nValues) || (uint64_t) nValues * sizeof(float) > bytesLeft())
+            return;
+
+        form.values.resize(nValues);
+        in.read(reinterpret_cast<char*>(form.values.data()), nValues * sizeof(float));
+        if (in.fail())
+            return;
+        for (float& f : form.values)
+            LE_TO_CPU_FLOAT(f, f);
+
+        auto iter = forms.find(name);
+        if (iter != forms.end())
+        {
+            staleSize += recordSize(name, iter->second.values);
+            iter->second = std::move(form);
+        }
+        else
+        {
+            forms.emplace(std::move(name), std::move(form));
+        }
+    }
+}
+
+
+bool FormCache::load(const string& name, uint64_t key, vector<float>& values)
+{
+    lock_guard<std::mutex> lock(mutex);
+    if (filename.empty())
+        return false;
+
+    if (!fileRead)
+        readFile();
+
+    auto iter = forms.find(name);
+    if (iter == forms.end() || iter->second.key != key)
+        return false;
+
+    values = iter->second.values;
+    return true;
+}
+
+
+void FormCache::save(const string& name, uint64_t key, const vector<float>& values)
+{
+    lock_guard<std::mutex> lock(mutex);
+    if (filename.empty())
+        return;
+
+    if (!fileRead)
+        readFile();
+
+    auto iter = forms.find(name);
+    if (iter != forms.end())
+    {
+        staleSize += recordSize(name, iter->second.values);
+        iter->second = Form{ key, values };
+    }
+    else
+    {
+        forms.emplace(name, Form{ key, values });
+    }
+
+    // A missing or damaged file, or one that would be mostly stale records,
+    // is written again with all the forms known, otherwise the new one is
+    // appended.
+    uint64_t size = recordSize(name, values);
+    ofstream out;
+    if (fileValid && staleSize * 2 <= fileSize + size)
+    {
+        out.open(filename.string(), ios::out | ios::binary | ios::app);
+        writeForm(out, name, key, values);
+        fileSize += size;
+    }
+    else
+    {
+        out.open(filename.string(), ios::out | ios::binary | ios::trunc);
+        uint16_t version = FORM_CACHE_VERSION;
+        LE_TO_CPU_INT16(version, version);
+        out.write(FORM_CACHE_HEADER, sizeof FORM_CACHE_HEADER - 1);
+        out.write(reinterpret_cast<char*>(&version), sizeof version);
+        fileSize = FORM_CACHE_HEADER_SIZE;
+        staleSize = 0;
+        for (const auto& form : forms)
+        {
+            writeForm(out, form.first, form.second.key, form.second.values);
+            fileSize += recordSize(form.first, form.second.values);
+        }
+    }
+
+    fileValid = out.good();
+    if (!fileValid)
+        fmt::fprintf(cerr, _("Error writing form cache %s\n"), filename);
+}
@@ -0,0 +1,62 @@
+// formcache.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+#include <celcompat/filesystem.h>
+
+// The forms of galaxies and globular clusters, the sets of points they're
+// drawn with, are generated randomly from templates. FormCache keeps the
+// generated forms in a file so that later runs can read them instead.
+// Each form is stored under a name together with a key, a hash of
+// everything it was generated from, and is only used while the key
+// matches. It may be used from several threads at once.
+class FormCache
+{
+ public:
+    static FormCache& get();
+
+    // Forms aren't cached until a file is set
+    void setFile(const fs::path&);
+
+    // Read the values of the form name into values, returning false if
+    // they aren't cached with the key given.
+    bool load(const std::string& name, uint64_t key, std::vector<float>& values);
+    void save(const std::string& name, uint64_t key, const std::vector<float>& values);
+
+    // 64-bit FNV-1a hash, for computing keys
+    static const uint64_t InitialHash = UINT64_C(0xcbf29ce484222325);
+    static void hashBytes(uint64_t& hash, const void* data, size_t size);
+
+ private:
+    FormCache() = default;
+
+    void readFile();
+
+    struct Form
+    {
+        uint64_t key;
+        std::vector<float> values;
+    };
+
+    std::mutex mutex;
+    fs::path filename;
+    bool fileRead{ false };
+    bool fileValid{ false };
+    // Sizes of the file and of the records in it superseded by later ones
+    uint64_t fileSize{ 0 };
+    uint64_t staleSize{ 0 };
+    std::map<std::string, Form> forms;
+};
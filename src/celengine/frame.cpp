@@ -457,39 +457,47 @@ CachingFrame::CachingFrame(Selection _center) :
 Quaterniond
 CachingFrame::getOrientation(double tjd) const
 {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (tjd == lastTime && orientationCacheValid)
+            return lastOrientation;
+    }
+
+    Quaterniond q = computeOrientation(tjd);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
     if (tjd != lastTime)
     {
         lastTime = tjd;
-        lastOrientation = computeOrientation(tjd);
-        orientationCacheValid = true;
         angularVelocityCacheValid = false;
     }
-    else if (!orientationCacheValid)
-    {
-        lastOrientation = computeOrientation(tjd);
-        orientationCacheValid = true;
-    }
+    lastOrientation = q;
+    orientationCacheValid = true;
 
-    return lastOrientation;
+    return q;
 }
 
 
 Vector3d CachingFrame::getAngularVelocity(double tjd) const
 {
+    {
+        std::lock_guard<std::mutex> lock(cacheMutex);
+        if (tjd == lastTime && angularVelocityCacheValid)
+            return lastAngularVelocity;
+    }
+
+    Vector3d w = computeAngularVelocity(tjd);
+
+    std::lock_guard<std::mutex> lock(cacheMutex);
     if (tjd != lastTime)
     {
         lastTime = tjd;
-        lastAngularVelocity = computeAngularVelocity(tjd);
         orientationCacheValid = false;
-        angularVelocityCacheValid = true;
-    }
-    else if (!angularVelocityCacheValid)
-    {
-        lastAngularVelocity = computeAngularVelocity(tjd);
-        angularVelocityCacheValid = true;
     }
+    lastAngularVelocity = w;
+    angularVelocityCacheValid = true;
 
-    return lastAngularVelocity;
+    return w;
 }
 
 
@@ -13,6 +13,7 @@
 
 #include <celengine/astro.h>
 #include <celengine/selection.h>
+#include <mutex>
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include "shared.h"
@@ -64,7 +65,8 @@ class ReferenceFrame
 
 
 /*! Base class for complex frames where there may be some benefit
- *  to caching the last calculated orientation.
+ *  to caching the last calculated orientation. The cache is guarded by
+ *  a mutex so that the frame may be used from several threads at once.
  */
 class CachingFrame : public ReferenceFrame
 {
@@ -82,6 +84,7 @@ class CachingFrame : public ReferenceFrame
     virtual Eigen::Vector3d computeAngularVelocity(double tjd) const;
 
  private:
+    mutable std::mutex cacheMutex;
     mutable double lastTime;
     mutable Eigen::Quaterniond lastOrientation;
     mutable Eigen::Vector3d lastAngularVelocity;
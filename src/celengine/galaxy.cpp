@@ -14,14 +14,19 @@
 #include "galaxy.h"
 #include "vecgl.h"
 #include "texture.h"
+#include "formcache.h"
 #include <celmath/mathlib.h>
 #include <celmath/perlin.h>
 #include <celmath/intersect.h>
 #include <celutil/gettext.h>
 #include <celutil/debug.h>
+#include <celutil/resmanager.h>
 #include <celcompat/filesystem.h>
+#include <chrono>
+#include <cstddef>
 #include <cstring>
 #include <fstream>
+#include <mutex>
 #include <algorithm>
 #include <random>
 #include <cassert>
@@ -29,22 +34,18 @@
 using namespace Eigen;
 using namespace std;
 using namespace celmath;
+using namespace celgl;
 
 static int width = 128, height = 128;
 static const unsigned int GALAXY_POINTS  = 3500;
 
-static bool formsInitialized = false;
-
-static GalacticForm** spiralForms     = nullptr;
-static GalacticForm** ellipticalForms = nullptr;
-static GalacticForm*  irregularForm   = nullptr;
+// Increase when the generation of forms changes, so that cached forms
+// aren't used anymore
+static const uint32_t GALACTIC_FORM_VERSION = 2;
 
 static Texture* galaxyTex = nullptr;
 static Texture* colorTex  = nullptr;
 
-static void InitializeForms();
-static GalacticForm* buildGalacticForms(const fs::path& filename);
-
 float Galaxy::lightGain  = 0.0f;
 
 bool operator< (const Blob& b1, const Blob& b2)
@@ -52,14 +53,112 @@ bool operator< (const Blob& b1, const Blob& b2)
     return (b1.position.squaredNorm() < b2.position.squaredNorm());
 }
 
-typedef vector<Blob, aligned_allocator<Blob> > BlobVector;
-class GalacticForm
+static GalacticForm* buildGalacticForm(const fs::path& filename, mt19937& rng);
+static GalacticForm* buildIrregularForm(mt19937& rng);
+
+
+// Galaxies share the forms generated from the same template: an image of
+// the galaxy seen face on or, for irregular galaxies, fractal noise. Forms
+// are generated when a galaxy using them is first drawn, on a thread of
+// their own.
+class GalacticFormInfo : public ResourceInfo<GalacticForm>
 {
-public:
-    BlobVector* blobs;
-    Vector3f scale;
+ public:
+    fs::path source; // empty for irregular galaxies
+
+    GalacticFormInfo(const fs::path& _source) : source(_source) {};
+
+    fs::path resolve(const fs::path&) override
+    {
+        return source;
+    }
+
+    GalacticForm* load(const fs::path&) override;
+
+    bool prepare(const fs::path& name) override
+    {
+        resource = load(name);
+        return resource != nullptr;
+    }
+
+    GalacticForm* create(const fs::path&) override
+    {
+        return resource;
+    }
 };
 
+static bool operator<(const GalacticFormInfo& f0, const GalacticFormInfo& f1)
+{
+    return f0.source < f1.source;
+}
+
+static ResourceManager<GalacticFormInfo>* GetGalacticFormManager()
+{
+    static ResourceManager<GalacticFormInfo> manager("");
+    static once_flag started;
+    call_once(started, []() { manager.setBackgroundLoading(true); });
+    return &manager;
+}
+
+// Return the form, or nullptr until it has been generated
+static GalacticForm* FindGalacticForm(ResourceHandle h, float priority)
+{
+    return GetGalacticFormManager()->find(h, priority);
+}
+
+
+// Forms are generated with a seed of their own, so that they are the same
+// from one run to the next, and cached with a key covering the template.
+GalacticForm* GalacticFormInfo::load(const fs::path& name)
+{
+    uint64_t key = FormCache::InitialHash;
+    FormCache::hashBytes(key, &GALACTIC_FORM_VERSION, sizeof GALACTIC_FORM_VERSION);
+    if (!name.empty())
+    {
+        ifstream in(name.string(), ios::in | ios::binary);
+        vector<char> contents((istreambuf_iterator<char>(in)), istreambuf_iterator<char>());
+        FormCache::hashBytes(key, contents.data(), contents.size());
+    }
+
+    string cacheName = "galaxy:" + name.string();
+    vector<float> values;
+    if (FormCache::get().load(cacheName, key, values) && values.size() % 5 == 0)
+    {
+        auto* form = new GalacticForm();
+        form->blobs.resize(values.size() / 5);
+        for (size_t i = 0; i < form->blobs.size(); i++)
+        {
+            const float* v = &values[i * 5];
+            form->blobs[i].position = Vector4f(v[0], v[1], v[2], 1.0f);
+            form->blobs[i].colorIndex = (unsigned int) v[3];
+            form->blobs[i].brightness = v[4];
+        }
+        return form;
+    }
+
+    uint64_t seed = FormCache::InitialHash;
+    FormCache::hashBytes(seed, cacheName.data(), cacheName.size());
+    mt19937 rng((mt19937::result_type) seed);
+
+    GalacticForm* form = name.empty() ? buildIrregularForm(rng) : buildGalacticForm(name, rng);
+    if (form == nullptr)
+        return nullptr;
+
+    values.clear();
+    values.reserve(form->blobs.size() * 5);
+    for (const auto& b : form->blobs)
+    {
+        values.push_back(b.position.x());
+        values.push_back(b.position.y());
+        values.push_back(b.position.z());
+        values.push_back((float) b.colorIndex);
+        values.push_back(b.brightness);
+    }
+    FormCache::get().save(cacheName, key, values);
+
+    return form;
+}
+
 struct GalaxyTypeName
 {
     const char* name;
@@ -166,42 +265,35 @@ void Galaxy::setType(const string& typeStr)
     if (iter != end(GalaxyTypeNames))
         type = iter->type;
 
-    if (!formsInitialized)
-        InitializeForms();
-
+    // All elliptical galaxies are drawn with the E0 form, flattened
+    fs::path source;
     if (customTmpName != nullptr)
+        source = fs::path("models") / *customTmpName;
+    else if (type < E0)
+        source = fs::path("models") / (string(GalaxyTypeNames[type].name) + ".png");
+    else if (type < Irr)
+        source = "models/E0.png";
+
+    form = GetGalacticFormManager()->getHandle(GalacticFormInfo(source));
+}
+
+
+// The scale of the form, which is generated within a sphere of unit
+// diameter except for irregular galaxies
+Vector3f Galaxy::getFormScale() const
+{
+    if (customTmpName == nullptr && type >= E0 && type < Irr)
     {
-        form = buildGalacticForms(fs::path("models") / *customTmpName);
+        // note the correct x,y-alignment of 'ell' scaling!!
+        float ell = 1.0f - (float) (type - E0) / 8.0f;
+        return Vector3f(ell, ell, 1.0f);
     }
-    else
+    else if (customTmpName == nullptr && type == Irr)
     {
-        switch (type)
-        {
-        case S0:
-        case Sa:
-        case Sb:
-        case Sc:
-        case SBa:
-        case SBb:
-        case SBc:
-            form = spiralForms[type - S0];
-            break;
-        case E0:
-        case E1:
-        case E2:
-        case E3:
-        case E4:
-        case E5:
-        case E6:
-        case E7:
-            form = ellipticalForms[type - E0];
-            //form = nullptr;
-            break;
-        case Irr:
-            form = irregularForm;
-            break;
-        }
+        return Vector3f::Constant(0.5f);
     }
+
+    return Vector3f::Ones();
 }
 
 
@@ -213,7 +305,19 @@ string Galaxy::getDescription() const
 
 GalacticForm* Galaxy::getForm() const
 {
-    return form;
+    return FindGalacticForm(form, 0.0f);
+}
+
+
+void Galaxy::finishLoadingForms()
+{
+    GetGalacticFormManager()->finishLoading(chrono::steady_clock::time_point::max());
+}
+
+
+void Galaxy::stopLoadingForms()
+{
+    GetGalacticFormManager()->setBackgroundLoading(false);
 }
 
 const char* Galaxy::getObjTypeName() const
@@ -237,10 +341,11 @@ bool Galaxy::pick(const Ray3d& ray,
     // The ellipsoid should be slightly larger to compensate for the fact
     // that blobs are considered points when galaxies are built, but have size
     // when they are drawn.
-    float yscale = (type < E0 )? MAX_SPIRAL_THICKNESS: form->scale.y() + RADIUS_CORRECTION;
-    Vector3d ellipsoidAxes(getRadius()*(form->scale.x() + RADIUS_CORRECTION),
+    Vector3f scale = getFormScale();
+    float yscale = (type < E0 )? MAX_SPIRAL_THICKNESS: scale.y() + RADIUS_CORRECTION;
+    Vector3d ellipsoidAxes(getRadius()*(scale.x() + RADIUS_CORRECTION),
                            getRadius()* yscale,
-                           getRadius()*(form->scale.z() + RADIUS_CORRECTION));
+                           getRadius()*(scale.z() + RADIUS_CORRECTION));
 
     Matrix3d rotation = getOrientation().cast<double>().toRotationMatrix();
     return testIntersection(Ray3d(ray.origin - getPosition(), ray.direction).transform(rotation),
@@ -274,7 +379,7 @@ void Galaxy::render(const Vector3f& offset,
                     float pixelSize,
                     const Renderer* renderer)
 {
-    if (form == nullptr)
+    if (form == InvalidResource)
     {
         //renderGalaxyEllipsoid(offset, viewerOrientation, brightness, pixelSize);
     }
@@ -284,29 +389,60 @@ void Galaxy::render(const Vector3f& offset,
     }
 }
 
+// The blobs are drawn as quads facing the viewer, sized and faded by the
+// shader; the corners of a quad differ only in texCoord.x and texCoord.y.
 struct GalaxyVertex
 {
-    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
-
-    Vector4f position;
-    Matrix<GLshort, 4, 1> texCoord; // texCoord.x = x, texCoord.y = y, texCoord.z = color index, texCoord.w = alpha
+    Vector3f position;
+    Matrix<GLshort, 4, 1> texCoord; // texCoord.x = x, texCoord.y = y, texCoord.z = color index, texCoord.w = sprite level
+    float brightness;
 };
 
-static void draw(const GalaxyVertex *v, size_t count, void *indices)
+// Sprites get smaller by this factor with each power of two of the blob
+// index: the blobs of a form are sorted by distance from its center, so the
+// outer ones are many and small.
+static const float spriteScaleFactor = 1.0f / 1.55f;
+
+static void initGalaxyData(VertexObject& vo, const BlobVector& blobs, GLint brightnessLoc)
 {
-    glVertexPointer(4, GL_FLOAT, sizeof(GalaxyVertex), &v->position);
-    glTexCoordPointer(4, GL_SHORT, sizeof(GalaxyVertex), &v->texCoord);
-    glDrawElements(GL_TRIANGLES, count, GL_UNSIGNED_SHORT, indices);
+    static const GLshort corners[4][2] = { { 0, 0 }, { 1, 0 }, { 1, 1 }, { 0, 1 } };
+
+    vector<GalaxyVertex> vertices;
+    vertices.reserve(blobs.size() * 4);
+
+    GLshort level = 0;
+    for (size_t i = 0; i < blobs.size(); i++)
+    {
+        if ((i & (i - 1)) == 0 && i != 0)
+            level++;
+
+        const Blob& b = blobs[i];
+        GalaxyVertex vtx;
+        vtx.position = b.position.head(3);
+        vtx.brightness = b.brightness / 255.0f;
+        for (const auto& corner : corners)
+        {
+            vtx.texCoord = { corner[0], corner[1], (GLshort) b.colorIndex, level };
+            vertices.push_back(vtx);
+        }
+    }
+
+    vo.allocate(vertices.size() * sizeof(GalaxyVertex), vertices.data());
+    vo.setVertices(3, GL_FLOAT, false, sizeof(GalaxyVertex), offsetof(GalaxyVertex, position));
+    vo.setTextureCoords(4, GL_SHORT, false, sizeof(GalaxyVertex), offsetof(GalaxyVertex, texCoord));
+    if (brightnessLoc != -1)
+        vo.setVertexAttrib(brightnessLoc, 1, GL_FLOAT, false, sizeof(GalaxyVertex), offsetof(GalaxyVertex, brightness));
 }
 
-void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
-                                      const Quaternionf& viewerOrientation,
-                                      float brightness,
-                                      float pixelSize,
-                                      const Renderer* renderer)
+
+bool Galaxy::getDrawParams(const Vector3f& offset,
+                           const Quaternionf& viewerOrientation,
+                           float brightness,
+                           float pixelSize,
+                           GalaxyDrawParams& params) const
 {
-    if (form == nullptr)
-        return;
+    if (form == InvalidResource)
+        return false;
 
     /* We'll first see if the galaxy's apparent size is big enough to
        be noticeable on screen; if it's not we'll break right here,
@@ -320,54 +456,22 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
     float size  = 2 * getRadius();
 
     if (size < minimumFeatureSize)
-        return;
-
-    auto *prog = renderer->getShaderManager().getShader("galaxy");
-    if (prog == nullptr)
-        return;
-
-    if (galaxyTex == nullptr)
-    {
-        galaxyTex = CreateProceduralTexture(width, height, GL_RGBA,
-                                            GalaxyTextureEval);
-    }
-    assert(galaxyTex != nullptr);
-    glActiveTexture(GL_TEXTURE0);
-    galaxyTex->bind();
-
-    if (colorTex == nullptr)
-    {
-        colorTex = CreateProceduralTexture(256, 1, GL_RGBA,
-                                           ColorTextureEval);
-    }
-    assert(colorTex != nullptr);
-    glActiveTexture(GL_TEXTURE1);
-    colorTex->bind();
+        return false;
 
-    Matrix3f viewMat = viewerOrientation.conjugate().toRotationMatrix();
-    Vector4f v0(Vector4f::Zero());
-    Vector4f v1(Vector4f::Zero());
-    Vector4f v2(Vector4f::Zero());
-    Vector4f v3(Vector4f::Zero());
-    v0.head(3) = viewMat * Vector3f(-1, -1, 0) * size;
-    v1.head(3) = viewMat * Vector3f( 1, -1, 0) * size;
-    v2.head(3) = viewMat * Vector3f( 1,  1, 0) * size;
-    v3.head(3) = viewMat * Vector3f(-1,  1, 0) * size;
+    // The galaxy isn't drawn until its form has been generated
+    GalacticForm* galacticForm = FindGalacticForm(form, size / minimumFeatureSize);
+    if (galacticForm == nullptr)
+        return false;
 
     Quaternionf orientation = getOrientation().conjugate();
-    Matrix3f mScale = form->scale.asDiagonal() * size;
-    Matrix3f mLinear = orientation.toRotationMatrix() * mScale;
-
-    Matrix4f m = Matrix4f::Identity();
-    m.topLeftCorner(3,3) = mLinear;
-    m.block<3,1>(0, 3) = offset;
+    Matrix3f mScale = getFormScale().asDiagonal() * size;
 
-    int pow2 = 1;
+    params.form = galacticForm;
+    params.m = orientation.toRotationMatrix() * mScale;
+    params.viewMat = viewerOrientation.conjugate().toRotationMatrix();
+    params.size = size;
 
-    BlobVector* points = form->blobs;
-    unsigned int nPoints = (unsigned int) (points->size() * clamp(getDetail()));
     // corrections to avoid excessive brightening if viewed e.g. edge-on
-
     float brightness_corr = 1.0f;
     float cosi;
 
@@ -386,88 +490,77 @@ void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
             brightness_corr = 0.45f;
     }
 
-    glPushMatrix();
-    glTranslatef(-offset.x(), -offset.y(), -offset.z());
-
     const float btot = ((type > SBc) && (type < Irr)) ? 2.5f : 5.0f;
-    const float spriteScaleFactor = 1.0f / 1.55f;
-
-    glEnableClientState(GL_VERTEX_ARRAY);
-    glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+    params.alphaScale = (4.0f * lightGain + 1.0f) * btot * brightness_corr * brightness;
 
-    vector<GalaxyVertex, aligned_allocator<GalaxyVertex>> vertices;
-    vertices.reserve(4096 / sizeof(GalaxyVertex));
-    vector<short> indices;
-    indices.reserve(4096 / sizeof(GalaxyVertex) / 4 * 6); // 6 indices per 4 vertices
-    unsigned short j = 0;
+    // Blobs are drawn until their sprites get smaller than a pixel, which
+    // only happens at powers of two of the blob index.
+    auto nPoints = (unsigned int) (galacticForm->blobs.size() * clamp(getDetail()));
+    unsigned int nBlobs = 1;
+    while (nBlobs < nPoints)
+    {
+        size *= spriteScaleFactor;
+        if (size < minimumFeatureSize)
+            break;
+        nBlobs <<= 1;
+    }
+    params.nBlobs = min(nBlobs, nPoints);
 
-    prog->use();
-    prog->samplerParam("galaxyTex") = 0;
-    prog->samplerParam("colorTex") = 1;
+    return true;
+}
 
-    for (unsigned int i = 0; i < nPoints; ++i)
-    {
-        if ((i & pow2) != 0)
-        {
-            pow2 <<= 1;
-            size *= spriteScaleFactor;
-            v0 *= spriteScaleFactor;
-            v1 *= spriteScaleFactor;
-            v2 *= spriteScaleFactor;
-            v3 *= spriteScaleFactor;
-            if (size < minimumFeatureSize)
-                break;
-        }
 
-        const Blob& b  = (*points)[i];
-        Vector4f    p  = m * b.position;
-        float       br = b.brightness / 255.0f;
+void Galaxy::renderGalaxyPointSprites(const Vector3f& offset,
+                                      const Quaternionf& viewerOrientation,
+                                      float brightness,
+                                      float pixelSize,
+                                      const Renderer* renderer)
+{
+    GalaxyDrawParams params;
+    if (!getDrawParams(offset, viewerOrientation, brightness, pixelSize, params) || params.nBlobs == 0)
+        return;
 
-        float screenFrac = size / p.norm();
-        if (screenFrac < 0.1f)
-        {
-            float a = (4.0f * lightGain + 1.0f) * btot * (0.1f - screenFrac) * brightness_corr * brightness * br;
-            short alpha = (short) (a * 65535.99f);
-            short color = (short)b.colorIndex;
-            GalaxyVertex vtx;
-            vtx.position = p + v0;
-            vtx.texCoord = { 0, 0, color, alpha };
-            vertices.push_back(vtx);
-            vtx.position = p + v1;
-            vtx.texCoord = { 1, 0, color, alpha  };
-            vertices.push_back(vtx);
-            vtx.position = p + v2;
-            vtx.texCoord = { 1, 1, color, alpha  };
-            vertices.push_back(vtx);
-            vtx.position = p + v3;
-            vtx.texCoord = { 0, 1, color, alpha  };
-            vertices.push_back(vtx);
+    auto *prog = renderer->getShaderManager().getShader("galaxy");
+    if (prog == nullptr)
+        return;
 
-            indices.push_back(j+0);
-            indices.push_back(j+1);
-            indices.push_back(j+2);
-            indices.push_back(j+0);
-            indices.push_back(j+2);
-            indices.push_back(j+3);
-            j += 4;
+    if (galaxyTex == nullptr)
+    {
+        galaxyTex = CreateProceduralTexture(width, height, GL_RGBA,
+                                            GalaxyTextureEval);
+    }
+    assert(galaxyTex != nullptr);
+    glActiveTexture(GL_TEXTURE0);
+    galaxyTex->bind();
 
-            if ((vertices.size() + 4) * sizeof(GalaxyVertex) > 4096)
-            {
-                draw(&vertices[0], indices.size(), indices.data());
-                vertices.clear();
-                indices.clear();
-                j = 0;
-            }
-        }
+    if (colorTex == nullptr)
+    {
+        colorTex = CreateProceduralTexture(256, 1, GL_RGBA,
+                                           ColorTextureEval);
     }
+    assert(colorTex != nullptr);
+    glActiveTexture(GL_TEXTURE1);
+    colorTex->bind();
+
+    // The form is uploaded once and shared by all the galaxies using it
+    VertexObject& vo = params.form->vo;
+    vo.bind();
+    if (!vo.initialized())
+        initGalaxyData(vo, params.form->blobs, prog->attribIndex("blobBrightness"));
 
-    if (indices.size() > 0)
-        draw(&vertices[0], indices.size(), indices.data());
+    prog->use();
+    prog->mat3Param("m")               = params.m;
+    prog->vec3Param("offset")          = offset;
+    prog->mat3Param("viewMat")         = params.viewMat;
+    prog->floatParam("size")           = params.size;
+    prog->floatParam("alphaScale")     = params.alphaScale;
+    prog->samplerParam("galaxyTex")    = 0;
+    prog->samplerParam("colorTex")     = 1;
+
+    vo.draw(GL_QUADS, params.nBlobs * 4);
 
-    glDisableClientState(GL_VERTEX_ARRAY);
-    glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+    vo.unbind();
     glUseProgram(0);
-    glPopMatrix();
     glActiveTexture(GL_TEXTURE0);
 }
 
@@ -573,10 +666,11 @@ void Galaxy::setLightGain(float lg)
 }
 
 
-GalacticForm* buildGalacticForms(const fs::path& filename)
+GalacticForm* buildGalacticForm(const fs::path& filename, mt19937& rng)
 {
     Blob b;
-    BlobVector* galacticPoints = new BlobVector;
+    auto* galacticForm = new GalacticForm();
+    BlobVector* galacticPoints = &galacticForm->blobs;
 
     // Load templates in standard .png format
     int width, height, rgb, j = 0, kmin = 9;
@@ -587,7 +681,7 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
     if (img == nullptr)
     {
         cout<<"\nThe galaxy template *** "<<filename<<" *** could not be loaded!\n\n";
-        delete galacticPoints;
+        delete galacticForm;
         return nullptr;
     }
     width  = img->getWidth();
@@ -603,8 +697,8 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
             z  = floor(i /(float) width);
             x  = (i - width * z - 0.5f * (width - 1)) / (float) width;
             z  = (0.5f * (height - 1) - z) / (float) height;
-            x  += sfrand<float>() * 0.008f;
-            z  += sfrand<float>() * 0.008f;
+            x  += sfrand<float>(rng) * 0.008f;
+            z  += sfrand<float>(rng) * 0.008f;
             r2 = x * x + z * z;
 
             if (filename != "models/E0.png")
@@ -618,10 +712,10 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
                     // generate "thickness" y of spirals with emulation of a dust lane
                     // in galctic plane (y=0)
 
-                    yr =  sfrand<float>() * h;
+                    yr =  sfrand<float>(rng) * h;
                     prob = (1.0f - B * exp(-yr * yr))/p0;
 
-                } while (frand<float>() > prob);
+                } while (frand<float>(rng) > prob);
                 b.brightness  = value * prob;
                 y = y0 * yr / h;
             }
@@ -630,10 +724,10 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
                 // generate spherically symmetric distribution from E0.png
                 do
                 {
-                    yy = sfrand<float>();
+                    yy = sfrand<float>(rng);
                     float ry2 = 1.0f - yy * yy;
                     prob = ry2 > 0? sqrt(ry2): 0.0f;
-                } while (frand<float>() > prob);
+                } while (frand<float>(rng) > prob);
                 y = yy * sqrt(0.25f - r2) ;
                 b.brightness  = value;
                 kmin = 12;
@@ -642,6 +736,11 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
             b.position    = Vector4f(x, y, z, 1.0f);
             unsigned int rr =  (unsigned int) (b.position.head(3).norm() * 511);
             b.colorIndex  = rr < 256? rr: 255;
+
+            // account for reddening of ellipticals rel.to spirals
+            if (filename == "models/E0.png")
+                b.colorIndex = (unsigned int) ceil(0.76f * b.colorIndex);
+
             galacticPoints->push_back(b);
             j++;
         }
@@ -658,75 +757,33 @@ GalacticForm* buildGalacticForms(const fs::path& filename)
     // reshuffle the galaxy points randomly...except the first kmin+1 in the center!
     // the higher that number the stronger the central "glow"
 
-    std::random_device rng;
-    std::mt19937 urng(rng());
-    shuffle(galacticPoints->begin() + kmin, galacticPoints->end(), urng);
-
-    auto* galacticForm  = new GalacticForm();
-    galacticForm->blobs = galacticPoints;
-    galacticForm->scale = Vector3f::Ones();
+    shuffle(galacticPoints->begin() + kmin, galacticPoints->end(), rng);
 
     return galacticForm;
 }
 
 
-void InitializeForms()
+GalacticForm* buildIrregularForm(mt19937& rng)
 {
-    // Spiral Galaxies, 7 classical Hubble types
-
-    spiralForms   = new GalacticForm*[7];
-
-    spiralForms[Galaxy::S0]   = buildGalacticForms("models/S0.png");
-    spiralForms[Galaxy::Sa]   = buildGalacticForms("models/Sa.png");
-    spiralForms[Galaxy::Sb]   = buildGalacticForms("models/Sb.png");
-    spiralForms[Galaxy::Sc]   = buildGalacticForms("models/Sc.png");
-    spiralForms[Galaxy::SBa]  = buildGalacticForms("models/SBa.png");
-    spiralForms[Galaxy::SBb]  = buildGalacticForms("models/SBb.png");
-    spiralForms[Galaxy::SBc]  = buildGalacticForms("models/SBc.png");
-
-    // Elliptical Galaxies , 8 classical Hubble types, E0..E7,
-    //
-    // To save space: generate spherical E0 template from S0 disk
-    // via rescaling by (1.0f, 3.8f, 1.0f).
-
-    ellipticalForms = new GalacticForm*[8];
-    for (unsigned int eform  = 0; eform <= 7; ++eform)
-    {
-        float ell = 1.0f - (float) eform / 8.0f;
-
-        // note the correct x,y-alignment of 'ell' scaling!!
-        // build all elliptical templates from rescaling E0
-
-        ellipticalForms[eform] = buildGalacticForms("models/E0.png");
-        if (*ellipticalForms)
-            ellipticalForms[eform]->scale = Vector3f(ell, ell, 1.0f);
-
-        // account for reddening of ellipticals rel.to spirals
-        if (*ellipticalForms)
-        {
-            unsigned int nPoints = (unsigned int) (ellipticalForms[eform]->blobs->size());
-            for (unsigned int i = 0; i < nPoints; ++i)
-            {
-                (*ellipticalForms[eform]->blobs)[i].colorIndex = (unsigned int) ceil(0.76f * (*ellipticalForms[eform]->blobs)[i].colorIndex);
-            }
-        }
-    }
-    //Irregular Galaxies
     unsigned int galaxySize = GALAXY_POINTS, ip = 0;
     Blob b;
     Vector3f p;
 
-    BlobVector* irregularPoints = new BlobVector;
+    auto* irregularForm = new GalacticForm();
+    BlobVector* irregularPoints = &irregularForm->blobs;
     irregularPoints->reserve(galaxySize);
 
     while (ip < galaxySize)
     {
-        p        = Vector3f(sfrand<float>(), sfrand<float>(), sfrand<float>());
+        // Draw the coordinates in a fixed order, for repeatable forms
+        p.x()    = sfrand<float>(rng);
+        p.y()    = sfrand<float>(rng);
+        p.z()    = sfrand<float>(rng);
         float r  = p.norm();
         if (r < 1)
         {
             float prob = (1 - r) * (fractalsum(Vector3f(p.x() + 5, p.y() + 5, p.z() + 5), 8) + 1) * 0.5f;
-            if (frand<float>() < prob)
+            if (frand<float>(rng) < prob)
             {
                 b.position   = Vector4f(p.x(), p.y(), p.z(), 1.0f);
                 b.brightness = 64u;
@@ -737,11 +794,8 @@ void InitializeForms()
             }
         }
     }
-    irregularForm        = new GalacticForm();
-    irregularForm->blobs = irregularPoints;
-    irregularForm->scale = Vector3f::Constant(0.5f);
 
-    formsInitialized = true;
+    return irregularForm;
 }
 
 
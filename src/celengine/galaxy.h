@@ -12,6 +12,9 @@
 #define _GALAXY_H_
 
 #include <celengine/deepskyobj.h>
+#include <celengine/vertexobject.h>
+#include <celutil/reshandle.h>
+#include <vector>
 
 
 struct Blob
@@ -23,7 +26,28 @@ struct Blob
     float           brightness;
 };
 
-class GalacticForm;
+typedef std::vector<Blob, Eigen::aligned_allocator<Blob> > BlobVector;
+
+class GalacticForm
+{
+public:
+    BlobVector blobs;
+    // The blobs as sprites, uploaded when the form is first drawn
+    celgl::VertexObject vo{ GL_ARRAY_BUFFER, 0, GL_STATIC_DRAW };
+};
+
+// The state a galaxy is drawn with: its form is drawn as sprites, from a
+// vertex buffer shared by the galaxies using it, and the shader transforms,
+// sizes and fades them.
+struct GalaxyDrawParams
+{
+    GalacticForm*   form;
+    Eigen::Matrix3f m;          // orientation and scale of the form
+    Eigen::Matrix3f viewMat;    // orientation of the sprites
+    float           size;       // sprite size of the first blob
+    float           alphaScale; // brightness of the blobs
+    unsigned int    nBlobs;     // number of blobs drawn
+};
 
 class Galaxy : public DeepSkyObject
 {
@@ -49,8 +73,23 @@ class Galaxy : public DeepSkyObject
                 float pixelSize,
                 const Renderer* r) override;
 
+    // Compute what the galaxy is drawn with, returning false if it isn't
+    // drawn at all
+    bool getDrawParams(const Eigen::Vector3f& offset,
+                       const Eigen::Quaternionf& viewerOrientation,
+                       float brightness,
+                       float pixelSize,
+                       GalaxyDrawParams& params) const;
+
     GalacticForm* getForm() const;
 
+    // Forms are generated on a thread of their own. Those generated since
+    // the last call are made available by finishLoadingForms(), called
+    // once per frame; after stopLoadingForms() they're generated when
+    // first found instead.
+    static void finishLoadingForms();
+    static void stopLoadingForms();
+
     static void  increaseLightGain();
     static void  decreaseLightGain();
     static float getLightGain();
@@ -87,6 +126,7 @@ class Galaxy : public DeepSkyObject
                                   float brightness,
                                   float pixelSize,
                                   const Renderer* r);
+    Eigen::Vector3f getFormScale() const;
 #if 0
     void renderGalaxyEllipsoid(const Eigen::Vector3f& offset,
                                const Eigen::Quaternionf& viewerOrientation,
@@ -97,7 +137,7 @@ class Galaxy : public DeepSkyObject
     float         detail{ 1.0f };
     std::string*  customTmpName{ nullptr };
     GalaxyType    type{ S0 };
-    GalacticForm* form{ nullptr };
+    ResourceHandle form{ InvalidResource };
 
     static float  lightGain;
 };
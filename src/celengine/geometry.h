@@ -53,6 +53,14 @@ public:
     virtual void loadTextures()
     {
     }
+
+    /*! Return the approximate memory used by the geometry, in bytes,
+     *  not including its textures.
+     */
+    virtual size_t getMemoryUsage() const
+    {
+        return 0;
+    }
 };
 
 #endif // _CELENGINE_GEOMETRY_H_
@@ -16,13 +16,18 @@
 #include "render.h"
 #include "globular.h"
 #include "texture.h"
+#include "formcache.h"
 #include <celmath/perlin.h>
 #include <celmath/intersect.h>
 #include <celutil/debug.h>
 #include <celutil/gettext.h>
+#include <celutil/resmanager.h>
+#include <chrono>
 #include <cmath>
 #include <fstream>
+#include <mutex>
 #include <algorithm>
+#include <random>
 #include <cassert>
 
 using namespace Eigen;
@@ -57,12 +62,113 @@ static const float RRatio_min = pow(10.0f, 1.7f);
 #endif
 static float CBin, RRatio, XI, Rr = 1.0f, Gg = 1.0f, Bb = 1.0f;
 
-static GlobularForm** globularForms = nullptr;
+// Increase when the generation of forms changes, so that cached forms
+// aren't used anymore
+static const uint32_t GLOBULAR_FORM_VERSION = 1;
+
 static Texture* globularTex = nullptr;
 static Texture* centerTex[8] = {nullptr};
-static void InitializeForms();
-static GlobularForm* buildGlobularForms(float /*c*/);
-static bool formsInitialized = false;
+static void InitializeColorTable();
+static GlobularForm* buildGlobularForm(float /*c*/, mt19937& rng);
+static bool colorTableInitialized = false;
+
+
+// Globulars share the forms generated for 8 bins of King concentration.
+// Forms are generated when a globular using them is first drawn, on a
+// thread of their own.
+class GlobularFormInfo : public ResourceInfo<GlobularForm>
+{
+ public:
+    unsigned int bin;
+
+    GlobularFormInfo(unsigned int _bin) : bin(_bin) {};
+
+    fs::path resolve(const fs::path&) override
+    {
+        return to_string(bin);
+    }
+
+    GlobularForm* load(const fs::path&) override;
+
+    bool prepare(const fs::path& name) override
+    {
+        resource = load(name);
+        return resource != nullptr;
+    }
+
+    GlobularForm* create(const fs::path&) override
+    {
+        return resource;
+    }
+};
+
+static bool operator<(const GlobularFormInfo& f0, const GlobularFormInfo& f1)
+{
+    return f0.bin < f1.bin;
+}
+
+static ResourceManager<GlobularFormInfo>* GetGlobularFormManager()
+{
+    static ResourceManager<GlobularFormInfo> manager("");
+    static once_flag started;
+    call_once(started, []() { manager.setBackgroundLoading(true); });
+    return &manager;
+}
+
+// Return the form, or nullptr until it has been generated
+static GlobularForm* FindGlobularForm(ResourceHandle h, float priority)
+{
+    return GetGlobularFormManager()->find(h, priority);
+}
+
+
+// Forms are generated with a seed of their own, so that they are the same
+// from one run to the next, and cached.
+GlobularForm* GlobularFormInfo::load(const fs::path&)
+{
+    float CBin = MinC + ((float) bin + 0.5f) * BinWidth;
+
+    uint64_t key = FormCache::InitialHash;
+    FormCache::hashBytes(key, &GLOBULAR_FORM_VERSION, sizeof GLOBULAR_FORM_VERSION);
+    FormCache::hashBytes(key, &GLOBULAR_POINTS, sizeof GLOBULAR_POINTS);
+    FormCache::hashBytes(key, &CBin, sizeof CBin);
+
+    string cacheName = "globular:" + to_string(bin);
+    vector<float> values;
+    if (FormCache::get().load(cacheName, key, values) && values.size() % 5 == 0)
+    {
+        auto* form = new GlobularForm();
+        form->gblobs.resize(values.size() / 5);
+        for (size_t i = 0; i < form->gblobs.size(); i++)
+        {
+            const float* v = &values[i * 5];
+            form->gblobs[i].position = Vector3f(v[0], v[1], v[2]);
+            form->gblobs[i].colorIndex = (unsigned int) v[3];
+            form->gblobs[i].radius_2d = v[4];
+        }
+        return form;
+    }
+
+    uint64_t seed = FormCache::InitialHash;
+    FormCache::hashBytes(seed, cacheName.data(), cacheName.size());
+    mt19937 rng((mt19937::result_type) seed);
+
+    GlobularForm* form = buildGlobularForm(CBin, rng);
+
+    values.clear();
+    values.reserve(form->gblobs.size() * 5);
+    for (const auto& b : form->gblobs)
+    {
+        values.push_back(b.position.x());
+        values.push_back(b.position.y());
+        values.push_back(b.position.z());
+        values.push_back((float) b.colorIndex);
+        values.push_back(b.radius_2d);
+    }
+    FormCache::get().save(cacheName, key, values);
+
+    return form;
+}
 
 #if 0
 static bool decreasing (const GBlob& b1, const GBlob& b2)
@@ -223,12 +329,12 @@ float Globular::getConcentration() const
 void Globular::setConcentration(const float conc)
 {
     c = conc;
-    if (!formsInitialized)
-        InitializeForms();
+    if (!colorTableInitialized)
+        InitializeColorTable();
 
     // For saving time, account for the c dependence via 8 bins only,
 
-    form = globularForms[cSlot(conc)];
+    form = GetGlobularFormManager()->getHandle(GlobularFormInfo(cSlot(conc)));
     recomputeTidalRadius();
 }
 
@@ -239,7 +345,19 @@ string Globular::getDescription() const
 
 GlobularForm* Globular::getForm() const
 {
-    return form;
+    return FindGlobularForm(form, 0.0f);
+}
+
+
+void Globular::finishLoadingForms()
+{
+    GetGlobularFormManager()->finishLoading(chrono::steady_clock::time_point::max());
+}
+
+
+void Globular::stopLoadingForms()
+{
+    GetGlobularFormManager()->setBackgroundLoading(false);
 }
 
 const char* Globular::getObjTypeName() const
@@ -259,9 +377,7 @@ bool Globular::pick(const Ray3d& ray,
      * that blobs are considered points when globulars are built, but have size
      * when they are drawn.
      */
-    Vector3d ellipsoidAxes(getRadius() * (form->scale.x() + RADIUS_CORRECTION),
-                           getRadius() * (form->scale.y() + RADIUS_CORRECTION),
-                           getRadius() * (form->scale.z() + RADIUS_CORRECTION));
+    Vector3d ellipsoidAxes = Vector3d::Constant(getRadius() * (1.0f + RADIUS_CORRECTION));
 
     Vector3d p = getPosition();
     return testIntersection(Ray3d(ray.origin - p, ray.direction).transform(getOrientation().cast<double>().toRotationMatrix()),
@@ -306,7 +422,7 @@ void Globular::render(const Vector3f& offset,
 }
 
 
-void initGlobularData(VertexObject& vo, vector<GBlob>* points, GLint sizeLoc, GLint etaLoc)
+void initGlobularData(VertexObject& vo, const vector<GBlob>& points, GLint sizeLoc, GLint etaLoc)
 {
     struct GlobularVtx
     {
@@ -316,7 +432,7 @@ void initGlobularData(VertexObject& vo, vector<GBlob>* points, GLint sizeLoc, GL
         float    eta;
     };
     vector<GlobularVtx> globularVtx;
-    globularVtx.reserve(4 + points->size());
+    globularVtx.reserve(4 + points.size());
 
     // Reuse the buffer for a tidal
     globularVtx.push_back({{-1, -1, 0}, {0, 0, 0}, 0, 0});
@@ -331,7 +447,7 @@ void initGlobularData(VertexObject& vo, vector<GBlob>* points, GLint sizeLoc, GL
 
     float starSize = 0.5f;
     size_t pow2 = 128;
-    for (size_t i = 0; i < points->size(); ++i)
+    for (size_t i = 0; i < points.size(); ++i)
     {
         /*! Note that the [axis,angle] input in globulars.dsc transforms the
          *  2d projected star distance r_2d in the globular frame to refer to the
@@ -348,7 +464,7 @@ void initGlobularData(VertexObject& vo, vector<GBlob>* points, GLint sizeLoc, GL
             starSize /= 1.25f;
         }
 
-        GBlob b = (*points)[i];
+        const GBlob& b = points[i];
         GlobularVtx vtx;
         vtx.starSize = starSize;
         vtx.position = b.position;
@@ -383,7 +499,7 @@ void Globular::renderGlobularPointSprites(
                                       float pixelSize,
                                       const Renderer* renderer)
 {
-    if (form == nullptr)
+    if (form == InvalidResource)
         return;
 
     float distanceToDSO = offset.norm() - getRadius();
@@ -404,6 +520,11 @@ void Globular::renderGlobularPointSprites(
     if (DiskSizeInPixels < 1.0f)
         return;
 
+    // The globular isn't drawn until its form has been generated
+    const GlobularForm* globularForm = FindGlobularForm(form, DiskSizeInPixels);
+    if (globularForm == nullptr)
+        return;
+
     auto *tidalProg = renderer->getShaderManager().getShader("tidal");
     auto *globProg  = renderer->getShaderManager().getShader("globular");
     if (tidalProg == nullptr || globProg == nullptr)
@@ -458,7 +579,7 @@ void Globular::renderGlobularPointSprites(
     {
         auto i = globProg->attribIndex("starSize");
         auto j = globProg->attribIndex("eta");
-        initGlobularData(vo, form->gblobs, i, j);
+        initGlobularData(vo, globularForm->gblobs, i, j);
     }
 
     tidalProg->use();
@@ -479,14 +600,14 @@ void Globular::renderGlobularPointSprites(
      * or when distance from globular center decreases.
      */
 
-    GLsizei count = (GLsizei) (form->gblobs->size() * clamp(getDetail()));
+    GLsizei count = (GLsizei) (globularForm->gblobs.size() * clamp(getDetail()));
     float t = pow(2, 1 + log2(minimumFeatureSize / brightness) / log2(1/1.25f));
     count = min(count, (GLsizei) clamp(t, 128.0f, (float) max(count, 128)));
 
     globProg->use();
 
     globularTex->bind();
-    Matrix3f m = Scaling(form->scale) * getOrientation().toRotationMatrix() * Scaling(tidalSize);
+    Matrix3f m = getOrientation().toRotationMatrix() * Scaling(tidalSize);
     globProg->mat3Param("m")            = m;
     globProg->vec3Param("offset")       = offset;
     globProg->floatParam("brightness")  = brightness;
@@ -526,10 +647,12 @@ void Globular::recomputeTidalRadius()
 }
 
 
-GlobularForm* buildGlobularForms(float c)
+GlobularForm* buildGlobularForm(float c, mt19937& rng)
 {
     GBlob b{};
-    vector<GBlob>* globularPoints = new vector<GBlob>;
+    auto* globularForm = new GlobularForm();
+    vector<GBlob>* globularPoints = &globularForm->gblobs;
+    globularPoints->reserve(GLOBULAR_POINTS);
 
     float rRatio = pow(10.0f, c); //  = r_t / r_c
     float prob;
@@ -558,7 +681,7 @@ GlobularForm* buildGlobularForms(float c)
          * parameters and variables!
          */
 
-        float uu = frand<float>();
+        float uu = frand<float>(rng);
 
         /* First step: eta distributed as inverse power distribution (~1/Z^2)
          * that majorizes the exact King profile. Compute eta in terms of uniformly
@@ -583,15 +706,15 @@ GlobularForm* buildGlobularForms(float c)
 
         k++;
 
-        if (frand<float>() < prob / cH)
+        if (frand<float>(rng) < prob / cH)
         {
             /* Generate 3d points of globular cluster stars in polar coordinates:
              * Distribution in eta (<=> r) according to King's profile.
              * Uniform distribution on any spherical surface for given eta.
              * Note: u = cos(phi) must be used as a stochastic variable to get uniformity in angle!
              */
-            float u = sfrand<float>();
-            float theta = 2 * (float) PI * frand<float>();
+            float u = sfrand<float>(rng);
+            float theta = 2 * (float) PI * frand<float>(rng);
             float sthetu2 = sin(theta) * sqrt(1.0f - u * u);
 
             // x,y,z points within -0.5..+0.5, as required for consistency:
@@ -620,14 +743,10 @@ GlobularForm* buildGlobularForms(float c)
     // Check for efficiency of sprite-star generation => close to 100 %!
     //cout << "c =  "<< c <<"  i =  " << i - 1 <<"  k =  " << k - 1 << "  Efficiency:  " << 100.0f * i / (float)k<<"%" << endl;
 
-    auto* globularForm   = new GlobularForm();
-    globularForm->gblobs = globularPoints;
-    globularForm->scale  = Vector3f::Ones();
-
     return globularForm;
 }
 
-void InitializeForms()
+void InitializeColorTable()
 {
 
     // Build RGB color table, using hue, saturation, value as input.
@@ -667,15 +786,6 @@ void InitializeForms()
         DeepSkyObject::hsv2rgb(&Rr, &Gg, &Bb, hue, sat, 0.85f);
         colorTable[i]  = Color(Rr, Gg, Bb);
     }
-    // Define globularForms corresponding to 8 different bins of King concentration c
-
-    globularForms = new GlobularForm*[8];
-
-    for (unsigned int ic  = 0; ic <= 7; ++ic)
-    {
-        float CBin = MinC + ((float) ic + 0.5f) * BinWidth;
-        globularForms[ic] = buildGlobularForms(CBin);
-    }
-    formsInitialized = true;
 
+    colorTableInitialized = true;
 }
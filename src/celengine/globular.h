@@ -18,6 +18,7 @@
 #include <Eigen/Geometry>
 #include <celengine/deepskyobj.h>
 #include <celengine/vertexobject.h>
+#include <celutil/reshandle.h>
 
 
 struct GBlob
@@ -29,8 +30,7 @@ struct GBlob
 
 struct GlobularForm
 {
-    std::vector<GBlob>* gblobs;
-    Eigen::Vector3f scale;
+    std::vector<GBlob> gblobs;
 };
 
 class Globular : public DeepSkyObject
@@ -66,6 +66,10 @@ class Globular : public DeepSkyObject
 
     GlobularForm* getForm() const;
 
+    // As for galaxies, see Galaxy::finishLoadingForms()
+    static void finishLoadingForms();
+    static void stopLoadingForms();
+
     uint64_t getRenderMask() const override;
     unsigned int getLabelMask() const override;
     const char* getObjTypeName() const override;
@@ -84,7 +88,7 @@ class Globular : public DeepSkyObject
     void recomputeTidalRadius();
 
     float         detail{ 1.0f };
-    GlobularForm* form{ nullptr };
+    ResourceHandle form{ InvalidResource };
     float         r_c{ R_c_ref };
     float         c{ C_ref };
     float         tidalRadius{ 0.0f };
@@ -8,6 +8,8 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
+#include <cstring>
 #include <utility>
 #include <celutil/color.h>
 #include <celutil/util.h>
@@ -21,26 +23,52 @@ using namespace std;
 using namespace celmath;
 
 
+static int compareKey(const HashKey& key, const string& s)
+{
+    int c = memcmp(key.data(), s.data(), min(key.size(), s.size()));
+    if (c != 0)
+        return c;
+    return key.size() < s.size() ? -1 : (key.size() > s.size() ? 1 : 0);
+}
+
+static HashEntries::const_iterator findKey(const HashEntries& entries, const string& key)
+{
+    return lower_bound(entries.begin(), entries.end(), key,
+                       [](const HashEntry& e, const string& k) { return compareKey(e.first, k) < 0; });
+}
+
+
 AssociativeArray::~AssociativeArray()
 {
     for (const auto &iter : assoc)
-        delete iter.second;
+        Value::destroy(iter.second);
 }
 
 
 Value* AssociativeArray::getValue(const string& key) const
 {
-    map<string, Value*>::const_iterator iter = assoc.find(key);
-    if (iter == assoc.end())
+    auto iter = findKey(assoc, key);
+    if (iter == assoc.end() || compareKey(iter->first, key) != 0)
         return nullptr;
 
     return iter->second;
 }
 
 
+// The hash takes ownership of the value. If the key is already present,
+// the first value is kept and the new one is released.
 void AssociativeArray::addValue(const string& key, Value& val)
 {
-    assoc.insert(map<string, Value*>::value_type(key, &val));
+    auto iter = findKey(assoc, key);
+    if (iter != assoc.end() && compareKey(iter->first, key) == 0)
+    {
+        Value::destroy(&val);
+        return;
+    }
+
+    PoolAllocator<char> allocator(assoc.get_allocator());
+    assoc.insert(assoc.begin() + (iter - assoc.begin()),
+                 HashEntry(HashKey(key.data(), key.size(), allocator), &val));
 }
 
 
@@ -10,21 +10,32 @@
 
 #pragma once
 
-#include <map>
+#include <string>
+#include <utility>
+#include <vector>
 #include <celcompat/filesystem.h>
 #include <celmath/mathlib.h>
+#include <celutil/memorypool.h>
 #include <Eigen/Geometry>
 
 
 class Color;
 class Value;
 
-using HashIterator = std::map<std::string, Value*>::const_iterator;
+using HashKey = std::basic_string<char, std::char_traits<char>, PoolAllocator<char>>;
+using HashEntry = std::pair<HashKey, Value*>;
+using HashEntries = std::vector<HashEntry, PoolAllocator<HashEntry>>;
+using HashIterator = HashEntries::const_iterator;
 
+// A hash of values keyed by name, kept as a vector sorted by key as they
+// have a handful of entries. It may be allocated with its keys and values
+// from a memory pool, so that a parse tree doesn't need to be freed piece
+// by piece.
 class AssociativeArray
 {
  public:
     AssociativeArray() = default;
+    explicit AssociativeArray(MemoryPool* pool) : assoc(PoolAllocator<HashEntry>(pool)) {}
     ~AssociativeArray();
     AssociativeArray(AssociativeArray&&) = default;
     AssociativeArray(const AssociativeArray&) = delete;
@@ -77,8 +88,13 @@ class AssociativeArray
         return assoc.end();
     }
 
+    PoolAllocator<HashEntry> get_allocator() const
+    {
+        return assoc.get_allocator();
+    }
+
  private:
-    std::map<std::string, Value*> assoc;
+    HashEntries assoc;
 };
 
 using Hash = AssociativeArray;
@@ -196,6 +196,11 @@ Geometry* GeometryInfo::load(const fs::path& resolvedFilename)
 
         model->determineOpacity();
 
+        // Build the hierarchies used for picking here rather than on the
+        // first pick, which may happen while drawing
+        for (unsigned int i = 0; i < model->getMeshCount(); i++)
+            model->getMesh(i)->getBVH();
+
         // Display some statics for the model
         fmt::fprintf(clog,
                      _("   Model statistics: %u vertices, %u primitives, %u materials (%u unique)\n"),
@@ -52,6 +52,23 @@ class GeometryInfo : public ResourceInfo<Geometry>
 
     virtual fs::path resolve(const fs::path&);
     virtual Geometry* load(const fs::path&);
+
+    // Models are read and prepared for rendering entirely on the loading
+    // thread, OpenGL objects being made when they're first rendered.
+    bool prepare(const fs::path& name) override
+    {
+        resource = load(name);
+        return resource != nullptr;
+    }
+    Geometry* create(const fs::path&) override
+    {
+        return resource;
+    }
+
+    size_t getMemoryUsage() const override
+    {
+        return resource->getMemoryUsage();
+    }
 };
 
 inline bool operator<(const GeometryInfo& g0, const GeometryInfo& g1)
@@ -65,6 +65,28 @@ ModelGeometry::pick(const Ray3d& r, double& distance) const
 }
 
 
+/*! The vertices and indices of the meshes, the copies of the vertices
+ *  in vertex buffer objects, and the triangles and nodes of the hierarchies
+ *  used for picking.
+ */
+size_t
+ModelGeometry::getMemoryUsage() const
+{
+    size_t size = 0;
+    for (unsigned int i = 0; i < m_model->getMeshCount(); ++i)
+    {
+        const Mesh* mesh = m_model->getMesh(i);
+        size_t vertexSize = mesh->getVertexCount() * mesh->getVertexStride();
+        size += vertexSize > MinVBOSize ? vertexSize * 2 : vertexSize;
+        for (unsigned int j = 0; j < mesh->getGroupCount(); ++j)
+            size += mesh->getGroup(j)->nIndices * sizeof(Mesh::index32);
+        size += mesh->getBVH().getMemoryUsage();
+    }
+
+    return size;
+}
+
+
 /*! Render the model; the time parameter is ignored right now
  *  since this class doesn't currently support animation.
  */
@@ -57,6 +57,7 @@ class ModelGeometry : public Geometry
     virtual bool usesTextureType(cmod::Material::TextureSemantic) const;
     virtual bool isOpaque() const;
     virtual bool isNormalized() const;
+    virtual size_t getMemoryUsage() const;
 
     void loadTextures();
 
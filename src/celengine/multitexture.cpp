@@ -62,14 +62,26 @@ void MultiResTexture::setTexture(const string& source,
 }
 
 
-Texture* MultiResTexture::find(unsigned int resolution)
+Texture* MultiResTexture::find(unsigned int resolution, float priority)
 {
     TextureManager* texMan = GetTextureManager();
 
-    Texture* res = texMan->find(tex[resolution]);
+    Texture* res = texMan->find(tex[resolution], priority);
     if (res != nullptr)
         return res;
 
+    // While the texture is loaded in the background, stand in another
+    // resolution if one is loaded already.
+    if (texMan->getState(tex[resolution]) == ResourceLoading)
+    {
+        for (ResourceHandle h : tex)
+        {
+            if (texMan->getState(h) == ResourceLoaded)
+                return texMan->find(h);
+        }
+        return nullptr;
+    }
+
     // Preferred resolution isn't available; try the second choice
     // Set these to some defaults to avoid GCC complaints
     // about possible uninitialized variable usage:
@@ -92,13 +104,13 @@ Texture* MultiResTexture::find(unsigned int resolution)
     }
 
     tex[resolution] = tex[secondChoice];
-    res = texMan->find(tex[resolution]);
-    if (res != nullptr)
+    res = texMan->find(tex[resolution], priority);
+    if (res != nullptr || texMan->getState(tex[resolution]) == ResourceLoading)
         return res;
 
     tex[resolution] = tex[lastResort];
 
-    return texMan->find(tex[resolution]);
+    return texMan->find(tex[resolution], priority);
 }
 
 
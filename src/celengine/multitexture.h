@@ -39,7 +39,9 @@ class MultiResTexture
                     const fs::path& path,
                     float bumpHeight,
                     unsigned int flags);
-    Texture* find(unsigned int resolution);
+    // Find the texture of the resolution, or of another one if it can't be
+    // loaded. The priority is that of loading it in the background.
+    Texture* find(unsigned int resolution, float priority = 0.0f);
 
     bool isValid() const;
 
@@ -1,9 +1,78 @@
+#include <algorithm>
 #include <celutil/debug.h>
 #include "name.h"
 
+namespace
+{
+inline char foldASCII(char c)
+{
+    return (c >= 'a' && c <= 'z') ? c - 'a' + 'A' : c;
+}
+
+bool equalIgnoringCase(const char* s0, const char* s1, size_t length)
+{
+    for (size_t i = 0; i < length; i++)
+    {
+        if (foldASCII(s0[i]) != foldASCII(s1[i]))
+            return false;
+    }
+    return true;
+}
+}
+
+
+// FNV-1a hash of the name with ASCII letters folded to upper case
+uint32_t NameDatabase::hashName(const char* name, size_t length)
+{
+    uint32_t hash = 2166136261u;
+    for (size_t i = 0; i < length; i++)
+    {
+        hash ^= (unsigned char) foldASCII(name[i]);
+        hash *= 16777619u;
+    }
+    return hash;
+}
+
+// Return the slot of the name in the hash table, which is unused if the
+// name isn't in the database
+size_t NameDatabase::findName(const std::string& name) const
+{
+    size_t mask = nameTable.size() - 1;
+    size_t slot = hashName(name.data(), name.length()) & mask;
+    for (;;)
+    {
+        uint32_t i = nameTable[slot];
+        if (i == 0)
+            return slot;
+
+        const NameEntry& entry = names[i - 1];
+        if (entry.length == name.length() &&
+            equalIgnoringCase(namePool.data() + entry.name, name.data(), name.length()))
+        {
+            return slot;
+        }
+
+        slot = (slot + 1) & mask;
+    }
+}
+
+void NameDatabase::growNameTable()
+{
+    // Keep the load factor under 1/2
+    nameTable.assign(std::max(nameTable.size() * 2, (size_t) 1024), 0);
+    size_t mask = nameTable.size() - 1;
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        size_t slot = hashName(namePool.data() + names[i].name, names[i].length) & mask;
+        while (nameTable[slot] != 0)
+            slot = (slot + 1) & mask;
+        nameTable[slot] = i + 1;
+    }
+}
+
 uint32_t NameDatabase::getNameCount() const
 {
-    return nameIndex.size();
+    return names.size();
 }
 
 void NameDatabase::add(const AstroCatalog::IndexNumber catalogNumber, const std::string& name, bool replaceGreek)
@@ -16,48 +85,105 @@ void NameDatabase::add(const AstroCatalog::IndexNumber catalogNumber, const std:
             DPRINTF(LOG_LEVEL_INFO,"Duplicated name '%s' on object with catalog numbers: %d and %d\n", name.c_str(), tmp, catalogNumber);
 #endif
         // Add the new name
-        //nameIndex.insert(NameIndex::value_type(name, catalogNumber));
         std::string fname = ReplaceGreekLetterAbbr(name);
 
-        nameIndex[fname] = catalogNumber;
-        numberIndex.insert(NumberIndex::value_type(catalogNumber, fname));
+        auto offset = (uint32_t) namePool.size();
+        namePool.append(fname.c_str(), fname.length() + 1);
+        numberIndex.push_back({ catalogNumber, offset });
+        numberIndexValid = false;
+
+        if ((names.size() + 1) * 2 > nameTable.size())
+            growNameTable();
+
+        size_t slot = findName(fname);
+        if (nameTable[slot] != 0)
+        {
+            names[nameTable[slot] - 1].catalogNumber = catalogNumber;
+        }
+        else
+        {
+            names.push_back({ offset, (uint32_t) fname.length(), catalogNumber });
+            nameTable[slot] = (uint32_t) names.size();
+            prefixIndexValid = false;
+        }
     }
 }
+
 void NameDatabase::erase(const AstroCatalog::IndexNumber catalogNumber)
 {
-    numberIndex.erase(catalogNumber);
+    numberIndex.push_back({ catalogNumber, InvalidName });
+    numberIndexValid = false;
 }
 
 AstroCatalog::IndexNumber NameDatabase::getCatalogNumberByName(const std::string& name) const
 {
-    NameIndex::const_iterator iter = nameIndex.find(name);
+    if (names.empty())
+        return AstroCatalog::InvalidIndex;
 
-    if (iter == nameIndex.end())
+    uint32_t i = nameTable[findName(name)];
+    if (i == 0)
     {
-        iter = nameIndex.find(ReplaceGreekLetterAbbr(name));
-        if (iter == nameIndex.end())
+        i = nameTable[findName(ReplaceGreekLetterAbbr(name))];
+        if (i == 0)
             return AstroCatalog::InvalidIndex;
     }
-    return iter->second;
+    return names[i - 1].catalogNumber;
+}
+
+// Merge the names added and erased since the last lookup by number into
+// the sorted part of the index
+void NameDatabase::sortNumberIndex() const
+{
+    if (numberIndexValid.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (numberIndexValid.load(std::memory_order_relaxed))
+        return;
+
+    auto numberOrder = [](const NumberIndexEntry& a, const NumberIndexEntry& b)
+    {
+        return a.catalogNumber < b.catalogNumber;
+    };
+    auto middle = numberIndex.begin() + numberIndexSorted;
+    std::stable_sort(middle, numberIndex.end(), numberOrder);
+    std::inplace_merge(numberIndex.begin(), middle, numberIndex.end(), numberOrder);
+
+    // Drop the erased names, which precede an erase entry of the same
+    // catalog number, and the erase entries
+    auto out = numberIndex.begin();
+    for (auto first = numberIndex.begin(); first != numberIndex.end();)
+    {
+        auto last = first;
+        auto kept = first;
+        for (; last != numberIndex.end() && last->catalogNumber == first->catalogNumber; ++last)
+        {
+            if (last->name == InvalidName)
+                kept = last + 1;
+        }
+
+        out = std::copy(kept, last, out);
+        first = last;
+    }
+    numberIndex.erase(out, numberIndex.end());
+    numberIndexSorted = numberIndex.size();
+    numberIndexValid.store(true, std::memory_order_release);
 }
 
 // Return the first name matching the catalog number or end()
 // if there are no matching names.  The first name *should* be the
 // proper name of the OBJ, if one exists. This requires the
 // OBJ name database file to have the proper names listed before
-// other designations.  Also, the STL implementation must
-// preserve this order when inserting the names into the multimap
-// (not certain whether or not this behavior is in the STL spec.
-// but it works on the implementations I've tried so far.)
+// other designations; names of the same object are kept in the
+// order they were added.
 std::string NameDatabase::getNameByCatalogNumber(const AstroCatalog::IndexNumber catalogNumber) const
 {
     if (catalogNumber == AstroCatalog::InvalidIndex)
         return "";
 
-    NumberIndex::const_iterator iter = numberIndex.lower_bound(catalogNumber);
-
-    if (iter != numberIndex.end() && iter->first == catalogNumber)
-        return iter->second;
+    NumberIndex::const_iterator iter = getFirstNameIter(catalogNumber);
+    if (iter != getFinalNameIter())
+        return getName(*iter);
 
     return "";
 }
@@ -67,15 +193,16 @@ std::string NameDatabase::getNameByCatalogNumber(const AstroCatalog::IndexNumber
 // if there are no matching names.  The first name *should* be the
 // proper name of the OBJ, if one exists. This requires the
 // OBJ name database file to have the proper names listed before
-// other designations.  Also, the STL implementation must
-// preserve this order when inserting the names into the multimap
-// (not certain whether or not this behavior is in the STL spec.
-// but it works on the implementations I've tried so far.)
+// other designations; names of the same object are kept in the
+// order they were added.
 NameDatabase::NumberIndex::const_iterator NameDatabase::getFirstNameIter(const AstroCatalog::IndexNumber catalogNumber) const
 {
-    NumberIndex::const_iterator iter = numberIndex.lower_bound(catalogNumber);
+    sortNumberIndex();
+
+    NumberIndex::const_iterator iter = std::lower_bound(numberIndex.begin(), numberIndex.end(), catalogNumber,
+                                                        [](const NumberIndexEntry& e, AstroCatalog::IndexNumber n) { return e.catalogNumber < n; });
 
-    if (iter == numberIndex.end() || iter->first != catalogNumber)
+    if (iter == numberIndex.end() || iter->catalogNumber != catalogNumber)
         return getFinalNameIter();
     else
         return iter;
@@ -83,38 +210,117 @@ NameDatabase::NumberIndex::const_iterator NameDatabase::getFirstNameIter(const A
 
 NameDatabase::NumberIndex::const_iterator NameDatabase::getFinalNameIter() const
 {
+    sortNumberIndex();
     return numberIndex.end();
 }
 
-std::vector<std::string> NameDatabase::getCompletion(const std::string& name, bool greek) const
+void NameDatabase::buildPrefixIndex() const
+{
+    if (prefixIndexValid.load(std::memory_order_acquire))
+        return;
+
+    std::lock_guard<std::mutex> lock(indexMutex);
+    if (prefixIndexValid.load(std::memory_order_relaxed))
+        return;
+
+    foldedPool.clear();
+    prefixIndex.clear();
+    prefixIndex.reserve(names.size());
+    for (uint32_t i = 0; i < names.size(); i++)
+    {
+        std::string key = UTF8FoldCase(namePool.c_str() + names[i].name);
+        prefixIndex.push_back({ (uint32_t) foldedPool.size(), (uint32_t) key.length(), i });
+        foldedPool += key;
+    }
+
+    auto keyOrder = [this](const PrefixIndexEntry& a, const PrefixIndexEntry& b)
+    {
+        return foldedPool.compare(a.key, a.length, foldedPool, b.key, b.length) < 0;
+    };
+    std::sort(prefixIndex.begin(), prefixIndex.end(), keyOrder);
+    prefixIndexValid.store(true, std::memory_order_release);
+}
+
+// Compare the first length characters of the key of an entry with s
+int NameDatabase::compareKey(const PrefixIndexEntry& entry, const std::string& s, size_t length) const
+{
+    return foldedPool.compare(entry.key, std::min((size_t) entry.length, length), s);
+}
+
+std::vector<std::string> NameDatabase::getCompletion(const std::string& name, bool greek, size_t maxCompletions) const
 {
     if (greek)
     {
         auto compList = getGreekCompletion(name);
         compList.push_back(name);
-        return getCompletion(compList);
+        return getCompletion(compList, maxCompletions);
     }
 
-    std::vector<std::string> completion;
-    int name_length = UTF8Length(name);
+    return getCompletion(std::vector<std::string>{ name }, maxCompletions);
+}
+
+std::vector<std::string> NameDatabase::getCompletion(const std::vector<std::string> &list, size_t maxCompletions) const
+{
+    buildPrefixIndex();
+
+    // Folding preserves character boundaries, so the names starting with a
+    // prefix are those whose key starts with the folded prefix, and they
+    // are a contiguous range of the index.
+    std::vector<std::pair<size_t, size_t>> ranges;
+    for (const auto &n : list)
+    {
+        std::string prefix = UTF8FoldCase(n);
+        auto first = std::lower_bound(prefixIndex.begin(), prefixIndex.end(), prefix,
+                                      [this](const PrefixIndexEntry& e, const std::string& s) { return compareKey(e, s, e.length) < 0; });
+        auto last = std::partition_point(first, prefixIndex.end(),
+                                         [this, &prefix](const PrefixIndexEntry& e) { return compareKey(e, prefix, prefix.length()) == 0; });
+        if (first != last)
+            ranges.emplace_back(first - prefixIndex.begin(), last - prefixIndex.begin());
+    }
 
-    for (NameIndex::const_iterator iter = nameIndex.begin(); iter != nameIndex.end(); ++iter)
+    // The prefixes may overlap
+    std::sort(ranges.begin(), ranges.end());
+    size_t nMatches = 0;
+    for (size_t i = 0, end = 0; i < ranges.size(); i++)
     {
-        if (!UTF8StringCompare(iter->first, name, name_length, true))
+        ranges[i].first = std::max(ranges[i].first, end);
+        end = std::max(ranges[i].second, end);
+        if (ranges[i].first < ranges[i].second)
+            nMatches += ranges[i].second - ranges[i].first;
+    }
+
+    // Keep the best matches in a heap, with the worst one at the top
+    auto rankOrder = [this](const PrefixIndexEntry* a, const PrefixIndexEntry* b)
+    {
+        if (a->length != b->length)
+            return a->length < b->length;
+        return foldedPool.compare(a->key, a->length, foldedPool, b->key, b->length) < 0;
+    };
+    std::vector<const PrefixIndexEntry*> matches;
+    matches.reserve(std::min(nMatches, maxCompletions));
+    for (const auto& range : ranges)
+    {
+        for (size_t i = range.first; i < range.second; i++)
         {
-            completion.push_back(iter->first);
+            const PrefixIndexEntry* entry = &prefixIndex[i];
+            if (matches.size() < maxCompletions)
+            {
+                matches.push_back(entry);
+                std::push_heap(matches.begin(), matches.end(), rankOrder);
+            }
+            else if (!matches.empty() && rankOrder(entry, matches.front()))
+            {
+                std::pop_heap(matches.begin(), matches.end(), rankOrder);
+                matches.back() = entry;
+                std::push_heap(matches.begin(), matches.end(), rankOrder);
+            }
         }
     }
-    return completion;
-}
+    std::sort_heap(matches.begin(), matches.end(), rankOrder);
 
-std::vector<std::string> NameDatabase::getCompletion(const std::vector<std::string> &list) const
-{
     std::vector<std::string> completion;
-    for (const auto &n : list)
-    {
-        for (const auto &nn : getCompletion(n, false))
-            completion.emplace_back(nn);
-    }
+    completion.reserve(matches.size());
+    for (const auto* match : matches)
+        completion.push_back(namePool.c_str() + names[match->entry].name);
     return completion;
 }
@@ -12,9 +12,11 @@
 
 #pragma once
 
+#include <atomic>
+#include <cstdint>
 #include <string>
 #include <iostream>
-#include <map>
+#include <mutex>
 #include <vector>
 #include <celutil/debug.h>
 #include <celutil/util.h>
@@ -26,8 +28,12 @@
 class NameDatabase
 {
  public:
-    typedef std::map<std::string, AstroCatalog::IndexNumber, CompareIgnoringCasePredicate> NameIndex;
-    typedef std::multimap<AstroCatalog::IndexNumber, std::string> NumberIndex;
+    struct NumberIndexEntry
+    {
+        AstroCatalog::IndexNumber catalogNumber;
+        uint32_t name;              // offset of the name in the name pool
+    };
+    typedef std::vector<NumberIndexEntry> NumberIndex;
 
  public:
     NameDatabase() {};
@@ -45,12 +51,70 @@ class NameDatabase
 
     NumberIndex::const_iterator getFirstNameIter(const AstroCatalog::IndexNumber catalogNumber) const;
     NumberIndex::const_iterator getFinalNameIter() const;
+    const char* getName(const NumberIndexEntry& entry) const
+    {
+        return namePool.c_str() + entry.name;
+    }
 
-    std::vector<std::string> getCompletion(const std::string& name, bool greek = true) const;
-    std::vector<std::string> getCompletion(const std::vector<std::string> &list) const;
+    // Return the names starting with any of the given prefixes, ignoring
+    // case; shorter names are returned first, and at most maxCompletions
+    // of them.
+    std::vector<std::string> getCompletion(const std::string& name, bool greek = true,
+                                           size_t maxCompletions = SIZE_MAX) const;
+    std::vector<std::string> getCompletion(const std::vector<std::string> &list,
+                                           size_t maxCompletions = SIZE_MAX) const;
 
- protected:
-    NameIndex   nameIndex;
-    NumberIndex numberIndex;
-};
+ private:
+    struct NameEntry
+    {
+        uint32_t name;              // offset of the name in the name pool
+        uint32_t length;
+        AstroCatalog::IndexNumber catalogNumber;
+    };
+
+    struct PrefixIndexEntry
+    {
+        uint32_t key;               // offset of the case folded name in the folded pool
+        uint32_t length;            // of the case folded name
+        uint32_t entry;             // index of the name in names
+    };
+
+    static uint32_t hashName(const char* name, size_t length);
+    size_t findName(const std::string& name) const;
+    void growNameTable();
+    void sortNumberIndex() const;
+    void buildPrefixIndex() const;
+    int compareKey(const PrefixIndexEntry& entry, const std::string& s, size_t length) const;
+
+    // The text of all names, each one followed by a nul
+    std::string namePool;
 
+    // The names with the catalog number they were last added with, and an
+    // open addressing hash table of indices in names + 1, or 0 for unused
+    // slots. Names are compared ignoring the case of ASCII letters.
+    std::vector<NameEntry> names;
+    std::vector<uint32_t> nameTable;
+
+    // The indices below are updated by lookups, which may be made by
+    // several threads at once, under indexMutex; the flags telling whether
+    // they are up to date are checked first without it. Names can't be
+    // added or erased while lookups are made.
+    mutable std::mutex indexMutex;
+
+    // The names of each catalog number in the order they were added, sorted
+    // by catalog number. Added and erased names are appended and merged in
+    // on the next lookup by number; an erase is recorded as an entry with
+    // the name InvalidName, which drops the names before it.
+    static const uint32_t InvalidName = ~0u;
+    mutable NumberIndex numberIndex;
+    mutable size_t numberIndexSorted{ 0 };
+    mutable std::atomic<bool> numberIndexValid{ true };
+
+    // All names sorted by their case folded form, so that the names with a
+    // prefix are a contiguous range. It's built on the first completion
+    // after names are added, as names are mostly added while loading. The
+    // folded names are kept in a pool like the names.
+    mutable std::string foldedPool;
+    mutable std::vector<PrefixIndexEntry> prefixIndex;
+    mutable std::atomic<bool> prefixIndexValid{ false };
+};
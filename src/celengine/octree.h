@@ -16,6 +16,12 @@
 #include <Eigen/Core>
 #include <Eigen/Geometry>
 #include <celengine/observer.h>
+#include <algorithm>
+#include <atomic>
+#include <cstdint>
+#include <new>
+#include <thread>
+#include <utility>
 #include <vector>
 
 // The DynamicOctree and StaticOctree template arguments are:
@@ -60,6 +66,8 @@ public:
 private:
     typedef std::vector<const OBJ*> ObjectList;
 
+    class NodeArena;
+    struct InsertTask;
 
     typedef bool (LimitingFactorPredicate)     (const OBJ&, const float);
     typedef bool (StraddlingPredicate)         (const Eigen::Matrix<PREC, 3, 1>&, const OBJ&, const float);
@@ -71,8 +79,12 @@ private:
     ~DynamicOctree();
 
     void insertObject  (const OBJ&, const PREC);
+    void insertObjects (const std::vector<const OBJ*>&, const PREC, unsigned int nThreads);
     void rebuildAndSort(StaticOctree<OBJ, PREC>*&, OBJ*&);
 
+    // Append the objects in the order in which rebuildAndSort() will place them
+    void getSortedObjects(std::vector<const OBJ*>&) const;
+
  private:
    static unsigned int SPLIT_THRESHOLD;
 
@@ -81,34 +93,165 @@ private:
    static ExclusionFactorDecayFunction* decayFunction;
 
  private:
+    DynamicOctree(const PointType& cellCenterPos,
+                  const float      exclusionFactor,
+                  NodeArena*       arena);
+    DynamicOctree(const DynamicOctree&) = delete;
+    DynamicOctree& operator=(const DynamicOctree&) = delete;
+
     void           add  (const OBJ&);
     void           split(const PREC);
     void           sortIntoChildNodes();
+    void           route(const ObjectList&, const PREC, size_t, std::vector<InsertTask>&);
     DynamicOctree* getChild(const OBJ&, const Eigen::Matrix<PREC, 3, 1>&);
 
-    DynamicOctree**            _children;
+    // The eight children are stored consecutively in an arena block
+    DynamicOctree*             _children;
     Eigen::Matrix<PREC, 3, 1>  cellCenterPos;
     PREC                       exclusionFactor;
-    ObjectList*                _objects;
+    ObjectList                 _objects;
+    // Arena the children of this node are allocated from
+    NodeArena*                 _arena;
+    // List of all arenas of the tree; only set for the root node
+    NodeArena*                 _ownedArenas;
 };
 
 
+// Nodes other than the root are constructed in blocks of eight children
+// taken from an arena, and are all destroyed along with the root. Each
+// thread building part of the tree uses an arena of its own.
+template <class OBJ, class PREC>
+class DynamicOctree<OBJ, PREC>::NodeArena
+{
+ public:
+    explicit NodeArena(NodeArena* next) : next(next) {};
+    ~NodeArena()
+    {
+        for (size_t i = 0; i < blocks.size(); ++i)
+        {
+            unsigned int nNodes = i + 1 == blocks.size() ? used : BlockSize;
+            for (unsigned int j = 0; j < nNodes; ++j)
+                blocks[i][j].~DynamicOctree();
+            ::operator delete(blocks[i]);
+        }
+    }
 
+    // Return uninitialized storage for eight nodes
+    DynamicOctree* allocate()
+    {
+        if (blocks.empty() || used == BlockSize)
+        {
+            blocks.push_back(static_cast<DynamicOctree*>(::operator new(BlockSize * sizeof(DynamicOctree))));
+            used = 0;
+        }
 
+        DynamicOctree* children = blocks.back() + used;
+        used += 8;
+        return children;
+    }
 
-template <class OBJ, class PREC> class StaticOctree
+    NodeArena* next;
+
+ private:
+    static const unsigned int BlockSize = 8 * 64;
+
+    std::vector<DynamicOctree*> blocks;
+    unsigned int used{ 0 };
+};
+
+
+// A subtree filled by a single thread with the objects it receives in the
+// serial build.
+template <class OBJ, class PREC>
+struct DynamicOctree<OBJ, PREC>::InsertTask
+{
+    DynamicOctree* node;
+    ObjectList     objects;
+    PREC           scale;
+};
+
+
+// The five planes of the view frustum, packed so that a node can be tested
+// against all of them at once. With vectorization enabled, Eigen evaluates
+// the test with a few SSE/AVX/NEON instructions; otherwise it falls back
+// to scalar code.
+template <class PREC> class OctreeFrustum
 {
- friend class DynamicOctree<OBJ, PREC>;
+ public:
+    explicit OctreeFrustum(const Eigen::Hyperplane<PREC, 3>* frustumPlanes)
+    {
+        // Unused lanes hold null planes which never cull anything
+        nx.setZero(); ny.setZero(); nz.setZero(); offset.setZero(); absSum.setZero();
+        for (int i = 0; i < 5; ++i)
+        {
+            const Eigen::Matrix<PREC, 3, 1>& normal = frustumPlanes[i].normal();
+            nx[i]     = normal.x();
+            ny[i]     = normal.y();
+            nz[i]     = normal.z();
+            offset[i] = frustumPlanes[i].offset();
+            absSum[i] = normal.cwiseAbs().sum();
+        }
+    }
+
+    // Return true if a cubic node with the given center and half size lies
+    // entirely outside one of the planes.
+    bool cullsNode(const Eigen::Matrix<PREC, 3, 1>& cellCenterPos, PREC scale) const
+    {
+        // Sum in the same order as Hyperplane::signedDistance() so that
+        // the nodes culled are exactly those of the per plane test.
+        PlaneArray distance = nx * cellCenterPos.x() + (ny * cellCenterPos.y() + nz * cellCenterPos.z()) + offset;
+        return (distance + absSum * scale < (PREC) 0).any();
+    }
+
+ private:
+    typedef Eigen::Array<PREC, 8, 1> PlaneArray;
 
+    PlaneArray nx;
+    PlaneArray ny;
+    PlaneArray nz;
+    PlaneArray offset;
+    PlaneArray absSum;
+};
+
+
+// Copies of the object fields used by the visible object traversal, stored
+// by a StaticOctree in the order of its sorted objects. Object types can
+// specialize this to allow vectorized culling; nothing is stored by default.
+template <class OBJ> class OctreeHotData
+{
+ public:
+    void build(const OBJ* /*objects*/, uint32_t /*nObjects*/) {};
+};
+
+
+template <class OBJ, class PREC> class StaticOctree
+{
  public:
     typedef Eigen::Matrix<PREC, 3, 1> PointType;
 
+    // The nodes are stored in a single array in breadth-first order, with
+    // the eight children of a node stored consecutively starting at
+    // firstChild; firstChild is zero for leaf nodes, as the root can't be a
+    // child. Objects are referenced by their index in the sorted object
+    // array, where the objects of a node are followed by the ones of its
+    // subtrees. The same layout is used to store a prebuilt octree in a file.
+    struct Node
+    {
+        PointType    cellCenterPos;
+        float        exclusionFactor;
+        uint32_t     firstObject;
+        uint32_t     nObjects;
+        uint32_t     firstChild;
+    };
+
  public:
-    StaticOctree(const PointType&    cellCenterPos,
-                 const float         exclusionFactor,
-                 OBJ*                _firstObject,
-                 unsigned int        nObjects);
-    ~StaticOctree();
+    StaticOctree(std::vector<Node>&& nodes, OBJ* objects);
+
+    // Create an octree from a node table read from a file; nullptr is
+    // returned if the nodes don't describe a valid tree over nObjects objects.
+    static StaticOctree* create(std::vector<Node>&& nodes,
+                                OBJ* objects,
+                                uint32_t nObjects);
 
     // These methods are only declared at the template level; we'll implement them as
     // full specializations, allowing for different traversal strategies depending on the
@@ -133,29 +276,72 @@ template <class OBJ, class PREC> class StaticOctree
                              PREC                               boundingRadius,
                              PREC                               scale) const;
 
+    // A part of the visible object traversal: either the objects of a
+    // single node, or a whole subtree.
+    struct TraversalTask
+    {
+        uint32_t node;
+        PREC     scale;
+        bool     subtree;
+        uint32_t level;   // depth of node in the tree
+    };
+
+    // Split the traversal done by processVisibleObjects() into at least
+    // nTasks parts when possible, listed in traversal order. Processing all
+    // of them in that order with processVisibleTask() passes the same
+    // objects to the processor as processVisibleObjects() does, and the
+    // parts can be processed concurrently with different processors. The
+    // statistics of each part can be gathered separately and merged with
+    // mergeStatistics().
+    void splitVisibleObjects(std::vector<TraversalTask>&       tasks,
+                             const PointType&                  obsPosition,
+                             const Eigen::Hyperplane<PREC, 3>* frustumPlanes,
+                             float                             limitingFactor,
+                             PREC                              scale,
+                             size_t                            nTasks) const;
+
+    void processVisibleTask(const TraversalTask&              task,
+                            OctreeProcessor<OBJ, PREC>&       processor,
+                            const PointType&                  obsPosition,
+                            const Eigen::Hyperplane<PREC, 3>* frustumPlanes,
+                            float                             limitingFactor,
+                            OctreeProcStats *                 stats = nullptr) const;
+    static void mergeStatistics(OctreeProcStats&       stats,
+                                const TraversalTask&   task,
+                                const OctreeProcStats& taskStats);
+
     int countChildren() const;
     int countObjects()  const;
 
-    void computeStatistics(std::vector<OctreeLevelStatistics>& stats, unsigned int level = 0);
+    void computeStatistics(std::vector<OctreeLevelStatistics>& stats);
+
+    const std::vector<Node>& getNodes() const { return nodes; }
 
  private:
+    void processVisibleNode(uint32_t                          node,
+                            OctreeProcessor<OBJ, PREC>&       processor,
+                            const PointType&                  obsPosition,
+                            const OctreeFrustum<PREC>&        frustum,
+                            float                             limitingFactor,
+                            PREC                              scale,
+                            OctreeProcStats *                 stats,
+                            bool                              processChildren) const;
+
+    void processCloseNode(uint32_t                           node,
+                          OctreeProcessor<OBJ, PREC>&        processor,
+                          const PointType&                   obsPosition,
+                          PREC                               boundingRadius,
+                          PREC                               scale) const;
+
     static const PREC SQRT3;
 
  private:
-    StaticOctree** _children;
-    Eigen::Matrix<PREC, 3, 1>   cellCenterPos;
-    float          exclusionFactor;
-    OBJ*           _firstObject;
-    unsigned int   nObjects;
+    std::vector<Node>   nodes;
+    OBJ*                _objects;
+    OctreeHotData<OBJ>  hotData;
 };
 
 
-
-
-
-
-
-
 // There are two classes implemented in this module: StaticOctree and
 // DynamicOctree.  The DynamicOctree is built first by inserting
 // objects from a database or catalog and is then 'compiled' into a StaticOctree.
@@ -180,7 +366,21 @@ inline DynamicOctree<OBJ, PREC>::DynamicOctree(const Eigen::Matrix<PREC, 3, 1>&
     _children      (nullptr),
     cellCenterPos  (cellCenterPos),
     exclusionFactor(exclusionFactor),
-    _objects       (nullptr)
+    _arena         (new NodeArena(nullptr)),
+    _ownedArenas   (_arena)
+{
+}
+
+
+template <class OBJ, class PREC>
+inline DynamicOctree<OBJ, PREC>::DynamicOctree(const PointType& cellCenterPos,
+                                               const float      exclusionFactor,
+                                               NodeArena*       arena):
+    _children      (nullptr),
+    cellCenterPos  (cellCenterPos),
+    exclusionFactor(exclusionFactor),
+    _arena         (arena),
+    _ownedArenas   (nullptr)
 {
 }
 
@@ -188,16 +388,12 @@ inline DynamicOctree<OBJ, PREC>::DynamicOctree(const Eigen::Matrix<PREC, 3, 1>&
 template <class OBJ, class PREC>
 inline DynamicOctree<OBJ, PREC>::~DynamicOctree()
 {
-    if (_children != nullptr)
+    while (_ownedArenas != nullptr)
     {
-        for (int i = 0; i < 8; ++i)
-        {
-            delete _children[i];
-        }
-
-        delete[] _children;
+        NodeArena* next = _ownedArenas->next;
+        delete _ownedArenas;
+        _ownedArenas = next;
     }
-    delete _objects;
 }
 
 
@@ -219,7 +415,7 @@ inline void DynamicOctree<OBJ, PREC>::insertObject(const OBJ& obj, const PREC sc
         if (_children == nullptr)
         {
             // Make sure that there's enough room left in this node
-            if (_objects != nullptr && _objects->size() >= DynamicOctree<OBJ, PREC>::SPLIT_THRESHOLD)
+            if (_objects.size() >= DynamicOctree<OBJ, PREC>::SPLIT_THRESHOLD)
                 split(scale * 0.5f);
             add(obj);
         }
@@ -231,20 +427,111 @@ inline void DynamicOctree<OBJ, PREC>::insertObject(const OBJ& obj, const PREC sc
 }
 
 
+// Insert a list of objects, building the subtrees in parallel. As the
+// placement of an object depends on the objects inserted before it, the
+// objects are first routed down from this node exactly as insertObject()
+// would do, until the lists of objects destined to each subtree are small
+// enough. Every subtree then receives its objects in the original order,
+// so the result is identical to inserting the objects one by one.
 template <class OBJ, class PREC>
-inline void DynamicOctree<OBJ, PREC>::add(const OBJ& obj)
+void DynamicOctree<OBJ, PREC>::insertObjects(const std::vector<const OBJ*>& objects,
+                                             const PREC scale,
+                                             unsigned int nThreads)
+{
+    // Not worth the thread startup cost for small catalogs
+    const size_t ParallelThreshold = 10000;
+
+    if (nThreads <= 1 || objects.size() < ParallelThreshold || _ownedArenas == nullptr)
+    {
+        for (const OBJ* obj : objects)
+            insertObject(*obj, scale);
+        return;
+    }
+
+    std::vector<InsertTask> tasks;
+    route(objects, scale, std::max(objects.size() / (nThreads * 8), (size_t) 1), tasks);
+
+    // Start with the largest subtrees for a better load balance
+    std::stable_sort(tasks.begin(), tasks.end(),
+                     [](const InsertTask& t0, const InsertTask& t1)
+                     { return t0.objects.size() > t1.objects.size(); });
+    for (auto& task : tasks)
+    {
+        _ownedArenas = new NodeArena(_ownedArenas);
+        task.node->_arena = _ownedArenas;
+    }
+
+    std::atomic<size_t> nextTask(0);
+    auto worker = [&tasks, &nextTask]()
+    {
+        for (size_t i = nextTask++; i < tasks.size(); i = nextTask++)
+        {
+            for (const OBJ* obj : tasks[i].objects)
+                tasks[i].node->insertObject(*obj, tasks[i].scale);
+        }
+    };
+
+    std::vector<std::thread> threads;
+    for (unsigned int i = 1; i < std::min((size_t) nThreads, tasks.size()); ++i)
+        threads.emplace_back(worker);
+    worker();
+    for (auto& thread : threads)
+        thread.join();
+}
+
+
+// Place objects into this node as insertObject() does, but collect the
+// objects destined to child nodes instead of inserting them.
+template <class OBJ, class PREC>
+void DynamicOctree<OBJ, PREC>::route(const ObjectList& objects,
+                                     const PREC scale,
+                                     size_t grainSize,
+                                     std::vector<InsertTask>& tasks)
 {
-    if (_objects == nullptr)
-        _objects = new ObjectList;
+    ObjectList childObjects[8];
+
+    for (const OBJ* obj : objects)
+    {
+        if (limitingFactorPredicate(*obj, exclusionFactor) || straddlingPredicate(cellCenterPos, *obj, exclusionFactor))
+        {
+            add(*obj);
+        }
+        else if (_children == nullptr)
+        {
+            if (_objects.size() >= DynamicOctree<OBJ, PREC>::SPLIT_THRESHOLD)
+                split(scale * 0.5f);
+            add(*obj);
+        }
+        else
+        {
+            childObjects[getChild(*obj, cellCenterPos) - _children].push_back(obj);
+        }
+    }
+
+    for (int i = 0; i < 8; ++i)
+    {
+        if (childObjects[i].empty())
+            continue;
 
-    _objects->push_back(&obj);
+        if (childObjects[i].size() > grainSize)
+            _children[i].route(childObjects[i], scale * (PREC) 0.5, grainSize, tasks);
+        else
+            tasks.push_back(InsertTask{ &_children[i], std::move(childObjects[i]), scale * (PREC) 0.5 });
+    }
+}
+
+
+template <class OBJ, class PREC>
+inline void DynamicOctree<OBJ, PREC>::add(const OBJ& obj)
+{
+    _objects.push_back(&obj);
 }
 
 
 template <class OBJ, class PREC>
 inline void DynamicOctree<OBJ, PREC>::split(const PREC scale)
 {
-    _children = new DynamicOctree*[8];
+    _children = _arena->allocate();
 
     for (int i = 0; i < 8; ++i)
     {
@@ -260,8 +547,9 @@ inline void DynamicOctree<OBJ, PREC>::split(const PREC scale)
         centerPos.z     += ((i & ZPos) != 0) ? scale : -scale;
 #endif
 
-        _children[i] = new DynamicOctree(centerPos,
-                                         decayFunction(exclusionFactor));
+        new (&_children[i]) DynamicOctree(centerPos,
+                                          decayFunction(exclusionFactor),
+                                          _arena);
     }
     sortIntoChildNodes();
 }
@@ -275,14 +563,14 @@ inline void DynamicOctree<OBJ, PREC>::sortIntoChildNodes()
 {
     unsigned int nKeptInParent = 0;
 
-    for (unsigned int i=0; i<_objects->size(); ++i)
+    for (unsigned int i=0; i<_objects.size(); ++i)
     {
-        const OBJ& obj    = *(*_objects)[i];
+        const OBJ& obj    = *_objects[i];
 
         if (limitingFactorPredicate(obj, exclusionFactor) ||
             straddlingPredicate(cellCenterPos, obj, exclusionFactor) )
         {
-            (*_objects)[nKeptInParent++] = (*_objects)[i];
+            _objects[nKeptInParent++] = _objects[i];
         }
         else
         {
@@ -290,96 +578,129 @@ inline void DynamicOctree<OBJ, PREC>::sortIntoChildNodes()
         }
     }
 
-    _objects->resize(nKeptInParent);
+    _objects.resize(nKeptInParent);
 }
 
 
 template <class OBJ, class PREC>
 inline void DynamicOctree<OBJ, PREC>::rebuildAndSort(StaticOctree<OBJ, PREC>*& _staticNode, OBJ*& _sortedObjects)
 {
-    OBJ* _firstObject = _sortedObjects;
+    typedef typename StaticOctree<OBJ, PREC>::Node StaticNode;
+
+    // Lay out the nodes in breadth-first order
+    std::vector<const DynamicOctree*> queue;
+    std::vector<StaticNode> nodes;
+    queue.push_back(this);
+    for (size_t i = 0; i < queue.size(); ++i)
+    {
+        const DynamicOctree* node = queue[i];
 
-    if (_objects != nullptr)
-        for (typename ObjectList::const_iterator iter = _objects->begin(); iter != _objects->end(); ++iter)
+        StaticNode staticNode;
+        staticNode.cellCenterPos   = node->cellCenterPos;
+        staticNode.exclusionFactor = node->exclusionFactor;
+        staticNode.firstObject     = 0;
+        staticNode.nObjects        = (uint32_t) node->_objects.size();
+        staticNode.firstChild      = 0;
+
+        if (node->_children != nullptr)
         {
-            *_sortedObjects++ = **iter;
+            staticNode.firstChild = (uint32_t) queue.size();
+            for (int j = 0; j < 8; ++j)
+                queue.push_back(&node->_children[j]);
         }
 
-    unsigned int nObjects  = (unsigned int) (_sortedObjects - _firstObject);
-    _staticNode            = new StaticOctree<OBJ, PREC>(cellCenterPos, exclusionFactor, _firstObject, nObjects);
+        nodes.push_back(staticNode);
+    }
 
-    if (_children != nullptr)
+    // The objects keep the depth-first order of getSortedObjects(): count
+    // the objects in every subtree, children always following their parent,
+    // then assign each node the start of its range.
+    std::vector<uint32_t> subtreeObjects(nodes.size());
+    for (size_t i = nodes.size(); i-- > 0; )
     {
-        _staticNode->_children    = new StaticOctree<OBJ, PREC>*[8];
-
-        for (int i=0; i<8; ++i)
-            _children[i]->rebuildAndSort(_staticNode->_children[i], _sortedObjects);
+        subtreeObjects[i] = nodes[i].nObjects;
+        if (nodes[i].firstChild != 0)
+        {
+            for (int j = 0; j < 8; ++j)
+                subtreeObjects[i] += subtreeObjects[nodes[i].firstChild + j];
+        }
     }
-}
-
 
-//MS VC++ wants this to be placed here:
-template <class OBJ, class PREC>
-const PREC StaticOctree<OBJ, PREC>::SQRT3 = (PREC) 1.732050807568877;
+    for (size_t i = 0; i < nodes.size(); ++i)
+    {
+        for (uint32_t j = 0; j < nodes[i].nObjects; ++j)
+            _sortedObjects[nodes[i].firstObject + j] = *queue[i]->_objects[j];
 
+        if (nodes[i].firstChild != 0)
+        {
+            uint32_t firstObject = nodes[i].firstObject + nodes[i].nObjects;
+            for (int j = 0; j < 8; ++j)
+            {
+                nodes[nodes[i].firstChild + j].firstObject = firstObject;
+                firstObject += subtreeObjects[nodes[i].firstChild + j];
+            }
+        }
+    }
 
-template <class OBJ, class PREC>
-inline StaticOctree<OBJ, PREC>::StaticOctree(const Eigen::Matrix<PREC, 3, 1>& cellCenterPos,
-                                             const float         exclusionFactor,
-                                             OBJ*                _firstObject,
-                                             unsigned int        nObjects):
-    _children      (nullptr),
-    cellCenterPos  (cellCenterPos),
-    exclusionFactor(exclusionFactor),
-    _firstObject   (_firstObject),
-    nObjects       (nObjects)
-{
+    _staticNode     = new StaticOctree<OBJ, PREC>(std::move(nodes), _sortedObjects);
+    _sortedObjects += subtreeObjects[0];
 }
 
 
 template <class OBJ, class PREC>
-inline StaticOctree<OBJ, PREC>::~StaticOctree()
+inline void DynamicOctree<OBJ, PREC>::getSortedObjects(std::vector<const OBJ*>& sortedObjects) const
 {
+    sortedObjects.insert(sortedObjects.end(), _objects.begin(), _objects.end());
+
     if (_children != nullptr)
     {
         for (int i = 0; i < 8; ++i)
-            delete _children[i];
-
-        delete[] _children;
+            _children[i].getSortedObjects(sortedObjects);
     }
 }
 
 
+//MS VC++ wants this to be placed here:
 template <class OBJ, class PREC>
-inline int StaticOctree<OBJ, PREC>::countChildren() const
+const PREC StaticOctree<OBJ, PREC>::SQRT3 = (PREC) 1.732050807568877;
+
+
+template <class OBJ, class PREC>
+inline StaticOctree<OBJ, PREC>::StaticOctree(std::vector<Node>&& nodes, OBJ* objects):
+    nodes   (std::move(nodes)),
+    _objects(objects)
 {
-    int count    = 0;
+    hotData.build(objects, (uint32_t) countObjects());
+}
 
-    for (int i = 0; i < 8; ++i)
-        count    += _children != nullptr ? 1 + _children[i]->countChildren() : 0;
 
-    return count;
+template <class OBJ, class PREC>
+inline int StaticOctree<OBJ, PREC>::countChildren() const
+{
+    return (int) nodes.size() - 1;
 }
 
 
 template <class OBJ, class PREC>
 inline int StaticOctree<OBJ, PREC>::countObjects() const
 {
-    int count    = nObjects;
+    int count    = 0;
 
-    if (_children != nullptr)
-        for (int i = 0; i < 8; ++i)
-            count    += _children[i]->countObjects();
+    for (const auto& node : nodes)
+        count    += node.nObjects;
 
     return count;
 }
 
 
 template <class OBJ, class PREC>
-void StaticOctree<OBJ, PREC>::computeStatistics(std::vector<OctreeLevelStatistics>& stats, unsigned int level)
+void StaticOctree<OBJ, PREC>::computeStatistics(std::vector<OctreeLevelStatistics>& stats)
 {
-    if (level >= stats.size())
+    std::vector<unsigned int> levels(nodes.size(), 0);
+
+    for (size_t i = 0; i < nodes.size(); ++i)
     {
+        unsigned int level = levels[i];
         while (level >= stats.size())
         {
             OctreeLevelStatistics levelStats;
@@ -388,17 +709,90 @@ void StaticOctree<OBJ, PREC>::computeStatistics(std::vector<OctreeLevelStatistic
             levelStats.size = 0.0;
             stats.push_back(levelStats);
         }
+
+        stats[level].nodeCount++;
+        stats[level].objectCount += nodes[i].nObjects;
+        stats[level].size = 0.0;
+
+        if (nodes[i].firstChild != 0)
+        {
+            for (int j = 0; j < 8; j++)
+                levels[nodes[i].firstChild + j] = level + 1;
+        }
     }
+}
 
-    stats[level].nodeCount++;
-    stats[level].objectCount += nObjects;
-    stats[level].size = 0.0;
 
-    if (_children != nullptr)
+template <class OBJ, class PREC>
+StaticOctree<OBJ, PREC>* StaticOctree<OBJ, PREC>::create(std::vector<Node>&& nodes,
+                                                         OBJ* objects,
+                                                         uint32_t nObjects)
+{
+    // In breadth-first order the child blocks are allocated in the same
+    // order as their parents appear; anything else is a corrupt table.
+    size_t nextChild = 1;
+    for (const auto& node : nodes)
     {
-        for (int i = 0; i < 8; i++)
-            _children[i]->computeStatistics(stats, level + 1);
+        if (node.firstObject > nObjects || node.nObjects > nObjects - node.firstObject)
+            return nullptr;
+        if (node.firstChild != 0)
+        {
+            if (node.firstChild != nextChild)
+                return nullptr;
+            nextChild += 8;
+        }
     }
+    if (nodes.empty() || nextChild != nodes.size())
+        return nullptr;
+
+    return new StaticOctree(std::move(nodes), objects);
+}
+
+
+template <class OBJ, class PREC>
+inline void StaticOctree<OBJ, PREC>::processVisibleObjects(OctreeProcessor<OBJ, PREC>&       processor,
+                                                           const PointType&                  obsPosition,
+                                                           const Eigen::Hyperplane<PREC, 3>* frustumPlanes,
+                                                           float                             limitingFactor,
+                                                           PREC                              scale,
+                                                           OctreeProcStats*                  stats) const
+{
+    OctreeFrustum<PREC> frustum(frustumPlanes);
+    processVisibleNode(0, processor, obsPosition, frustum, limitingFactor, scale, stats, true);
+}
+
+
+template <class OBJ, class PREC>
+inline void StaticOctree<OBJ, PREC>::processVisibleTask(const TraversalTask&              task,
+                                                        OctreeProcessor<OBJ, PREC>&       processor,
+                                                        const PointType&                  obsPosition,
+                                                        const Eigen::Hyperplane<PREC, 3>* frustumPlanes,
+                                                        float                             limitingFactor,
+                                                        OctreeProcStats*                  stats) const
+{
+    OctreeFrustum<PREC> frustum(frustumPlanes);
+    processVisibleNode(task.node, processor, obsPosition, frustum, limitingFactor, task.scale, stats, task.subtree);
+}
+
+
+template <class OBJ, class PREC>
+inline void StaticOctree<OBJ, PREC>::mergeStatistics(OctreeProcStats&       stats,
+                                                     const TraversalTask&   task,
+                                                     const OctreeProcStats& taskStats)
+{
+    stats.nodes   += taskStats.nodes;
+    stats.objects += taskStats.objects;
+    stats.height   = std::max(stats.height, task.level + taskStats.height);
+}
+
+
+template <class OBJ, class PREC>
+inline void StaticOctree<OBJ, PREC>::processCloseObjects(OctreeProcessor<OBJ, PREC>& processor,
+                                                         const PointType&            obsPosition,
+                                                         PREC                        boundingRadius,
+                                                         PREC                        scale) const
+{
+    processCloseNode(0, processor, obsPosition, boundingRadius, scale);
 }
 
 
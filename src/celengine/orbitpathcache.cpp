@@ -0,0 +1,368 @@
+// orbitpathcache.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <celephem/orbit.h>
+#include "orbitpathcache.h"
+#include "orbitsampler.h"
+
+using namespace Eigen;
+using namespace std;
+
+
+// Extra time span sampled on each side of the window of periodic orbits,
+// in periods. A path is extended once the window gets within half of it
+// of an end.
+static const double WindowSlack = 0.2;
+
+// Paths aren't refined beyond this fraction of the orbit size
+static const double MinRelativeTolerance = 1.0e-8;
+static const double MinTolerance = 1.0e-6; // km
+
+// Each sample interval of the orbit is split in at most 2^6 intervals
+static const int MaxRefinementDepth = 6;
+static const size_t MaxPathSamples = 100000;
+
+// About 64 MB of samples
+static const size_t DefaultMaxSamples = 1 << 20;
+
+
+// Tolerances are rounded down to a power of four, so that zooming in
+// refines a path in a few steps rather than on every frame.
+static double toleranceLevel(const Orbit* orbit, double tolerance)
+{
+    tolerance = max(tolerance, orbit->getBoundingRadius() * MinRelativeTolerance);
+    tolerance = max(tolerance, MinTolerance);
+    return pow(4.0, floor(log(tolerance) / log(4.0)));
+}
+
+
+// Split the intervals between samples in two until the midpoint of the
+// cubic through their ends is within tolerance of the orbit, one level at
+// a time so that the positions of each level are computed together, and
+// then the velocities at the midpoints kept.
+static void refineSamples(const Orbit* orbit,
+                          vector<CurvePlotSample>& samples,
+                          double tolerance,
+                          size_t& nComputed)
+{
+    // Whether the interval following a sample is to be tested
+    vector<char> test(samples.size(), 1);
+    vector<double> times;
+    vector<Vector3d> positions;
+    vector<size_t> added;      // indices of the midpoints kept in refined
+    vector<double> addedTimes;
+    vector<Vector3d> velocities;
+
+    for (int depth = 0; depth < MaxRefinementDepth && samples.size() < MaxPathSamples; depth++)
+    {
+        times.clear();
+        for (size_t i = 0; i + 1 < samples.size(); i++)
+        {
+            if (test[i])
+                times.push_back((samples[i].t + samples[i + 1].t) * 0.5);
+        }
+        if (times.empty())
+            break;
+
+        positions.resize(times.size());
+        orbit->positionsAtTimes(times, positions);
+        nComputed += times.size();
+
+        vector<CurvePlotSample> refined;
+        vector<char> refinedTest;
+        refined.reserve(samples.size() + times.size());
+        refinedTest.reserve(samples.size() + times.size());
+        added.clear();
+        addedTimes.clear();
+
+        size_t j = 0;
+        for (size_t i = 0; i < samples.size(); i++)
+        {
+            const CurvePlotSample& s0 = samples[i];
+            refined.push_back(s0);
+            refinedTest.push_back(0);
+            if (i + 1 == samples.size() || !test[i])
+                continue;
+
+            const CurvePlotSample& s1 = samples[i + 1];
+            double dt = s1.t - s0.t;
+            Vector3d interpolated = (s0.position + s1.position) * 0.5 + (s0.velocity - s1.velocity) * (dt / 8.0);
+            const Vector3d& position = positions[j];
+            double t = times[j++];
+            if ((interpolated - position).norm() > tolerance)
+            {
+                CurvePlotSample mid;
+                mid.t = t;
+                mid.position = position;
+                refinedTest.back() = 1;
+                added.push_back(refined.size());
+                addedTimes.push_back(t);
+                refined.push_back(mid);
+                refinedTest.push_back(1);
+            }
+        }
+
+        velocities.resize(addedTimes.size());
+        orbit->velocitiesAtTimes(addedTimes, velocities);
+        for (size_t i = 0; i < added.size(); i++)
+            refined[added[i]].velocity = velocities[i];
+
+        samples.swap(refined);
+        test.swap(refinedTest);
+    }
+}
+
+
+OrbitPathCache::OrbitPathCache(unsigned int _nThreads) :
+    nThreads(max(_nThreads, 1u)),
+    maxSamples(DefaultMaxSamples)
+{
+}
+
+
+OrbitPathCache::~OrbitPathCache()
+{
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    jobQueued.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+
+shared_ptr<const CurvePlot> OrbitPathCache::find(const Orbit* orbit,
+                                                 double startTime,
+                                                 double endTime,
+                                                 double tolerance)
+{
+    tolerance = toleranceLevel(orbit, tolerance);
+
+    lock_guard<std::mutex> lock(mutex);
+    Path& path = paths[orbit];
+    path.lastUsed = frame;
+
+    const CurvePlot* plot = path.plot.get();
+    bool current = plot != nullptr;
+    if (current && !plot->empty())
+    {
+        if (tolerance < path.tolerance)
+        {
+            current = false;
+        }
+        else if (orbit->isPeriodic())
+        {
+            double margin = orbit->getPeriod() * WindowSlack * 0.5;
+            current = plot->startTime() <= startTime - margin && plot->endTime() >= endTime + margin;
+        }
+    }
+
+    if (current)
+    {
+        frameStats.hits++;
+        return path.plot;
+    }
+
+    frameStats.misses++;
+    path.startTime = startTime;
+    path.endTime = endTime;
+    if (path.queued)
+    {
+        path.requestedTolerance = min(path.requestedTolerance, tolerance);
+    }
+    else
+    {
+        path.requestedTolerance = tolerance;
+        path.queued = true;
+        queue.push_back(orbit);
+        if (workers.empty())
+        {
+            for (unsigned int i = 0; i < nThreads; i++)
+                workers.emplace_back(&OrbitPathCache::workerMain, this);
+        }
+        jobQueued.notify_one();
+    }
+
+    return path.plot;
+}
+
+
+OrbitPathStatistics OrbitPathCache::nextFrame()
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    if (nSamples > maxSamples)
+    {
+        vector<pair<uint32_t, const Orbit*>> unused;
+        for (const auto& p : paths)
+        {
+            if (p.second.lastUsed != frame)
+                unused.emplace_back(p.second.lastUsed, p.first);
+        }
+        sort(unused.begin(), unused.end());
+
+        for (const auto& u : unused)
+        {
+            if (nSamples <= maxSamples)
+                break;
+            auto iter = paths.find(u.second);
+            setPlot(iter->second, nullptr);
+            paths.erase(iter);
+            frameStats.evictions++;
+        }
+    }
+
+    OrbitPathStatistics stats = frameStats;
+    stats.samples = nSamples;
+    frameStats = OrbitPathStatistics();
+    frame++;
+
+    return stats;
+}
+
+
+void OrbitPathCache::setMaxSamples(size_t _maxSamples)
+{
+    lock_guard<std::mutex> lock(mutex);
+    maxSamples = _maxSamples;
+}
+
+
+void OrbitPathCache::clear()
+{
+    lock_guard<std::mutex> lock(mutex);
+    paths.clear();
+    queue.clear();
+    nSamples = 0;
+}
+
+
+void OrbitPathCache::setPlot(Path& path, const shared_ptr<const CurvePlot>& plot)
+{
+    if (path.plot != nullptr)
+        nSamples -= path.plot->sampleCount();
+    path.plot = plot;
+    if (path.plot != nullptr)
+        nSamples += path.plot->sampleCount();
+}
+
+
+void OrbitPathCache::workerMain()
+{
+    for (;;)
+    {
+        Job job;
+        {
+            unique_lock<std::mutex> lock(mutex);
+            jobQueued.wait(lock, [this]() { return stopping || !queue.empty(); });
+            if (stopping)
+                return;
+
+            job.orbit = queue.front();
+            queue.pop_front();
+
+            // The path may have been unloaded since
+            auto iter = paths.find(job.orbit);
+            if (iter == paths.end())
+                continue;
+
+            Path& path = iter->second;
+            job.plot = path.plot;
+            job.startTime = path.startTime;
+            job.endTime = path.endTime;
+            job.tolerance = path.requestedTolerance;
+        }
+
+        size_t nComputed = 0;
+        shared_ptr<const CurvePlot> plot(samplePath(job, nComputed));
+
+        lock_guard<std::mutex> lock(mutex);
+        frameStats.pathsSampled++;
+        frameStats.samplesComputed += nComputed;
+
+        auto iter = paths.find(job.orbit);
+        if (iter != paths.end())
+        {
+            Path& path = iter->second;
+            setPlot(path, plot);
+            path.tolerance = job.tolerance;
+            path.queued = false;
+        }
+    }
+}
+
+
+CurvePlot* OrbitPathCache::samplePath(const Job& job, size_t& nComputed)
+{
+    const Orbit* orbit = job.orbit;
+    vector<CurvePlotSample> samples;
+
+    // Append the samples of the orbit over [start, end] following the last one
+    auto sampleOrbit = [&](double start, double end)
+    {
+        OrbitSampler sampler;
+        orbit->sample(start, end, sampler);
+        nComputed += sampler.samples.size();
+        for (const auto& s : sampler.samples)
+        {
+            if (samples.empty() || s.t > samples.back().t)
+                samples.push_back(s);
+        }
+    };
+
+    const CurvePlot* base = job.plot.get();
+    if (!orbit->isPeriodic())
+    {
+        // Trajectories are sampled over their whole span at once
+        if (base != nullptr)
+            samples.assign(base->samples().begin(), base->samples().end());
+        else
+            sampleOrbit(job.startTime, job.endTime);
+    }
+    else
+    {
+        // Keep the samples of the path within the window, and sample the
+        // orbit on either side
+        double slack = orbit->getPeriod() * WindowSlack;
+        double start = job.startTime - slack;
+        double end = job.endTime + slack;
+
+        if (base != nullptr && !base->empty() && base->startTime() < end && base->endTime() > start)
+        {
+            if (start < base->startTime())
+                sampleOrbit(start, base->startTime());
+            for (const auto& s : base->samples())
+            {
+                if (s.t >= start && s.t <= end && (samples.empty() || s.t > samples.back().t))
+                    samples.push_back(s);
+            }
+            if (samples.empty())
+                sampleOrbit(start, end);
+            else if (samples.back().t < end)
+                sampleOrbit(samples.back().t, end);
+        }
+        else
+        {
+            sampleOrbit(start, end);
+        }
+    }
+
+    refineSamples(orbit, samples, job.tolerance, nComputed);
+
+    auto* plot = new CurvePlot();
+    for (const auto& s : samples)
+        plot->addSample(s);
+
+    return plot;
+}
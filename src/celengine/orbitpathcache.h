@@ -0,0 +1,110 @@
+// orbitpathcache.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include "curveplot.h"
+
+class Orbit;
+
+struct OrbitPathStatistics
+{
+    size_t hits{ 0 };            // paths found as requested
+    size_t misses{ 0 };          // paths missing, too coarse or not covering the time span
+    size_t pathsSampled{ 0 };    // paths sampled or refined by the worker threads
+    size_t samplesComputed{ 0 }; // orbit positions computed for them
+    size_t evictions{ 0 };
+    size_t samples{ 0 };         // samples held by the cache
+};
+
+// The paths of orbits, sampled on worker threads so that drawing never
+// waits for them, and shared by all the views of a renderer. An orbit is
+// first sampled the way it chooses, then the path is refined until the
+// cubic drawn between each pair of samples is within a tolerance of the
+// orbit at its midpoint. When a path is drawn closer to the viewer it's
+// refined further rather than sampled again; paths of periodic orbits
+// are extended as time goes on.
+class OrbitPathCache
+{
+ public:
+    explicit OrbitPathCache(unsigned int nThreads = 2);
+    ~OrbitPathCache();
+    OrbitPathCache(const OrbitPathCache&) = delete;
+    OrbitPathCache& operator=(const OrbitPathCache&) = delete;
+
+    // Return the path of orbit over [startTime, endTime], with an error
+    // of at most tolerance km. A path not in the cache that way is
+    // requested, and the one sampled last is returned meanwhile; it may
+    // be coarser or cover another time span, and is null until the orbit
+    // has been sampled. Aperiodic orbits are sampled over the first span
+    // requested only.
+    std::shared_ptr<const CurvePlot> find(const Orbit* orbit,
+                                          double startTime,
+                                          double endTime,
+                                          double tolerance);
+
+    // Unload the least recently used paths while more than maxSamples
+    // samples are held, except those found since the last call, and
+    // return the statistics since the last call.
+    OrbitPathStatistics nextFrame();
+
+    void setMaxSamples(size_t);
+    void clear();
+
+ private:
+    struct Path
+    {
+        std::shared_ptr<const CurvePlot> plot;
+        double tolerance{ 0.0 }; // of plot
+
+        // Requested while a job for the path is queued or running
+        double startTime{ 0.0 };
+        double endTime{ 0.0 };
+        double requestedTolerance{ 0.0 };
+        bool queued{ false };
+
+        uint32_t lastUsed{ 0 };
+    };
+
+    struct Job
+    {
+        const Orbit* orbit;
+        std::shared_ptr<const CurvePlot> plot;
+        double startTime;
+        double endTime;
+        double tolerance;
+    };
+
+    void workerMain();
+    static CurvePlot* samplePath(const Job&, size_t& nComputed);
+    void setPlot(Path&, const std::shared_ptr<const CurvePlot>&);
+
+    unsigned int nThreads;
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable jobQueued;
+    std::deque<const Orbit*> queue;
+    bool stopping{ false };
+
+    std::map<const Orbit*, Path> paths;
+    uint32_t frame{ 0 };
+    size_t nSamples{ 0 };
+    size_t maxSamples;
+    OrbitPathStatistics frameStats;
+};
@@ -0,0 +1,81 @@
+// parsedcatalog.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <memory>
+#include <string>
+#include <vector>
+#include <celutil/memorypool.h>
+#include <celengine/value.h>
+
+// The entries of a text catalog file, tokenized and parsed but not yet
+// added to a database. Parsing depends only on the contents of the file,
+// so several catalogs can be parsed at once on different threads, while
+// adding their entries, which may refer to objects defined by earlier
+// catalogs, is done one catalog at a time in the original order.
+//
+// The parse trees of the entries are allocated from a memory pool, either
+// one set with setPool(), which must outlive the entries, or one of the
+// catalog's own freed all at once with it.
+template <class ENTRY> struct ParsedCatalog
+{
+    ParsedCatalog() = default;
+
+    // The entries must be released before the pool their trees use; when
+    // moved, entries is assigned before the pool.
+    ~ParsedCatalog()
+    {
+        entries.clear();
+    }
+
+    ParsedCatalog(ParsedCatalog&& other) :
+        entries(std::move(other.entries)),
+        error(std::move(other.error)),
+        ownPool(std::move(other.ownPool)),
+        pool(other.pool)
+    {
+        other.pool = nullptr;
+    }
+
+    ParsedCatalog& operator=(ParsedCatalog&& other)
+    {
+        entries = std::move(other.entries);
+        error = std::move(other.error);
+        ownPool = std::move(other.ownPool);
+        pool = other.pool;
+        other.pool = nullptr;
+        return *this;
+    }
+
+    void setPool(MemoryPool* _pool)
+    {
+        pool = _pool;
+    }
+
+    MemoryPool* getPool()
+    {
+        if (pool == nullptr)
+        {
+            ownPool = std::unique_ptr<MemoryPool>(new MemoryPool(sizeof(double), 64 * 1024));
+            pool = ownPool.get();
+        }
+        return pool;
+    }
+
+    std::vector<ENTRY> entries;
+
+    // The error that stopped parsing, reported after the entries read
+    // before it have been added
+    std::string error;
+
+ private:
+    std::unique_ptr<MemoryPool> ownPool;
+    MemoryPool* pool{ nullptr };
+};
@@ -19,12 +19,34 @@ using namespace celmath;
 
 /****** Parser method implementation ******/
 
-Parser::Parser(Tokenizer* _tokenizer) :
-    tokenizer(_tokenizer)
+Parser::Parser(Tokenizer* _tokenizer, MemoryPool* _pool) :
+    tokenizer(_tokenizer),
+    pool(_pool)
 {
 }
 
 
+void Parser::destroy(ValueArray* array)
+{
+    for (auto* v : *array)
+        Value::destroy(v);
+
+    if (pool == nullptr)
+        delete array;
+    else
+        array->~ValueArray();
+}
+
+
+void Parser::destroy(Hash* hash)
+{
+    if (pool == nullptr)
+        delete hash;
+    else
+        hash->~Hash();
+}
+
+
 ValueArray* Parser::readArray()
 {
     Tokenizer::TokenType tok = tokenizer->nextToken();
@@ -34,20 +56,20 @@ ValueArray* Parser::readArray()
         return nullptr;
     }
 
-    ValueArray* array = new ValueArray();
+    ValueArray* array = Value::create<ValueArray>(pool, PoolAllocator<Value*>(pool));
 
-    Value* v = readValue();
+    Value* v = readValue(true);
     while (v != nullptr)
     {
         array->push_back(v);
-        v = readValue();
+        v = readValue(true);
     }
 
     tok = tokenizer->nextToken();
     if (tok != Tokenizer::TokenEndArray)
     {
         tokenizer->pushBack();
-        delete array;
+        destroy(array);
         return nullptr;
     }
 
@@ -64,7 +86,7 @@ Hash* Parser::readHash()
         return nullptr;
     }
 
-    auto* hash = new Hash();
+    auto* hash = Value::create<Hash>(pool, pool);
 
     tok = tokenizer->nextToken();
     while (tok != Tokenizer::TokenEndGroup)
@@ -72,7 +94,7 @@ Hash* Parser::readHash()
         if (tok != Tokenizer::TokenName)
         {
             tokenizer->pushBack();
-            delete hash;
+            destroy(hash);
             return nullptr;
         }
         string name = tokenizer->getNameValue();
@@ -81,10 +103,10 @@ Hash* Parser::readHash()
         readUnits(name, hash);
 #endif
 
-        Value* value = readValue();
+        Value* value = readValue(true);
         if (value == nullptr)
         {
-            delete hash;
+            destroy(hash);
             return nullptr;
         }
 
@@ -126,7 +148,7 @@ bool Parser::readUnits(const string& propertyName, Hash* hash)
         }
 
         string unit = tokenizer->getNameValue();
-        Value* value = new Value(unit);
+        Value* value = Value::create<Value>(pool, unit, pool);
 
         if (astro::isLengthUnit(unit))
         {
@@ -150,7 +172,7 @@ bool Parser::readUnits(const string& propertyName, Hash* hash)
         }
         else
         {
-            delete value;
+            Value::destroy(value);
             return false;
         }
 
@@ -163,20 +185,30 @@ bool Parser::readUnits(const string& propertyName, Hash* hash)
 
 Value* Parser::readValue()
 {
+    return readValue(false);
+}
+
+
+// Read a value; the values nested in arrays and hashes are allocated from
+// the pool along with their contents.
+Value* Parser::readValue(bool nested)
+{
+    MemoryPool* valuePool = nested ? pool : nullptr;
+
     Tokenizer::TokenType tok = tokenizer->nextToken();
     switch (tok)
     {
     case Tokenizer::TokenNumber:
-        return new Value(tokenizer->getNumberValue());
+        return Value::create<Value>(valuePool, tokenizer->getNumberValue());
 
     case Tokenizer::TokenString:
-        return new Value(tokenizer->getStringValue());
+        return Value::create<Value>(valuePool, tokenizer->getStringView(), pool);
 
     case Tokenizer::TokenName:
-        if (tokenizer->getNameValue() == "false")
-            return new Value(false);
-        else if (tokenizer->getNameValue() == "true")
-            return new Value(true);
+        if (tokenizer->getNameView() == "false")
+            return Value::create<Value>(valuePool, false);
+        else if (tokenizer->getNameView() == "true")
+            return Value::create<Value>(valuePool, true);
         else
         {
             tokenizer->pushBack();
@@ -190,7 +222,7 @@ Value* Parser::readValue()
             if (array == nullptr)
                 return nullptr;
             else
-                return new Value(array);
+                return Value::create<Value>(valuePool, array);
         }
 
     case Tokenizer::TokenBeginGroup:
@@ -200,7 +232,7 @@ Value* Parser::readValue()
             if (hash == nullptr)
                 return nullptr;
             else
-                return new Value(hash);
+                return Value::create<Value>(valuePool, hash);
         }
 
     default:
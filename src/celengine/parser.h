@@ -13,20 +13,28 @@
 #include "hash.h"
 #include "value.h"
 
+class MemoryPool;
 class Tokenizer;
 class Value;
 
 class Parser
 {
  public:
-    Parser(Tokenizer*);
+    // If a memory pool is given, the strings, arrays and hashes of the
+    // values read are allocated from it, so it must outlive the values;
+    // only the top level Value is allocated on the heap.
+    Parser(Tokenizer*, MemoryPool* pool = nullptr);
 
     Value* readValue();
 
  private:
     Tokenizer* tokenizer;
+    MemoryPool* pool;
 
+    Value* readValue(bool nested);
     bool readUnits(const std::string&, Hash*);
     Array* readArray();
     Hash* readHash();
+    void destroy(ValueArray*);
+    void destroy(Hash*);
 };
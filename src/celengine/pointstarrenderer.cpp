@@ -32,6 +32,32 @@ PointStarRenderer::PointStarRenderer() :
 {
 }
 
+inline void PointStarRenderer::addStar(const Vector3f& pos, const Color& color, float size)
+{
+    if (batch != nullptr)
+    {
+        batch->stars.emplace_back();
+        batch->stars.back().set(pos, color, size);
+    }
+    else
+    {
+        starVertexBuffer->addStar(pos, color, size);
+    }
+}
+
+inline void PointStarRenderer::addGlare(const Vector3f& pos, const Color& color, float size)
+{
+    if (batch != nullptr)
+    {
+        batch->glares.emplace_back();
+        batch->glares.back().set(pos, color, size);
+    }
+    else
+    {
+        glareVertexBuffer->addStar(pos, color, size);
+    }
+}
+
 void PointStarRenderer::process(const Star& star, float distance, float appMag)
 {
     nProcessed++;
@@ -108,9 +134,11 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
                 float distr = 3.5f * (labelThresholdMag - appMag)/labelThresholdMag;
                 if (distr > 1.0f)
                     distr = 1.0f;
-                renderer->addBackgroundAnnotation(nullptr, starDB->getStarName(star, true),
-                                                  Color(Renderer::StarLabelColor, distr * Renderer::StarLabelColor.alpha()),
-                                                  relPos);
+                Color labelColor(Renderer::StarLabelColor, distr * Renderer::StarLabelColor.alpha());
+                if (batch != nullptr)
+                    batch->labels.push_back(PointStarBatch::Label{ &star, labelColor, relPos });
+                else
+                    renderer->addBackgroundAnnotation(nullptr, starDB->getStarName(star, true), labelColor, relPos);
                 nLabelled++;
             }
         }
@@ -151,11 +179,11 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
                     discSize *= discScale;
 
                     float glareAlpha = min(0.5f, discScale / 4.0f);
-                    glareVertexBuffer->addStar(relPos, Color(starColor, glareAlpha), discSize * 3.0f);
+                    addGlare(relPos, Color(starColor, glareAlpha), discSize * 3.0f);
 
                     alpha = 1.0f;
                 }
-                starVertexBuffer->addStar(relPos, Color(starColor, alpha), discSize);
+                addStar(relPos, Color(starColor, alpha), discSize);
             }
             else
             {
@@ -167,12 +195,12 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
                 {
                     float discScale = min(100.0f, satPoint - appMag + 2.0f);
                     float glareAlpha = min(GlareOpacity, (discScale - 2.0f) / 4.0f);
-                    glareVertexBuffer->addStar(relPos, Color(starColor, glareAlpha), 2.0f * discScale * size);
+                    addGlare(relPos, Color(starColor, glareAlpha), 2.0f * discScale * size);
 #ifdef DEBUG_HDR_ADAPT
                     maxSize = max(maxSize, 2.0f * discScale * size);
 #endif
                 }
-                starVertexBuffer->addStar(relPos, Color(starColor, alpha), size);
+                addStar(relPos, Color(starColor, alpha), size);
             }
 
             ++nRendered;
@@ -197,7 +225,10 @@ void PointStarRenderer::process(const Star& star, float distance, float appMag)
             rle.discSizeInPixels = discSizeInPixels;
             rle.appMag = appMag;
             rle.isOpaque = true;
-            renderList->push_back(rle);
+            if (batch != nullptr)
+                batch->renderList.push_back(rle);
+            else
+                renderList->push_back(rle);
         }
     }
 }
@@ -12,14 +12,56 @@
 
 #include <Eigen/Core>
 #include <vector>
+#include <celutil/color.h>
 #include "objectrenderer.h"
+#include "pointstarvertexbuffer.h"
 #include "renderlistentry.h"
 
 class ColorTemperatureTable;
-class PointStarVertexBuffer;
 class Star;
 class StarDatabase;
 
+// Output of a PointStarRenderer kept in memory instead of being sent to
+// the vertex buffers and the renderer, so that several threads can
+// process stars at the same time. The contents are then submitted in the
+// order in which the stars would have been processed by a single thread.
+struct PointStarBatch
+{
+    struct Label
+    {
+        const Star*     star;
+        Color           color;
+        Eigen::Vector3f position;
+    };
+
+    // Positions in the arrays, marking the output of a part of the work
+    struct Mark
+    {
+        size_t stars;
+        size_t glares;
+        size_t labels;
+        size_t renderList;
+    };
+
+    Mark mark() const
+    {
+        return Mark{ stars.size(), glares.size(), labels.size(), renderList.size() };
+    }
+
+    void clear()
+    {
+        stars.clear();
+        glares.clear();
+        labels.clear();
+        renderList.clear();
+    }
+
+    std::vector<PointStarVertexBuffer::StarVertex> stars;
+    std::vector<PointStarVertexBuffer::StarVertex> glares;
+    std::vector<Label> labels;
+    std::vector<RenderListEntry> renderList;
+};
+
 // TODO: move these variables to PointStarRenderer class
 // without adding a variable. Requires C++17
 constexpr const float StarDistanceLimit     = 1.0e6f;
@@ -42,12 +84,21 @@ class PointStarRenderer : public ObjectRenderer<Star, float>
     PointStarRenderer();
     void process(const Star &star, float distance, float appMag);
 
+ private:
+    inline void addStar(const Eigen::Vector3f& pos, const Color& color, float size);
+    inline void addGlare(const Eigen::Vector3f& pos, const Color& color, float size);
+
+ public:
+
     Eigen::Vector3d obsPos;
     std::vector<RenderListEntry>* renderList    { nullptr };
     PointStarVertexBuffer* starVertexBuffer     { nullptr };
     PointStarVertexBuffer* glareVertexBuffer    { nullptr };
     const StarDatabase* starDB                  { nullptr };
     const ColorTemperatureTable* colorTemp      { nullptr };
+    // When set, output goes to the batch instead of the vertex buffers,
+    // render list and renderer annotations
+    PointStarBatch* batch                       { nullptr };
     float SolarSystemMaxDistance                { 1.0f };
     float maxDiscSize                           { 1.0f };
     float cosFOV                                { 1.0f };
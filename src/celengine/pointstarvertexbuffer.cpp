@@ -8,6 +8,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
 #include "glsupport.h"
 #include <celutil/color.h>
 #include "objectrenderer.h"
@@ -112,6 +113,26 @@ void PointStarVertexBuffer::render()
     }
 }
 
+// Add vertices prepared in advance; the vertices are drawn in the same
+// batches as if they were added one at a time.
+void PointStarVertexBuffer::addStars(const StarVertex* stars, size_t count)
+{
+    while (count > 0)
+    {
+        capacity_t n = (capacity_t) std::min(count, (size_t) (capacity - nStars));
+        std::copy(stars, stars + n, vertices + nStars);
+        nStars += n;
+        stars += n;
+        count -= n;
+
+        if (nStars == capacity)
+        {
+            render();
+            nStars = 0;
+        }
+    }
+}
+
 void PointStarVertexBuffer::finish()
 {
     render();
@@ -10,9 +10,10 @@
 
 #pragma once
 
+#include <cstddef>
 #include <Eigen/Core>
+#include <celutil/color.h>
 
-class Color;
 class Renderer;
 class Texture;
 
@@ -30,22 +31,25 @@ public:
     PointStarVertexBuffer& operator=(const PointStarVertexBuffer&) = delete;
     PointStarVertexBuffer& operator=(PointStarVertexBuffer&&) = delete;
 
-    void startPoints();
-    void startSprites();
-    void render();
-    void finish();
-    inline void addStar(const Eigen::Vector3f& pos, const Color&, float);
-    void setTexture(Texture* /*_texture*/);
-
-private:
     struct StarVertex
     {
+        inline void set(const Eigen::Vector3f& pos, const Color&, float);
+
         Eigen::Vector3f position;
         float size;
         unsigned char color[4];
         float pad;
     };
 
+    void startPoints();
+    void startSprites();
+    void render();
+    void finish();
+    inline void addStar(const Eigen::Vector3f& pos, const Color&, float);
+    void addStars(const StarVertex* stars, size_t count);
+    void setTexture(Texture* /*_texture*/);
+
+private:
     const Renderer& renderer;
     capacity_t capacity;
 
@@ -55,15 +59,22 @@ private:
     bool useSprites         { false };
 };
 
+inline void PointStarVertexBuffer::StarVertex::set(const Eigen::Vector3f& pos,
+                                                   const Color& color,
+                                                   float size)
+{
+    position = pos;
+    this->size = size;
+    color.get(this->color);
+}
+
 inline void PointStarVertexBuffer::addStar(const Eigen::Vector3f& pos,
                                            const Color& color,
                                            float size)
 {
     if (nStars < capacity)
     {
-        vertices[nStars].position = pos;
-        vertices[nStars].size = size;
-        color.get(vertices[nStars].color);
+        vertices[nStars].set(pos, color, size);
         nStars++;
     }
 
@@ -433,7 +433,7 @@ GLSL_RenderContext::makeCurrent(const Material& m)
 
     if (diffuseMap != InvalidResource && (useTexCoords || usePointSize))
     {
-        baseTex = GetTextureManager()->find(diffuseMap);
+        baseTex = GetTextureManager()->find(diffuseMap, texturePriority);
         if (baseTex != nullptr)
         {
             shaderProps.texUsage |= ShaderProperties::DiffuseTexture;
@@ -443,7 +443,7 @@ GLSL_RenderContext::makeCurrent(const Material& m)
 
     if (normalMap != InvalidResource)
     {
-        bumpTex = GetTextureManager()->find(normalMap);
+        bumpTex = GetTextureManager()->find(normalMap, texturePriority);
         if (bumpTex != nullptr)
         {
             shaderProps.texUsage |= ShaderProperties::NormalTexture;
@@ -458,7 +458,7 @@ GLSL_RenderContext::makeCurrent(const Material& m)
     if (m.specular != Material::Color(0.0f, 0.0f, 0.0f) && useNormals)
     {
         shaderProps.lightModel = ShaderProperties::PerPixelSpecularModel;
-        specTex = GetTextureManager()->find(specularMap);
+        specTex = GetTextureManager()->find(specularMap, texturePriority);
         if (specTex == nullptr)
         {
             if (baseTex != nullptr)
@@ -473,7 +473,7 @@ GLSL_RenderContext::makeCurrent(const Material& m)
 
     if (emissiveMap != InvalidResource)
     {
-        emissiveTex = GetTextureManager()->find(emissiveMap);
+        emissiveTex = GetTextureManager()->find(emissiveMap, texturePriority);
         if (emissiveTex != nullptr)
         {
             shaderProps.texUsage |= ShaderProperties::EmissiveTexture;
@@ -720,7 +720,7 @@ GLSLUnlit_RenderContext::makeCurrent(const Material& m)
     ResourceHandle diffuseMap = GetTextureHandle(m.maps[Material::DiffuseMap]);
     if (diffuseMap != InvalidResource && (useTexCoords || usePointSize))
     {
-        baseTex = GetTextureManager()->find(diffuseMap);
+        baseTex = GetTextureManager()->find(diffuseMap, texturePriority);
         if (baseTex != nullptr)
         {
             shaderProps.texUsage |= ShaderProperties::DiffuseTexture;
@@ -49,6 +49,10 @@ class RenderContext
     void setPointScale(float);
     float getPointScale() const;
 
+    // Priority of loading the textures of materials in the background,
+    // such as the size on screen of the object rendered
+    void setTexturePriority(float priority) { texturePriority = priority; }
+
     void setCameraOrientation(const Eigen::Quaternionf& q);
     Eigen::Quaternionf getCameraOrientation() const;
 
@@ -65,6 +69,7 @@ class RenderContext
     bool useNormals{ true };
     bool useColors{ false };
     bool useTexCoords{ true };
+    float texturePriority{ 0.0f };
 };
 
 
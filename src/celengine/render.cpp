@@ -10,7 +10,6 @@
 
 #define DEBUG_COALESCE               0
 #define DEBUG_SECONDARY_ILLUMINATION 0
-#define DEBUG_ORBIT_CACHE            0
 
 //#define DEBUG_HDR
 #ifdef DEBUG_HDR
@@ -47,6 +46,8 @@ std::ofstream hdrlog;
 #include "geometry.h"
 #include "texmanager.h"
 #include "meshmanager.h"
+#include "galaxy.h"
+#include "globular.h"
 #include "renderinfo.h"
 #include "renderglsl.h"
 #include "axisarrow.h"
@@ -60,7 +61,7 @@ std::ofstream hdrlog;
 #include "framebuffer.h"
 #include "pointstarvertexbuffer.h"
 #include "pointstarrenderer.h"
-#include "orbitsampler.h"
+#include "orbitpathcache.h"
 #include "asterismrenderer.h"
 #include "boundariesrenderer.h"
 #include "rendcontext.h"
@@ -75,6 +76,8 @@ std::ofstream hdrlog;
 #include <celutil/utf8.h>
 #include <celutil/util.h>
 #include <celutil/timer.h>
+#include <celutil/threadpool.h>
+#include <celutil/profiler.h>
 #if NO_TTF
 #include <celtxf/texturefont.h>
 #else
@@ -82,6 +85,7 @@ std::ofstream hdrlog;
 #endif
 #include "glsupport.h"
 #include <algorithm>
+#include <chrono>
 #include <cstring>
 #include <cassert>
 #include <sstream>
@@ -161,10 +165,8 @@ static const int MaxSkyRings = 32;
 static const int MaxSkySlices = 180;
 static const int MinSkySlices = 30;
 
-// Size at which the orbit cache will be flushed of old orbit paths
-static const unsigned int OrbitCacheCullThreshold = 200;
-// Age in frames at which unused orbit paths may be eliminated from the cache
-static const uint32_t OrbitCacheRetireAge = 16;
+// Largest error of orbit paths, in pixels
+static const double OrbitPathMaxError = 0.5;
 
 Color Renderer::StarLabelColor          (0.471f, 0.356f, 0.682f);
 Color Renderer::PlanetLabelColor        (0.407f, 0.333f, 0.964f);
@@ -262,7 +264,7 @@ Renderer::Renderer() :
     glareVertexBuffer(nullptr),
     textureResolution(medres),
     frameCount(0),
-    lastOrbitCacheFlush(0),
+    orbitPathCache(new OrbitPathCache()),
     minOrbitSize(MinOrbitSizeForLabel),
     distanceLimit(1.0e6f),
     minFeatureSize(MinFeatureSizeForLabel),
@@ -311,8 +313,14 @@ Renderer::Renderer() :
 
 Renderer::~Renderer()
 {
+    Galaxy::stopLoadingForms();
+    Globular::stopLoadingForms();
+
     delete pointStarVertexBuffer;
     delete glareVertexBuffer;
+    delete renderThreadPool;
+    delete orbitPathCache;
+    delete[] starBatches;
     delete[] skyVertices;
     delete[] skyIndices;
     delete[] skyContour;
@@ -341,12 +349,13 @@ Renderer::~Renderer()
 
 
 Renderer::DetailOptions::DetailOptions() :
-    orbitPathSamplePoints(100),
     shadowTextureSize(256),
     eclipseTextureSize(128),
     orbitWindowEnd(0.5),
     orbitPeriodsShown(1.0),
-    linearFadeFraction(0.0)
+    linearFadeFraction(0.0),
+    backgroundLoading(false),
+    resourceCreationTime(0.005)
 {
 }
 
@@ -603,6 +612,11 @@ bool Renderer::init(
         commonDataInitialized = true;
     }
 
+    // Textures and models may be read on other threads, then be made into
+    // OpenGL objects at the start of each frame.
+    GetTextureManager()->setBackgroundLoading(detailOptions.backgroundLoading);
+    GetGeometryManager()->setBackgroundLoading(detailOptions.backgroundLoading);
+
 #ifdef USE_HDR
     Image        *testImg = new Image(GL_LUMINANCE_ALPHA, 1, 1);
     ImageTexture *testTex = new ImageTexture(*testImg,
@@ -1085,84 +1099,6 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
     else
         orbit = orbitPath.star->getOrbit();
 
-    CurvePlot* cachedOrbit = nullptr;
-    OrbitCache::iterator cached = orbitCache.find(orbit);
-    if (cached != orbitCache.end())
-    {
-        cachedOrbit = cached->second;
-        cachedOrbit->setLastUsed(frameCount);
-    }
-
-    // If it's not in the cache already
-    if (cachedOrbit == nullptr)
-    {
-        double startTime = t;
-        int nSamples = detailOptions.orbitPathSamplePoints;
-
-        // Adjust the number of samples used for aperiodic orbits--these aren't
-        // true orbits, but are sampled trajectories, generally of spacecraft.
-        // Better control is really needed--some sort of adaptive sampling would
-        // be ideal.
-        if (!orbit->isPeriodic())
-        {
-            double begin = 0.0, end = 0.0;
-            orbit->getValidRange(begin, end);
-
-            if (begin != end)
-            {
-                startTime = begin;
-                nSamples = (int) (orbit->getPeriod() * 100.0);
-                nSamples = max(min(nSamples, 1000), 100);
-            }
-            else
-            {
-                // If the orbit is aperiodic and doesn't have a
-                // finite duration, we don't render it. A compromise
-                // would be to pick some time window centered at the
-                // current time, but we'd have to pick some arbitrary
-                // duration.
-                nSamples = 0;
-            }
-        }
-        else
-        {
-            startTime = t - orbit->getPeriod();
-        }
-
-        cachedOrbit = new CurvePlot();
-        cachedOrbit->setLastUsed(frameCount);
-
-        OrbitSampler sampler;
-        orbit->sample(startTime,
-                      startTime + orbit->getPeriod(),
-                      sampler);
-        sampler.insertForward(cachedOrbit);
-
-        // If the orbit cache is full, first try and eliminate some old orbits
-        if (orbitCache.size() > OrbitCacheCullThreshold)
-        {
-            // Check for old orbits at most once per frame
-            if (lastOrbitCacheFlush != frameCount)
-            {
-                for (auto iter = orbitCache.begin(); iter != orbitCache.end();)
-                {
-                    // Tricky code to eliminate a node in the orbit cache without screwing
-                    // up the iterator. Should work in all STL implementations.
-                    if (frameCount - iter->second->lastUsed() > OrbitCacheRetireAge)
-                        orbitCache.erase(iter++);
-                    else
-                        ++iter;
-                }
-                lastOrbitCacheFlush = frameCount;
-            }
-        }
-
-        orbitCache[orbit] = cachedOrbit;
-    }
-
-    if (cachedOrbit->empty())
-        return;
-
     //*** Orbit rendering parameters
 
     // The 'window' is the interval of time for which the orbit will be drawn.
@@ -1182,57 +1118,50 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
     // The default value is 0.0.
     const double LinearFadeFraction = detailOptions.linearFadeFraction;
 
-    // Extra size of the internal sample cache.
-    const double WindowSlack        = 0.2;
-
     //***
 
-    // 'Periodic' orbits are generally not strictly periodic because of perturbations
-    // from other bodies. Here we update the trajectory samples to make sure that the
-    // orbit covers a time range centered at the current time and covering a full revolution.
+    double startTime, endTime;
     if (orbit->isPeriodic())
     {
         double period = orbit->getPeriod();
-        double endTime = t + period * OrbitWindowEnd;
-        double startTime = endTime - period * OrbitPeriodsShown;
-
-        double currentWindowStart = cachedOrbit->startTime();
-        double currentWindowEnd = cachedOrbit->endTime();
-        double newWindowStart = startTime - period * WindowSlack;
-        double newWindowEnd = endTime + period * WindowSlack;
+        endTime = t + period * OrbitWindowEnd;
+        startTime = endTime - period * OrbitPeriodsShown;
+    }
+    else
+    {
+        // Aperiodic orbits aren't true orbits, but are sampled trajectories,
+        // generally of spacecraft. If the orbit doesn't have a finite
+        // duration, we don't render it. A compromise would be to pick some
+        // time window centered at the current time, but we'd have to pick
+        // some arbitrary duration.
+        orbit->getValidRange(startTime, endTime);
+        if (startTime == endTime)
+            return;
+        endTime = startTime + orbit->getPeriod();
+    }
+
+    // The path is sampled finely enough to be drawn within a fraction of a
+    // pixel where the orbit comes closest to the viewer.
+    double distance = max(orbitPath.origin.norm() - orbit->getBoundingRadius(), 0.0);
+    double tolerance = distance * pixelSize * OrbitPathMaxError;
+
+    // The orbit isn't drawn until it has been sampled
+    shared_ptr<const CurvePlot> cachedOrbit = orbitPathCache->find(orbit, startTime, endTime, tolerance);
+    if (cachedOrbit == nullptr || cachedOrbit->empty())
+        return;
 
-        if (startTime < currentWindowStart)
-        {
-            // Remove samples at the end of the time window
-            cachedOrbit->removeSamplesAfter(newWindowEnd);
-
-            // Trim the first sample (because it will be duplicated when we sample the orbit.)
-            cachedOrbit->removeSamplesBefore(cachedOrbit->startTime() * (1.0 + 1.0e-15));
-
-            // Add the new samples
-            OrbitSampler sampler;
-            orbit->sample(newWindowStart, min(currentWindowStart, newWindowEnd), sampler);
-            sampler.insertBackward(cachedOrbit);
-#if DEBUG_ORBIT_CACHE
-            clog << "new sample count: " << cachedOrbit->sampleCount() << endl;
-#endif
-        }
-        else if (endTime > currentWindowEnd)
-        {
-            // Remove samples at the beginning of the time window
-            cachedOrbit->removeSamplesBefore(newWindowStart);
-
-            // Trim the last sample (because it will be duplicated when we sample the orbit.)
-            cachedOrbit->removeSamplesAfter(cachedOrbit->endTime() * (1.0 - 1.0e-15));
-
-            // Add the new samples
-            OrbitSampler sampler;
-            orbit->sample(max(currentWindowEnd, newWindowStart), newWindowEnd, sampler);
-            sampler.insertForward(cachedOrbit);
-#if DEBUG_ORBIT_CACHE
-            clog << "new sample count: " << cachedOrbit->sampleCount() << endl;
-#endif
-        }
+    // 'Periodic' orbits are generally not strictly periodic because of
+    // perturbations from other bodies, so the path is sampled again as
+    // time goes on. Until the new samples are ready, a window the path
+    // doesn't cover is drawn a whole number of periods earlier or later.
+    double timeShift = 0.0;
+    if (orbit->isPeriodic())
+    {
+        double period = orbit->getPeriod();
+        if (endTime > cachedOrbit->endTime())
+            timeShift = period * ceil((endTime - cachedOrbit->endTime()) / period);
+        else if (startTime < cachedOrbit->startTime())
+            timeShift = -period * ceil((cachedOrbit->startTime() - startTime) / period);
     }
 
     // We perform vertex tranformations on the CPU because double precision is necessary to
@@ -1275,9 +1204,8 @@ void Renderer::renderOrbit(const OrbitPathListEntry& orbitPath,
     prog->use();
     if (orbit->isPeriodic())
     {
-        double period = orbit->getPeriod();
-        double windowEnd = t + period * OrbitWindowEnd;
-        double windowStart = windowEnd - period * OrbitPeriodsShown;
+        double windowEnd = endTime - timeShift;
+        double windowStart = startTime - timeShift;
         double windowDuration = windowEnd - windowStart;
 
         if (LinearFadeFraction == 0.0f || (renderFlags & ShowFadingOrbits) == 0)
@@ -1530,13 +1458,12 @@ void Renderer::render(const Observer& observer,
 #endif
 }
 
-void Renderer::draw(const Observer& observer,
-                    const Universe& universe,
-                    float faintestMagNight,
-                    const Selection& sel)
+// Set up the state shared by all stages of a frame and clear the lists
+// built by the previous one.
+void Renderer::beginFrame(const Observer& observer,
+                          float faintestMagNight,
+                          const Selection& sel)
 {
-    // Get the observer's time
-    double now = observer.getTime();
     realTime = observer.getRealTime();
 
     frameCount++;
@@ -1556,14 +1483,6 @@ void Renderer::draw(const Observer& observer,
 
     m_cameraOrientation = observer.getOrientationf();
 
-    // Get the view frustum used for culling in camera space.
-    Frustum frustum(degToRad(fov), getAspectRatio(), MinNearPlaneDistance);
-
-    // Get the transformed frustum, used for culling in the astrocentric coordinate
-    // system.
-    Frustum xfrustum(frustum);
-    xfrustum.transform(getCameraOrientation().conjugate().toRotationMatrix());
-
     // Set up the projection and modelview matrices.
     // We'll usethem for positioning star and planet labels.
     m_projMatrix = Perspective(fov, getAspectRatio(), NEAR_DIST, FAR_DIST);
@@ -1595,6 +1514,68 @@ void Renderer::draw(const Observer& observer,
     }
 
     faintestPlanetMag = faintestMag;
+}
+
+// Build the render, orbit and label lists of a frame the way draw() does,
+// but without drawing anything, so that no OpenGL context is required.
+void Renderer::buildFrameLists(const Observer& observer,
+                               const Universe& universe,
+                               float faintestMagNight,
+                               const Selection& sel,
+                               FrameListStats* stats)
+{
+    if (stats != nullptr)
+        *stats = FrameListStats();
+
+    beginFrame(observer, faintestMagNight, sel);
+
+    Frustum xfrustum(degToRad(fov), getAspectRatio(), MinNearPlaneDistance);
+    xfrustum.transform(getCameraOrientation().conjugate().toRotationMatrix());
+
+    if ((renderFlags & (ShowSolarSystemObjects | ShowOrbits)) != 0)
+        buildNearSystemsLists(universe, observer, xfrustum, observer.getTime(), stats);
+
+    if (stats != nullptr)
+    {
+        stats->nRenderListEntries = renderList.size();
+        stats->nOrbitPaths = orbitPathList.size();
+        stats->nLabels = depthSortedAnnotations.size();
+    }
+}
+
+void Renderer::draw(const Observer& observer,
+                    const Universe& universe,
+                    float faintestMagNight,
+                    const Selection& sel)
+{
+    PROFILE_SCOPE("Renderer::draw");
+
+    // Get the observer's time
+    double now = observer.getTime();
+
+    if (detailOptions.backgroundLoading)
+    {
+        auto creationTime = chrono::duration<double>(detailOptions.resourceCreationTime);
+        auto deadline = chrono::steady_clock::now() +
+                        chrono::duration_cast<chrono::steady_clock::duration>(creationTime);
+        GetTextureManager()->finishLoading(deadline);
+        GetGeometryManager()->finishLoading(deadline);
+    }
+
+    // Galaxy and globular forms are always generated in the background
+    Galaxy::finishLoadingForms();
+    Globular::finishLoadingForms();
+
+    beginFrame(observer, faintestMagNight, sel);
+
+    // Get the view frustum used for culling in camera space.
+    Frustum frustum(degToRad(fov), getAspectRatio(), MinNearPlaneDistance);
+
+    // Get the transformed frustum, used for culling in the astrocentric coordinate
+    // system.
+    Frustum xfrustum(frustum);
+    xfrustum.transform(getCameraOrientation().conjugate().toRotationMatrix());
+
 #ifdef USE_HDR
     float maxBodyMagPrev = saturationMag;
     maxBodyMag = min(maxBodyMag, saturationMag);
@@ -2625,25 +2606,29 @@ void Renderer::renderObject(const Vector3f& pos,
     // Get the object's geometry; nullptr indicates that object is an
     // ellipsoid.
     Geometry* geometry = nullptr;
-    if (obj.geometry != InvalidResource)
+    bool ellipsoid = obj.geometry == InvalidResource;
+    if (!ellipsoid)
     {
-        // This is a model loaded from a file
-        geometry = GetGeometryManager()->find(obj.geometry);
+        // This is a model loaded from a file. While it's being loaded in
+        // the background, the object is drawn as an ellipsoid instead.
+        geometry = GetGeometryManager()->find(obj.geometry, discSizeInPixels);
+        if (geometry == nullptr)
+            ellipsoid = GetGeometryManager()->getState(obj.geometry) == ResourceLoading;
     }
 
     // Get the textures . . .
     if (obj.surface->baseTexture.tex[textureResolution] != InvalidResource)
-        ri.baseTex = obj.surface->baseTexture.find(textureResolution);
+        ri.baseTex = obj.surface->baseTexture.find(textureResolution, discSizeInPixels);
     if ((obj.surface->appearanceFlags & Surface::ApplyBumpMap) != 0 &&
         obj.surface->bumpTexture.tex[textureResolution] != InvalidResource)
-        ri.bumpTex = obj.surface->bumpTexture.find(textureResolution);
+        ri.bumpTex = obj.surface->bumpTexture.find(textureResolution, discSizeInPixels);
     if ((obj.surface->appearanceFlags & Surface::ApplyNightMap) != 0 &&
         (renderFlags & ShowNightMaps) != 0)
-        ri.nightTex = obj.surface->nightTexture.find(textureResolution);
+        ri.nightTex = obj.surface->nightTexture.find(textureResolution, discSizeInPixels);
     if ((obj.surface->appearanceFlags & Surface::SeparateSpecularMap) != 0)
-        ri.glossTex = obj.surface->specularTexture.find(textureResolution);
+        ri.glossTex = obj.surface->specularTexture.find(textureResolution, discSizeInPixels);
     if ((obj.surface->appearanceFlags & Surface::ApplyOverlay) != 0)
-        ri.overlayTex = obj.surface->overlayTexture.find(textureResolution);
+        ri.overlayTex = obj.surface->overlayTexture.find(textureResolution, discSizeInPixels);
 
     // Apply the modelview transform for the object
     glPushMatrix();
@@ -2710,7 +2695,7 @@ void Renderer::renderObject(const Vector3f& pos,
     // be seen, make the far plane of the frustum as close to the viewer
     // as possible.
     float frustumFarPlane = farPlaneDistance;
-    if (obj.geometry == InvalidResource)
+    if (ellipsoid)
     {
         // Only adjust the far plane for ellipsoidal objects
         float d = pos.norm();
@@ -2766,15 +2751,15 @@ void Renderer::renderObject(const Vector3f& pos,
         if ((renderFlags & ShowCloudMaps) != 0)
         {
             if (atmosphere->cloudTexture.tex[textureResolution] != InvalidResource)
-                cloudTex = atmosphere->cloudTexture.find(textureResolution);
+                cloudTex = atmosphere->cloudTexture.find(textureResolution, discSizeInPixels);
             if (atmosphere->cloudNormalMap.tex[textureResolution] != InvalidResource)
-                cloudNormalMap = atmosphere->cloudNormalMap.find(textureResolution);
+                cloudNormalMap = atmosphere->cloudNormalMap.find(textureResolution, discSizeInPixels);
         }
         if (atmosphere->cloudSpeed != 0.0f)
             cloudTexOffset = (float) (-pfmod(now * atmosphere->cloudSpeed / (2 * PI), 1.0));
     }
 
-    if (obj.geometry == InvalidResource)
+    if (ellipsoid)
     {
         // A null model indicates that this body is a sphere
         if (lit)
@@ -2960,7 +2945,7 @@ void Renderer::renderObject(const Vector3f& pos,
     {
         if (lit && (renderFlags & ShowRingShadows) != 0)
         {
-            Texture* ringsTex = obj.rings->texture.find(textureResolution);
+            Texture* ringsTex = obj.rings->texture.find(textureResolution, discSizeInPixels);
             if (ringsTex != nullptr)
                 ringsTex->bind();
         }
@@ -4432,6 +4417,8 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
                                 float faintestMagNight,
                                 const Observer& observer)
 {
+    PROFILE_SCOPE("Renderer::renderPointStars");
+
     // Disable multisample rendering when drawing point stars
     bool toggleAA = (starStyle == Renderer::PointStars && glIsEnabled(GL_MULTISAMPLE));
     if (toggleAA)
@@ -4505,22 +4492,30 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
     else
         starRenderer.starVertexBuffer->startSprites();
 
+    OctreeProcStats* stats = nullptr;
 #ifdef OCTREE_DEBUG
     m_starProcStats.nodes = 0;
     m_starProcStats.height = 0;
     m_starProcStats.objects = 0;
+    stats = &m_starProcStats;
 #endif
-    starDB.findVisibleStars(starRenderer,
-                            obsPos.cast<float>(),
-                            observer.getOrientationf(),
-                            degToRad(fov),
-                            getAspectRatio(),
-                            faintestMagNight,
-#ifdef OCTREE_DEBUG
-                            &m_starProcStats);
-#else
-                            nullptr);
-#endif
+    if (renderThreadPool != nullptr)
+    {
+        processVisibleStarsParallel(starDB, starRenderer, faintestMagNight, observer, stats);
+    }
+    else
+    {
+        starDB.findVisibleStars(starRenderer,
+                                obsPos.cast<float>(),
+                                observer.getOrientationf(),
+                                degToRad(fov),
+                                getAspectRatio(),
+                                faintestMagNight,
+                                stats);
+    }
+
+    PROFILE_COUNT("Stars processed", starRenderer.nProcessed);
+    PROFILE_COUNT("Stars rendered", starRenderer.nRendered);
 
     starRenderer.starVertexBuffer->render();
     starRenderer.glareVertexBuffer->render();
@@ -4531,10 +4526,111 @@ void Renderer::renderPointStars(const StarDatabase& starDB,
         glEnable(GL_MULTISAMPLE);
 }
 
+// Process the visible stars using the render threads. Every thread adds
+// the output of the parts of the star octree it processes to a batch of its
+// own, and the parts are then submitted in traversal order, giving the
+// same result as a single thread. The statistics of the threads are
+// merged into those of starRenderer, and those of the octree traversal
+// into stats when it isn't null.
+void Renderer::processVisibleStarsParallel(const StarDatabase& starDB,
+                                           PointStarRenderer& starRenderer,
+                                           float faintestMagNight,
+                                           const Observer& observer,
+                                           OctreeProcStats* stats)
+{
+    unsigned int nThreads = renderThreadPool->getThreadCount();
+    Vector3f obsPos = starRenderer.obsPos.cast<float>();
+
+    // Several tasks per thread, as the amount of work in each varies a lot
+    vector<StarOctree::TraversalTask> tasks;
+    starDB.splitVisibleStars(tasks,
+                             obsPos,
+                             observer.getOrientationf(),
+                             degToRad(fov),
+                             getAspectRatio(),
+                             faintestMagNight,
+                             nThreads * 8);
+
+    vector<PointStarRenderer> starRenderers(nThreads, starRenderer);
+    for (unsigned int i = 0; i < nThreads; i++)
+    {
+        starBatches[i].clear();
+        starRenderers[i].batch = &starBatches[i];
+    }
+
+    struct TaskOutput
+    {
+        unsigned int thread;
+        PointStarBatch::Mark begin;
+        PointStarBatch::Mark end;
+        OctreeProcStats stats;
+    };
+    vector<TaskOutput> outputs(tasks.size());
+
+    renderThreadPool->parallelFor(tasks.size(), [&](size_t task, unsigned int thread)
+    {
+        TaskOutput& output = outputs[task];
+        output.thread = thread;
+        output.begin = starBatches[thread].mark();
+        starDB.findVisibleStars(tasks[task],
+                                starRenderers[thread],
+                                obsPos,
+                                observer.getOrientationf(),
+                                degToRad(fov),
+                                getAspectRatio(),
+                                faintestMagNight,
+                                stats != nullptr ? &output.stats : nullptr);
+        output.end = starBatches[thread].mark();
+    });
+
+    for (size_t task = 0; task < tasks.size(); task++)
+    {
+        const TaskOutput& output = outputs[task];
+        const PointStarBatch& batch = starBatches[output.thread];
+        if (stats != nullptr)
+            StarOctree::mergeStatistics(*stats, tasks[task], output.stats);
+
+        starRenderer.starVertexBuffer->addStars(batch.stars.data() + output.begin.stars,
+                                                output.end.stars - output.begin.stars);
+        starRenderer.glareVertexBuffer->addStars(batch.glares.data() + output.begin.glares,
+                                                 output.end.glares - output.begin.glares);
+        for (size_t i = output.begin.labels; i < output.end.labels; i++)
+        {
+            const PointStarBatch::Label& label = batch.labels[i];
+            addBackgroundAnnotation(nullptr, starDB.getStarName(*label.star, true),
+                                    label.color, label.position);
+        }
+        renderList.insert(renderList.end(),
+                          batch.renderList.begin() + output.begin.renderList,
+                          batch.renderList.begin() + output.end.renderList);
+    }
+
+    for (const auto& threadRenderer : starRenderers)
+    {
+        starRenderer.nProcessed += threadRenderer.nProcessed;
+        starRenderer.nRendered += threadRenderer.nRendered;
+        starRenderer.nClose += threadRenderer.nClose;
+        starRenderer.nBright += threadRenderer.nBright;
+        starRenderer.nLabelled += threadRenderer.nLabelled;
+#ifdef DEBUG_HDR_ADAPT
+        starRenderer.minMag = max(starRenderer.minMag, threadRenderer.minMag);
+        starRenderer.maxMag = min(starRenderer.maxMag, threadRenderer.maxMag);
+        starRenderer.minAlpha = min(starRenderer.minAlpha, threadRenderer.minAlpha);
+        starRenderer.maxAlpha = max(starRenderer.maxAlpha, threadRenderer.maxAlpha);
+        starRenderer.maxSize = max(starRenderer.maxSize, threadRenderer.maxSize);
+        starRenderer.countAboveN += threadRenderer.countAboveN;
+        starRenderer.total += threadRenderer.total;
+#endif
+    }
+}
+
+
 void Renderer::renderDeepSkyObjects(const Universe& universe,
                                     const Observer& observer,
                                     const float     faintestMagNight)
 {
+    PROFILE_SCOPE("Renderer::renderDeepSkyObjects");
+
     DSORenderer dsoRenderer;
 
     Vector3d obsPos     = observer.getPosition().toLy();
@@ -4605,7 +4701,7 @@ void Renderer::renderDeepSkyObjects(const Universe& universe,
                             nullptr);
 #endif
 
-    // clog << "DSOs processed: " << dsoRenderer.dsosProcessed << endl;
+    PROFILE_COUNT("DSOs processed", dsoRenderer.dsosProcessed);
 
     disableSmoothLines();
 }
@@ -5108,7 +5204,7 @@ void Renderer::loadTextures(Body* body)
 
 void Renderer::invalidateOrbitCache()
 {
-    orbitCache.clear();
+    orbitPathCache->clear();
 }
 
 
@@ -5457,6 +5553,26 @@ Renderer::setShadowMapSize(unsigned size)
         createShadowFBO();
 }
 
+void
+Renderer::setRenderThreadCount(unsigned nThreads)
+{
+    delete renderThreadPool;
+    delete[] starBatches;
+    renderThreadPool = nullptr;
+    starBatches = nullptr;
+
+    auto* pool = new ThreadPool(nThreads);
+    if (pool->getThreadCount() > 1)
+    {
+        renderThreadPool = pool;
+        starBatches = new PointStarBatch[pool->getThreadCount()];
+    }
+    else
+    {
+        delete pool;
+    }
+}
+
 void
 Renderer::removeInvisibleItems(const Frustum &frustum)
 {
@@ -5705,7 +5821,8 @@ void
 Renderer::buildNearSystemsLists(const Universe &universe,
                                 const Observer &observer,
                                 const Frustum &xfrustum,
-                                double now)
+                                double now,
+                                FrameListStats *stats)
 {
     UniversalCoord observerPos = observer.getPosition();
     Eigen::Quaterniond observerOrient = observer.getOrientation();
@@ -5745,18 +5862,35 @@ Renderer::buildNearSystemsLists(const Universe &universe,
         Vector3d astrocentricObserverPos = astrocentricPosition(observerPos, *sun, now);
 
         // Build render lists for bodies and orbits paths
-        buildRenderLists(astrocentricObserverPos, xfrustum,
-                         observerOrient.conjugate() * -Vector3d::UnitZ(),
-                         Vector3d::Zero(), solarSysTree, observer, now);
+        Timer timer;
+        {
+            PROFILE_SCOPE("Renderer::buildRenderLists");
+            buildRenderLists(astrocentricObserverPos, xfrustum,
+                             observerOrient.conjugate() * -Vector3d::UnitZ(),
+                             Vector3d::Zero(), solarSysTree, observer, now);
+        }
+        if (stats != nullptr)
+            stats->renderListTime += timer.getTime();
+
         if ((renderFlags & ShowOrbits) != 0)
         {
+            PROFILE_SCOPE("Renderer::buildOrbitLists");
+            timer.reset();
             buildOrbitLists(astrocentricObserverPos, observerOrient,
                             xfrustum, solarSysTree, now);
+            if (stats != nullptr)
+                stats->orbitListTime += timer.getTime();
         }
     }
 
     if ((labelMode & BodyLabelMask) != 0)
+    {
+        PROFILE_SCOPE("Renderer::buildLabelLists");
+        Timer timer;
         buildLabelLists(xfrustum, now);
+        if (stats != nullptr)
+            stats->labelListTime += timer.getTime();
+    }
 }
 
 int
@@ -29,9 +29,12 @@ class GLContext;
 class RendererWatcher;
 class FrameTree;
 class ReferenceMark;
-class CurvePlot;
+class OrbitPathCache;
 class Rect;
 class PointStarVertexBuffer;
+class PointStarRenderer;
+struct PointStarBatch;
+class ThreadPool;
 class AsterismRenderer;
 class BoundariesRenderer;
 class Observer;
@@ -81,12 +84,13 @@ class Renderer
     struct DetailOptions
     {
         DetailOptions();
-        unsigned int orbitPathSamplePoints;
         unsigned int shadowTextureSize;
         unsigned int eclipseTextureSize;
         double orbitWindowEnd;
         double orbitPeriodsShown;
         double linearFadeFraction;
+        bool backgroundLoading;
+        double resourceCreationTime; // seconds per frame
     };
 
 #ifdef USE_GLCONTEXT
@@ -113,6 +117,24 @@ class Renderer
               float faintestVisible,
               const Selection& sel);
 
+    // Timings of the stages of buildFrameLists() and the size of the
+    // lists built
+    struct FrameListStats
+    {
+        double renderListTime{ 0.0 };
+        double orbitListTime{ 0.0 };
+        double labelListTime{ 0.0 };
+        size_t nRenderListEntries{ 0 };
+        size_t nOrbitPaths{ 0 };
+        size_t nLabels{ 0 };
+    };
+
+    void buildFrameLists(const Observer&,
+                         const Universe&,
+                         float faintestVisible,
+                         const Selection& sel,
+                         FrameListStats* stats = nullptr);
+
     bool getInfo(std::map<std::string, std::string>& info) const;
 
     enum {
@@ -251,6 +273,9 @@ class Renderer
     [[deprecated]] void setVideoSync(bool);
     void setSolarSystemMaxDistance(float);
     void setShadowMapSize(unsigned);
+    // Number of threads used to process stars; zero means one per
+    // processor core.
+    void setRenderThreadCount(unsigned);
 
     bool captureFrame(int, int, int, int, PixelFormat format, unsigned char*, bool = false) const;
 
@@ -340,6 +365,7 @@ class Renderer
     void clearAnnotations(std::vector<Annotation>&);
 
     void invalidateOrbitCache();
+    OrbitPathCache& getOrbitPathCache() const { return *orbitPathCache; }
 
     struct OrbitPathListEntry
     {
@@ -454,12 +480,20 @@ class Renderer
 
  private:
     void setFieldOfView(float);
+    void beginFrame(const Observer& observer,
+                    float faintestMagNight,
+                    const Selection& sel);
     void renderStars(const StarDatabase& starDB,
                      float faintestVisible,
                      const Observer& observer);
     void renderPointStars(const StarDatabase& starDB,
                           float faintestVisible,
                           const Observer& observer);
+    void processVisibleStarsParallel(const StarDatabase& starDB,
+                                     PointStarRenderer& starRenderer,
+                                     float faintestMagNight,
+                                     const Observer& observer,
+                                     OctreeProcStats* stats);
     void renderDeepSkyObjects(const Universe&,
                               const Observer&,
                               float faintestMagNight);
@@ -477,7 +511,8 @@ class Renderer
     void buildNearSystemsLists(const Universe &universe,
                                const Observer &observer,
                                const celmath::Frustum &xfrustum,
-                               double jd);
+                               double jd,
+                               FrameListStats *stats = nullptr);
 
     void buildRenderLists(const Eigen::Vector3d& astrocentricObserverPos,
                           const celmath::Frustum& viewFrustum,
@@ -742,9 +777,8 @@ class Renderer
     int m_GLStateFlag { 0 };
 
  private:
-    typedef std::map<const Orbit*, CurvePlot*> OrbitCache;
-    OrbitCache orbitCache;
-    uint32_t lastOrbitCacheFlush;
+    // Shared by all the views
+    OrbitPathCache* orbitPathCache;
 
     float minOrbitSize;
     float distanceLimit;
@@ -778,6 +812,11 @@ class Renderer
     unsigned m_shadowMapSize { 0 };
     std::unique_ptr<FramebufferObject> m_shadowFBO;
 
+    // Threads processing stars, and their output; null when stars are
+    // processed by the render thread alone
+    ThreadPool* renderThreadPool{ nullptr };
+    PointStarBatch* starBatches{ nullptr };
+
     std::array<celgl::VertexObject*, static_cast<size_t>(VOType::Count)> m_VertexObjects;
 
     // Location markers
@@ -396,6 +396,7 @@ void renderGeometry_GLSL(Geometry* geometry,
 
     rc.setCameraOrientation(ri.orientation);
     rc.setPointScale(ri.pointScale);
+    rc.setTexturePriority(ri.pixWidth);
 
     // Handle extended material attributes (per model only, not per submesh)
     rc.setLunarLambert(ri.lunarLambert);
@@ -441,6 +442,7 @@ void renderGeometry_GLSL_Unlit(Geometry* geometry,
     GLSLUnlit_RenderContext rc(renderer, geometryScale);
 
     rc.setPointScale(ri.pointScale);
+    rc.setTexturePriority(ri.pixWidth);
 
     // Handle material override; a texture specified in an ssc file will
     // override all materials specified in the model file.
@@ -440,7 +440,7 @@ Selection Simulation::findObjectFromPath(string s, bool i18n)
 }
 
 
-vector<std::string> Simulation::getObjectCompletion(string s, bool withLocations)
+vector<std::string> Simulation::getObjectCompletion(string s, bool withLocations, size_t maxCompletions)
 {
     Selection path[2];
     int nPathEntries = 0;
@@ -462,7 +462,7 @@ vector<std::string> Simulation::getObjectCompletion(string s, bool withLocations
         path[nPathEntries++] = Selection(closestSolarSystem->getStar());
     }
 
-    return universe->getCompletionPath(s, path, nPathEntries, withLocations);
+    return universe->getCompletionPath(s, path, nPathEntries, withLocations, maxCompletions);
 }
 
 
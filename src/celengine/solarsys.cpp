@@ -75,18 +75,24 @@ enum BodyType
   The name and parent name are both mandatory.
 */
 
-static void errorMessagePrelude(const Tokenizer& tok)
+static void errorMessagePrelude(int lineNumber)
 {
-    fmt::fprintf(cerr,_("Error in .ssc file (line %d): "), tok.getLineNumber());
+    fmt::fprintf(cerr,_("Error in .ssc file (line %d): "), lineNumber);
 }
 
-static void sscError(const Tokenizer& tok,
+static void sscError(int lineNumber,
                      const string& msg)
 {
-    errorMessagePrelude(tok);
+    errorMessagePrelude(lineNumber);
     cerr << msg << '\n';
 }
 
+static string sscErrorMessage(const Tokenizer& tok,
+                              const string& msg)
+{
+    return fmt::sprintf(_("Error in .ssc file (line %d): "), tok.getLineNumber()) + msg + '\n';
+}
+
 
 // Object class properties
 static const int CLASSES_UNCLICKABLE           = Body::Invisible |
@@ -1080,13 +1086,16 @@ bool LoadSolarSystemObjects(istream& in,
                             Universe& universe,
                             const fs::path& directory)
 {
-    Tokenizer tokenizer(&in);
-    Parser parser(&tokenizer);
+    ParsedSolarSystemCatalog catalog;
+    ParseSolarSystemCatalog(in, catalog);
+    return LoadSolarSystemObjects(catalog, universe, directory);
+}
 
-#ifdef ENABLE_NLS
-    const char* d = directory.string().c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
-#endif
+
+static void ParseSolarSystemCatalog(Tokenizer& tokenizer,
+                                    ParsedSolarSystemCatalog& catalog)
+{
+    Parser parser(&tokenizer, catalog.getPool());
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
@@ -1121,8 +1130,8 @@ bool LoadSolarSystemObjects(istream& in,
 
         if (tokenizer.getTokenType() != Tokenizer::TokenString)
         {
-            sscError(tokenizer, "object name expected");
-            return false;
+            catalog.error = sscErrorMessage(tokenizer, "object name expected");
+            return;
         }
 
         // The name list is a string with zero more names. Multiple names are
@@ -1131,25 +1140,67 @@ bool LoadSolarSystemObjects(istream& in,
 
         if (tokenizer.nextToken() != Tokenizer::TokenString)
         {
-            sscError(tokenizer, "bad parent object name");
-            return false;
+            catalog.error = sscErrorMessage(tokenizer, "bad parent object name");
+            return;
         }
         string parentName = tokenizer.getStringValue().c_str();
 
         Value* objectDataValue = parser.readValue();
         if (objectDataValue == nullptr)
         {
-            sscError(tokenizer, "bad object definition");
-            return false;
+            catalog.error = sscErrorMessage(tokenizer, "bad object definition");
+            return;
         }
 
         if (objectDataValue->getType() != Value::HashType)
         {
-            sscError(tokenizer, "{ expected");
+            catalog.error = sscErrorMessage(tokenizer, "{ expected");
             delete objectDataValue;
-            return false;
+            return;
         }
-        Hash* objectData = objectDataValue->getHash();
+
+        catalog.entries.push_back({ disposition, itemType, nameList, parentName,
+                                    unique_ptr<Value>(objectDataValue),
+                                    tokenizer.getLineNumber() });
+    }
+}
+
+
+void ParseSolarSystemCatalog(istream& in,
+                             ParsedSolarSystemCatalog& catalog)
+{
+    Tokenizer tokenizer(&in);
+    ParseSolarSystemCatalog(tokenizer, catalog);
+}
+
+
+void ParseSolarSystemCatalog(const char* data, size_t size,
+                             ParsedSolarSystemCatalog& catalog)
+{
+    Tokenizer tokenizer(data, size);
+    ParseSolarSystemCatalog(tokenizer, catalog);
+}
+
+
+/*! Add the objects of a parsed solar system catalog to the universe. The
+ *  object definitions are consumed.
+ */
+bool LoadSolarSystemObjects(ParsedSolarSystemCatalog& catalog,
+                            Universe& universe,
+                            const fs::path& directory)
+{
+#ifdef ENABLE_NLS
+    const char* d = directory.string().c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+#endif
+
+    for (auto& entry : catalog.entries)
+    {
+        DataDisposition disposition = entry.disposition;
+        const string& itemType = entry.itemType;
+        const string& nameList = entry.nameList;
+        const string& parentName = entry.parentName;
+        Hash* objectData = entry.objectData->getHash();
 
         Selection parent = universe.findPath(parentName, nullptr, 0);
         PlanetarySystem* parentSystem = nullptr;
@@ -1216,7 +1267,7 @@ bool LoadSolarSystemObjects(istream& in,
             }
             else
             {
-                errorMessagePrelude(tokenizer);
+                errorMessagePrelude(entry.lineNumber);
                 fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), parentName, primaryName);
             }
 
@@ -1227,7 +1278,7 @@ bool LoadSolarSystemObjects(istream& in,
                 {
                     if (disposition == DataDisposition::Add)
                     {
-                        errorMessagePrelude(tokenizer);
+                        errorMessagePrelude(entry.lineNumber);
                         fmt::fprintf(cerr, _("warning duplicate definition of %s %s\n"), parentName, primaryName);
                     }
                     else if (disposition == DataDisposition::Replace)
@@ -1259,7 +1310,7 @@ bool LoadSolarSystemObjects(istream& in,
             if (parent.body() != nullptr)
                 parent.body()->addAlternateSurface(primaryName, surface);
             else
-                sscError(tokenizer, _("bad alternate surface"));
+                sscError(entry.lineNumber, _("bad alternate surface"));
         }
         else if (itemType == "Location")
         {
@@ -1274,19 +1325,24 @@ bool LoadSolarSystemObjects(istream& in,
                 }
                 else
                 {
-                    sscError(tokenizer, _("bad location"));
+                    sscError(entry.lineNumber, _("bad location"));
                 }
             }
             else
             {
-                errorMessagePrelude(tokenizer);
+                errorMessagePrelude(entry.lineNumber);
                 fmt::fprintf(cerr, _("parent body '%s' of '%s' not found.\n"), parentName, primaryName);
             }
         }
-        delete objectDataValue;
+        entry.objectData.reset();
+    }
+
+    if (!catalog.error.empty())
+    {
+        cerr << catalog.error;
+        return false;
     }
 
-    // TODO: Return some notification if there's an error parsing the file
     return true;
 }
 
@@ -39,9 +39,31 @@ typedef std::map<uint32_t, SolarSystem*> SolarSystemCatalog;
 
 class Universe;
 
+// An object definition of a solar system catalog
+struct SolarSystemCatalogEntry
+{
+    DataDisposition disposition;
+    std::string itemType;
+    std::string nameList;
+    std::string parentName;
+    std::unique_ptr<Value> objectData;
+    int lineNumber;
+};
+typedef ParsedCatalog<SolarSystemCatalogEntry> ParsedSolarSystemCatalog;
+
+// Parse a solar system catalog without modifying any universe, so that
+// several catalogs can be parsed in parallel
+void ParseSolarSystemCatalog(std::istream& in,
+                             ParsedSolarSystemCatalog& catalog);
+void ParseSolarSystemCatalog(const char* data, size_t size,
+                             ParsedSolarSystemCatalog& catalog);
+
 bool LoadSolarSystemObjects(std::istream& in,
                             Universe& universe,
                             const fs::path& dir = fs::path());
+bool LoadSolarSystemObjects(ParsedSolarSystemCatalog& catalog,
+                            Universe& universe,
+                            const fs::path& dir = fs::path());
 
 #endif // _SOLARSYS_H_
 
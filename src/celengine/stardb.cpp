@@ -14,10 +14,13 @@
 #include <cstdlib>
 #include <cassert>
 #include <algorithm>
+#include <fstream>
+#include <thread>
 #include <celmath/mathlib.h>
 #include <celutil/bytes.h>
 #include <celutil/debug.h>
 #include <celutil/gettext.h>
+#include <celutil/profiler.h>
 #include "stardb.h"
 #include "astro.h"
 #include "parser.h"
@@ -51,6 +54,23 @@ constexpr const float STAR_OCTREE_MAGNITUDE   = 6.0f;
 //constexpr const float STAR_EXTRA_ROOM        = 0.01f; // Reserve 1% capacity for extra stars
 
 constexpr const char FILE_HEADER[]            = "CELSTARS";
+// Version 0x0100 files contain stars in arbitrary order; version 0x0200
+// files are written by sortstardb and contain stars already sorted into
+// octree order, followed by a table describing the octree nodes.
+constexpr const uint16_t UNSORTED_FILE_VERSION = 0x0100;
+constexpr const uint16_t SORTED_FILE_VERSION   = 0x0200;
+// Size of a single star record: catalog number, position, absolute
+// magnitude and spectral type.
+constexpr const size_t STAR_RECORD_SIZE        = 20;
+// Size of a single octree node record: cell center, exclusion factor,
+// first object, object count and first child.
+constexpr const size_t NODE_RECORD_SIZE        = 28;
+
+// The octree cache stores the node table and, for every star in octree
+// order, its position in the list of loaded stars. It is only used when
+// the key computed from the loaded stars matches.
+constexpr const char OCTREE_CACHE_HEADER[]     = "CELOCTRC";
+constexpr const uint16_t OCTREE_CACHE_VERSION  = 0x0100;
 constexpr const char CROSSINDEX_FILE_HEADER[] = "CELINDEX";
 
 
@@ -317,13 +337,13 @@ Star* StarDatabase::searchCrossIndex(const Catalog catalog, const AstroCatalog::
 }
 
 
-vector<string> StarDatabase::getCompletion(const string& name) const
+vector<string> StarDatabase::getCompletion(const string& name, size_t maxCompletions) const
 {
     vector<string> completion;
 
     // only named stars are supported by completion.
     if (!name.empty() && namesDB != nullptr)
-        return namesDB->getCompletion(name);
+        return namesDB->getCompletion(name, true, maxCompletions);
     else
         return completion;
 }
@@ -375,12 +395,13 @@ string StarDatabase::getStarName(const Star& star, bool i18n) const
     if (namesDB != nullptr)
     {
         StarNameDatabase::NumberIndex::const_iterator iter = namesDB->getFirstNameIter(catalogNumber);
-        if (iter != namesDB->getFinalNameIter() && iter->first == catalogNumber)
+        if (iter != namesDB->getFinalNameIter() && iter->catalogNumber == catalogNumber)
         {
-            if (i18n && iter->second != _(iter->second.c_str()))
-                return _(iter->second.c_str());
+            const char* name = namesDB->getName(*iter);
+            if (i18n)
+                return _(name);
             else
-                return iter->second;
+                return name;
         }
     }
 
@@ -405,12 +426,13 @@ void StarDatabase::getStarName(const Star& star, char* nameBuffer, unsigned int
     if (namesDB != nullptr)
     {
         StarNameDatabase::NumberIndex::const_iterator iter = namesDB->getFirstNameIter(catalogNumber);
-        if (iter != namesDB->getFinalNameIter() && iter->first == catalogNumber)
+        if (iter != namesDB->getFinalNameIter() && iter->catalogNumber == catalogNumber)
         {
-            if (i18n && iter->second != _(iter->second.c_str()))
-                strncpy(nameBuffer, _(iter->second.c_str()), bufferSize);
+            const char* name = namesDB->getName(*iter);
+            if (i18n)
+                strncpy(nameBuffer, _(name), bufferSize);
             else
-                strncpy(nameBuffer, iter->second.c_str(), bufferSize);
+                strncpy(nameBuffer, name, bufferSize);
 
             nameBuffer[bufferSize - 1] = '\0';
             return;
@@ -433,12 +455,12 @@ string StarDatabase::getStarNameList(const Star& star, const unsigned int maxNam
     {
         StarNameDatabase::NumberIndex::const_iterator iter = namesDB->getFirstNameIter(catalogNumber);
 
-        while (iter != namesDB->getFinalNameIter() && iter->first == catalogNumber && count < maxNames)
+        while (iter != namesDB->getFinalNameIter() && iter->catalogNumber == catalogNumber && count < maxNames)
         {
             if (count != 0)
                 starNames += " / ";
 
-            starNames += iter->second;
+            starNames += namesDB->getName(*iter);
             ++iter;
             ++count;
         }
@@ -491,16 +513,13 @@ string StarDatabase::getStarNameList(const Star& star, const unsigned int maxNam
 }
 
 
-void StarDatabase::findVisibleStars(StarHandler& starHandler,
-                                    const Vector3f& position,
-                                    const Quaternionf& orientation,
-                                    float fovY,
-                                    float aspectRatio,
-                                    float limitingMag,
-                                    OctreeProcStats *stats) const
+// Compute the bounding planes of an infinite view frustum
+static void computeFrustumPlanes(Hyperplane<float, 3>* frustumPlanes,
+                                 const Vector3f& position,
+                                 const Quaternionf& orientation,
+                                 float fovY,
+                                 float aspectRatio)
 {
-    // Compute the bounding planes of an infinite view frustum
-    Hyperplane<float, 3> frustumPlanes[5];
     Vector3f planeNormals[5];
     Eigen::Matrix3f rot = orientation.toRotationMatrix();
     float h = (float) tan(fovY / 2);
@@ -515,6 +534,21 @@ void StarDatabase::findVisibleStars(StarHandler& starHandler,
         planeNormals[i] = rot.transpose() * planeNormals[i].normalized();
         frustumPlanes[i] = Hyperplane<float, 3>(planeNormals[i], position);
     }
+}
+
+
+void StarDatabase::findVisibleStars(StarHandler& starHandler,
+                                    const Vector3f& position,
+                                    const Quaternionf& orientation,
+                                    float fovY,
+                                    float aspectRatio,
+                                    float limitingMag,
+                                    OctreeProcStats *stats) const
+{
+    PROFILE_SCOPE("StarDatabase::findVisibleStars");
+
+    Hyperplane<float, 3> frustumPlanes[5];
+    computeFrustumPlanes(frustumPlanes, position, orientation, fovY, aspectRatio);
 
     octreeRoot->processVisibleObjects(starHandler,
                                       position,
@@ -525,10 +559,55 @@ void StarDatabase::findVisibleStars(StarHandler& starHandler,
 }
 
 
+void StarDatabase::splitVisibleStars(vector<StarOctree::TraversalTask>& tasks,
+                                     const Vector3f& position,
+                                     const Quaternionf& orientation,
+                                     float fovY,
+                                     float aspectRatio,
+                                     float limitingMag,
+                                     size_t nTasks) const
+{
+    Hyperplane<float, 3> frustumPlanes[5];
+    computeFrustumPlanes(frustumPlanes, position, orientation, fovY, aspectRatio);
+
+    octreeRoot->splitVisibleObjects(tasks,
+                                    position,
+                                    frustumPlanes,
+                                    limitingMag,
+                                    STAR_OCTREE_ROOT_SIZE,
+                                    nTasks);
+}
+
+
+void StarDatabase::findVisibleStars(const StarOctree::TraversalTask& task,
+                                    StarHandler& starHandler,
+                                    const Vector3f& position,
+                                    const Quaternionf& orientation,
+                                    float fovY,
+                                    float aspectRatio,
+                                    float limitingMag,
+                                    OctreeProcStats *stats) const
+{
+    PROFILE_SCOPE("StarDatabase::findVisibleStars");
+
+    Hyperplane<float, 3> frustumPlanes[5];
+    computeFrustumPlanes(frustumPlanes, position, orientation, fovY, aspectRatio);
+
+    octreeRoot->processVisibleTask(task,
+                                   starHandler,
+                                   position,
+                                   frustumPlanes,
+                                   limitingMag,
+                                   stats);
+}
+
+
 void StarDatabase::findCloseStars(StarHandler& starHandler,
                                   const Vector3f& position,
                                   float radius) const
 {
+    PROFILE_SCOPE("StarDatabase::findCloseStars");
+
     octreeRoot->processCloseObjects(starHandler,
                                     position,
                                     radius,
@@ -617,8 +696,6 @@ bool StarDatabase::loadCrossIndex(const Catalog catalog, istream& in)
 
 bool StarDatabase::loadBinary(istream& in)
 {
-    uint32_t nStarsInFile = 0;
-
     // Verify that the star database file has a correct header
     {
         int headerLength = strlen(FILE_HEADER);
@@ -632,63 +709,113 @@ bool StarDatabase::loadBinary(istream& in)
     }
 
     // Verify the version
+    uint16_t version;
+    in.read((char*) &version, sizeof version);
+    LE_TO_CPU_INT16(version, version);
+
+    if (version == SORTED_FILE_VERSION)
+        return loadSortedBinary(in);
+    if (version == UNSORTED_FILE_VERSION)
+        return loadUnsortedBinary(in);
+
+    return false;
+}
+
+
+static inline uint32_t readUint(const char* p)
+{
+    uint32_t n;
+    memcpy(&n, p, sizeof n);
+    LE_TO_CPU_INT32(n, n);
+    return n;
+}
+
+
+static inline float readFloat(const char* p)
+{
+    float f;
+    memcpy(&f, p, sizeof f);
+    LE_TO_CPU_FLOAT(f, f);
+    return f;
+}
+
+
+static inline uint16_t readUshort(const char* p)
+{
+    uint16_t n;
+    memcpy(&n, p, sizeof n);
+    LE_TO_CPU_INT16(n, n);
+    return n;
+}
+
+
+// Decode a star record; returns false if the spectral type is invalid.
+static bool unpackStar(const char* record, Star& star)
+{
+    star.setIndex(readUint(record));
+    star.setPosition(readFloat(record + 4), readFloat(record + 8), readFloat(record + 12));
+    star.setAbsoluteMagnitude((float) (int16_t) readUshort(record + 16) / 256.0f);
+
+    StarDetails* details = nullptr;
+    StellarClass sc;
+    if (sc.unpack(readUshort(record + 18)))
+        details = StarDetails::GetStarDetails(sc);
+
+    if (details == nullptr)
+        return false;
+
+    star.setDetails(details);
+    return true;
+}
+
+
+static void unpackNodes(const vector<char>& nodeData, vector<StarOctree::Node>& nodes)
+{
+    nodes.resize(nodeData.size() / NODE_RECORD_SIZE);
+    for (size_t i = 0; i < nodes.size(); i++)
     {
-        uint16_t version;
-        in.read((char*) &version, sizeof version);
-        LE_TO_CPU_INT16(version, version);
-        if (version != 0x0100)
-            return false;
+        const char* p = &nodeData[i * NODE_RECORD_SIZE];
+        StarOctree::Node& node = nodes[i];
+        node.cellCenterPos   = Vector3f(readFloat(p), readFloat(p + 4), readFloat(p + 8));
+        node.exclusionFactor = readFloat(p + 12);
+        node.firstObject     = readUint(p + 16);
+        node.nObjects        = readUint(p + 20);
+        node.firstChild      = readUint(p + 24);
+    }
+}
+
+
+bool StarDatabase::loadUnsortedBinary(istream& in)
+{
+    if (octreeRoot != nullptr)
+    {
+        cerr << _("Star database can't be combined with a sorted star database\n");
+        return false;
     }
 
+    uint32_t nStarsInFile = 0;
+
     // Read the star count
     in.read((char *) &nStarsInFile, sizeof nStarsInFile);
     LE_TO_CPU_INT32(nStarsInFile, nStarsInFile);
     if (!in.good())
         return false;
 
-    unsigned int totalStars = nStars + nStarsInFile;
+    // Read all records at once rather than one field at a time.
+    vector<char> records((size_t) nStarsInFile * STAR_RECORD_SIZE);
+    in.read(records.data(), records.size());
+    nStarsInFile = (uint32_t) (in.gcount() / STAR_RECORD_SIZE);
 
-    while (((unsigned int) nStars) < totalStars)
+    for (uint32_t i = 0; i < nStarsInFile; i++)
     {
-        AstroCatalog::IndexNumber catNo = 0;
-        float x = 0.0f, y = 0.0f, z = 0.0f;
-        int16_t absMag;
-        uint16_t spectralType;
-
-        in.read((char *) &catNo, sizeof catNo);
-        LE_TO_CPU_INT32(catNo, catNo);
-        in.read((char *) &x, sizeof x);
-        LE_TO_CPU_FLOAT(x, x);
-        in.read((char *) &y, sizeof y);
-        LE_TO_CPU_FLOAT(y, y);
-        in.read((char *) &z, sizeof z);
-        LE_TO_CPU_FLOAT(z, z);
-        in.read((char *) &absMag, sizeof absMag);
-        LE_TO_CPU_INT16(absMag, absMag);
-        in.read((char *) &spectralType, sizeof spectralType);
-        LE_TO_CPU_INT16(spectralType, spectralType);
-        if (in.bad())
-        break;
-
         Star star;
-        star.setPosition(x, y, z);
-        star.setAbsoluteMagnitude((float) absMag / 256.0f);
-
-        StarDetails* details = nullptr;
-        StellarClass sc;
-        if (sc.unpack(spectralType))
-            details = StarDetails::GetStarDetails(sc);
-
-        if (details == nullptr)
+        if (!unpackStar(&records[i * STAR_RECORD_SIZE], star))
         {
             fmt::fprintf(cerr, _("Bad spectral type in star database, star #%u\n"), nStars);
             return false;
         }
 
-        star.setDetails(details);
-        star.setIndex(catNo);
         unsortedStars.add(star);
-
         nStars++;
     }
 
@@ -718,11 +845,297 @@ bool StarDatabase::loadBinary(istream& in)
 }
 
 
+/*! Load a star database in which the stars are already sorted into octree
+ *  order. The stars are decoded straight into the final star array and the
+ *  octree is recreated from the node table, so neither the copy through
+ *  the unsorted star list nor the octree construction is required. This is
+ *  only possible when the file is the first one loaded.
+ */
+bool StarDatabase::loadSortedBinary(istream& in)
+{
+    if (nStars != 0 || octreeRoot != nullptr)
+    {
+        cerr << _("Sorted star database must be loaded before any other star catalog\n");
+        return false;
+    }
+
+    uint32_t nStarsInFile = 0;
+    uint32_t nNodesInFile = 0;
+    in.read((char *) &nStarsInFile, sizeof nStarsInFile);
+    LE_TO_CPU_INT32(nStarsInFile, nStarsInFile);
+    in.read((char *) &nNodesInFile, sizeof nNodesInFile);
+    LE_TO_CPU_INT32(nNodesInFile, nNodesInFile);
+    if (!in.good())
+        return false;
+
+    // Read the whole node table and star array with a single read each
+    vector<char> nodeData((size_t) nNodesInFile * NODE_RECORD_SIZE);
+    in.read(nodeData.data(), nodeData.size());
+    vector<char> records((size_t) nStarsInFile * STAR_RECORD_SIZE);
+    in.read(records.data(), records.size());
+    if (in.fail())
+        return false;
+
+    vector<StarOctree::Node> nodes;
+    unpackNodes(nodeData, nodes);
+
+    Star* sortedStars = new Star[nStarsInFile];
+    for (uint32_t i = 0; i < nStarsInFile; i++)
+    {
+        if (!unpackStar(&records[i * STAR_RECORD_SIZE], sortedStars[i]))
+        {
+            fmt::fprintf(cerr, _("Bad spectral type in star database, star #%u\n"), i);
+            delete[] sortedStars;
+            return false;
+        }
+    }
+
+    StarOctree* root = StarOctree::create(std::move(nodes), sortedStars, nStarsInFile);
+    if (root == nullptr || (uint32_t) root->countObjects() != nStarsInFile)
+    {
+        cerr << _("Bad octree in sorted star database\n");
+        delete root;
+        delete[] sortedStars;
+        return false;
+    }
+
+    stars      = sortedStars;
+    octreeRoot = root;
+    nStars     = nStarsInFile;
+
+    fmt::fprintf(clog, _("%d stars in binary database\n"), nStars);
+
+    // Temporary catalog number index used while loading stc files
+    binFileStarCount = nStarsInFile;
+    binFileCatalogNumberIndex = new Star*[binFileStarCount];
+    for (unsigned int i = 0; i < binFileStarCount; i++)
+        binFileCatalogNumberIndex[i] = &stars[i];
+    sort(binFileCatalogNumberIndex, binFileCatalogNumberIndex + binFileStarCount,
+         PtrCatalogNumberOrderingPredicate());
+
+    return true;
+}
+
+
+const StarOctree* StarDatabase::getOctree() const
+{
+    return octreeRoot;
+}
+
+
+void StarDatabase::setOctreeCacheFile(const fs::path& path)
+{
+    octreeCacheFile = path;
+}
+
+
+bool StarDatabase::isOctreeCached() const
+{
+    return octreeCached;
+}
+
+
+static void writeUint(ostream& out, uint32_t n)
+{
+    LE_TO_CPU_INT32(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+
+static void writeFloat(ostream& out, float f)
+{
+    LE_TO_CPU_FLOAT(f, f);
+    out.write(reinterpret_cast<char*>(&f), sizeof f);
+}
+
+
+// 64-bit FNV-1a hash
+static inline void hashBytes(uint64_t& hash, const void* data, size_t size)
+{
+    auto bytes = static_cast<const unsigned char*>(data);
+    for (size_t i = 0; i < size; i++)
+    {
+        hash ^= bytes[i];
+        hash *= UINT64_C(0x100000001b3);
+    }
+}
+
+
+// The cache key covers everything that affects the shape of the octree:
+// the octree parameters and, in loading order, the catalog number,
+// position, magnitude and orbital radius of every star.
+static uint64_t computeOctreeCacheKey(const vector<const Star*>& unsortedList)
+{
+    uint64_t hash = UINT64_C(0xcbf29ce484222325);
+
+    hashBytes(hash, &OCTREE_CACHE_VERSION, sizeof OCTREE_CACHE_VERSION);
+    hashBytes(hash, &STAR_OCTREE_ROOT_SIZE, sizeof STAR_OCTREE_ROOT_SIZE);
+    hashBytes(hash, &STAR_OCTREE_MAGNITUDE, sizeof STAR_OCTREE_MAGNITUDE);
+
+    for (const Star* star : unsortedList)
+    {
+        float values[5];
+        AstroCatalog::IndexNumber catalogNumber = star->getIndex();
+        values[0] = star->getPosition().x();
+        values[1] = star->getPosition().y();
+        values[2] = star->getPosition().z();
+        values[3] = star->getAbsoluteMagnitude();
+        values[4] = star->getOrbitalRadius();
+        hashBytes(hash, &catalogNumber, sizeof catalogNumber);
+        hashBytes(hash, values, sizeof values);
+    }
+
+    return hash;
+}
+
+
+bool StarDatabase::loadOctreeCache(const vector<const Star*>& unsortedList, uint64_t key)
+{
+    ifstream in(octreeCacheFile.string(), ios::in | ios::binary);
+    if (!in.good())
+        return false;
+
+    char header[sizeof OCTREE_CACHE_HEADER - 1];
+    in.read(header, sizeof header);
+    if (!in.good() || strncmp(header, OCTREE_CACHE_HEADER, sizeof header))
+        return false;
+
+    uint16_t version;
+    uint64_t fileKey;
+    uint32_t nStarsInFile;
+    uint32_t nNodesInFile;
+    in.read((char*) &version, sizeof version);
+    LE_TO_CPU_INT16(version, version);
+    in.read((char*) &fileKey, sizeof fileKey);
+    in.read((char*) &nStarsInFile, sizeof nStarsInFile);
+    LE_TO_CPU_INT32(nStarsInFile, nStarsInFile);
+    in.read((char*) &nNodesInFile, sizeof nNodesInFile);
+    LE_TO_CPU_INT32(nNodesInFile, nNodesInFile);
+    if (!in.good() || version != OCTREE_CACHE_VERSION ||
+        memcmp(&fileKey, &key, sizeof key) != 0 || nStarsInFile != unsortedList.size())
+    {
+        return false;
+    }
+
+    vector<char> nodeData((size_t) nNodesInFile * NODE_RECORD_SIZE);
+    in.read(nodeData.data(), nodeData.size());
+    vector<char> orderData((size_t) nStarsInFile * sizeof(uint32_t));
+    in.read(orderData.data(), orderData.size());
+    if (in.fail())
+        return false;
+
+    // The stored order must be a permutation of the loaded stars
+    vector<uint32_t> order(nStarsInFile);
+    vector<bool> used(nStarsInFile, false);
+    for (uint32_t i = 0; i < nStarsInFile; i++)
+    {
+        order[i] = readUint(&orderData[i * sizeof(uint32_t)]);
+        if (order[i] >= nStarsInFile || used[order[i]])
+            return false;
+        used[order[i]] = true;
+    }
+
+    vector<StarOctree::Node> nodes;
+    unpackNodes(nodeData, nodes);
+
+    Star* sortedStars = new Star[nStarsInFile];
+    for (uint32_t i = 0; i < nStarsInFile; i++)
+        sortedStars[i] = *unsortedList[order[i]];
+
+    StarOctree* root = StarOctree::create(std::move(nodes), sortedStars, nStarsInFile);
+    if (root == nullptr || (uint32_t) root->countObjects() != nStarsInFile)
+    {
+        delete root;
+        delete[] sortedStars;
+        return false;
+    }
+
+    delete octreeRoot;
+    delete[] stars;
+    unsortedStars.clear();
+
+    octreeRoot = root;
+    stars = sortedStars;
+
+    return true;
+}
+
+
+void StarDatabase::saveOctreeCache(const vector<uint32_t>& order, uint64_t key) const
+{
+    const vector<StarOctree::Node>& nodes = octreeRoot->getNodes();
+
+    ofstream out(octreeCacheFile.string(), ios::out | ios::binary);
+    if (!out.good())
+    {
+        fmt::fprintf(cerr, _("Error writing star octree cache %s\n"), octreeCacheFile);
+        return;
+    }
+
+    uint16_t version = OCTREE_CACHE_VERSION;
+    LE_TO_CPU_INT16(version, version);
+
+    out.write(OCTREE_CACHE_HEADER, sizeof OCTREE_CACHE_HEADER - 1);
+    out.write((char*) &version, sizeof version);
+    out.write((char*) &key, sizeof key);
+    writeUint(out, (uint32_t) order.size());
+    writeUint(out, (uint32_t) nodes.size());
+
+    for (const auto& node : nodes)
+    {
+        writeFloat(out, node.cellCenterPos.x());
+        writeFloat(out, node.cellCenterPos.y());
+        writeFloat(out, node.cellCenterPos.z());
+        writeFloat(out, node.exclusionFactor);
+        writeUint(out, node.firstObject);
+        writeUint(out, node.nObjects);
+        writeUint(out, node.firstChild);
+    }
+
+    for (uint32_t index : order)
+        writeUint(out, index);
+
+    if (!out.good())
+        fmt::fprintf(cerr, _("Error writing star octree cache %s\n"), octreeCacheFile);
+}
+
+
 void StarDatabase::finish()
 {
     fmt::fprintf(clog, _("Total star count: %d\n"), nStars);
 
-    buildOctree();
+    // The octree read from a sorted binary database can be used as is
+    // unless stc files added stars or modified the existing ones.
+    if (octreeRoot == nullptr || unsortedStars.size() > 0 || binFileStarsModified)
+    {
+        // Stars from a sorted binary database come first, as they would
+        // if the database had been loaded into the unsorted list.
+        vector<const Star*> unsortedList;
+        unsortedList.reserve(nStars);
+        if (octreeRoot != nullptr)
+        {
+            for (unsigned int i = 0; i < binFileStarCount; ++i)
+                unsortedList.push_back(&stars[i]);
+        }
+        for (unsigned int i = 0; i < unsortedStars.size(); ++i)
+            unsortedList.push_back(&unsortedStars[i]);
+
+        if (octreeCacheFile.empty())
+        {
+            buildOctree(unsortedList, nullptr);
+        }
+        else
+        {
+            uint64_t key = computeOctreeCacheKey(unsortedList);
+            octreeCached = loadOctreeCache(unsortedList, key);
+            if (!octreeCached)
+            {
+                vector<uint32_t> order;
+                buildOctree(unsortedList, &order);
+                saveOctreeCache(order, key);
+            }
+        }
+    }
     buildIndexes();
 
     // Delete the temporary indices used only during loading
@@ -751,10 +1164,10 @@ void StarDatabase::finish()
 }
 
 
-static void stcError(const Tokenizer& tok,
-                     const string& msg)
+static string stcErrorMessage(const Tokenizer& tok,
+                              const string& msg)
 {
-    fmt::fprintf(cerr,  _("Error in .stc file (line %i): %s\n"), tok.getLineNumber(), msg);
+    return fmt::sprintf(_("Error in .stc file (line %i): %s\n"), tok.getLineNumber(), msg);
 }
 
 
@@ -1160,14 +1573,30 @@ bool StarDatabase::createStar(Star* star,
  *  Modify <number>   : error
  */
 bool StarDatabase::load(istream& in, const fs::path& resourcePath)
+{
+    ParsedStarCatalog catalog;
+    parse(in, catalog);
+    return load(catalog, resourcePath);
+}
+
+
+void StarDatabase::parse(istream& in, ParsedStarCatalog& catalog)
 {
     Tokenizer tokenizer(&in);
-    Parser parser(&tokenizer);
+    parse(tokenizer, catalog);
+}
 
-#ifdef ENABLE_NLS
-    const char *d = resourcePath.string().c_str();
-    bindtextdomain(d, d); // domain name is the same as resource path
-#endif
+
+void StarDatabase::parse(const char* data, size_t size, ParsedStarCatalog& catalog)
+{
+    Tokenizer tokenizer(data, size);
+    parse(tokenizer, catalog);
+}
+
+
+void StarDatabase::parse(Tokenizer& tokenizer, ParsedStarCatalog& catalog)
+{
+    Parser parser(&tokenizer, catalog.getPool());
 
     while (tokenizer.nextToken() != Tokenizer::TokenEnd)
     {
@@ -1209,8 +1638,8 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
             }
             else
             {
-                stcError(tokenizer, "unrecognized object type");
-                return false;
+                catalog.error = stcErrorMessage(tokenizer, "unrecognized object type");
+                return;
             }
             tokenizer.nextToken();
         }
@@ -1224,17 +1653,56 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
         }
 
         string objName;
-        string firstName;
         if (tokenizer.getTokenType() == Tokenizer::TokenString)
         {
             // A star name (or names) is present
             objName    = tokenizer.getStringValue();
             tokenizer.nextToken();
-            if (!objName.empty())
-            {
-                string::size_type next = objName.find(':', 0);
-                firstName = objName.substr(0, next);
-            }
+        }
+
+        tokenizer.pushBack();
+
+        Value* starDataValue = parser.readValue();
+        if (starDataValue == nullptr)
+        {
+            catalog.error = "Error reading star.\n";
+            return;
+        }
+
+        if (starDataValue->getType() != Value::HashType)
+        {
+            catalog.error = "Bad star definition.\n";
+            delete starDataValue;
+            return;
+        }
+
+        catalog.entries.push_back({ disposition, isStar, catalogNumber, objName,
+                                    unique_ptr<Value>(starDataValue) });
+    }
+}
+
+
+/*! Add the entries of a parsed star catalog to the database. The star
+ *  definitions are consumed.
+ */
+bool StarDatabase::load(ParsedStarCatalog& catalog, const fs::path& resourcePath)
+{
+#ifdef ENABLE_NLS
+    const char *d = resourcePath.string().c_str();
+    bindtextdomain(d, d); // domain name is the same as resource path
+#endif
+
+    for (auto& entry : catalog.entries)
+    {
+        DataDisposition disposition = entry.disposition;
+        AstroCatalog::IndexNumber catalogNumber = entry.catalogNumber;
+        const string& objName = entry.objName;
+
+        string firstName;
+        if (!objName.empty())
+        {
+            string::size_type next = objName.find(':', 0);
+            firstName = objName.substr(0, next);
         }
 
         Star* star = nullptr;
@@ -1290,22 +1758,7 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
 
         bool isNewStar = star == nullptr;
 
-        tokenizer.pushBack();
-
-        Value* starDataValue = parser.readValue();
-        if (starDataValue == nullptr)
-        {
-            clog << "Error reading star.\n";
-            return false;
-        }
-
-        if (starDataValue->getType() != Value::HashType)
-        {
-            DPRINTF(LOG_LEVEL_ERROR, "Bad star definition.\n");
-            delete starDataValue;
-            return false;
-        }
-        Hash* starData = starDataValue->getHash();
+        Hash* starData = entry.starData->getHash();
 
         if (isNewStar)
             star = new Star();
@@ -1317,13 +1770,16 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
         }
         else
         {
-            ok = createStar(star, disposition, catalogNumber, starData, resourcePath, !isStar);
+            ok = createStar(star, disposition, catalogNumber, starData, resourcePath, !entry.isStar);
             star->loadCategories(starData, disposition, resourcePath.string());
         }
-        delete starDataValue;
+        entry.starData.reset();
 
         if (ok)
         {
+            if (!isNewStar && octreeRoot != nullptr)
+                binFileStarsModified = true;
+
             if (isNewStar)
             {
                 unsortedStars.add(*star);
@@ -1369,11 +1825,21 @@ bool StarDatabase::load(istream& in, const fs::path& resourcePath)
         }
     }
 
+    if (!catalog.error.empty())
+    {
+        cerr << catalog.error;
+        return false;
+    }
+
     return true;
 }
 
 
-void StarDatabase::buildOctree()
+/*! Sort the loaded stars into an octree. If order isn't null, it receives
+ *  the position in unsortedList of every star in the sorted array.
+ */
+void StarDatabase::buildOctree(const vector<const Star*>& unsortedList,
+                               vector<uint32_t>* order)
 {
     // This should only be called once for the database
     // ASSERT(octreeRoot == nullptr);
@@ -1383,11 +1849,34 @@ void StarDatabase::buildOctree()
                                       STAR_OCTREE_ROOT_SIZE * (float) sqrt(3.0));
     DynamicStarOctree* root = new DynamicStarOctree(Vector3f(1000.0f, 1000.0f, 1000.0f),
                                                     absMag);
-    for (unsigned int i = 0; i < unsortedStars.size(); ++i)
+    root->insertObjects(unsortedList, STAR_OCTREE_ROOT_SIZE,
+                        std::thread::hardware_concurrency());
+
+    if (order != nullptr)
     {
-        root->insertObject(unsortedStars[i], STAR_OCTREE_ROOT_SIZE);
+        vector<const Star*> sortedList;
+        sortedList.reserve(unsortedList.size());
+        root->getSortedObjects(sortedList);
+
+        vector<pair<const Star*, uint32_t>> indices;
+        indices.reserve(unsortedList.size());
+        for (uint32_t i = 0; i < unsortedList.size(); ++i)
+            indices.emplace_back(unsortedList[i], i);
+        sort(indices.begin(), indices.end());
+
+        order->clear();
+        order->reserve(sortedList.size());
+        for (const Star* star : sortedList)
+        {
+            auto iter = lower_bound(indices.begin(), indices.end(),
+                                    make_pair(star, (uint32_t) 0));
+            order->push_back(iter->second);
+        }
     }
 
+    delete octreeRoot;
+    octreeRoot = nullptr;
+
     DPRINTF(LOG_LEVEL_INFO, "Spatially sorting stars for improved locality of reference . . .\n");
     Star* sortedStars    = new Star[nStars];
     Star* firstStar      = sortedStars;
@@ -1414,7 +1903,7 @@ void StarDatabase::buildOctree()
 #endif
 
     // Clean up . . .
-    //delete[] stars;
+    delete[] stars;
     unsortedStars.clear();
     delete root;
 
@@ -20,6 +20,7 @@
 #include <celengine/star.h>
 #include <celengine/staroctree.h>
 #include <celengine/parseobject.h>
+#include <celengine/parsedcatalog.h>
 
 
 static const unsigned int MAX_STAR_NAMES = 10;
@@ -39,7 +40,7 @@ class StarDatabase
     Star* find(const std::string&) const;
     AstroCatalog::IndexNumber findCatalogNumberByName(const std::string&) const;
 
-    std::vector<std::string> getCompletion(const std::string&) const;
+    std::vector<std::string> getCompletion(const std::string&, size_t maxCompletions = SIZE_MAX) const;
 
     void findVisibleStars(StarHandler& starHandler,
                           const Eigen::Vector3f& obsPosition,
@@ -49,6 +50,25 @@ class StarDatabase
                           float limitingMag,
                           OctreeProcStats * = nullptr) const;
 
+    // Split the work of findVisibleStars() into about nTasks parts, listed
+    // in traversal order, which can be processed concurrently by the
+    // overload taking a task.
+    void splitVisibleStars(std::vector<StarOctree::TraversalTask>& tasks,
+                           const Eigen::Vector3f& obsPosition,
+                           const Eigen::Quaternionf& obsOrientation,
+                           float fovY,
+                           float aspectRatio,
+                           float limitingMag,
+                           size_t nTasks) const;
+    void findVisibleStars(const StarOctree::TraversalTask& task,
+                          StarHandler& starHandler,
+                          const Eigen::Vector3f& obsPosition,
+                          const Eigen::Quaternionf& obsOrientation,
+                          float fovY,
+                          float aspectRatio,
+                          float limitingMag,
+                          OctreeProcStats * = nullptr) const;
+
     void findCloseStars(StarHandler& starHandler,
                         const Eigen::Vector3f& obsPosition,
                         float radius) const;
@@ -60,9 +80,33 @@ class StarDatabase
     StarNameDatabase* getNameDatabase() const;
     void setNameDatabase(StarNameDatabase*);
 
+    // An entry of a text star catalog
+    struct CatalogEntry
+    {
+        DataDisposition disposition;
+        bool isStar;
+        AstroCatalog::IndexNumber catalogNumber;
+        std::string objName;
+        std::unique_ptr<Value> starData;
+    };
+    typedef ParsedCatalog<CatalogEntry> ParsedStarCatalog;
+
+    // Parse a text star catalog without modifying any database, so that
+    // several catalogs can be parsed in parallel
+    static void parse(std::istream&, ParsedStarCatalog&);
+    static void parse(const char* data, size_t size, ParsedStarCatalog&);
+
     bool load(std::istream&, const fs::path& resourcePath = fs::path());
+    bool load(ParsedStarCatalog&, const fs::path& resourcePath = fs::path());
     bool loadBinary(std::istream&);
 
+    const StarOctree* getOctree() const;
+
+    // File used to cache the octree between runs; the cache is used by
+    // finish() when it was built from exactly the same stars.
+    void setOctreeCacheFile(const fs::path&);
+    bool isOctreeCached() const;
+
     enum Catalog
     {
         HenryDraper = 0,
@@ -95,6 +139,8 @@ class StarDatabase
     static StarDatabase* read(std::istream&);
 
 private:
+    static void parse(Tokenizer&, ParsedStarCatalog&);
+
     bool createStar(Star* star,
                     DataDisposition disposition,
                     AstroCatalog::IndexNumber catalogNumber,
@@ -102,8 +148,14 @@ private:
                     const fs::path& path,
                     const bool isBarycenter);
 
-    void buildOctree();
+    bool loadUnsortedBinary(std::istream&);
+    bool loadSortedBinary(std::istream&);
+
+    void buildOctree(const std::vector<const Star*>& unsortedList,
+                     std::vector<uint32_t>* order);
     void buildIndexes();
+    bool loadOctreeCache(const std::vector<const Star*>& unsortedList, uint64_t key);
+    void saveOctreeCache(const std::vector<uint32_t>& order, uint64_t key) const;
     Star* findWhileLoading(AstroCatalog::IndexNumber catalogNumber) const;
 
     int nStars{ 0 };
@@ -116,12 +168,18 @@ private:
 
     std::vector<CrossIndex*> crossIndexes;
 
+    fs::path octreeCacheFile;
+    bool octreeCached{ false };
+
     // These values are used by the star database loader; they are
     // not used after loading is complete.
     BlockArray<Star> unsortedStars;
     // List of stars loaded from binary file, sorted by catalog number
     Star** binFileCatalogNumberIndex{ nullptr };
     unsigned int binFileStarCount{ 0 };
+    // Set when an stc file modifies a star of a prebuilt (sorted) binary
+    // file, which invalidates the octree read from that file
+    bool binFileStarsModified{ false };
     // Catalog number -> star mapping for stars loaded from stc files
     std::map<AstroCatalog::IndexNumber, Star*> stcFileCatalogNumberIndex;
 
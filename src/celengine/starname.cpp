@@ -74,9 +74,13 @@ uint32_t StarNameDatabase::findCatalogNumberByName(const string& name) const
         }
     }
 
-    catalogNumber = getCatalogNumberByName(priName);
-    if (catalogNumber != AstroCatalog::InvalidIndex)
-        return catalogNumber;
+    // The name was already looked up if it isn't a designation
+    if (priName != name)
+    {
+        catalogNumber = getCatalogNumberByName(priName);
+        if (catalogNumber != AstroCatalog::InvalidIndex)
+            return catalogNumber;
+    }
 
     priName += " A";  // try by appending an A
     catalogNumber = getCatalogNumberByName(priName);
@@ -67,7 +67,7 @@ DynamicStarOctree* DynamicStarOctree::getChild(const Star&          obj,
     child     |= objPos.y() < cellCenterPos.y() ? 0 : YPos;
     child     |= objPos.z() < cellCenterPos.z() ? 0 : ZPos;
 
-    return _children[child];
+    return &_children[child];
 }
 
 
@@ -83,49 +83,100 @@ template<> DynamicStarOctree::ExclusionFactorDecayFunction*
            DynamicStarOctree::decayFunction = starAbsoluteMagnitudeDecayFunction;
 
 
+void OctreeHotData<Star>::build(const Star* stars, uint32_t nStars)
+{
+    x.resize(nStars);
+    y.resize(nStars);
+    z.resize(nStars);
+    absMag.resize(nStars);
+
+    for (uint32_t i = 0; i < nStars; ++i)
+    {
+        const Vector3f& pos = stars[i].getPosition();
+        x[i]      = pos.x();
+        y[i]      = pos.y();
+        z[i]      = pos.z();
+        absMag[i] = stars[i].getAbsoluteMagnitude();
+    }
+}
+
+
+// Constants for computing astro::absToAppMag() with natural logarithms
+static const float AppMagScale  = (float) (5.0 / log(10.0));
+static const float AppMagOffset = (float) (-5.0 - 5.0 * log10(LY_PER_PARSEC));
+
+
 // total specialization of the StaticOctree template process*() methods for stars:
 template<>
-void StarOctree::processVisibleObjects(StarHandler&    processor,
-                                       const Vector3f& obsPosition,
-                                       const Hyperplane<float, 3>*   frustumPlanes,
-                                       float           limitingFactor,
-                                       float           scale,
-                                       OctreeProcStats *stats) const
+void StarOctree::processVisibleNode(uint32_t        nodeIndex,
+                                    StarHandler&    processor,
+                                    const Vector3f& obsPosition,
+                                    const OctreeFrustum<float>& frustum,
+                                    float           limitingFactor,
+                                    float           scale,
+                                    OctreeProcStats *stats,
+                                    bool            processChildren) const
 {
-#ifdef OCTREE_DEBUG
-    size_t h;
+    const Node& node = nodes[nodeIndex];
+
+    size_t h = 0;
     if (stats != nullptr)
     {
         h = stats->height + 1;
         stats->nodes++;
     }
-#endif
+
     // See if this node lies within the view frustum
 
-    // Test the cubic octree node against each one of the five
-    // planes that define the infinite view frustum.
-    for (unsigned int i = 0; i < 5; ++i)
-    {
-        const Hyperplane<float, 3>& plane = frustumPlanes[i];
-        float r = scale * plane.normal().cwiseAbs().sum();
-        if (plane.signedDistance(cellCenterPos) < -r)
-            return;
-    }
+    // Test the cubic octree node against the five planes that define the
+    // infinite view frustum.
+    if (frustum.cullsNode(node.cellCenterPos, scale))
+        return;
 
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
-    float minDistance = (obsPosition - cellCenterPos).norm() - scale * StarOctree::SQRT3;
+    float minDistance = (obsPosition - node.cellCenterPos).norm() - scale * StarOctree::SQRT3;
 
     // Process the objects in this node
     float dimmest     = minDistance > 0 ? astro::appToAbsMag(limitingFactor, minDistance) : 1000;
 
-    for (unsigned int i=0; i<nObjects; ++i)
+    if (stats != nullptr)
+        stats->objects += node.nObjects;
+
+    // Process the stars of the node eight at a time, computing distances
+    // and apparent magnitudes from the packed positions and magnitudes;
+    // the Star objects are only accessed for the stars passed to the
+    // processor.
+    typedef Eigen::Array<float, 8, 1> Packet;
+
+    uint32_t i   = node.firstObject;
+    uint32_t end = node.firstObject + node.nObjects;
+    for (; i + 8 <= end; i += 8)
+    {
+        Map<const Packet> absMag(&hotData.absMag[i]);
+        Eigen::Array<bool, 8, 1> bright = absMag < dimmest;
+        if (!bright.any())
+            continue;
+
+        Packet dx = Map<const Packet>(&hotData.x[i]) - obsPosition.x();
+        Packet dy = Map<const Packet>(&hotData.y[i]) - obsPosition.y();
+        Packet dz = Map<const Packet>(&hotData.z[i]) - obsPosition.z();
+        Packet distance = (dx.square() + dy.square() + dz.square()).sqrt();
+        Packet appMag   = absMag + distance.log() * AppMagScale + AppMagOffset;
+
+        Eigen::Array<bool, 8, 1> visible = bright && appMag < limitingFactor;
+        Eigen::Array<bool, 8, 1> close   = bright && distance < MAX_STAR_ORBIT_RADIUS;
+        for (int j = 0; j < 8; ++j)
+        {
+            const Star& obj = _objects[i + j];
+            if (visible[j] || (close[j] && obj.getOrbit()))
+                processor.process(obj, distance[j], appMag[j]);
+        }
+    }
+
+    for (; i < end; ++i)
     {
-#ifdef OCTREE_DEBUG
-        if (stats != nullptr)
-            stats->objects++;
-#endif
-        const Star& obj = _firstObject[i];
+        const Star& obj = _objects[i];
 
         if (obj.getAbsoluteMagnitude() < dimmest)
         {
@@ -139,43 +190,106 @@ void StarOctree::processVisibleObjects(StarHandler&    processor,
 
     // See if any of the objects in child nodes are potentially included
     // that we need to recurse deeper.
-    if (minDistance <= 0 || astro::absToAppMag(exclusionFactor, minDistance) <= limitingFactor)
+    if (processChildren &&
+        (minDistance <= 0 || astro::absToAppMag(node.exclusionFactor, minDistance) <= limitingFactor))
     {
         // Recurse into the child nodes
-        if (_children != nullptr)
+        if (node.firstChild != 0)
         {
-            for (int i=0; i<8; ++i)
+            for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
             {
-                _children[i]->processVisibleObjects(processor,
-                                                    obsPosition,
-                                                    frustumPlanes,
-                                                    limitingFactor,
-                                                    scale * 0.5f,
-                                                    stats
-                                                   );
-#ifdef OCTREE_DEBUG
+                processVisibleNode(i,
+                                   processor,
+                                   obsPosition,
+                                   frustum,
+                                   limitingFactor,
+                                   scale * 0.5f,
+                                   stats,
+                                   true);
                 if (stats != nullptr && stats->height > h)
                     h = stats->height;
-#endif
             }
-#ifdef OCTREE_DEBUG
             if (stats != nullptr)
                 stats->height = h;
-#endif
+        }
+    }
+}
+
+
+// Expand the traversal down to the given depth, making the nodes above it
+// tasks of their own and the nodes at that depth subtree tasks, using the
+// same tests as processVisibleNode().
+static void splitVisibleNode(const std::vector<StarOctree::Node>& nodes,
+                             uint32_t nodeIndex,
+                             const Vector3f& obsPosition,
+                             const OctreeFrustum<float>& frustum,
+                             float limitingFactor,
+                             float scale,
+                             unsigned int level,
+                             unsigned int depth,
+                             std::vector<StarOctree::TraversalTask>& tasks)
+{
+    const StarOctree::Node& node = nodes[nodeIndex];
+
+    if (depth == 0 || node.firstChild == 0)
+    {
+        tasks.push_back(StarOctree::TraversalTask{ nodeIndex, scale, true, level });
+        return;
+    }
+
+    if (frustum.cullsNode(node.cellCenterPos, scale))
+        return;
+
+    if (node.nObjects > 0)
+        tasks.push_back(StarOctree::TraversalTask{ nodeIndex, scale, false, level });
+
+    float minDistance = (obsPosition - node.cellCenterPos).norm() - scale * (float) sqrt(3.0);
+    if (minDistance <= 0 || astro::absToAppMag(node.exclusionFactor, minDistance) <= limitingFactor)
+    {
+        for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
+        {
+            splitVisibleNode(nodes, i, obsPosition, frustum, limitingFactor,
+                             scale * 0.5f, level + 1, depth - 1, tasks);
         }
     }
 }
 
 
 template<>
-void StarOctree::processCloseObjects(StarHandler&    processor,
+void StarOctree::splitVisibleObjects(std::vector<TraversalTask>& tasks,
                                      const Vector3f& obsPosition,
-                                     float           boundingRadius,
-                                     float           scale) const
+                                     const Hyperplane<float, 3>* frustumPlanes,
+                                     float           limitingFactor,
+                                     float           scale,
+                                     size_t          nTasks) const
 {
+    // Deeper splits give more, smaller tasks; stop at the first depth
+    // giving enough of them.
+    const unsigned int MaxSplitDepth = 8;
+
+    OctreeFrustum<float> frustum(frustumPlanes);
+    for (unsigned int depth = 1; depth <= MaxSplitDepth; ++depth)
+    {
+        tasks.clear();
+        splitVisibleNode(nodes, 0, obsPosition, frustum, limitingFactor, scale, 0, depth, tasks);
+        if (tasks.size() >= nTasks)
+            break;
+    }
+}
+
+
+template<>
+void StarOctree::processCloseNode(uint32_t        nodeIndex,
+                                  StarHandler&    processor,
+                                  const Vector3f& obsPosition,
+                                  float           boundingRadius,
+                                  float           scale) const
+{
+    const Node& node = nodes[nodeIndex];
+
     // Compute the distance to node; this is equal to the distance to
     // the cellCenterPos of the node minus the boundingRadius of the node, scale * SQRT3.
-    float nodeDistance    = (obsPosition - cellCenterPos).norm() - scale * StarOctree::SQRT3;
+    float nodeDistance    = (obsPosition - node.cellCenterPos).norm() - scale * StarOctree::SQRT3;
 
     if (nodeDistance > boundingRadius)
         return;
@@ -188,9 +302,10 @@ void StarOctree::processCloseObjects(StarHandler&    processor,
     float radiusSquared    = boundingRadius * boundingRadius;
 
     // Check all the objects in the node.
-    for (unsigned int i = 0; i < nObjects; ++i)
+    const Star* firstObject = _objects + node.firstObject;
+    for (unsigned int i = 0; i < node.nObjects; ++i)
     {
-        Star& obj = _firstObject[i];
+        const Star& obj = firstObject[i];
 
         if ((obsPosition - obj.getPosition()).squaredNorm() < radiusSquared)
         {
@@ -202,14 +317,15 @@ void StarOctree::processCloseObjects(StarHandler&    processor,
     }
 
     // Recurse into the child nodes
-    if (_children != nullptr)
+    if (node.firstChild != 0)
     {
-        for (int i = 0; i < 8; ++i)
+        for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
         {
-            _children[i]->processCloseObjects(processor,
-                                              obsPosition,
-                                              boundingRadius,
-                                              scale * 0.5f);
+            processCloseNode(i,
+                             processor,
+                             obsPosition,
+                             boundingRadius,
+                             scale * 0.5f);
         }
     }
 }
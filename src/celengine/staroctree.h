@@ -15,6 +15,24 @@
 
 #include <celengine/star.h>
 #include <celengine/octree.h>
+#include <vector>
+
+
+// Positions and absolute magnitudes of the sorted stars in separate
+// arrays, so that the stars of an octree node can be culled with a
+// vectorized loop without touching the Star objects themselves.
+template <> class OctreeHotData<Star>
+{
+ public:
+    typedef std::vector<float, Eigen::aligned_allocator<float>> FloatArray;
+
+    void build(const Star* stars, uint32_t nStars);
+
+    FloatArray x;
+    FloatArray y;
+    FloatArray z;
+    FloatArray absMag;
+};
 
 
 typedef DynamicOctree  <Star, float> DynamicStarOctree;
@@ -9,8 +9,11 @@
 
 #include <config.h>
 #include <celutil/debug.h>
+#include <celutil/filetype.h>
+#include <celutil/profiler.h>
 #include <iostream>
 #include <fstream>
+#include "glsupport.h"
 #include "multitexture.h"
 #include "texmanager.h"
 
@@ -112,31 +115,88 @@ fs::path TextureInfo::resolve(const fs::path& baseDir)
 }
 
 
-Texture* TextureInfo::load(const fs::path& name)
+Texture::AddressMode TextureInfo::addressMode() const
 {
-    Texture::AddressMode addressMode = Texture::EdgeClamp;
-    Texture::MipMapMode mipMode = Texture::DefaultMipMaps;
-
     if (flags & WrapTexture)
-        addressMode = Texture::Wrap;
-    else if (flags & BorderClamp)
-        addressMode = Texture::BorderClamp;
+        return Texture::Wrap;
+    if (flags & BorderClamp)
+        return Texture::BorderClamp;
+    return Texture::EdgeClamp;
+}
+
 
+Texture::MipMapMode TextureInfo::mipMode() const
+{
     if (flags & NoMipMaps)
-        mipMode = Texture::NoMipMaps;
-    else if (flags & AutoMipMaps)
-        mipMode = Texture::AutoMipMaps;
+        return Texture::NoMipMaps;
+    if (flags & AutoMipMaps)
+        return Texture::AutoMipMaps;
+    return Texture::DefaultMipMaps;
+}
+
+
+Texture* TextureInfo::load(const fs::path& name)
+{
+    PROFILE_SCOPE("Texture loading");
 
     if (bumpHeight == 0.0f)
     {
         DPRINTF(LOG_LEVEL_ERROR, "Loading texture: %s\n", name);
         // cout << "Loading texture: " << name << '\n';
 
-        return LoadTextureFromFile(name, addressMode, mipMode);
+        return LoadTextureFromFile(name, addressMode(), mipMode());
     }
 
     DPRINTF(LOG_LEVEL_ERROR, "Loading bump map: %s\n", name);
     // cout << "Loading texture: " << name << '\n';
 
-    return LoadHeightMapFromFile(name, bumpHeight, addressMode);
+    return LoadHeightMapFromFile(name, bumpHeight, addressMode());
+}
+
+
+// Decode the image, and compute the normal map from a height map, on the
+// loading thread.
+bool TextureInfo::prepare(const fs::path& name)
+{
+    // Virtual textures load their tiles when they're needed
+    if (DetermineFileType(name) == Content_CelestiaTexture)
+        return true;
+
+    DPRINTF(LOG_LEVEL_ERROR, "Loading texture in the background: %s\n", name);
+
+    image.reset(LoadImageFromFile(name));
+    if (image != nullptr && bumpHeight != 0.0f)
+        image.reset(image->computeNormalMap(bumpHeight, addressMode() == Texture::Wrap));
+
+    return image != nullptr;
+}
+
+
+Texture* TextureInfo::create(const fs::path& name)
+{
+    if (image == nullptr)
+        return load(name);
+
+    PROFILE_SCOPE("Texture creation");
+
+    Texture* tex = CreateTextureFromImage(*image, addressMode(),
+                                          bumpHeight == 0.0f ? mipMode() : Texture::DefaultMipMaps);
+
+    // As in LoadTextureFromFile(), .dxt5nm files are DXT5 normal maps
+    if (tex != nullptr &&
+        DetermineFileType(name) == Content_DXT5NormalMap &&
+        image->getFormat() == GL_COMPRESSED_RGBA_S3TC_DXT5_EXT)
+    {
+        tex->setFormatOptions(Texture::DXT5NormalMap);
+    }
+
+    image.reset();
+
+    return tex;
+}
+
+
+size_t TextureInfo::getMemoryUsage() const
+{
+    return resource->getMemoryUsage();
 }
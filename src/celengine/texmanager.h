@@ -12,6 +12,7 @@
 
 #include <string>
 #include <map>
+#include <memory>
 #include <celutil/resmanager.h>
 #include <celengine/texture.h>
 #include "multitexture.h"
@@ -67,6 +68,16 @@ class TextureInfo : public ResourceInfo<Texture>
 
     fs::path resolve(const fs::path&) override;
     Texture* load(const fs::path&) override;
+    bool prepare(const fs::path&) override;
+    Texture* create(const fs::path&) override;
+    size_t getMemoryUsage() const override;
+
+ private:
+    Texture::AddressMode addressMode() const;
+    Texture::MipMapMode mipMode() const;
+
+    // Read by prepare(), and turned into a texture by create()
+    std::shared_ptr<Image> image;
 };
 
 inline bool operator<(const TextureInfo& ti0, const TextureInfo& ti1)
@@ -288,6 +288,15 @@ static int CalcMipLevelCount(int w, int h)
 }
 
 
+// The size of the texels of an image, plus a third for the mipmaps when
+// they're generated by OpenGL
+static size_t TextureMemoryUsage(const Image& img, bool genMipmaps)
+{
+    size_t size = img.getSize();
+    return genMipmaps ? size + size / 3 : size;
+}
+
+
 Texture::Texture(int w, int h, int d) :
     width(w),
     height(h),
@@ -442,6 +451,7 @@ ImageTexture::ImageTexture(Image& img,
 
     alpha = img.hasAlpha();
     compressed = img.isCompressed();
+    memoryUsage = TextureMemoryUsage(img, genMipmaps);
 }
 
 
@@ -649,6 +659,8 @@ TiledTexture::TiledTexture(Image& img,
     }
 
     delete tile;
+
+    memoryUsage = TextureMemoryUsage(img, mipmap && !precomputedMipMaps);
 }
 
 
@@ -949,9 +961,9 @@ static bool isPow2(int x)
 }
 #endif
 
-static Texture* CreateTextureFromImage(Image& img,
-                                       Texture::AddressMode addressMode,
-                                       Texture::MipMapMode mipMode)
+Texture* CreateTextureFromImage(Image& img,
+                                Texture::AddressMode addressMode,
+                                Texture::MipMapMode mipMode)
 {
 #if 0
     // Require texture dimensions to be powers of two.  Even though the
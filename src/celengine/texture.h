@@ -73,6 +73,9 @@ class Texture
     bool hasAlpha() const { return alpha; }
     bool isCompressed() const { return compressed; }
 
+    //! Approximate size of the texture in video memory, in bytes
+    size_t getMemoryUsage() const { return memoryUsage; }
+
     /*! Identical formats may need to be treated in slightly different
      *  fashions. One (and currently the only) example is the DXT5 compressed
      *  normal map format, which is an ordinary DXT5 texture but requires some
@@ -105,6 +108,7 @@ class Texture
  protected:
     bool alpha{ false };
     bool compressed{ false };
+    size_t memoryUsage{ 0 };
 
  private:
     int width;
@@ -180,6 +184,12 @@ extern Texture* CreateProceduralTexture(int width, int height,
 extern Texture* CreateProceduralCubeMap(int size, int format,
                                         ProceduralTexEval func);
 
+// Make a texture from an image already loaded, which may have been decoded
+// on another thread than the one with the OpenGL context.
+extern Texture* CreateTextureFromImage(Image& img,
+                                       Texture::AddressMode addressMode = Texture::EdgeClamp,
+                                       Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
+
 extern Texture* LoadTextureFromFile(const fs::path& filename,
                                     Texture::AddressMode addressMode = Texture::EdgeClamp,
                                     Texture::MipMapMode mipMode = Texture::DefaultMipMaps);
@@ -15,18 +15,76 @@
 #include "tokenizer.h"
 
 
+using celestia::compat::string_view;
+
+
 static bool issep(char c)
 {
     return !isdigit(c) && !isalpha(c) && c != '.';
 }
 
 
+// The text is tokenized with ASCII character classes, independent of the
+// locale.
+static inline bool isDigitChar(char c)
+{
+    return c >= '0' && c <= '9';
+}
+
+static inline bool isAlphaChar(char c)
+{
+    return (c >= 'a' && c <= 'z') || (c >= 'A' && c <= 'Z');
+}
+
+static inline bool isNameChar(char c)
+{
+    return isAlphaChar(c) || isDigitChar(c) || c == '_';
+}
+
+static inline bool isSpaceChar(char c)
+{
+    return c == ' ' || (c >= '\t' && c <= '\r');
+}
+
+static inline int hexDigitValue(char c)
+{
+    if (c >= '0' && c <= '9')
+        return c - '0';
+    if (c >= 'a' && c <= 'f')
+        return c - 'a' + 10;
+    if (c >= 'A' && c <= 'F')
+        return c - 'A' + 10;
+    return -1;
+}
+
+
+static double makeNumber(double integerValue,
+                         double fractionValue,
+                         double fracExp,
+                         double exponentValue,
+                         double exponentSign,
+                         double sign)
+{
+    double value = integerValue + fractionValue / fracExp;
+    if (exponentValue != 0)
+        value *= pow(10.0, exponentValue * exponentSign);
+    return value * sign;
+}
+
+
 Tokenizer::Tokenizer(istream* _in) :
     in(_in)
 {
 }
 
 
+Tokenizer::Tokenizer(const char* data, size_t size) :
+    pos(data),
+    end(data + size)
+{
+}
+
+
 Tokenizer::TokenType Tokenizer::nextToken()
 {
     State state = StartState;
@@ -37,6 +95,13 @@ Tokenizer::TokenType Tokenizer::nextToken()
         return tokenType;
     }
 
+    if (in == nullptr)
+    {
+        if (tokenType != TokenEnd)
+            tokenType = scanToken();
+        return tokenType;
+    }
+
     textToken = "";
     haveValidNumber = false;
     haveValidName = false;
@@ -367,18 +432,239 @@ Tokenizer::TokenType Tokenizer::nextToken()
     }
 
     tokenType = newToken;
+    textView = textToken;
     if (haveValidNumber)
     {
-        numberValue = integerValue + fractionValue / fracExp;
-        if (exponentValue != 0)
-            numberValue *= pow(10.0, exponentValue * exponentSign);
-        numberValue *= sign;
+        numberValue = makeNumber(integerValue, fractionValue, fracExp,
+                                 exponentValue, exponentSign, sign);
     }
 
     return tokenType;
 }
 
 
+// Read the next token from text in memory. This accepts the same tokens
+// as the stream tokenizer and computes identical number values, but scans
+// each token in a tight loop and returns names and strings without
+// escapes as views of the text.
+Tokenizer::TokenType Tokenizer::scanToken()
+{
+    textView = string_view();
+
+    // Skip white space and comments
+    for (;;)
+    {
+        while (pos != end && isSpaceChar(*pos))
+        {
+            if (*pos == '\n')
+                lineNum++;
+            pos++;
+        }
+
+        if (pos == end)
+            return TokenEnd;
+        if (*pos != '#')
+            break;
+
+        while (pos != end && *pos != '\n' && *pos != '\r')
+            pos++;
+    }
+
+    char c = *pos;
+    if (isDigitChar(c) || c == '-' || c == '+' || c == '.')
+        return scanNumber();
+
+    if (isAlphaChar(c) || c == '_')
+    {
+        const char* start = pos;
+        while (++pos != end && isNameChar(*pos));
+        textView = string_view(start, pos - start);
+        return TokenName;
+    }
+
+    TokenType type;
+    switch (c)
+    {
+    case '"':
+        return scanString();
+    case '{':
+        type = TokenBeginGroup;
+        break;
+    case '}':
+        type = TokenEndGroup;
+        break;
+    case '[':
+        type = TokenBeginArray;
+        break;
+    case ']':
+        type = TokenEndArray;
+        break;
+    case '=':
+        type = TokenEquals;
+        break;
+    case '|':
+        type = TokenBar;
+        break;
+    case '<':
+        type = TokenBeginUnits;
+        break;
+    case '>':
+        type = TokenEndUnits;
+        break;
+    default:
+        syntaxError("Bad character in stream");
+        return TokenError;
+    }
+
+    pos++;
+    return type;
+}
+
+
+Tokenizer::TokenType Tokenizer::scanNumber()
+{
+    double integerValue = 0;
+    double fractionValue = 0;
+    double sign = 1;
+    double fracExp = 1;
+    double exponentValue = 0;
+    double exponentSign = 1;
+
+    if (*pos == '-')
+    {
+        sign = -1;
+        pos++;
+    }
+    else if (*pos == '+')
+    {
+        pos++;
+    }
+
+    // The digits are accumulated with the same expressions as in the
+    // stream tokenizer so that the values are identical.
+    for (; pos != end && isDigitChar(*pos); pos++)
+        integerValue = integerValue * 10 + (int) *pos - (int) '0';
+
+    if (pos != end && *pos == '.')
+    {
+        for (pos++; pos != end && isDigitChar(*pos); pos++)
+        {
+            fractionValue = fractionValue * 10 + *pos - (int) '0';
+            fracExp *= 10;
+        }
+    }
+
+    if (pos != end && (*pos == 'e' || *pos == 'E'))
+    {
+        pos++;
+        if (pos != end && (*pos == '-' || *pos == '+'))
+        {
+            if (*pos == '-')
+                exponentSign = -1;
+            pos++;
+        }
+        else if (pos == end || !isDigitChar(*pos))
+        {
+            syntaxError("Bad character in number");
+            return TokenError;
+        }
+
+        for (; pos != end && isDigitChar(*pos); pos++)
+            exponentValue = exponentValue * 10 + (int) *pos - (int) '0';
+    }
+
+    if (pos != end && (isAlphaChar(*pos) || *pos == '.'))
+    {
+        syntaxError("Bad character in number");
+        return TokenError;
+    }
+
+    numberValue = makeNumber(integerValue, fractionValue, fracExp,
+                             exponentValue, exponentSign, sign);
+    return TokenNumber;
+}
+
+
+Tokenizer::TokenType Tokenizer::scanString()
+{
+    const char* start = ++pos;
+    while (pos != end && *pos != '"' && *pos != '\\')
+    {
+        if (*pos == '\n')
+            lineNum++;
+        pos++;
+    }
+
+    if (pos != end && *pos == '"')
+    {
+        textView = string_view(start, pos - start);
+        pos++;
+        return TokenString;
+    }
+
+    // Strings with escapes are copied with the escapes replaced
+    textToken.assign(start, pos - start);
+    while (pos != end && *pos != '"')
+    {
+        char c = *pos++;
+        if (c == '\n')
+            lineNum++;
+        if (c != '\\')
+        {
+            textToken += c;
+            continue;
+        }
+
+        c = pos == end ? '\0' : *pos++;
+        if (c == '\\')
+        {
+            textToken += '\\';
+        }
+        else if (c == 'n')
+        {
+            textToken += '\n';
+        }
+        else if (c == '"')
+        {
+            textToken += '"';
+        }
+        else if (c == 'u')
+        {
+            unsigned int value = 0;
+            for (int i = 0; i < 4; i++, pos++)
+            {
+                int digitValue = pos == end ? -1 : hexDigitValue(*pos);
+                if (digitValue < 0)
+                {
+                    syntaxError("Bad Unicode escape in string");
+                    return TokenError;
+                }
+                value = (value << 4) + digitValue;
+            }
+
+            char utf8Encoded[7];
+            UTF8Encode((wchar_t) value, utf8Encoded);
+            textToken += utf8Encoded;
+        }
+        else
+        {
+            syntaxError("Unknown escape code in string");
+            return TokenError;
+        }
+    }
+
+    if (pos == end)
+    {
+        syntaxError("Unterminated string");
+        return TokenError;
+    }
+
+    pos++;
+    textView = textToken;
+    return TokenString;
+}
+
+
 Tokenizer::TokenType Tokenizer::getTokenType()
 {
     return tokenType;
@@ -399,13 +685,25 @@ double Tokenizer::getNumberValue()
 
 string Tokenizer::getNameValue()
 {
-    return textToken;
+    return string(textView);
 }
 
 
 string Tokenizer::getStringValue()
 {
-    return textToken;
+    return string(textView);
+}
+
+
+string_view Tokenizer::getNameView() const
+{
+    return textView;
+}
+
+
+string_view Tokenizer::getStringView() const
+{
+    return textView;
 }
 
 
@@ -426,6 +724,11 @@ void Tokenizer::syntaxError(const char* message)
 
 int Tokenizer::getLineNumber() const
 {
+    // The stream tokenizer has always read the character after a token,
+    // so a newline there is counted.
+    if (in == nullptr && pos != end && *pos == '\n')
+        return lineNum + 1;
+
     return lineNum;
 }
 
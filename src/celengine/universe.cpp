@@ -1084,7 +1084,8 @@ Selection Universe::findPath(const string& s,
 vector<string> Universe::getCompletion(const string& s,
                                                  Selection* contexts,
                                                  int nContexts,
-                                                 bool withLocations)
+                                                 bool withLocations,
+                                                 size_t maxCompletions)
 {
     vector<string> completion;
     int s_length = UTF8Length(s);
@@ -1118,17 +1119,23 @@ vector<string> Universe::getCompletion(const string& s,
         }
     }
 
+    if (completion.size() >= maxCompletions)
+    {
+        completion.resize(maxCompletions);
+        return completion;
+    }
+
     // Deep sky objects:
     if (dsoCatalog != nullptr)
     {
-        vector<string> dsos  = dsoCatalog->getCompletion(s);
+        vector<string> dsos  = dsoCatalog->getCompletion(s, maxCompletions - completion.size());
         completion.insert(completion.end(), dsos.begin(), dsos.end());
     }
 
     // and finally stars;
-    if (starCatalog != nullptr)
+    if (starCatalog != nullptr && completion.size() < maxCompletions)
     {
-        vector<string> stars  = starCatalog->getCompletion(s);
+        vector<string> stars  = starCatalog->getCompletion(s, maxCompletions - completion.size());
         completion.insert(completion.end(), stars.begin(), stars.end());
     }
 
@@ -1139,14 +1146,15 @@ vector<string> Universe::getCompletion(const string& s,
 vector<string> Universe::getCompletionPath(const string& s,
                                            Selection* contexts,
                                            int nContexts,
-                                           bool withLocations)
+                                           bool withLocations,
+                                           size_t maxCompletions)
 {
     vector<string> completion;
     vector<string> locationCompletion;
     string::size_type pos = s.rfind('/', s.length());
 
     if (pos == string::npos)
-        return getCompletion(s, contexts, nContexts, withLocations);
+        return getCompletion(s, contexts, nContexts, withLocations, maxCompletions);
 
     string base(s, 0, pos);
     Selection sel = findPath(base, contexts, nContexts, true);
@@ -1191,6 +1199,8 @@ vector<string> Universe::getCompletionPath(const string& s,
         completion = worlds->getCompletion(s.substr(pos + 1), false);
 
     completion.insert(completion.end(), locationCompletion.begin(), locationCompletion.end());
+    if (completion.size() > maxCompletions)
+        completion.resize(maxCompletions);
 
     return completion;
 }
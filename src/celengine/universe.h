@@ -71,11 +71,13 @@ class Universe
     std::vector<std::string> getCompletion(const std::string& s,
                                            Selection* contexts = nullptr,
                                            int nContexts = 0,
-                                           bool withLocations = false);
+                                           bool withLocations = false,
+                                           size_t maxCompletions = SIZE_MAX);
     std::vector<std::string> getCompletionPath(const std::string& s,
                                                Selection* contexts = nullptr,
                                                int nContexts = 0,
-                                               bool withLocations = false);
+                                               bool withLocations = false,
+                                               size_t maxCompletions = SIZE_MAX);
 
 
     SolarSystem* getNearestSolarSystem(const UniversalCoord& position) const;
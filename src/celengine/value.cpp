@@ -10,6 +10,18 @@
 
 #include "value.h"
 
+// Destroy a container, which is allocated from the pool its allocator uses
+template <class T> static void destroyContainer(T* p)
+{
+    if (p == nullptr)
+        return;
+
+    if (p->get_allocator().pool() == nullptr)
+        delete p;
+    else
+        p->~T();
+}
+
 /****** Value method implementations *******/
 
 Value::~Value()
@@ -17,20 +29,31 @@ Value::~Value()
     switch (type)
     {
     case StringType:
-        delete data.s;
+        destroyContainer(data.s);
         break;
     case ArrayType:
         if (data.a != nullptr)
         {
             for (auto *p : *data.a)
-                delete p;
-            delete data.a;
+                destroy(p);
+            destroyContainer(data.a);
         }
         break;
     case HashType:
-        delete data.h;
+        destroyContainer(data.h);
         break;
     default:
         break;
     }
 }
+
+void Value::destroy(Value* value)
+{
+    if (value == nullptr)
+        return;
+
+    if (value->poolAllocated)
+        value->~Value();
+    else
+        delete value;
+}
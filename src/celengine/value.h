@@ -11,13 +11,18 @@
 #pragma once
 
 #include <cassert>
+#include <new>
 #include <string>
+#include <utility>
 #include <vector>
+#include <celcompat/string_view.h>
+#include <celutil/memorypool.h>
 #include "hash.h"
 
 class Value;
-using Array = std::vector<Value*>;
+using Array = std::vector<Value*, PoolAllocator<Value*>>;
 using ValueArray = Array;
+using ValueString = std::basic_string<char, std::char_traits<char>, PoolAllocator<char>>;
 
 class Value
 {
@@ -45,12 +50,19 @@ class Value
     }
     Value(const char *s) : type(StringType)
     {
-        data.s = new std::string(s);
+        data.s = new ValueString(s);
     }
     explicit Value(const std::string &s) : type(StringType)
     {
-        data.s = new std::string(s);
+        data.s = new ValueString(s.data(), s.size());
     }
+    // The string is copied to the pool, or to the heap if pool is nullptr
+    Value(celestia::compat::string_view s, MemoryPool *pool) : type(StringType)
+    {
+        data.s = create<ValueString>(pool, s.data(), s.size(), PoolAllocator<char>(pool));
+    }
+    // Arrays and hashes may be allocated from a pool with create(); their
+    // contents are then expected to come from the same pool.
     Value(Array *a) : type(ArrayType)
     {
         data.a = a;
@@ -80,7 +92,7 @@ class Value
     std::string getString() const
     {
         assert(type == StringType);
-        return *data.s;
+        return std::string(data.s->data(), data.s->size());
     }
     Array* getArray() const
     {
@@ -98,15 +110,36 @@ class Value
         return (data.d != 0.0);
     }
 
+    // Construct an object in the pool, or on the heap if pool is nullptr
+    template <class T, class... Args> static T* create(MemoryPool* pool, Args&&... args)
+    {
+        if (pool == nullptr)
+            return new T(std::forward<Args>(args)...);
+
+        void* memory = pool->allocate(sizeof(T));
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        T* p = new (memory) T(std::forward<Args>(args)...);
+        markPoolAllocated(p);
+        return p;
+    }
+
+    // Release a value whether it was allocated from a pool or the heap
+    static void destroy(Value* value);
+
  private:
+    static void markPoolAllocated(Value* value) { value->poolAllocated = true; }
+    template <class T> static void markPoolAllocated(T*) {}
+
     union Data
     {
-        std::string *s;
+        ValueString *s;
         double       d;
         Array       *a;
         Hash        *h;
     };
 
     ValueType type { NullType };
+    bool poolAllocated { false };
     Data data;
 };
@@ -15,7 +15,7 @@
 #include <celmath/geomutil.h>
 #include <cassert>
 #include <vector>
-#include <fstream>
+#include <iostream>
 #include <celutil/debug.h>
 
 using namespace Eigen;
@@ -3054,6 +3054,9 @@ class HTC20Orbit : public CachingOrbit
 };
 
 
+// Times evaluated together by JPLEphOrbit::positionsAtTimes()
+static const size_t JPLEphBatchSize = 64;
+
 class JPLEphOrbit : public CachingOrbit
 {
  public:
@@ -3083,42 +3086,109 @@ class JPLEphOrbit : public CachingOrbit
 
     Vector3d computePosition(double tjd) const override
     {
+        // Get the positions of the target, and of the center and Earth
+        // when needed, together, so that the ephemeris record is looked up
+        // and the Moon is evaluated only once.
+        JPLEphemItem items[3] = { target, center, JPLEph_Earth };
+        Vector3d positions[3];
+        size_t nItems = needsCenter() ? (needsEarth() ? 3 : 2) : 1;
+        ephem.getPlanetPositions(tjd,
+                                 celestia::compat::span<const JPLEphemItem>(items, nItems),
+                                 celestia::compat::span<Vector3d>(positions, nItems));
+
         // Get the position relative to the Earth (for the Moon) or
         // the solar system barycenter.
-        Vector3d pos = ephem.getPlanetPosition(target, tjd);
+        Vector3d pos = positions[0];
 
-        if (center == JPLEph_SSB && target != JPLEph_Moon)
-        {
-            // No translation necessary
-        }
-        else if (center == JPLEph_Earth && target == JPLEph_Moon)
-        {
-            // No translation necessary
-        }
-        else
+        if (needsCenter())
         {
-            Vector3d centerPos = ephem.getPlanetPosition(center, tjd);
+            Vector3d centerPos = positions[1];
             if (target == JPLEph_Moon)
             {
-                pos += ephem.getPlanetPosition(JPLEph_Earth, tjd);
+                pos += positions[2];
             }
             if (center == JPLEph_Moon)
             {
-                centerPos += ephem.getPlanetPosition(JPLEph_Earth, tjd);
+                centerPos += positions[2];
             }
 
             // Compute the position of target relative to the center
             pos -= centerPos;
         }
 
+        return toCelestiaCoordinates(pos);
+    }
+
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Vector3d> positions) const override
+    {
+        // The positions of the target, and those of the center and Earth
+        // in blocks of times, are each evaluated in one pass through the
+        // records.
+        ephem.getPlanetPositions(target, times, positions);
+
+        if (needsCenter())
+        {
+            Vector3d centerPositions[JPLEphBatchSize];
+            Vector3d earthPositions[JPLEphBatchSize];
+            for (size_t start = 0; start < times.size(); start += JPLEphBatchSize)
+            {
+                size_t n = min(JPLEphBatchSize, times.size() - start);
+                celestia::compat::span<const double> blockTimes = times.subspan(start, n);
+                ephem.getPlanetPositions(center, blockTimes,
+                                         celestia::compat::span<Vector3d>(centerPositions, n));
+                if (needsEarth())
+                {
+                    ephem.getPlanetPositions(JPLEph_Earth, blockTimes,
+                                             celestia::compat::span<Vector3d>(earthPositions, n));
+                }
+
+                for (size_t i = 0; i < n; i++)
+                {
+                    Vector3d& pos = positions[start + i];
+                    Vector3d centerPos = centerPositions[i];
+                    if (target == JPLEph_Moon)
+                        pos += earthPositions[i];
+                    if (center == JPLEph_Moon)
+                        centerPos += earthPositions[i];
+                    pos -= centerPos;
+                }
+            }
+        }
+
+        for (size_t i = 0; i < times.size(); i++)
+            positions[i] = toCelestiaCoordinates(positions[i]);
+    }
+
+ private:
+    // Return true unless the ephemeris gives the position of the target
+    // relative to the center directly.
+    bool needsCenter() const
+    {
+        if (center == JPLEph_SSB && target != JPLEph_Moon)
+            return false;
+        if (center == JPLEph_Earth && target == JPLEph_Moon)
+            return false;
+        return true;
+    }
+
+    // Return true if the position of the Earth is needed along with those
+    // of the target and center: the Moon's is relative to the Earth.
+    bool needsEarth() const
+    {
+        return target == JPLEph_Moon || center == JPLEph_Moon;
+    }
+
+    static Vector3d toCelestiaCoordinates(const Vector3d& pos)
+    {
         // Rotate from the J2000 mean equator to the ecliptic
-        pos = XRotation(-astro::J2000Obliquity) * pos;
+        Vector3d v = XRotation(-astro::J2000Obliquity) * pos;
 
         // Convert to Celestia's coordinate system
-        return Vector3d(pos.x(), pos.z(), -pos.y());
+        return Vector3d(v.x(), v.z(), -v.y());
     }
 
- private:
+
     const JPLEphemeris& ephem;
     JPLEphemItem target;
     JPLEphemItem center;
@@ -3155,9 +3225,7 @@ Orbit* GetCustomOrbit(const string& name)
     if (!jplephInitialized)
     {
         jplephInitialized = true;
-        ifstream in("data/jpleph.dat", ios::in | ios::binary);
-        if (in.good())
-            jpleph = JPLEphemeris::load(in);
+        jpleph = JPLEphemeris::load("data/jpleph.dat");
         if (jpleph != nullptr)
         {
            fmt::fprintf(clog, "Loaded DE%u ephemeris. Valid from JD %.8lf to JD %.8lf\n",
@@ -10,14 +10,18 @@
 // Load JPL's DE200, DE405, and DE406 ephemerides and compute planet
 // positions.
 
-#include <fstream>
-#include <iomanip>
+#include <algorithm>
 #include <cassert>
+#include <cstdint>
+#include <cstring>
 #include <celutil/bytes.h>
+#include <celutil/mappedfile.h>
+#include <celutil/threadcache.h>
 #include "jpleph.h"
 
 using namespace Eigen;
 using namespace std;
+using celestia::compat::span;
 
 static const unsigned int DE200RecordSize    =  826;
 static const unsigned int DE405RecordSize    = 1018;
@@ -30,33 +34,82 @@ static const unsigned int MaxChebyshevCoeffs = 32;
 
 static const int LabelSize = 84;
 
+// Size of the part of the first record read by load()
+static const unsigned int HeaderSize = 2856;
 
-// Read a big-endian 32-bit unsigned integer
-static int32_t readUint(istream& in)
+
+// Read a big-endian 32-bit unsigned integer and move past it
+static uint32_t readUint(const char*& p)
 {
     int32_t ret;
-    in.read((char*) &ret, sizeof(int32_t));
+    memcpy(&ret, p, sizeof(int32_t));
+    p += sizeof(int32_t);
     BE_TO_CPU_INT32(ret, ret);
     return (uint32_t) ret;
 }
 
 // Read a big-endian 64-bit IEEE double--if the native double format isn't
 // IEEE 754, there will be troubles.
-static double readDouble(istream& in)
+static double getDouble(const char* p)
 {
     double d;
-    in.read((char*) &d, sizeof(double));
+    memcpy(&d, p, sizeof(double));
     BE_TO_CPU_DOUBLE(d, d);
     return d;
 }
 
+// Read a big-endian double and move past it
+static double readDouble(const char*& p)
+{
+    double d = getDouble(p);
+    p += sizeof(double);
+    return d;
+}
+
+
+// A record of the ephemeris converted to native doubles, with the
+// coefficients of the x, y and z series interleaved so that the three
+// series are evaluated together as the lanes of one array. Only the
+// coefficients of items up to the Sun are converted.
+struct JPLEphRecord
+{
+    double t0{ 0.0 };
+    vector<Array4d, aligned_allocator<Array4d>> coeffs;
+};
 
-JPLEphRecord::~JPLEphRecord()
+namespace
 {
-    delete coeffs;
+// Records used by each thread, which are usually used many times in a row as
+// time advances. The key of a record combines the key of the ephemeris with
+// the record number, so that the entries of adjacent records differ.
+typedef ThreadLocalCache<JPLEphRecord, 4> RecordCache;
 }
 
 
+// Evaluate the Chebyshev series at the normalized time u in [-1, 1] with
+// Clenshaw's recurrence, which for x, y and z together runs on SIMD
+// registers.
+static Vector3d evaluateChebyshev(const Array4d* coeffs, unsigned int nCoeffs, double u)
+{
+    Array4d b1 = Array4d::Zero();
+    Array4d b2 = Array4d::Zero();
+    double twoU = 2.0 * u;
+    for (unsigned int j = nCoeffs - 1; j >= 1; j--)
+    {
+        Array4d b0 = coeffs[j] + twoU * b1 - b2;
+        b2 = b1;
+        b1 = b0;
+    }
+
+    Array4d sum = coeffs[0] + u * b1 - b2;
+
+    return Vector3d(sum[0], sum[1], sum[2]);
+}
+
+
+JPLEphemeris::~JPLEphemeris() = default;
+
+
 unsigned int JPLEphemeris::getDENumber() const
 {
     return DENum;
@@ -73,135 +126,197 @@ double JPLEphemeris::getEndDate() const
 }
 
 
-// Return the position of an object relative to the solar system barycenter
-// or the Earth (in the case of the Moon) at a specified TDB Julian date tjd.
-// If tjd is outside the span covered by the ephemeris it is clamped to a
-// valid time.
-Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd) const
+// Return the record covering tjd. If tjd is outside the span covered by the
+// ephemeris it is clamped to a valid time.
+const JPLEphRecord& JPLEphemeris::findRecord(double& tjd) const
 {
-    // Solar system barycenter is the origin
-    if (planet == JPLEph_SSB)
-    {
-        return Vector3d::Zero();
-    }
-
-    // The position of the Earth must be computed from the positions of the
-    // Earth-Moon barycenter and Moon
-    if (planet == JPLEph_Earth)
-    {
-        Vector3d embPos = getPlanetPosition(JPLEph_EarthMoonBary, tjd);
-
-        // Get the geocentric position of the Moon
-        Vector3d moonPos = getPlanetPosition(JPLEph_Moon, tjd);
-
-        return embPos - moonPos * (1.0 / (earthMoonMassRatio + 1.0));
-    }
-
     // Clamp time to [ startDate, endDate ]
     if (tjd < startDate)
         tjd = startDate;
     else if (tjd > endDate)
-    tjd = endDate;
+        tjd = endDate;
 
     // recNo is always >= 0:
     auto recNo = (unsigned int) ((tjd - startDate) / daysPerInterval);
     // Make sure we don't go past the end of the array if t == endDate
-    if (recNo >= records.size())
-        recNo = records.size() - 1;
-    const JPLEphRecord* rec = &records[recNo];
+    if (recNo >= nRecords)
+        recNo = nRecords - 1;
+
+    JPLEphRecord& record = RecordCache::entry((cacheKey << 32) | recNo);
+    if (!record.coeffs.empty())
+        return record;
+
+    // Convert the record, which starts with its start and end times
+    const char* data = records + (size_t) recNo * recordSize * sizeof(double);
+    const char* dataCoeffs = data + 2 * sizeof(double);
+    record.t0 = getDouble(data);
+    record.coeffs.resize((recordSize - 2) / 3);
+    for (unsigned int i = 0; i <= JPLEph_Sun; i++)
+    {
+        const JPLEphCoeffInfo& info = coeffInfo[i];
+        unsigned int nGranules = info.nGranules == (unsigned int) -1 ? 1 : info.nGranules;
+        unsigned int nCoeffs = info.nCoeffs;
+        for (unsigned int g = 0; g < nGranules; g++)
+        {
+            const char* cx = dataCoeffs + (info.offset + g * nCoeffs * 3) * sizeof(double);
+            const char* cy = cx + nCoeffs * sizeof(double);
+            const char* cz = cy + nCoeffs * sizeof(double);
+            Array4d* c = &record.coeffs[info.offset / 3 + g * nCoeffs];
+            for (unsigned int j = 0; j < nCoeffs; j++)
+            {
+                size_t offset = j * sizeof(double);
+                c[j] = Array4d(getDouble(cx + offset), getDouble(cy + offset), getDouble(cz + offset), 0.0);
+            }
+        }
+    }
+
+    return record;
+}
 
-    assert(coeffInfo[planet].nGranules >= 1);
-    assert(coeffInfo[planet].nGranules <= 32);
-    assert(coeffInfo[planet].nCoeffs <= MaxChebyshevCoeffs);
 
+// Evaluate the position of an item stored in the ephemeris from the record
+// covering tjd.
+Vector3d JPLEphemeris::evaluate(const JPLEphRecord& record, JPLEphemItem planet, double tjd) const
+{
     // u is the normalized time (in [-1, 1]) for interpolating
     // coeffs is a pointer to the Chebyshev coefficients
     double u = 0.0;
-    double* coeffs = nullptr;
+    const Array4d* coeffs = nullptr;
+    const JPLEphCoeffInfo& info = coeffInfo[planet];
 
     // nGranules is unsigned int so it will be compared against FFFFFFFF:
-    if (coeffInfo[planet].nGranules == (unsigned int) -1)
+    if (info.nGranules == (unsigned int) -1)
     {
-        coeffs = rec->coeffs + coeffInfo[planet].offset;
-        u = 2.0 * (tjd - rec->t0) / daysPerInterval - 1.0;
+        coeffs = &record.coeffs[info.offset / 3];
+        u = 2.0 * (tjd - record.t0) / daysPerInterval - 1.0;
     }
     else
     {
-    double daysPerGranule = daysPerInterval / coeffInfo[planet].nGranules;
-    auto granule = (int) ((tjd - rec->t0) / daysPerGranule);
-    double granuleStartDate = rec->t0 + daysPerGranule * (double) granule;
-    coeffs = rec->coeffs + coeffInfo[planet].offset +
-            granule * coeffInfo[planet].nCoeffs * 3;
-    u = 2.0 * (tjd - granuleStartDate) / daysPerGranule - 1.0;
+        double daysPerGranule = daysPerInterval / info.nGranules;
+        auto granule = (unsigned int) ((tjd - record.t0) / daysPerGranule);
+        if (granule >= info.nGranules)
+            granule = info.nGranules - 1;
+        double granuleStartDate = record.t0 + daysPerGranule * (double) granule;
+        coeffs = &record.coeffs[info.offset / 3 + granule * info.nCoeffs];
+        u = 2.0 * (tjd - granuleStartDate) / daysPerGranule - 1.0;
     }
 
-    // Evaluate the Chebyshev polynomials
-    double sum[3];
-    double cc[MaxChebyshevCoeffs];
-    unsigned int nCoeffs = coeffInfo[planet].nCoeffs;
-    for (int i = 0; i < 3; i++)
+    return evaluateChebyshev(coeffs, info.nCoeffs, u);
+}
+
+
+// Return the position of an object relative to the solar system barycenter
+// or the Earth (in the case of the Moon) at a specified TDB Julian date tjd.
+// If tjd is outside the span covered by the ephemeris it is clamped to a
+// valid time.
+Vector3d JPLEphemeris::getPlanetPosition(JPLEphemItem planet, double tjd) const
+{
+    Vector3d position;
+    getPlanetPositions(planet, span<const double>(&tjd, 1), span<Vector3d>(&position, 1));
+    return position;
+}
+
+
+void JPLEphemeris::getPlanetPositions(double tjd,
+                                      span<const JPLEphemItem> items,
+                                      span<Vector3d> positions) const
+{
+    const JPLEphRecord& record = findRecord(tjd);
+
+    Vector3d evaluated[JPLEph_NItems];
+    bool isEvaluated[JPLEph_NItems] = {};
+    auto position = [&](JPLEphemItem item) -> const Vector3d&
     {
-        cc[0] = 1.0;
-        cc[1] = u;
-        sum[i] = coeffs[i * nCoeffs] + coeffs[i * nCoeffs + 1] * u;
-        for (unsigned int j = 2; j < nCoeffs; j++)
+        if (!isEvaluated[item])
         {
-            cc[j] = 2.0 * u * cc[j - 1] - cc[j - 2];
-            sum[i] += coeffs[i * nCoeffs + j] * cc[j];
+            evaluated[item] = evaluate(record, item, tjd);
+            isEvaluated[item] = true;
         }
-    }
+        return evaluated[item];
+    };
 
-    return Vector3d(sum[0], sum[1], sum[2]);
+    for (size_t i = 0; i < items.size(); i++)
+    {
+        if (items[i] == JPLEph_SSB)
+        {
+            // Solar system barycenter is the origin
+            positions[i] = Vector3d::Zero();
+        }
+        else if (items[i] == JPLEph_Earth)
+        {
+            // The position of the Earth must be computed from the positions
+            // of the Earth-Moon barycenter and the geocentric Moon
+            positions[i] = position(JPLEph_EarthMoonBary) -
+                           position(JPLEph_Moon) * (1.0 / (earthMoonMassRatio + 1.0));
+        }
+        else
+        {
+            positions[i] = position(items[i]);
+        }
+    }
 }
 
 
-JPLEphemeris* JPLEphemeris::load(istream& in)
+void JPLEphemeris::getPlanetPositions(JPLEphemItem planet,
+                                      span<const double> times,
+                                      span<Vector3d> positions) const
 {
-    JPLEphemeris* eph = nullptr;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        double tjd = times[i];
+        const JPLEphRecord& record = findRecord(tjd);
 
-    // Skip past three header labels
-    in.ignore(LabelSize * 3);
-    if (!in.good())
-        return nullptr;
+        if (planet == JPLEph_SSB)
+        {
+            positions[i] = Vector3d::Zero();
+        }
+        else if (planet == JPLEph_Earth)
+        {
+            positions[i] = evaluate(record, JPLEph_EarthMoonBary, tjd) -
+                           evaluate(record, JPLEph_Moon, tjd) * (1.0 / (earthMoonMassRatio + 1.0));
+        }
+        else
+        {
+            positions[i] = evaluate(record, planet, tjd);
+        }
+    }
+}
 
-    // Skip past the constant names
-    in.ignore(NConstants * ConstantNameLength);
-    if (!in.good())
+
+JPLEphemeris* JPLEphemeris::load(const fs::path& filename)
+{
+    unique_ptr<MappedFile> file(new MappedFile(filename));
+    if (!file->isOpen() || file->size() < HeaderSize)
         return nullptr;
 
-    eph = new JPLEphemeris();
+    // Skip past three header labels and the constant names
+    const char* p = file->data() + LabelSize * 3 + NConstants * ConstantNameLength;
+
+    unique_ptr<JPLEphemeris> eph(new JPLEphemeris());
 
     // Read the start time, end time, and time interval
-    eph->startDate = readDouble(in);
-    eph->endDate = readDouble(in);
-    eph->daysPerInterval = readDouble(in);
-    if (!in.good())
-    {
-        delete eph;
+    eph->startDate = readDouble(p);
+    eph->endDate = readDouble(p);
+    eph->daysPerInterval = readDouble(p);
+    if (!(eph->daysPerInterval > 0.0) || !(eph->endDate > eph->startDate))
         return nullptr;
-    }
 
     // Number of constants with valid values; not useful for us
-    (void) readUint(in);
+    (void) readUint(p);
 
-    eph->au = readDouble(in);     // kilometers per astronomical unit
-    eph->earthMoonMassRatio = readDouble(in);
+    eph->au = readDouble(p);     // kilometers per astronomical unit
+    eph->earthMoonMassRatio = readDouble(p);
 
     // Read the coefficient information for each item in the ephemeris
     unsigned int i;
     for (i = 0; i < JPLEph_NItems; i++)
     {
-        eph->coeffInfo[i].offset = readUint(in) - 3;
-        eph->coeffInfo[i].nCoeffs = readUint(in);
-        eph->coeffInfo[i].nGranules = readUint(in);
-    }
-    if (!in.good())
-    {
-        delete eph;
-        return nullptr;
+        eph->coeffInfo[i].offset = readUint(p) - 3;
+        eph->coeffInfo[i].nCoeffs = readUint(p);
+        eph->coeffInfo[i].nGranules = readUint(p);
     }
 
-    eph->DENum = readUint(in);
+    eph->DENum = readUint(p);
 
     switch (eph->DENum)
     {
@@ -209,56 +324,54 @@ JPLEphemeris* JPLEphemeris::load(istream& in)
         eph->recordSize = DE200RecordSize;
         break;
     case 405:
+    // Later ephemerides have records laid out like DE405's
+    case 430:
+    case 431:
+    case 440:
+    case 441:
         eph->recordSize = DE405RecordSize;
         break;
     case 406:
         eph->recordSize = DE406RecordSize;
         break;
     default:
-        delete eph;
         return nullptr;
     }
 
-    eph->librationCoeffInfo.offset        = readUint(in);
-    eph->librationCoeffInfo.nCoeffs       = readUint(in);
-    eph->librationCoeffInfo.nGranules     = readUint(in);
-    if (!in.good())
+    eph->librationCoeffInfo.offset        = readUint(p);
+    eph->librationCoeffInfo.nCoeffs       = readUint(p);
+    eph->librationCoeffInfo.nGranules     = readUint(p);
+
+    // The coefficients of the items must lie within the records, as they
+    // are read from the file without further checks. The last item of the
+    // coefficient information, which holds nutations, isn't used.
+    for (i = 0; i <= JPLEph_Sun; i++)
     {
-        delete eph;
-        return nullptr;
+        const JPLEphCoeffInfo& info = eph->coeffInfo[i];
+        unsigned int nGranules = info.nGranules == (unsigned int) -1 ? 1 : info.nGranules;
+        if (info.offset % 3 != 0 ||
+            info.nCoeffs < 1 || info.nCoeffs > MaxChebyshevCoeffs ||
+            nGranules < 1 || nGranules > 32 ||
+            (uint64_t) info.offset + (uint64_t) info.nCoeffs * 3 * nGranules > eph->recordSize - 2)
+        {
+            return nullptr;
+        }
     }
 
-    // Skip past the rest of the record
-    in.ignore(eph->recordSize * 8 - 2856);
-    // The next record contains constant values (which we don't need)
-    in.ignore(eph->recordSize * 8);
-    if (!in.good())
+    // The records follow the first record, holding the header, and the
+    // second one, holding constant values (which we don't need)
+    eph->nRecords = (unsigned int) ((eph->endDate - eph->startDate) /
+                                    eph->daysPerInterval);
+    size_t recordBytes = (size_t) eph->recordSize * sizeof(double);
+    if (eph->nRecords == 0 ||
+        file->size() / recordBytes < (uint64_t) eph->nRecords + 2)
     {
-        delete eph;
         return nullptr;
     }
 
-    auto nRecords = (unsigned int) ((eph->endDate - eph->startDate) /
-                        eph->daysPerInterval);
-    eph->records.resize(nRecords);
-    for (i = 0; i < nRecords; i++)
-    {
-        eph->records[i].t0 = readDouble(in);
-        eph->records[i].t1 = readDouble(in);
-
-        // Allocate coefficient array for this record; the first two
-        // 'coefficients' are actually the start and end time (t0 and t1)
-        eph->records[i].coeffs = new double[eph->recordSize - 2];
-        for (unsigned int j = 0; j < eph->recordSize - 2; j++)
-            eph->records[i].coeffs[j] = readDouble(in);
-
-        // Make sure that we read this record successfully
-        if (!in.good())
-        {
-            delete eph;
-            return nullptr;
-        }
-    }
+    eph->records = file->data() + 2 * recordBytes;
+    eph->file = move(file);
+    eph->cacheKey = RecordCache::newKey();
 
-    return eph;
+    return eph.release();
 }
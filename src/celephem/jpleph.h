@@ -13,9 +13,14 @@
 #ifndef _CELENGINE_JPLEPH_H_
 #define _CELENGINE_JPLEPH_H_
 
-#include <iostream>
-#include <vector>
+#include <cstdint>
+#include <memory>
 #include <Eigen/Core>
+#include <celcompat/filesystem.h>
+#include <celcompat/span.h>
+
+class MappedFile;
+struct JPLEphRecord;
 
 enum JPLEphemItem
 {
@@ -45,34 +50,41 @@ struct JPLEphCoeffInfo
 };
 
 
-struct JPLEphRecord
-{
-    JPLEphRecord() = default;
-    ~JPLEphRecord();
-
-    double t0{ 0.0 };
-    double t1{ 0.0 };
-    double* coeffs{ nullptr };
-};
-
-
+// The ephemeris is read from a file mapped into memory, so that only the
+// records used are read from the disk, however large the file is. The
+// records last used by each thread are kept converted to native doubles.
 class JPLEphemeris
 {
 private:
     JPLEphemeris() = default;
 
 public:
-    ~JPLEphemeris() = default;
+    ~JPLEphemeris();
 
     Eigen::Vector3d getPlanetPosition(JPLEphemItem, double t) const;
 
-    static JPLEphemeris* load(std::istream&);
+    // Compute the positions of several items at the same time, looking up
+    // the record covering it once, and evaluating each item once; the Moon
+    // is evaluated once for the Earth and the Moon.
+    void getPlanetPositions(double t,
+                            celestia::compat::span<const JPLEphemItem> items,
+                            celestia::compat::span<Eigen::Vector3d> positions) const;
+
+    // Compute the positions of an item at several times
+    void getPlanetPositions(JPLEphemItem item,
+                            celestia::compat::span<const double> times,
+                            celestia::compat::span<Eigen::Vector3d> positions) const;
+
+    static JPLEphemeris* load(const fs::path& filename);
 
     unsigned int getDENumber() const;
     double getStartDate() const;
     double getEndDate() const;
 
 private:
+    const JPLEphRecord& findRecord(double& t) const;
+    Eigen::Vector3d evaluate(const JPLEphRecord& record, JPLEphemItem item, double t) const;
+
     JPLEphCoeffInfo coeffInfo[JPLEph_NItems];
     JPLEphCoeffInfo librationCoeffInfo;
 
@@ -86,7 +98,10 @@ private:
     unsigned int DENum;       // ephemeris version
     unsigned int recordSize;  // number of doubles per record
 
-    std::vector<JPLEphRecord> records;
+    std::unique_ptr<MappedFile> file;
+    const char* records{ nullptr };
+    unsigned int nRecords{ 0 };
+    uint64_t cacheKey{ 0 };
 };
 
 #endif // _CELENGINE_JPLEPH_H_
@@ -13,6 +13,7 @@
 #include <celmath/mathlib.h>
 #include <celmath/solve.h>
 #include <celmath/geomutil.h>
+#include <celutil/threadcache.h>
 #include <functional>
 #include <algorithm>
 #include <cmath>
@@ -278,6 +279,22 @@ Vector3d Orbit::velocityAtTime(double tdb) const
 }
 
 
+void Orbit::positionsAtTimes(celestia::compat::span<const double> times,
+                             celestia::compat::span<Vector3d> positions) const
+{
+    for (size_t i = 0; i < times.size(); i++)
+        positions[i] = positionAtTime(times[i]);
+}
+
+
+void Orbit::velocitiesAtTimes(celestia::compat::span<const double> times,
+                              celestia::compat::span<Vector3d> velocities) const
+{
+    for (size_t i = 0; i < times.size(); i++)
+        velocities[i] = velocityAtTime(times[i]);
+}
+
+
 double EllipticalOrbit::eccentricAnomaly(double M) const
 {
     if (eccentricity == 0.0)
@@ -433,41 +450,85 @@ double EllipticalOrbit::getBoundingRadius() const
 }
 
 
+namespace
+{
+// Values cached by CachingOrbit, in the cache of each thread
+struct OrbitCacheEntry
+{
+    Vector3d position{ Vector3d::Zero() };
+    Vector3d velocity{ Vector3d::Zero() };
+    double time{ -1.0e30 };
+    bool positionValid{ false };
+    bool velocityValid{ false };
+};
+
+typedef ThreadLocalCache<OrbitCacheEntry> OrbitCache;
+}
+
+
+CachingOrbit::CachingOrbit() :
+    cacheKey(OrbitCache::newKey())
+{
+}
+
+
 Vector3d CachingOrbit::positionAtTime(double jd) const
 {
-    if (jd != lastTime)
-    {
-        lastTime = jd;
-        lastPosition = computePosition(jd);
-        positionCacheValid = true;
-        velocityCacheValid = false;
-    }
-    else if (!positionCacheValid)
+    const OrbitCacheEntry& cached = OrbitCache::entry(cacheKey);
+    if (jd == cached.time && cached.positionValid)
+        return cached.position;
+
+    Vector3d position = computePosition(jd);
+
+    // Look the entry up again, as computing the position may have used it
+    // for another orbit.
+    OrbitCacheEntry& entry = OrbitCache::entry(cacheKey);
+    if (jd != entry.time)
     {
-        lastPosition = computePosition(jd);
-        positionCacheValid = true;
+        entry.time = jd;
+        entry.velocityValid = false;
     }
+    entry.position = position;
+    entry.positionValid = true;
 
-    return lastPosition;
+    return position;
 }
 
 
 Vector3d CachingOrbit::velocityAtTime(double jd) const
 {
-    if (jd != lastTime)
-    {
-        lastVelocity = computeVelocity(jd);
-        lastTime = jd;  // must be set *after* call to computeVelocity
-        positionCacheValid = false;
-        velocityCacheValid = true;
-    }
-    else if (!velocityCacheValid)
+    const OrbitCacheEntry& cached = OrbitCache::entry(cacheKey);
+    if (jd == cached.time && cached.velocityValid)
+        return cached.velocity;
+
+    Vector3d velocity = computeVelocity(jd);
+
+    OrbitCacheEntry& entry = OrbitCache::entry(cacheKey);
+    if (jd != entry.time)
     {
-        lastVelocity = computeVelocity(jd);
-        velocityCacheValid = true;
+        entry.time = jd;
+        entry.positionValid = false;
     }
+    entry.velocity = velocity;
+    entry.velocityValid = true;
 
-    return lastVelocity;
+    return velocity;
+}
+
+
+void CachingOrbit::positionsAtTimes(celestia::compat::span<const double> times,
+                                    celestia::compat::span<Vector3d> positions) const
+{
+    for (size_t i = 0; i < times.size(); i++)
+        positions[i] = computePosition(times[i]);
+}
+
+
+void CachingOrbit::velocitiesAtTimes(celestia::compat::span<const double> times,
+                                     celestia::compat::span<Vector3d> velocities) const
+{
+    for (size_t i = 0; i < times.size(); i++)
+        velocities[i] = computeVelocity(times[i]);
 }
 
 
@@ -604,6 +665,54 @@ Vector3d MixedOrbit::velocityAtTime(double jd) const
 }
 
 
+const Orbit* MixedOrbit::orbitAtTime(double jd) const
+{
+    if (jd < begin)
+        return beforeApprox;
+    else if (jd < end)
+        return primary;
+    else
+        return afterApprox;
+}
+
+
+// Pass each run of times covered by the same orbit on to it in one call
+void MixedOrbit::positionsAtTimes(celestia::compat::span<const double> times,
+                                  celestia::compat::span<Vector3d> positions) const
+{
+    size_t runStart = 0;
+    while (runStart < times.size())
+    {
+        const Orbit* o = orbitAtTime(times[runStart]);
+        size_t runEnd = runStart + 1;
+        while (runEnd < times.size() && orbitAtTime(times[runEnd]) == o)
+            runEnd++;
+
+        o->positionsAtTimes(times.subspan(runStart, runEnd - runStart),
+                            positions.subspan(runStart, runEnd - runStart));
+        runStart = runEnd;
+    }
+}
+
+
+void MixedOrbit::velocitiesAtTimes(celestia::compat::span<const double> times,
+                                   celestia::compat::span<Vector3d> velocities) const
+{
+    size_t runStart = 0;
+    while (runStart < times.size())
+    {
+        const Orbit* o = orbitAtTime(times[runStart]);
+        size_t runEnd = runStart + 1;
+        while (runEnd < times.size() && orbitAtTime(times[runEnd]) == o)
+            runEnd++;
+
+        o->velocitiesAtTimes(times.subspan(runStart, runEnd - runStart),
+                             velocities.subspan(runStart, runEnd - runStart));
+        runStart = runEnd;
+    }
+}
+
+
 double MixedOrbit::getPeriod() const
 {
     return primary->getPeriod();
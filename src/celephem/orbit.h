@@ -10,7 +10,9 @@
 #ifndef _CELENGINE_ORBIT_H_
 #define _CELENGINE_ORBIT_H_
 
+#include <cstdint>
 #include <Eigen/Core>
+#include <celcompat/span.h>
 
 
 class OrbitSampleProc;
@@ -32,6 +34,21 @@ class Orbit
      */
     virtual Eigen::Vector3d velocityAtTime(double) const;
 
+    /*! Compute the positions at several times (TDB) at once, storing them
+     * in positions, which must be at least as long as times. Orbits may
+     * override this with an implementation faster than calling
+     * positionAtTime() for each time; they evaluate sorted times fastest.
+     * Positions computed this way are not cached.
+     */
+    virtual void positionsAtTimes(celestia::compat::span<const double> times,
+                                  celestia::compat::span<Eigen::Vector3d> positions) const;
+
+    /*! Compute the velocities at several times (TDB) at once, the way
+     * positionsAtTimes() does positions.
+     */
+    virtual void velocitiesAtTimes(celestia::compat::span<const double> times,
+                                   celestia::compat::span<Eigen::Vector3d> velocities) const;
+
     virtual double getPeriod() const = 0;
     virtual double getBoundingRadius() const = 0;
 
@@ -102,13 +119,16 @@ class OrbitSampleProc
  * Celestia may need require position of a planet more than once per frame; in
  * order to avoid redundant calculation, the CachingOrbit class saves the
  * result of the last calculation and uses it if the time matches the cached
- * time.
+ * time. Each thread has a cache of its own, so that the orbit may be
+ * evaluated from several threads at once.
  */
 class CachingOrbit : public Orbit
 {
  public:
-    CachingOrbit() = default;
+    CachingOrbit();
     virtual ~CachingOrbit() = default;
+    CachingOrbit(const CachingOrbit&) = delete;
+    CachingOrbit& operator=(const CachingOrbit&) = delete;
 
     virtual Eigen::Vector3d computePosition(double jd) const = 0;
     virtual Eigen::Vector3d computeVelocity(double jd) const;
@@ -117,13 +137,13 @@ class CachingOrbit : public Orbit
 
     Eigen::Vector3d positionAtTime(double jd) const;
     Eigen::Vector3d velocityAtTime(double jd) const;
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Eigen::Vector3d> positions) const override;
+    void velocitiesAtTimes(celestia::compat::span<const double> times,
+                           celestia::compat::span<Eigen::Vector3d> velocities) const override;
 
  private:
-    mutable Eigen::Vector3d lastPosition;
-    mutable Eigen::Vector3d lastVelocity;
-    mutable double lastTime{ -1.0e30 };
-    mutable bool positionCacheValid{ false };
-    mutable bool velocityCacheValid{ false };
+    uint64_t cacheKey;
 };
 
 
@@ -141,11 +161,17 @@ class MixedOrbit : public Orbit
 
     virtual Eigen::Vector3d positionAtTime(double jd) const;
     virtual Eigen::Vector3d velocityAtTime(double jd) const;
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Eigen::Vector3d> positions) const override;
+    void velocitiesAtTimes(celestia::compat::span<const double> times,
+                           celestia::compat::span<Eigen::Vector3d> velocities) const override;
     virtual double getPeriod() const;
     virtual double getBoundingRadius() const;
     virtual void sample(double startTime, double endTime, OrbitSampleProc& proc) const;
 
  private:
+    const Orbit* orbitAtTime(double jd) const;
+
     Orbit* primary;
     EllipticalOrbit* afterApprox;
     EllipticalOrbit* beforeApprox;
@@ -14,6 +14,7 @@
 #include "rotation.h"
 #include <celmath/geomutil.h>
 #include <celmath/mathlib.h>
+#include <celutil/threadcache.h>
 #include <cmath>
 
 using namespace Eigen;
@@ -55,11 +56,26 @@ RotationModel::angularVelocityAtTime(double tdb) const
 
 /***** CachingRotationModel *****/
 
+namespace
+{
+// Values cached by CachingRotationModel, in the cache of each thread
+struct RotationCacheEntry
+{
+    Quaterniond spin{ Quaterniond::Identity() };
+    Quaterniond equator{ Quaterniond::Identity() };
+    Vector3d angularVelocity{ Vector3d::Zero() };
+    double time{ 365.0 };
+    bool spinValid{ false };
+    bool equatorValid{ false };
+    bool angularVelocityValid{ false };
+};
+
+typedef ThreadLocalCache<RotationCacheEntry> RotationCache;
+}
+
+
 CachingRotationModel::CachingRotationModel() :
-    lastTime(365.0),
-    spinCacheValid(false),
-    equatorCacheValid(false),
-    angularVelocityCacheValid(false)
+    cacheKey(RotationCache::newKey())
 {
 }
 
@@ -67,63 +83,71 @@ CachingRotationModel::CachingRotationModel() :
 Quaterniond
 CachingRotationModel::spin(double tjd) const
 {
-    if (tjd != lastTime)
-    {
-        lastTime = tjd;
-        lastSpin = computeSpin(tjd);
-        spinCacheValid = true;
-        equatorCacheValid = false;
-        angularVelocityCacheValid = false;
-    }
-    else if (!spinCacheValid)
+    const RotationCacheEntry& cached = RotationCache::entry(cacheKey);
+    if (tjd == cached.time && cached.spinValid)
+        return cached.spin;
+
+    Quaterniond q = computeSpin(tjd);
+
+    // Look the entry up again, as computing the spin may have used it for
+    // another rotation model.
+    RotationCacheEntry& entry = RotationCache::entry(cacheKey);
+    if (tjd != entry.time)
     {
-        lastSpin = computeSpin(tjd);
-        spinCacheValid = true;
+        entry.time = tjd;
+        entry.equatorValid = false;
+        entry.angularVelocityValid = false;
     }
+    entry.spin = q;
+    entry.spinValid = true;
 
-    return lastSpin;
+    return q;
 }
 
 
 Quaterniond
 CachingRotationModel::equatorOrientationAtTime(double tjd) const
 {
-    if (tjd != lastTime)
-    {
-        lastTime = tjd;
-        lastEquator = computeEquatorOrientation(tjd);
-        spinCacheValid = false;
-        equatorCacheValid = true;
-        angularVelocityCacheValid = false;
-    }
-    else if (!equatorCacheValid)
+    const RotationCacheEntry& cached = RotationCache::entry(cacheKey);
+    if (tjd == cached.time && cached.equatorValid)
+        return cached.equator;
+
+    Quaterniond q = computeEquatorOrientation(tjd);
+
+    RotationCacheEntry& entry = RotationCache::entry(cacheKey);
+    if (tjd != entry.time)
     {
-        lastEquator = computeEquatorOrientation(tjd);
-        equatorCacheValid = true;
+        entry.time = tjd;
+        entry.spinValid = false;
+        entry.angularVelocityValid = false;
     }
+    entry.equator = q;
+    entry.equatorValid = true;
 
-    return lastEquator;
+    return q;
 }
 
 
 Vector3d
 CachingRotationModel::angularVelocityAtTime(double tjd) const
 {
-    if (tjd != lastTime)
-    {
-        lastAngularVelocity = computeAngularVelocity(tjd);
-        lastTime = tjd;
-        spinCacheValid = false;
-        equatorCacheValid = false;
-        angularVelocityCacheValid = true;
-    }
-    else if (!angularVelocityCacheValid)
+    const RotationCacheEntry& cached = RotationCache::entry(cacheKey);
+    if (tjd == cached.time && cached.angularVelocityValid)
+        return cached.angularVelocity;
+
+    Vector3d w = computeAngularVelocity(tjd);
+
+    RotationCacheEntry& entry = RotationCache::entry(cacheKey);
+    if (tjd != entry.time)
     {
-        lastAngularVelocity = computeAngularVelocity(tjd);
-        angularVelocityCacheValid = true;
+        entry.time = tjd;
+        entry.spinValid = false;
+        entry.equatorValid = false;
     }
+    entry.angularVelocity = w;
+    entry.angularVelocityValid = true;
 
-    return lastAngularVelocity;
+    return w;
 }
 
 
@@ -11,6 +11,7 @@
 #ifndef _CELENGINE_ROTATION_H_
 #define _CELENGINE_ROTATION_H_
 
+#include <cstdint>
 #include <Eigen/Geometry>
 
 
@@ -82,7 +83,8 @@ class RotationModel
  *  of computeAngularVelocity uses differentiation to approximate the
  *  the instantaneous angular velocity. It may be overridden if there is some
  *  better means to calculate the angular velocity for a specific rotation
- *  model.
+ *  model. Each thread has a cache of its own, so that the rotation model may
+ *  be evaluated from several threads at once.
  */
 class CachingRotationModel : public RotationModel
 {
@@ -91,6 +93,8 @@ class CachingRotationModel : public RotationModel
 
     CachingRotationModel();
     virtual ~CachingRotationModel() = default;
+    CachingRotationModel(const CachingRotationModel&) = delete;
+    CachingRotationModel& operator=(const CachingRotationModel&) = delete;
 
     Eigen::Quaterniond spin(double tjd) const;
     Eigen::Quaterniond equatorOrientationAtTime(double tjd) const;
@@ -103,13 +107,7 @@ class CachingRotationModel : public RotationModel
     virtual bool isPeriodic() const = 0;
 
 private:
-    mutable Eigen::Quaterniond lastSpin;
-    mutable Eigen::Quaterniond lastEquator;
-    mutable Eigen::Vector3d lastAngularVelocity;
-    mutable double lastTime;
-    mutable bool spinCacheValid;
-    mutable bool equatorCacheValid;
-    mutable bool angularVelocityCacheValid;
+    uint64_t cacheKey;
 };
 
 
@@ -18,6 +18,7 @@
 #include <celutil/bytes.h>
 #include <celutil/gettext.h>
 #include <celutil/debug.h>
+#include <atomic>
 #include <cmath>
 #include <string>
 #include <algorithm>
@@ -78,6 +79,8 @@ public:
     double getBoundingRadius() const override;
     Vector3d computePosition(double jd) const override;
     Vector3d computeVelocity(double jd) const override;
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Vector3d> positions) const override;
 
     bool isPeriodic() const override;
     void getValidRange(double& begin, double& end) const override;
@@ -85,10 +88,16 @@ public:
     void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
 
 private:
+    int findSample(double jd, int hint) const;
+    Vector3d interpolatePosition(double jd, int n) const;
+
     vector<Sample<T> > samples;
     double boundingRadius;
     double period;
-    mutable int lastSample;
+    // Sample found by the last search of computePosition() and
+    // computeVelocity(), used as a hint for the next one. It's shared by all
+    // threads, while positionsAtTimes() keeps a hint of its own.
+    mutable std::atomic<int> lastSample;
 
     TrajectoryInterpolation interpolation;
 };
@@ -162,7 +171,55 @@ static Vector3d cubicInterpolateVelocity(const Vector3d& p0, const Vector3d& v0,
 }
 
 
+// Return the index of the first sample at or after jd, or the sample count
+// if there is none, trying the span ending at the hint and the next one
+// before searching all samples.
+template <typename T> int SampledOrbit<T>::findSample(double jd, int hint) const
+{
+    int n = hint;
+    if (n >= 1 && n < (int) samples.size() && jd >= samples[n - 1].t)
+    {
+        if (jd <= samples[n].t)
+            return n;
+        if (n + 1 < (int) samples.size() && jd <= samples[n + 1].t)
+            return n + 1;
+    }
+
+    Sample<T> samp;
+    samp.t = jd;
+    auto iter = lower_bound(samples.begin(), samples.end(), samp);
+    return (int) (iter - samples.begin());
+}
+
+
 template <typename T> Vector3d SampledOrbit<T>::computePosition(double jd) const
+{
+    int n = 0;
+    if (samples.size() > 1)
+    {
+        n = findSample(jd, lastSample);
+        lastSample = n;
+    }
+
+    return interpolatePosition(jd, n);
+}
+
+
+template <typename T> void SampledOrbit<T>::positionsAtTimes(celestia::compat::span<const double> times,
+                                                             celestia::compat::span<Vector3d> positions) const
+{
+    int n = 0;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        if (samples.size() > 1)
+            n = findSample(times[i], n);
+        positions[i] = interpolatePosition(times[i], n);
+    }
+}
+
+
+// Interpolate the position at jd in the span ending at sample n
+template <typename T> Vector3d SampledOrbit<T>::interpolatePosition(double jd, int n) const
 {
     Vector3d pos;
     if (samples.size() == 0)
@@ -175,23 +232,6 @@ template <typename T> Vector3d SampledOrbit<T>::computePosition(double jd) const
     }
     else
     {
-        Sample<T> samp;
-        samp.t = jd;
-        int n = lastSample;
-
-        if (n < 1 || n >= (int) samples.size() || jd < samples[n - 1].t || jd > samples[n].t)
-        {
-            typename vector<Sample<T> >::const_iterator iter = lower_bound(samples.begin(),
-                                                                           samples.end(),
-                                                                           samp);
-            if (iter == samples.end())
-                n = samples.size();
-            else
-                n = iter - samples.begin();
-
-            lastSample = n;
-        }
-
         if (n == 0)
         {
             pos = Vector3d(samples[n].x, samples[n].y, samples[n].z);
@@ -290,21 +330,8 @@ template <typename T> Vector3d SampledOrbit<T>::computeVelocity(double jd) const
     }
     else
     {
-        Sample<T> samp;
-        samp.t = jd;
-        int n = lastSample;
-
-        if (n < 1 || n >= (int) samples.size() || jd < samples[n - 1].t || jd > samples[n].t)
-        {
-            typename vector<Sample<T> >::const_iterator iter = lower_bound(samples.begin(),
-                                                                           samples.end(),
-                                                                           samp);
-            if (iter == samples.end())
-                n = samples.size();
-            else
-                n = iter - samples.begin();
-            lastSample = n;
-        }
+        int n = findSample(jd, lastSample);
+        lastSample = n;
 
         if (n == 0)
         {
@@ -443,6 +470,8 @@ public:
     double getBoundingRadius() const override;
     Vector3d computePosition(double jd) const override;
     Vector3d computeVelocity(double jd) const override;
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Vector3d> positions) const override;
 
     bool isPeriodic() const override;
     void getValidRange(double& begin, double& end) const override;
@@ -450,10 +479,16 @@ public:
     void sample(double startTime, double endTime, OrbitSampleProc& proc) const override;
 
 private:
+    int findSample(double jd, int hint) const;
+    Vector3d interpolatePosition(double jd, int n) const;
+
     vector<SampleXYZV<T> > samples;
     double boundingRadius;
     double period;
-    mutable int lastSample;
+    // Sample found by the last search of computePosition() and
+    // computeVelocity(), used as a hint for the next one. It's shared by all
+    // threads, while positionsAtTimes() keeps a hint of its own.
+    mutable std::atomic<int> lastSample;
 
     TrajectoryInterpolation interpolation;
 };
@@ -514,7 +549,55 @@ template <typename T> double SampledOrbitXYZV<T>::getBoundingRadius() const
 }
 
 
+// Return the index of the first sample at or after jd, or the sample count
+// if there is none, trying the span ending at the hint and the next one
+// before searching all samples.
+template <typename T> int SampledOrbitXYZV<T>::findSample(double jd, int hint) const
+{
+    int n = hint;
+    if (n >= 1 && n < (int) samples.size() && jd >= samples[n - 1].t)
+    {
+        if (jd <= samples[n].t)
+            return n;
+        if (n + 1 < (int) samples.size() && jd <= samples[n + 1].t)
+            return n + 1;
+    }
+
+    SampleXYZV<T> samp;
+    samp.t = jd;
+    auto iter = lower_bound(samples.begin(), samples.end(), samp);
+    return (int) (iter - samples.begin());
+}
+
+
 template <typename T> Vector3d SampledOrbitXYZV<T>::computePosition(double jd) const
+{
+    int n = 0;
+    if (samples.size() > 1)
+    {
+        n = findSample(jd, lastSample);
+        lastSample = n;
+    }
+
+    return interpolatePosition(jd, n);
+}
+
+
+template <typename T> void SampledOrbitXYZV<T>::positionsAtTimes(celestia::compat::span<const double> times,
+                                                                 celestia::compat::span<Vector3d> positions) const
+{
+    int n = 0;
+    for (size_t i = 0; i < times.size(); i++)
+    {
+        if (samples.size() > 1)
+            n = findSample(times[i], n);
+        positions[i] = interpolatePosition(times[i], n);
+    }
+}
+
+
+// Interpolate the position at jd in the span ending at sample n
+template <typename T> Vector3d SampledOrbitXYZV<T>::interpolatePosition(double jd, int n) const
 {
     Vector3d pos;
     if (samples.size() == 0)
@@ -523,27 +606,10 @@ template <typename T> Vector3d SampledOrbitXYZV<T>::computePosition(double jd) c
     }
     else if (samples.size() == 1)
     {
-        pos = Vector3d(samples[0].position.x(), samples[1].position.y(), samples[2].position.z());
+        pos = Vector3d(samples[0].position.x(), samples[0].position.y(), samples[0].position.z());
     }
     else
     {
-        SampleXYZV<T> samp;
-        samp.t = jd;
-        int n = lastSample;
-
-        if (n < 1 || n >= (int) samples.size() || jd < samples[n - 1].t || jd > samples[n].t)
-        {
-            typename vector<SampleXYZV<T> >::const_iterator iter = lower_bound(samples.begin(),
-                                                                               samples.end(),
-                                                                               samp);
-            if (iter == samples.end())
-                n = samples.size();
-            else
-                n = iter - samples.begin();
-
-            lastSample = n;
-        }
-
         if (n == 0)
         {
             pos = Vector3d(samples[n].position.x(), samples[n].position.y(), samples[n].position.z());
@@ -598,22 +664,8 @@ template <typename T> Vector3d SampledOrbitXYZV<T>::computeVelocity(double jd) c
 
     if (samples.size() >= 2)
     {
-        SampleXYZV<T> samp;
-        samp.t = jd;
-        int n = lastSample;
-
-        if (n < 1 || n >= (int) samples.size() || jd < samples[n - 1].t || jd > samples[n].t)
-        {
-            typename vector<SampleXYZV<T> >::const_iterator iter = lower_bound(samples.begin(),
-                                                                               samples.end(),
-                                                                               samp);
-            if (iter == samples.end())
-                n = samples.size();
-            else
-                n = iter - samples.begin();
-
-            lastSample = n;
-        }
+        int n = findSample(jd, lastSample);
+        lastSample = n;
 
         if (n > 0 && n < (int) samples.size())
         {
@@ -14,6 +14,7 @@
 #include "samporient.h"
 #include <celmath/mathlib.h>
 #include <celmath/geomutil.h>
+#include <atomic>
 #include <cmath>
 #include <cassert>
 #include <string>
@@ -99,7 +100,8 @@ private:
 
 private:
     OrientationSampleVector samples;
-    mutable int lastSample{0};
+    // Sample found by the last search, which is shared by all threads
+    mutable std::atomic<int> lastSample{0};
 
     enum InterpolationType
     {
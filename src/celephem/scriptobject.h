@@ -18,6 +18,7 @@
 
 #include "lua.hpp"
 #include <iostream>
+#include <mutex>
 #include <string>
 #include <celengine/parser.h>
 
@@ -26,6 +27,11 @@ void SetScriptedObjectContext(lua_State* l);
 
 lua_State* GetScriptedObjectContext();
 
+// Lock to hold while calling into the script context, as scripted orbits and
+// rotations may be evaluated from several threads. It is recursive because
+// a script may ask for the position of another scripted object.
+std::recursive_mutex& GetScriptedObjectMutex();
+
 
 std::string GenerateScriptObjectName();
 
@@ -162,6 +162,7 @@ Vector3d
 ScriptedOrbit::computePosition(double tjd) const
 {
     Vector3d pos(Vector3d::Zero());
+    std::lock_guard<std::recursive_mutex> lock(GetScriptedObjectMutex());
     lua_getglobal(luaState, luaOrbitObjectName.c_str());
     if (lua_istable(luaState, -1))
     {
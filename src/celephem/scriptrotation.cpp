@@ -138,6 +138,7 @@ ScriptedRotation::initialize(const std::string& moduleName,
 Quaterniond
 ScriptedRotation::spin(double tjd) const
 {
+    std::lock_guard<std::recursive_mutex> lock(GetScriptedObjectMutex());
     if (tjd != lastTime || !cacheable)
     {
         lua_getglobal(luaState, luaRotationObjectName.c_str());
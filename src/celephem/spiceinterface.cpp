@@ -24,6 +24,14 @@ using namespace std;
 static set<fs::path> ResidentSpiceKernels;
 
 
+std::mutex&
+GetSpiceMutex()
+{
+    static std::mutex spiceMutex;
+    return spiceMutex;
+}
+
+
 /*! Perform one-time initialization of SPICE.
  */
 bool
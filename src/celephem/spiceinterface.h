@@ -12,11 +12,16 @@
 #ifndef _CELENGINE_SPICEINTERFACE_H_
 #define _CELENGINE_SPICEINTERFACE_H_
 
+#include <mutex>
 #include <string>
 #include <celcompat/filesystem.h>
 
 extern bool InitializeSpice();
 
+// SPICE keeps its state in globals, so calls to it must hold this lock when
+// they may be made from several threads.
+extern std::mutex& GetSpiceMutex();
+
 // SPICE utility functions
 
 extern bool GetNaifId(const std::string& name, int* id);
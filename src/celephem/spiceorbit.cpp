@@ -251,6 +251,7 @@ SpiceOrbit::computePosition(double jd) const
         double position[3];
         double lt;          // One way light travel time
 
+        std::lock_guard<std::mutex> lock(GetSpiceMutex());
         spkgps_c(targetID,
                  t,
                  "eclipj2000",
@@ -296,6 +297,7 @@ SpiceOrbit::computeVelocity(double jd) const
         double state[6];
         double lt;          // One way light travel time
 
+        std::lock_guard<std::mutex> lock(GetSpiceMutex());
         spkgeo_c(targetID,
                  t,
                  "eclipj2000",
@@ -13,8 +13,12 @@
 // of the License, or (at your option) any later version.
 
 #include <cmath>
+#include <cstdint>
+#include <limits>
+#include <vector>
 #include <celmath/mathlib.h>
 #include <celengine/astro.h>
+#include <celutil/threadcache.h>
 #include "vsop87.h"
 
 using namespace Eigen;
@@ -10998,45 +11002,173 @@ static VSOPSeries sun_Z[] = {
 };
 
 
-static double SumSeries(const VSOPSeries& series, double t)
+// Terms with a smaller amplitude are left out of the orbits created
+static double minAmplitude = 0.0;
+
+void SetVSOP87MinAmplitude(double amplitude)
 {
-    if (series.nTerms < 1)
-        return 0.0;
+    minAmplitude = max(amplitude, 0.0);
+}
 
-    double x = 0.0;
-    VSOPTerm* term = &series.terms[0];
-    for (int i = 0; i < series.nTerms; i++, term++)
-        x += term->A * cos(term->B + term->C * t);
 
-    return x;
-};
+// The phases of the terms, up to 2.6e5 radians per millenium times the six
+// millenia from J2000.0 over which the series are used, stay within the
+// range where celmath::branchlessCos() is accurate.
 
-class VSOP87Orbit : public CachingOrbit
-{
- private:
-    VSOPSeries* vsL;
-    int nL;
-    VSOPSeries* vsB;
-    int nB;
-    VSOPSeries* vsR;
-    int nR;
-    double period;
-    double boundingRadius;
+// Number of times evaluated together by positionsAtTimes(); the sums for
+// all of them stay in the L1 cache while each term is applied to them.
+constexpr const size_t BatchSize = 64;
 
+
+// A variable of the theory, such as the longitude: the sum of the series
+// for each power of t multiplied by that power. The terms of each series
+// are copied from the tables to separate arrays of amplitudes, phases and
+// frequencies, which the loops over them read with vector instructions.
+class VSOPVariable
+{
  public:
-    VSOP87Orbit(VSOPSeries* _vsL, int _nL,
-                VSOPSeries* _vsB, int _nB,
-                VSOPSeries* _vsR, int _nR,
-                double _period,
-                double _boundingRadius) :
-        vsL(_vsL), nL(_nL),
-        vsB(_vsB), nB(_nB),
-        vsR(_vsR), nR(_nR),
-        period(_period),
-        boundingRadius(_boundingRadius)
+    VSOPVariable(const VSOPSeries* series, int nSeries);
+
+    void evaluate(const double* t, double* x, size_t n) const;
+    double maxFrequency() const;
+
+ private:
+    struct Terms
     {
+        vector<double> A, B, C;
     };
-    ~VSOP87Orbit() override = default;
+    vector<Terms> powers;
+};
+
+
+VSOPVariable::VSOPVariable(const VSOPSeries* series, int nSeries) :
+    powers(nSeries)
+{
+    for (int i = 0; i < nSeries; i++)
+    {
+        for (int j = 0; j < series[i].nTerms; j++)
+        {
+            const VSOPTerm& term = series[i].terms[j];
+            if (abs(term.A) < minAmplitude)
+                continue;
+            powers[i].A.push_back(term.A);
+            powers[i].B.push_back(term.B);
+            powers[i].C.push_back(term.C);
+        }
+    }
+}
+
+
+// Evaluate the variable for n <= BatchSize times at once. Each term is
+// loaded once for all the times rather than once per time, and the inner
+// loop over the times has no dependencies between iterations.
+void VSOPVariable::evaluate(const double* t, double* x, size_t n) const
+{
+    double T[BatchSize];
+    for (size_t k = 0; k < n; k++)
+    {
+        T[k] = 1.0;
+        x[k] = 0.0;
+    }
+
+    for (const auto& terms : powers)
+    {
+        double sum[BatchSize] = {};
+        for (size_t j = 0; j < terms.A.size(); j++)
+        {
+            double A = terms.A[j];
+            double B = terms.B[j];
+            double C = terms.C[j];
+            for (size_t k = 0; k < n; k++)
+                sum[k] += A * celmath::branchlessCos(B + C * t[k]);
+        }
+
+        for (size_t k = 0; k < n; k++)
+        {
+            x[k] += sum[k] * T[k];
+            T[k] = t[k] * T[k];
+        }
+    }
+}
+
+
+// Frequency of the fastest term, in radians per millenium
+double VSOPVariable::maxFrequency() const
+{
+    double maxC = 0.0;
+    for (const auto& terms : powers)
+    {
+        for (double C : terms.C)
+            maxC = max(maxC, abs(C));
+    }
+    return maxC;
+}
+
+
+// Convert times in Julian days to Julian millenia since J2000.0
+static size_t ToMillenia(celestia::compat::span<const double> times,
+                         size_t start, double* t)
+{
+    size_t n = min(BatchSize, times.size() - start);
+    for (size_t k = 0; k < n; k++)
+        t[k] = (times[start + k] - 2451545.0) / 365250.0;
+    return n;
+}
+
+
+// Convert heliocentric longitude, latitude and radius in AU to a position
+static Vector3d SphericalToPosition(double l, double b, double r)
+{
+    r *= KM_PER_AU;
+
+    // Corrections for internal coordinate system
+    b -= PI / 2;
+    l += PI;
+
+    return Vector3d(cos(l) * sin(b) * r,
+                    cos(b) * r,
+                    -sin(l) * sin(b) * r);
+}
+
+
+// Single positions are computed from Chebyshev polynomials fitted to the
+// series over windows of time, which is much faster when many positions
+// are needed close together in time, as when the simulation runs or an
+// event is searched for. Windows are short enough that the phase of the
+// fastest term changes by FitWindowPhase radians at most across them, so
+// that the positions given by the fit of FitSize polynomials are within
+// ten metres of those computed from the series, and within three over
+// the thousand years either side of J2000.0.
+constexpr const int FitSize = 16;
+constexpr const double FitWindowPhase = 4.0;
+
+// The polynomials fitted to the positions over a window, kept for each
+// orbit by each thread that uses it. A window is fitted for the first
+// position needed in it, which costs as much as computing FitSize
+// positions from the series. The fit only depends on the window, so a
+// position doesn't depend on those computed before it, or on the thread.
+namespace
+{
+struct VSOPFit
+{
+    double window{ numeric_limits<double>::quiet_NaN() };
+    Vector3d coeffs[FitSize];
+};
+}
+
+typedef ThreadLocalCache<VSOPFit, 64> FitCache;
+
+
+// Base class of the orbits computed from three variables of the theory
+class VSOP87OrbitBase : public CachingOrbit
+{
+ public:
+    VSOP87OrbitBase(const VSOPSeries* vs0, int n0,
+                    const VSOPSeries* vs1, int n1,
+                    const VSOPSeries* vs2, int n2,
+                    double _period,
+                    double _boundingRadius);
+    ~VSOP87OrbitBase() override = default;
 
     double getPeriod() const override
     {
@@ -11048,55 +11180,153 @@ class VSOP87Orbit : public CachingOrbit
         return boundingRadius;
     }
 
-    Vector3d computePosition(double jd) const override
+    Vector3d computePosition(double jd) const override;
+    void positionsAtTimes(celestia::compat::span<const double> times,
+                          celestia::compat::span<Vector3d> positions) const override;
+    void velocitiesAtTimes(celestia::compat::span<const double> times,
+                           celestia::compat::span<Vector3d> velocities) const override;
+
+ protected:
+    // Position in km from the values of the variables
+    virtual Vector3d toPosition(double x0, double x1, double x2) const = 0;
+
+    double period;
+
+ private:
+    void fitWindow(double window, Vector3d* coeffs) const;
+
+    VSOPVariable variables[3];
+    double boundingRadius;
+    double fitWindowLength;
+    uint64_t fitKey;
+};
+
+
+VSOP87OrbitBase::VSOP87OrbitBase(const VSOPSeries* vs0, int n0,
+                                 const VSOPSeries* vs1, int n1,
+                                 const VSOPSeries* vs2, int n2,
+                                 double _period,
+                                 double _boundingRadius) :
+    period(_period),
+    variables{ { vs0, n0 }, { vs1, n1 }, { vs2, n2 } },
+    boundingRadius(_boundingRadius),
+    fitKey(FitCache::newKey())
+{
+    double maxFrequency = max(variables[0].maxFrequency(),
+                              max(variables[1].maxFrequency(),
+                                  variables[2].maxFrequency()));
+    // With only the constant terms left, the series are polynomials of
+    // t, which are fitted exactly over any window.
+    fitWindowLength = maxFrequency > 0.0 ? FitWindowPhase / maxFrequency * 365250.0 : 365250.0;
+}
+
+
+// Fit Chebyshev polynomials to positions computed at the Chebyshev nodes
+// of the window
+void VSOP87OrbitBase::fitWindow(double window, Vector3d* coeffs) const
+{
+    double center = 2451545.0 + (window + 0.5) * fitWindowLength;
+    double times[FitSize];
+    Vector3d positions[FitSize];
+    for (int k = 0; k < FitSize; k++)
+        times[k] = center + 0.5 * fitWindowLength * cos(PI * (k + 0.5) / FitSize);
+    positionsAtTimes(times, positions);
+
+    for (int j = 0; j < FitSize; j++)
     {
-        // t is Julian millenia since J2000.0
-        double t = (jd - 2451545.0) / 365250.0;
+        coeffs[j] = Vector3d::Zero();
+        for (int k = 0; k < FitSize; k++)
+            coeffs[j] += positions[k] * cos(PI * j * (k + 0.5) / FitSize);
+        coeffs[j] *= (j == 0 ? 1.0 : 2.0) / FitSize;
+    }
+}
 
-        // Heliocentric coordinates
-        double l = 0.0; // longitude
-        double b = 0.0; // latitude
-        double r = 0.0; // radius
 
-        int i;
-        double T;
+Vector3d VSOP87OrbitBase::computePosition(double jd) const
+{
+    double window = floor((jd - 2451545.0) / fitWindowLength);
+    VSOPFit& fit = FitCache::entry(fitKey);
+    if (window != fit.window)
+    {
+        fitWindow(window, fit.coeffs);
+        fit.window = window;
+    }
 
-        // Evaluate series for l
-        T = 1;
-        for (i = 0; i < nL; i++)
-        {
-            l += SumSeries(vsL[i], t) * T;
-            T = t * T;
-        }
+    // Sum the polynomials with Clenshaw's recurrence
+    double center = 2451545.0 + (window + 0.5) * fitWindowLength;
+    double u = (jd - center) * 2.0 / fitWindowLength;
+    Vector3d b1 = Vector3d::Zero();
+    Vector3d b2 = Vector3d::Zero();
+    for (int j = FitSize - 1; j > 0; j--)
+    {
+        Vector3d b0 = 2.0 * u * b1 - b2 + fit.coeffs[j];
+        b2 = b1;
+        b1 = b0;
+    }
+    return u * b1 - b2 + fit.coeffs[0];
+}
 
-        // Evaluate series for b
-        T = 1;
-        for (i = 0; i < nB; i++)
-        {
-            b += SumSeries(vsB[i], t) * T;
-            T = t * T;
-        }
 
-        // Evaluate series for r
-        T = 1;
-        for (i = 0; i < nR; i++)
-        {
-            r += SumSeries(vsR[i], t) * T;
-            T = t * T;
-        }
+// Positions at many times are computed from the series, a batch of times
+// at once. They differ from single positions, given by the fits, by less
+// than ten metres.
+void VSOP87OrbitBase::positionsAtTimes(celestia::compat::span<const double> times,
+                                       celestia::compat::span<Vector3d> positions) const
+{
+    double t[BatchSize];
+    double x[3][BatchSize];
+
+    for (size_t start = 0; start < times.size(); start += BatchSize)
+    {
+        size_t n = ToMillenia(times, start, t);
+        for (int i = 0; i < 3; i++)
+            variables[i].evaluate(t, x[i], n);
+        for (size_t k = 0; k < n; k++)
+            positions[start + k] = toPosition(x[0][k], x[1][k], x[2][k]);
+    }
+}
 
-        r *= KM_PER_AU;
 
-        // Corrections for internal coordinate system
-        b -= PI / 2;
-        l += PI;
+// Velocities are differentiated from positions a minute apart, as by
+// CachingOrbit::computeVelocity(), with both positions of each time
+// computed from the series in the same batch.
+void VSOP87OrbitBase::velocitiesAtTimes(celestia::compat::span<const double> times,
+                                        celestia::compat::span<Vector3d> velocities) const
+{
+    const double dt = 1.0 / 1440.0;
+    double t[BatchSize];
+    Vector3d p[BatchSize];
 
-        return Vector3d(cos(l) * sin(b) * r,
-                        cos(b) * r,
-                        -sin(l) * sin(b) * r);
+    for (size_t start = 0; start < times.size(); start += BatchSize / 2)
+    {
+        size_t n = min(BatchSize / 2, times.size() - start);
+        for (size_t k = 0; k < n; k++)
+        {
+            t[k * 2] = times[start + k];
+            t[k * 2 + 1] = times[start + k] + dt;
+        }
+        positionsAtTimes(celestia::compat::span<const double>(t, n * 2),
+                         celestia::compat::span<Vector3d>(p, n * 2));
+        for (size_t k = 0; k < n; k++)
+            velocities[start + k] = (p[k * 2 + 1] - p[k * 2]) * (1.0 / dt);
     }
+}
 
 
+// VSOP87 orbit with spherical variables: longitude, latitude and radius
+class VSOP87Orbit : public VSOP87OrbitBase
+{
+ public:
+    VSOP87Orbit(const VSOPSeries* vsL, int nL,
+                const VSOPSeries* vsB, int nB,
+                const VSOPSeries* vsR, int nR,
+                double _period,
+                double _boundingRadius) :
+        VSOP87OrbitBase(vsL, nL, vsB, nB, vsR, nR, _period, _boundingRadius)
+    {
+    };
+    ~VSOP87Orbit() override = default;
+
     /** Custom implementation of sample() for VSOP87 orbits. The default
       * implementation runs too slowly and produces too many samples.
       */
@@ -11117,90 +11347,38 @@ class VSOP87Orbit : public CachingOrbit
         adaptiveSample(startTime, endTime, proc, samplingParams);
     }
 
+ protected:
+    Vector3d toPosition(double l, double b, double r) const override
+    {
+        return SphericalToPosition(l, b, r);
+    }
 };
 
 
 // VSOP87 orbit with rectangular variables
-class VSOP87OrbitRect : public CachingOrbit
+class VSOP87OrbitRect : public VSOP87OrbitBase
 {
- private:
-    VSOPSeries* vsX;
-    int nX;
-    VSOPSeries* vsY;
-    int nY;
-    VSOPSeries* vsZ;
-    int nZ;
-    double period;
-    double boundingRadius;
-
  public:
-    VSOP87OrbitRect(VSOPSeries* _vsX, int _nX,
-                    VSOPSeries* _vsY, int _nY,
-                    VSOPSeries* _vsZ, int _nZ,
+    VSOP87OrbitRect(const VSOPSeries* vsX, int nX,
+                    const VSOPSeries* vsY, int nY,
+                    const VSOPSeries* vsZ, int nZ,
                     double _period,
                     double _boundingRadius) :
-        vsX(_vsX), nX(_nX),
-        vsY(_vsY), nY(_nY),
-        vsZ(_vsZ), nZ(_nZ),
-        period(_period),
-        boundingRadius(_boundingRadius)
+        VSOP87OrbitBase(vsX, nX, vsY, nY, vsZ, nZ, _period, _boundingRadius)
     {
     };
     ~VSOP87OrbitRect() override = default;
 
-    double getPeriod() const override
-    {
-        return period;
-    }
-
     bool isPeriodic() const override
     {
         return period != 0.0;
     }
 
-    double getBoundingRadius() const override
+ protected:
+    Vector3d toPosition(double x, double y, double z) const override
     {
-        return boundingRadius;
-    }
-
-    Vector3d computePosition(double jd) const override
-    {
-        // t is Julian millenia since J2000.0
-        double t = (jd - 2451545.0) / 365250.0;
-
-        Vector3d v(Vector3d::Zero());
-
-        int i;
-        double T;
-
-        // Evaluate series for x
-        T = 1;
-        for (i = 0; i < nX; i++)
-        {
-            v.x() += SumSeries(vsX[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for y
-        T = 1;
-        for (i = 0; i < nY; i++)
-        {
-            v.y() += SumSeries(vsY[i], t) * T;
-            T = t * T;
-        }
-
-        // Evaluate series for z
-        T = 1;
-        for (i = 0; i < nZ; i++)
-        {
-            v.z() += SumSeries(vsZ[i], t) * T;
-            T = t * T;
-        }
-
-        v *= KM_PER_AU;
-
         // Corrections for internal coordinate system
-        return Vector3d(v.x(), v.z(), -v.y());
+        return Vector3d(x, z, -y) * KM_PER_AU;
     }
 };
 
@@ -15,4 +15,8 @@
 
 extern Orbit* CreateVSOP87Orbit(const std::string& name);
 
+// Leave the terms with an amplitude below the given one, in radians or AU,
+// out of the orbits created afterwards. Zero keeps all the terms.
+extern void SetVSOP87MinAmplitude(double amplitude);
+
 #endif // _CELENGINE_VSOP87_H_
@@ -0,0 +1,177 @@
+// catalogparser.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <celutil/filetype.h>
+#include <celutil/mappedfile.h>
+#include "catalogparser.h"
+
+using namespace std;
+
+
+// Number of catalogs parsed ahead of the one to be loaded next
+static const size_t MaxCatalogsAhead = 4;
+
+
+CatalogParser::~CatalogParser()
+{
+    // The catalogs not yet started are skipped if they are no longer
+    // wanted, but those being parsed can't be interrupted
+    {
+        lock_guard<std::mutex> lock(mutex);
+        stopping = true;
+    }
+    catalogLoaded.notify_all();
+
+    if (thread.joinable())
+        thread.join();
+}
+
+
+void CatalogParser::add(CatalogType type,
+                        const fs::path& path,
+                        const fs::path& resourcePath)
+{
+    Catalog catalog;
+    catalog.type = type;
+    catalog.path = path;
+    catalog.resourcePath = resourcePath;
+    catalogs.push_back(move(catalog));
+}
+
+
+void CatalogParser::addExtras(CatalogType type, const fs::path& dir)
+{
+    ContentType contentType = Content_Unknown;
+    switch (type)
+    {
+    case StarCatalog:
+        contentType = Content_CelestiaStarCatalog;
+        break;
+    case DeepSkyCatalog:
+        contentType = Content_CelestiaDeepSkyCatalog;
+        break;
+    case SolarSystemFile:
+        contentType = Content_CelestiaCatalog;
+        break;
+    }
+
+    for (const auto& fn : fs::recursive_directory_iterator(dir))
+    {
+        if (DetermineFileType(fn) != contentType)
+            continue;
+
+        add(type, fn, fn.path().parent_path());
+        catalogs.back().fromExtras = true;
+    }
+}
+
+
+void CatalogParser::start()
+{
+    parsed.assign(catalogs.size(), false);
+
+    // The calling thread is busy loading the parsed catalogs, so it isn't
+    // counted in the parsing threads.
+    unsigned int nThreads = max(std::thread::hardware_concurrency(), 2u) - 1;
+    pool = unique_ptr<ThreadPool>(new ThreadPool(nThreads));
+
+    thread = std::thread([this]()
+    {
+        // The catalogs are picked in order, so the first ones are parsed
+        // first.
+        pool->parallelFor(catalogs.size(), [this](size_t i, unsigned int)
+        {
+            {
+                unique_lock<std::mutex> lock(mutex);
+                catalogLoaded.wait(lock, [this, i]() { return stopping || i < nextCatalog + MaxCatalogsAhead; });
+                if (stopping)
+                    return;
+
+                if (freePools.empty())
+                {
+                    catalogs[i].pool = unique_ptr<MemoryPool>(new MemoryPool(sizeof(double), 64 * 1024));
+                }
+                else
+                {
+                    catalogs[i].pool = move(freePools.back());
+                    freePools.pop_back();
+                }
+            }
+
+            parse(catalogs[i]);
+
+            {
+                lock_guard<std::mutex> lock(mutex);
+                parsed[i] = true;
+            }
+            catalogParsed.notify_all();
+        });
+    });
+}
+
+
+void CatalogParser::parse(Catalog& catalog)
+{
+    // The catalogs are tokenized in place, which is much faster than
+    // reading them from a stream
+    MappedFile file(catalog.path);
+    catalog.opened = file.isOpen();
+    if (!catalog.opened)
+        return;
+
+    switch (catalog.type)
+    {
+    case StarCatalog:
+        catalog.stars.setPool(catalog.pool.get());
+        StarDatabase::parse(file.data(), file.size(), catalog.stars);
+        break;
+    case DeepSkyCatalog:
+        catalog.deepSkyObjects.setPool(catalog.pool.get());
+        DSODatabase::parse(file.data(), file.size(), catalog.deepSkyObjects);
+        break;
+    case SolarSystemFile:
+        catalog.solarSystem.setPool(catalog.pool.get());
+        ParseSolarSystemCatalog(file.data(), file.size(), catalog.solarSystem);
+        break;
+    }
+}
+
+
+CatalogParser::Catalog* CatalogParser::next(CatalogType type)
+{
+    // Release the contents of the previous catalog, and let its pool be
+    // used for the next one parsed
+    if (nextCatalog > 0)
+    {
+        Catalog& previous = catalogs[nextCatalog - 1];
+        previous.stars = StarDatabase::ParsedStarCatalog();
+        previous.deepSkyObjects = DSODatabase::ParsedDSOCatalog();
+        previous.solarSystem = ParsedSolarSystemCatalog();
+        if (previous.pool != nullptr)
+        {
+            previous.pool->freeAll();
+            lock_guard<std::mutex> lock(mutex);
+            freePools.push_back(move(previous.pool));
+        }
+    }
+
+    if (nextCatalog == catalogs.size() || catalogs[nextCatalog].type != type)
+        return nullptr;
+
+    Catalog* catalog = nullptr;
+    {
+        unique_lock<std::mutex> lock(mutex);
+        catalogParsed.wait(lock, [this]() { return parsed[nextCatalog]; });
+        catalog = &catalogs[nextCatalog++];
+    }
+    catalogLoaded.notify_all();
+
+    return catalog;
+}
@@ -0,0 +1,88 @@
+// catalogparser.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+#include <celcompat/filesystem.h>
+#include <celengine/dsodb.h>
+#include <celengine/solarsys.h>
+#include <celengine/stardb.h>
+#include <celutil/threadpool.h>
+
+// Reads and parses the text catalogs loaded at startup on a pool of
+// threads, while the caller adds the catalogs parsed so far to the
+// databases. Catalogs are handed out in the order they were added, which
+// is the order they must be loaded in, as later catalogs may modify or
+// refer to objects defined by earlier ones. Parsing stays a few catalogs
+// ahead of loading, so that the parsed catalogs waiting to be loaded don't
+// use much memory, and the memory pools of the catalogs loaded are reused
+// for the next ones parsed.
+class CatalogParser
+{
+ public:
+    enum CatalogType
+    {
+        StarCatalog,
+        DeepSkyCatalog,
+        SolarSystemFile,
+    };
+
+    struct Catalog
+    {
+        CatalogType type;
+        fs::path path;
+        fs::path resourcePath;
+        bool fromExtras{ false };   // found in an extras directory
+        bool opened{ false };
+        StarDatabase::ParsedStarCatalog stars;
+        DSODatabase::ParsedDSOCatalog deepSkyObjects;
+        ParsedSolarSystemCatalog solarSystem;
+        std::unique_ptr<MemoryPool> pool;
+    };
+
+    CatalogParser() = default;
+    ~CatalogParser();
+    CatalogParser(const CatalogParser&) = delete;
+    CatalogParser& operator=(const CatalogParser&) = delete;
+
+    // Catalogs can only be added before parsing is started
+    void add(CatalogType type,
+             const fs::path& path,
+             const fs::path& resourcePath = fs::path());
+
+    // Add the catalogs of a type found in an extras directory tree
+    void addExtras(CatalogType type, const fs::path& dir);
+
+    void start();
+
+    // Return the next catalog once it has been parsed, or nullptr if the
+    // next one isn't of the given type. The caller takes the parsed
+    // contents, and the memory they use is released on the next call.
+    Catalog* next(CatalogType type);
+
+ private:
+    void parse(Catalog& catalog);
+
+    std::vector<Catalog> catalogs;
+    std::vector<bool> parsed;
+    size_t nextCatalog{ 0 };
+    std::vector<std::unique_ptr<MemoryPool>> freePools;
+    bool stopping{ false };
+
+    std::unique_ptr<ThreadPool> pool;
+    std::thread thread;
+    std::mutex mutex;
+    std::condition_variable catalogParsed;
+    std::condition_variable catalogLoaded;
+};
@@ -14,6 +14,7 @@
 // of the License, or (at your option) any later version.
 
 #include "celestiacore.h"
+#include "catalogparser.h"
 #include "favorites.h"
 #include "url.h"
 #include <celengine/astro.h>
@@ -24,9 +25,13 @@
 #include <celscript/legacy/execution.h>
 #include <celscript/legacy/cmdparser.h>
 #include <celengine/multitexture.h>
+#include <celengine/meshmanager.h>
 #ifdef USE_SPICE
 #include <celephem/spiceinterface.h>
 #endif
+#include <celephem/vsop87.h>
+#include <celengine/formcache.h>
+#include <celengine/orbitpathcache.h>
 #include <celengine/axisarrow.h>
 #include <celengine/planetgrid.h>
 #include <celengine/visibleregion.h>
@@ -36,6 +41,7 @@
 #include <celutil/formatnum.h>
 #include <celutil/debug.h>
 #include <celutil/gettext.h>
+#include <celutil/profiler.h>
 #include <celutil/utf8.h>
 #include <celcompat/filesystem.h>
 #include <celcompat/memory.h>
@@ -89,6 +95,9 @@ static float KeyRotationAccel = degToRad(120.0f);
 static float MouseRotationSensitivity = degToRad(1.0f);
 
 static const int ConsolePageRows = 10;
+// Limit of the names offered while typing an object name; the shortest
+// matching names are kept.
+static const size_t MaxTypedTextCompletions = 100;
 static Console console(200, 120);
 
 static void warning(string s)
@@ -936,7 +945,7 @@ void CelestiaCore::charEntered(const char *c_p, int modifiers)
                     typedText = string(typedText, 0, typedText.size() - 1);
                     if (typedText.size() > 0)
                     {
-                        typedTextCompletion = sim->getObjectCompletion(typedText, (renderer->getLabelMode() & Renderer::LocationLabels) != 0);
+                        typedTextCompletion = sim->getObjectCompletion(typedText, (renderer->getLabelMode() & Renderer::LocationLabels) != 0, MaxTypedTextCompletions);
                     } else {
                         typedTextCompletion.clear();
                     }
@@ -1724,6 +1733,17 @@ void CelestiaCore::charEntered(const char *c_p, int modifiers)
         showFPSCounter = !showFPSCounter;
         break;
 
+    case '#':
+        showProfile = !showProfile;
+        Profiler::get().setEnabled(showProfile);
+        if (!showProfile)
+        {
+            fs::path traceFile = PathExp("~/celestia-trace.json");
+            if (saveProfileTrace(traceFile))
+                flash(fmt::sprintf(_("Profile saved to %s"), traceFile));
+        }
+        break;
+
     case '{':
         {
             if (renderer->getAmbientLightLevel() > 0.05f)
@@ -1887,6 +1907,9 @@ void CelestiaCore::setStartURL(string url)
 
 void CelestiaCore::tick()
 {
+    Profiler::get().nextFrame();
+    PROFILE_SCOPE("CelestiaCore::tick");
+
     double lastTime = sysTime;
     sysTime = timer->getTime();
 
@@ -2084,6 +2107,8 @@ void CelestiaCore::draw()
         return;
     viewChanged = false;
 
+    PROFILE_SCOPE("CelestiaCore::draw");
+
     if (views.size() == 1)
     {
         // I'm not certain that a special case for one view is required; but,
@@ -2109,6 +2134,27 @@ void CelestiaCore::draw()
         renderer->setRenderRegion(0, 0, width, height, false);
     }
 
+    // Unload the textures, models and orbit paths unused for a while if
+    // they're over budget, once all the views have been drawn.
+    ResourceStatistics textureStats = GetTextureManager()->nextFrame();
+    ResourceStatistics modelStats = GetGeometryManager()->nextFrame();
+    PROFILE_COUNT("Textures found", textureStats.hits);
+    PROFILE_COUNT("Textures loaded", textureStats.misses);
+    PROFILE_COUNT("Textures unloaded", textureStats.evictions);
+    PROFILE_COUNT("Texture memory (MB)", textureStats.memoryUsage >> 20);
+    PROFILE_COUNT("Models found", modelStats.hits);
+    PROFILE_COUNT("Models loaded", modelStats.misses);
+    PROFILE_COUNT("Models unloaded", modelStats.evictions);
+    PROFILE_COUNT("Model memory (MB)", modelStats.memoryUsage >> 20);
+
+    OrbitPathStatistics orbitStats = renderer->getOrbitPathCache().nextFrame();
+    PROFILE_COUNT("Orbit paths found", orbitStats.hits);
+    PROFILE_COUNT("Orbit paths requested", orbitStats.misses);
+    PROFILE_COUNT("Orbit paths sampled", orbitStats.pathsSampled);
+    PROFILE_COUNT("Orbit positions computed", orbitStats.samplesComputed);
+    PROFILE_COUNT("Orbit paths unloaded", orbitStats.evictions);
+    PROFILE_COUNT("Orbit path samples", orbitStats.samples);
+
     bool toggleAA = renderer->isMSAAEnabled();
     if (toggleAA && (renderer->getRenderFlags() & Renderer::ShowCloudMaps))
         renderer->disableMSAA();
@@ -3087,6 +3133,28 @@ void CelestiaCore::renderOverlay()
         overlay->restorePos();
     }
 
+    if (showProfile)
+    {
+        // Average time per frame spent in each zone, and average counts
+        vector<Profiler::Summary> zones;
+        vector<Profiler::Summary> counters;
+        Profiler::get().getZoneSummary(zones);
+        Profiler::get().getCounterSummary(counters);
+
+        overlay->savePos();
+        overlay->moveBy(width - emWidth * 32, height - fontHeight * 4);
+        overlay->setColor(0.7f, 0.7f, 1.0f, 1.0f);
+
+        overlay->beginText();
+        fmt::fprintf(*overlay, _("Frame: %.2f ms\n"), Profiler::get().getAverageFrameTime());
+        for (const auto& zone : zones)
+            fmt::fprintf(*overlay, "%s: %.2f ms (max %.2f)\n", zone.name, zone.average, zone.maximum);
+        for (const auto& counter : counters)
+            fmt::fprintf(*overlay, "%s: %.0f\n", counter.name, counter.average);
+        overlay->endText();
+        overlay->restorePos();
+    }
+
     Universe *u = sim->getUniverse();
 
     if (hudDetail > 0 && (overlayElements & ShowFrame))
@@ -3494,74 +3562,6 @@ void CelestiaCore::renderOverlay()
 }
 
 
-class SolarSystemLoader
-{
-    Universe* universe;
-    ProgressNotifier* notifier;
-
- public:
-    SolarSystemLoader(Universe* u, ProgressNotifier* pn) : universe(u), notifier(pn) {};
-
-    void process(const fs::path& filepath)
-    {
-        if (DetermineFileType(filepath) != Content_CelestiaCatalog)
-            return;
-
-        fmt::fprintf(clog, _("Loading solar system catalog: %s\n"), filepath.string());
-        if (notifier != nullptr)
-            notifier->update(filepath.filename().string());
-
-        ifstream solarSysFile(filepath.string(), ios::in);
-        if (solarSysFile.good())
-        {
-            LoadSolarSystemObjects(solarSysFile,
-                                   *universe,
-                                   filepath.parent_path());
-        }
-    };
-};
-
-template <class OBJDB> class CatalogLoader
-{
-    OBJDB*      objDB;
-    string      typeDesc;
-    ContentType contentType;
-    ProgressNotifier* notifier;
-
- public:
-    CatalogLoader(OBJDB* db,
-                  const std::string& typeDesc,
-                  const ContentType& contentType,
-                  ProgressNotifier* pn) :
-        objDB      (db),
-        typeDesc   (typeDesc),
-        contentType(contentType),
-        notifier(pn)
-    {
-    }
-
-    void process(const fs::path& filepath)
-    {
-        if (DetermineFileType(filepath) != contentType)
-            return;
-
-        fmt::fprintf(clog, _("Loading %s catalog: %s\n"), typeDesc, filepath.string());
-        if (notifier != nullptr)
-            notifier->update(filepath.filename().string());
-
-        ifstream catalogFile(filepath.string(), ios::in);
-        if (catalogFile.good())
-        {
-            if (!objDB->load(catalogFile, filepath.parent_path()))
-                DPRINTF(LOG_LEVEL_ERROR, "Error reading %s catalog file: %s\n", typeDesc.c_str(), filepath.string());
-        }
-    }
-};
-
-using StarLoader = CatalogLoader<StarDatabase>;
-using DeepSkyLoader = CatalogLoader<DSODatabase>;
-
-
 bool CelestiaCore::initSimulation(const fs::path& configFileName,
                                   const vector<fs::path>& extrasDirs,
                                   ProgressNotifier* progressNotifier)
@@ -3630,10 +3630,51 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
 
     universe = new Universe();
 
+    // Orbits are created with the terms kept when solar systems are loaded
+    SetVSOP87MinAmplitude(config->vsop87MinAmplitude);
+
+    FormCache::get().setFile(config->dsoFormCacheFile);
+
+    /***** Parse the text catalogs *****/
+    // Star, deep sky and solar system catalogs are loaded in that order,
+    // each from the files listed in the config file and then from the
+    // extras directories. The files are parsed ahead on other threads
+    // while the ones already parsed are loaded.
+    CatalogParser catalogParser;
+
+    for (const auto& file : config->starCatalogFiles)
+    {
+        if (!file.empty())
+            catalogParser.add(CatalogParser::StarCatalog, file);
+    }
+    for (const auto& dir : config->extrasDirs)
+    {
+        if (is_valid_directory(dir))
+            catalogParser.addExtras(CatalogParser::StarCatalog, dir);
+    }
+
+    for (const auto& file : config->dsoCatalogFiles)
+        catalogParser.add(CatalogParser::DeepSkyCatalog, file);
+    for (const auto& dir : config->extrasDirs)
+    {
+        if (is_valid_directory(dir))
+            catalogParser.addExtras(CatalogParser::DeepSkyCatalog, dir);
+    }
+
+    for (const auto& file : config->solarSystemFiles)
+        catalogParser.add(CatalogParser::SolarSystemFile, file);
+    for (const auto& dir : config->extrasDirs)
+    {
+        if (is_valid_directory(dir))
+            catalogParser.addExtras(CatalogParser::SolarSystemFile, dir);
+    }
+
+    catalogParser.start();
+
 
     /***** Load star catalogs *****/
 
-    if (!readStars(*config, progressNotifier))
+    if (!readStars(*config, progressNotifier, catalogParser))
     {
         fatalError(_("Cannot read star database."), false);
         return false;
@@ -3646,36 +3687,34 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
     DSODatabase*     dsoDB      = new DSODatabase;
     dsoDB->setNameDatabase(dsoNameDB);
 
-    // Load first the vector of dsoCatalogFiles in the data directory (deepsky.dsc, globulars.dsc,...):
-
-    for (const auto& file : config->dsoCatalogFiles)
+    // Load first the vector of dsoCatalogFiles in the data directory
+    // (deepsky.dsc, globulars.dsc,...), then the deep sky files in the
+    // extras directories
+    while (CatalogParser::Catalog* catalog = catalogParser.next(CatalogParser::DeepSkyCatalog))
     {
-        if (progressNotifier)
-            progressNotifier->update(file.string());
-
-        ifstream dsoFile(file.string(), ios::in);
-        if (!dsoFile.good())
+        if (catalog->fromExtras)
         {
-            warning(fmt::sprintf(_("Error opening deepsky catalog file %s.\n"), file));
+            fmt::fprintf(clog, _("Loading %s catalog: %s\n"), "deep sky object", catalog->path.string());
+            if (progressNotifier)
+                progressNotifier->update(catalog->path.filename().string());
+
+            if (catalog->opened && !dsoDB->load(catalog->deepSkyObjects, catalog->resourcePath))
+                DPRINTF(LOG_LEVEL_ERROR, "Error reading %s catalog file: %s\n", "deep sky object", catalog->path.string());
         }
-        if (!dsoDB->load(dsoFile, ""))
+        else
         {
-            warning(fmt::sprintf(_("Cannot read Deep Sky Objects database %s.\n"), file));
-        }
-    }
-
-    // Next, read all the deep sky files in the extras directories
-    for (const auto& dir : config->extrasDirs)
-    {
-        if (!is_valid_directory(dir))
-            continue;
+            if (progressNotifier)
+                progressNotifier->update(catalog->path.string());
 
-        DeepSkyLoader loader(dsoDB,
-                             "deep sky object",
-                             Content_CelestiaDeepSkyCatalog,
-                             progressNotifier);
-        for (const auto& fn : fs::recursive_directory_iterator(dir))
-            loader.process(fn);
+            if (!catalog->opened)
+            {
+                warning(fmt::sprintf(_("Error opening deepsky catalog file %s.\n"), catalog->path));
+            }
+            else if (!dsoDB->load(catalog->deepSkyObjects, catalog->resourcePath))
+            {
+                warning(fmt::sprintf(_("Cannot read Deep Sky Objects database %s.\n"), catalog->path));
+            }
+        }
     }
     dsoDB->finish();
     universe->setDSOCatalog(dsoDB);
@@ -3683,37 +3722,28 @@ bool CelestiaCore::initSimulation(const fs::path& configFileName,
 
     /***** Load the solar system catalogs *****/
     // First read the solar system files listed individually in the
-    // config file.
+    // config file, then the ones in the extras directories.
+    universe->setSolarSystemCatalog(new SolarSystemCatalog());
+    while (CatalogParser::Catalog* catalog = catalogParser.next(CatalogParser::SolarSystemFile))
     {
-        SolarSystemCatalog* solarSystemCatalog = new SolarSystemCatalog();
-        universe->setSolarSystemCatalog(solarSystemCatalog);
-        for (const auto& file : config->solarSystemFiles)
+        if (catalog->fromExtras)
         {
+            fmt::fprintf(clog, _("Loading solar system catalog: %s\n"), catalog->path.string());
             if (progressNotifier)
-                progressNotifier->update(file.string());
+                progressNotifier->update(catalog->path.filename().string());
 
-            ifstream solarSysFile(file.string(), ios::in);
-            if (!solarSysFile.good())
-            {
-                warning(fmt::sprintf(_("Error opening solar system catalog %s.\n"), file));
-            }
-            else
-            {
-                LoadSolarSystemObjects(solarSysFile, *universe);
-            }
+            if (catalog->opened)
+                LoadSolarSystemObjects(catalog->solarSystem, *universe, catalog->resourcePath);
         }
-    }
-
-    // Next, read all the solar system files in the extras directories
-    {
-        for (const auto& dir : config->extrasDirs)
+        else
         {
-            if (!is_valid_directory(dir))
-                continue;
+            if (progressNotifier)
+                progressNotifier->update(catalog->path.string());
 
-            SolarSystemLoader loader(universe, progressNotifier);
-            for (const auto& fn : fs::recursive_directory_iterator(dir))
-                loader.process(fn);
+            if (!catalog->opened)
+                warning(fmt::sprintf(_("Error opening solar system catalog %s.\n"), catalog->path));
+            else
+                LoadSolarSystemObjects(catalog->solarSystem, *universe);
         }
     }
 
@@ -3806,12 +3836,13 @@ bool CelestiaCore::initRenderer()
 #endif
 
     Renderer::DetailOptions detailOptions;
-    detailOptions.orbitPathSamplePoints = config->orbitPathSamplePoints;
     detailOptions.shadowTextureSize = config->shadowTextureSize;
     detailOptions.eclipseTextureSize = config->eclipseTextureSize;
     detailOptions.orbitWindowEnd = config->orbitWindowEnd;
     detailOptions.orbitPeriodsShown = config->orbitPeriodsShown;
     detailOptions.linearFadeFraction = config->linearFadeFraction;
+    detailOptions.backgroundLoading = config->backgroundLoading;
+    detailOptions.resourceCreationTime = config->resourceCreationTime / 1000.0;
 
     // Prepare the scene for rendering.
 #ifdef USE_GLCONTEXT
@@ -3824,6 +3855,12 @@ bool CelestiaCore::initRenderer()
         return false;
     }
 
+    // Budgets are in megabytes
+    GetTextureManager()->setMemoryBudget((size_t) config->textureMemoryBudget << 20,
+                                         config->resourceEvictionAge);
+    GetGeometryManager()->setMemoryBudget((size_t) config->modelMemoryBudget << 20,
+                                          config->resourceEvictionAge);
+
     if ((renderer->getRenderFlags() & Renderer::ShowAutoMag) != 0)
     {
         renderer->setFaintestAM45deg(renderer->getFaintestAM45deg());
@@ -3897,7 +3934,8 @@ static void loadCrossIndex(StarDatabase* starDB,
 
 
 bool CelestiaCore::readStars(const CelestiaConfig& cfg,
-                             ProgressNotifier* progressNotifier)
+                             ProgressNotifier* progressNotifier,
+                             CatalogParser& catalogParser)
 {
     StarDetails::SetStarTextures(cfg.starTextures);
 
@@ -3949,32 +3987,43 @@ bool CelestiaCore::readStars(const CelestiaConfig& cfg,
     loadCrossIndex(starDB, StarDatabase::Gliese,      cfg.GlieseCrossIndexFile);
 
     // Next, read any ASCII star catalog files specified in the StarCatalogs
-    // list.
-    for (const auto& file : config->starCatalogFiles)
+    // list, and then the supplemental star files from the extras directories
+    while (CatalogParser::Catalog* catalog = catalogParser.next(CatalogParser::StarCatalog))
     {
-        if (file.empty())
-            continue;
+        if (catalog->fromExtras)
+        {
+            fmt::fprintf(clog, _("Loading %s catalog: %s\n"), "star", catalog->path.string());
+            if (progressNotifier)
+                progressNotifier->update(catalog->path.filename().string());
 
-        ifstream starFile(file.string(), ios::in);
-        if (starFile.good())
-            starDB->load(starFile);
+            if (catalog->opened && !starDB->load(catalog->stars, catalog->resourcePath))
+                DPRINTF(LOG_LEVEL_ERROR, "Error reading %s catalog file: %s\n", "star", catalog->path.string());
+        }
         else
-            fmt::fprintf(cerr, _("Error opening star catalog %s\n"), file);
+        {
+            if (catalog->opened)
+                starDB->load(catalog->stars);
+            else
+                fmt::fprintf(cerr, _("Error opening star catalog %s\n"), catalog->path);
+        }
     }
 
-    // Now, read supplemental star files from the extras directories
-    for (const auto& dir : config->extrasDirs)
-    {
-        if (!is_valid_directory(dir))
-            continue;
-
-        StarLoader loader(starDB, "star", Content_CelestiaStarCatalog, progressNotifier);
-        for (const auto& fn : fs::recursive_directory_iterator(dir))
-            loader.process(fn);
-    }
+    starDB->setOctreeCacheFile(cfg.starOctreeCacheFile);
 
+    Timer octreeTimer;
     starDB->finish();
 
+    if (!cfg.starOctreeCacheFile.empty())
+    {
+        string msg = fmt::sprintf(starDB->isOctreeCached() ?
+                                  _("Star octree cache hit, stars sorted in %.1f ms") :
+                                  _("Star octree cache miss, stars sorted in %.1f ms"),
+                                  octreeTimer.getTime() * 1000.0);
+        clog << msg << '\n';
+        if (progressNotifier)
+            progressNotifier->update(msg);
+    }
+
     universe->setStarCatalog(starDB);
 
     return true;
@@ -4429,7 +4478,7 @@ bool CelestiaCore::initLuaHook(ProgressNotifier* progressNotifier)
 void CelestiaCore::setTypedText(const char *c_p)
 {
     typedText += string(c_p);
-    typedTextCompletion = sim->getObjectCompletion(typedText, (renderer->getLabelMode() & Renderer::LocationLabels) != 0);
+    typedTextCompletion = sim->getObjectCompletion(typedText, (renderer->getLabelMode() & Renderer::LocationLabels) != 0, MaxTypedTextCompletions);
     typedTextCompletionIdx = -1;
 #ifdef AUTO_COMPLETION
     if (typedTextCompletion.size() == 1)
@@ -4486,3 +4535,15 @@ bool CelestiaCore::saveScreenShot(const fs::path& filename, ContentType type) co
 
     return false;
 }
+
+bool CelestiaCore::saveProfileTrace(const fs::path& filename) const
+{
+    ofstream out(filename.string());
+    if (!out.good())
+    {
+        DPRINTF(LOG_LEVEL_ERROR, "Could not open %s\n", filename);
+        return false;
+    }
+
+    return Profiler::get().writeChromeTrace(out);
+}
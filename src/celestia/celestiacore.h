@@ -35,6 +35,7 @@
 #include <celscript/common/scriptmaps.h>
 
 class Url;
+class CatalogParser;
 
 // class CelestiaWatcher;
 class CelestiaCore;
@@ -339,9 +340,10 @@ class CelestiaCore // : public Watchable<CelestiaCore>
     const std::shared_ptr<celestia::scripts::ScriptMaps>& scriptMaps() const { return m_scriptMaps; }
 
     bool saveScreenShot(const fs::path&, ContentType = Content_Unknown) const;
+    bool saveProfileTrace(const fs::path&) const;
 
  protected:
-    bool readStars(const CelestiaConfig&, ProgressNotifier*);
+    bool readStars(const CelestiaConfig&, ProgressNotifier*, CatalogParser&);
     void renderOverlay();
 #ifdef CELX
     bool initLuaHook(ProgressNotifier*);
@@ -421,6 +423,8 @@ class CelestiaCore // : public Watchable<CelestiaCore>
     double fps{ 0.0 };
     double fpsCounterStartTime{ 0.0 };
 
+    bool showProfile{ false };
+
     float oldFOV;
     float mouseMotion{ 0.0f };
     double dollyMotion{ 0.0 };
@@ -85,6 +85,8 @@ CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig *con
     configParams->getPath("BoundariesFile", config->boundariesFile);
     configParams->getPath("StarDatabase", config->starDatabaseFile);
     configParams->getPath("StarNameDatabase", config->starNamesFile);
+    configParams->getPath("StarOctreeCache", config->starOctreeCacheFile);
+    configParams->getPath("DSOFormCache", config->dsoFormCacheFile);
     configParams->getPath("HDCrossIndex", config->HDCrossIndexFile);
     configParams->getPath("SAOCrossIndex", config->SAOCrossIndexFile);
     configParams->getPath("GlieseCrossIndex", config->GlieseCrossIndexFile);
@@ -99,6 +101,7 @@ CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig *con
     config->SolarSystemMaxDistance = min(max(maxDist, 1.0f), 10.0f);
 
     config->ShadowMapSize = getUint(configParams, "ShadowMapSize", 0);
+    config->RenderThreads = getUint(configParams, "RenderThreads", 1);
 
     double aaSamples = 1;
     configParams->getNumber("AntialiasingSamples", aaSamples);
@@ -124,10 +127,21 @@ CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig *con
     config->linearFadeFraction = 0.0f;
     configParams->getNumber("LinearFadeFraction", config->linearFadeFraction);
 
-    config->orbitPathSamplePoints = getUint(configParams, "OrbitPathSamplePoints", 100);
+    config->vsop87MinAmplitude = 0.0;
+    configParams->getNumber("VSOP87MinAmplitude", config->vsop87MinAmplitude);
+
     config->shadowTextureSize = getUint(configParams, "ShadowTextureSize", 256);
     config->eclipseTextureSize = getUint(configParams, "EclipseTextureSize", 128);
 
+    config->backgroundLoading = false;
+    configParams->getBoolean("BackgroundLoading", config->backgroundLoading);
+    config->resourceCreationTime = 5.0;
+    configParams->getNumber("ResourceCreationTime", config->resourceCreationTime);
+
+    config->textureMemoryBudget = getUint(configParams, "TextureMemoryBudget", 0);
+    config->modelMemoryBudget = getUint(configParams, "ModelMemoryBudget", 0);
+    config->resourceEvictionAge = getUint(configParams, "ResourceEvictionAge", 300);
+
     config->consoleLogRows = getUint(configParams, "LogSize", 200);
 
     Value* solarSystemsVal = configParams->getValue("SolarSystemCatalogs");
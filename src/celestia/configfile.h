@@ -22,6 +22,8 @@ class CelestiaConfig
 public:
     fs::path starDatabaseFile;
     fs::path starNamesFile;
+    fs::path starOctreeCacheFile;
+    fs::path dsoFormCacheFile;
     std::vector<fs::path> solarSystemFiles;
     std::vector<fs::path> starCatalogFiles;
     std::vector<fs::path> dsoCatalogFiles;
@@ -46,6 +48,7 @@ public:
     double orbitWindowEnd;
     double orbitPeriodsShown;
     double linearFadeFraction;
+    double vsop87MinAmplitude;
     fs::path scriptScreenshotDirectory;
     std::string scriptSystemAccessPolicy;
 #ifdef CELX
@@ -62,7 +65,11 @@ public:
     // Renderer detail options
     unsigned int shadowTextureSize;
     unsigned int eclipseTextureSize;
-    unsigned int orbitPathSamplePoints;
+    bool backgroundLoading;
+    double resourceCreationTime;
+    unsigned int textureMemoryBudget;
+    unsigned int modelMemoryBudget;
+    unsigned int resourceEvictionAge;
 
     unsigned int aaSamples;
 
@@ -77,6 +84,7 @@ public:
 
     float SolarSystemMaxDistance;
     unsigned ShadowMapSize;
+    unsigned RenderThreads;
 };
 
 CelestiaConfig* ReadCelestiaConfig(const fs::path& filename, CelestiaConfig* config = nullptr);
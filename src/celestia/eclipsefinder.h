@@ -40,7 +40,15 @@ class EclipseFinderWatcher
         AbortOperation = 1,
     };
 
+    // Called as the search goes on with the time up to which eclipses have
+    // been searched for; the search stops if AbortOperation is returned.
     virtual Status eclipseFinderProgressUpdate(double t) = 0;
+
+    // Called with each eclipse as soon as it is found, so that results can
+    // be shown before the search completes. Eclipses aren't necessarily
+    // reported in order of their start times. All calls to the watcher are
+    // made from the thread calling findEclipses().
+    virtual void eclipseFound(const Eclipse& /*eclipse*/) {};
 };
 
 class EclipseFinder
@@ -48,6 +56,13 @@ class EclipseFinder
  public:
     EclipseFinder(Body*, EclipseFinderWatcher* = nullptr);
 
+    // Set the precision of the start and end times of eclipses, in days
+    void setPrecision(double _precision) { precision = _precision; }
+    double getPrecision() const { return precision; }
+
+    // Find the eclipses of the body by its satellites and of its satellites
+    // by the body which begin between startDate and endDate, sorted by start
+    // time. Satellites are searched in parallel.
     void findEclipses(double startDate,
                       double endDate,
                       int eclipseTypeMask,
@@ -55,6 +70,7 @@ class EclipseFinder
  private:
     Body* body;
     EclipseFinderWatcher* watcher;
+    double precision;
 };
 #endif // _ECLIPSEFINDER_H_
 
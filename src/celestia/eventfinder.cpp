@@ -0,0 +1,493 @@
+// eventfinder.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// Search for events such as conjunctions, occultations, transits and close
+// approaches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <celmath/mathlib.h>
+#include <celmath/solve.h>
+#include <celutil/threadpool.h>
+#include "eventfinder.h"
+
+using namespace Eigen;
+using namespace std;
+using namespace celmath;
+
+
+// Default precision of event times
+constexpr const double DefaultPrecision = 1.0 / (24.0 * 3600.0); // one second
+
+// Default shortest step, so that the search doesn't stall close to an event
+constexpr const double DefaultMinStep = 1.0 / (24.0 * 60.0); // one minute
+
+// Number of samples of a function used to estimate how fast it changes
+constexpr const int RateSampleCount = 64;
+
+// Margin applied to the estimated rate of change of functions, allowing for
+// them to change somewhat faster between samples.
+constexpr const double RateSafetyFactor = 1.5;
+
+// Number of parts into which the search is split; the watcher is updated
+// after each one.
+constexpr const int SearchSliceCount = 256;
+
+// Searches are split into as many chunks searched in parallel as there are
+// threads, but chunks are at least this many of the longest steps long.
+constexpr const double MinChunkSteps = 16.0;
+
+
+namespace
+{
+// Estimate the greatest rate of change of the function of a search from
+// samples over its first steps.
+double estimateRate(const EventFinder::Search& search, double startTime, double endTime)
+{
+    if (search.maxRate > 0.0 || !isfinite(search.threshold))
+        return search.maxRate;
+
+    double maxRate = 0.0;
+    double span = min(endTime - startTime, search.maxStep * 16.0);
+    double dt = span / RateSampleCount;
+    if (dt > 0.0)
+    {
+        double f0 = search.function(startTime);
+        for (int i = 1; i <= RateSampleCount; i++)
+        {
+            double f1 = search.function(startTime + dt * i);
+            maxRate = max(maxRate, abs(f1 - f0) / dt);
+            f0 = f1;
+        }
+    }
+    return maxRate * RateSafetyFactor;
+}
+
+
+// The state of the search of a chunk of the time span of a search, which is
+// advanced through time in parts so that chunks can be searched in parallel
+// and report progress. A chunk only reports the events starting within it,
+// following spans below the threshold past its end; the first chunk also
+// reports the span in progress at its start.
+class EventSearch
+{
+ public:
+    EventSearch(const EventFinder::Search& _search, size_t _index,
+                double _startTime, double _endTime,
+                double _searchStartTime, double _searchEndTime,
+                double _precision, double _minStep, double _maxRate) :
+        search(_search),
+        index(_index),
+        startTime(_startTime),
+        endTime(_endTime),
+        searchStartTime(_searchStartTime),
+        searchEndTime(_searchEndTime),
+        precision(_precision),
+        minStep(_minStep),
+        maxRate(_maxRate)
+    {
+    };
+
+    double getStartTime() const { return startTime; }
+    double getEndTime() const { return endTime; }
+
+    // Search up to the time until, and on to the end of any span below the
+    // threshold in progress then. Events are added to found as they are
+    // completed.
+    void advance(double until, vector<EventFinder::Event>& found);
+
+ private:
+    bool isFirst() const { return startTime == searchStartTime; }
+    bool isLast() const { return endTime == searchEndTime; }
+
+    double safeStep(double f) const;
+    double findCrossing(double t0, double f0, double t1, double f1) const;
+    void start();
+    void addEvent(EventFinder::Event& event, vector<EventFinder::Event>& found) const;
+    void addSpan(double spanEnd, vector<EventFinder::Event>& found) const;
+    void addMinimum(double t0, double t1, vector<EventFinder::Event>& found) const;
+
+    const EventFinder::Search& search;
+    size_t index;
+    double startTime;
+    double endTime;
+    double searchStartTime;
+    double searchEndTime;
+    double precision;
+    double minStep;
+    double maxRate;
+
+    bool started{ false };
+    bool finished{ false };
+    double t{ 0.0 };
+    double f{ 0.0 };
+    double tPrev{ 0.0 };
+    double fPrev{ numeric_limits<double>::quiet_NaN() }; // no sample yet
+    bool below{ false };
+    double spanStart{ 0.0 };
+    bool spanReported{ true }; // false for a span started in another chunk
+};
+
+
+// The function can't reach the threshold in less time than its distance
+// from it divided by its greatest rate of change.
+double EventSearch::safeStep(double f) const
+{
+    double d = abs(f - search.threshold);
+    if (search.type == EventFinder::Minimum && f <= search.threshold)
+        return search.maxStep;
+    if (!isfinite(d) || maxRate <= 0.0)
+        return search.maxStep;
+    return min(max(d / maxRate, minStep), search.maxStep);
+}
+
+
+double EventSearch::findCrossing(double t0, double f0, double t1, double f1) const
+{
+    double threshold = search.threshold;
+    auto g = [this, threshold](double t) { return search.function(t) - threshold; };
+    return solve_brent(g, t0, t1, f0 - threshold, f1 - threshold, precision).first;
+}
+
+
+void EventSearch::start()
+{
+    started = true;
+
+    t = startTime;
+    f = search.function(t);
+    if (!isFirst())
+    {
+        // The chunk before ends with the middle of three samples past its
+        // end, so it finds the minima just before. The minima just after
+        // are found from a sample before this chunk.
+        if (search.type == EventFinder::Minimum)
+        {
+            tPrev = t - safeStep(f);
+            fPrev = search.function(tPrev);
+        }
+        else if (f < search.threshold)
+        {
+            // The chunk before reports the span in progress
+            below = true;
+            spanReported = false;
+        }
+    }
+    else if (search.type == EventFinder::BelowThreshold && f < search.threshold)
+    {
+        // A span is in progress: look back for its start, but not further
+        // than a few of the longest steps.
+        double t0 = t;
+        double f0 = f;
+        while (f0 < search.threshold && t0 > startTime - search.maxStep * 4.0)
+        {
+            t0 -= safeStep(f0);
+            f0 = search.function(t0);
+        }
+        spanStart = f0 < search.threshold ? t0 : findCrossing(t0, f0, t, f);
+        below = true;
+    }
+}
+
+
+void EventSearch::addEvent(EventFinder::Event& event, vector<EventFinder::Event>& found) const
+{
+    event.search = index;
+    if (!search.accept || search.accept(event))
+        found.push_back(event);
+}
+
+
+void EventSearch::addSpan(double spanEnd, vector<EventFinder::Event>& found) const
+{
+    if (!spanReported)
+        return;
+
+    EventFinder::Event event;
+    event.startTime = spanStart;
+    event.endTime = spanEnd;
+    event.time = (spanStart + spanEnd) / 2.0;
+    event.value = search.function(event.time);
+    addEvent(event, found);
+}
+
+
+void EventSearch::addMinimum(double t0, double t1, vector<EventFinder::Event>& found) const
+{
+    auto minimum = minimize_golden_section(search.function, t0, t1, precision);
+    if (minimum.second >= search.threshold || minimum.first < startTime || minimum.first > endTime)
+        return;
+    // The chunk after reports the minima at its start
+    if (minimum.first == endTime && !isLast())
+        return;
+
+    EventFinder::Event event;
+    event.startTime = event.endTime = event.time = minimum.first;
+    event.value = minimum.second;
+    addEvent(event, found);
+}
+
+
+void EventSearch::advance(double until, vector<EventFinder::Event>& found)
+{
+    if (!started)
+        start();
+
+    // A span in progress is followed past the end of the search, but not
+    // for long
+    double limit = searchEndTime + search.maxStep * 4.0;
+
+    while (!finished && (t < until || below || until >= endTime))
+    {
+        double t1 = t + safeStep(f);
+        if (search.type == EventFinder::BelowThreshold && !below)
+            t1 = min(t1, endTime);
+        double f1 = search.function(t1);
+
+        // The function may change faster than estimated where it wasn't
+        // sampled.
+        if (isfinite(f1) && isfinite(f))
+            maxRate = max(maxRate, abs(f1 - f) / (t1 - t) * RateSafetyFactor);
+
+        if (search.type == EventFinder::Minimum)
+        {
+            if (f < fPrev && f <= f1)
+                addMinimum(tPrev, t1, found);
+        }
+        else if ((f1 < search.threshold) != below)
+        {
+            double crossing = findCrossing(t, f, t1, f1);
+            if (below)
+                addSpan(crossing, found);
+            else
+                spanStart = crossing;
+            below = !below;
+            spanReported = true;
+        }
+
+        tPrev = t;
+        fPrev = f;
+        t = t1;
+        f = f1;
+
+        if (below && t >= limit)
+        {
+            addSpan(t, found);
+            below = false;
+        }
+        // Minima are looked for until the middle sample is past the end
+        if (search.type == EventFinder::Minimum ? tPrev >= endTime : !below && t >= endTime)
+            finished = true;
+    }
+}
+
+
+Vector3d relativePosition(const Selection& from, const Selection& to, double t)
+{
+    return to.getPosition(t).offsetFromKm(from.getPosition(t));
+}
+
+
+double apparentRadius(const Vector3d& v, double radius)
+{
+    double distance = v.norm();
+    return distance > radius ? asin(radius / distance) : PI / 2.0;
+}
+} // namespace
+
+
+EventFinder::EventFinder(EventFinderWatcher* _watcher,
+                         unsigned int _nThreads) :
+    watcher(_watcher),
+    nThreads(_nThreads),
+    precision(DefaultPrecision),
+    minStep(DefaultMinStep)
+{
+}
+
+
+size_t EventFinder::addSearch(const Search& search)
+{
+    searches.push_back(search);
+    return searches.size() - 1;
+}
+
+
+void EventFinder::findEvents(double startTime,
+                             double endTime,
+                             vector<Event>& events)
+{
+    if (searches.empty() || endTime < startTime)
+        return;
+
+    ThreadPool threadPool(nThreads);
+    unsigned int nThreadsUsed = threadPool.getThreadCount();
+
+    vector<double> rates(searches.size());
+    threadPool.parallelFor(searches.size(), [&](size_t i, unsigned int)
+    {
+        rates[i] = estimateRate(searches[i], startTime, endTime);
+    });
+
+    // Split each search in chunks, in order of time
+    vector<EventSearch> states;
+    for (size_t i = 0; i < searches.size(); i++)
+    {
+        double span = endTime - startTime;
+        auto nChunks = (unsigned int) min((double) nThreadsUsed,
+                                          max(floor(span / (searches[i].maxStep * MinChunkSteps)), 1.0));
+        double chunkStart = startTime;
+        for (unsigned int j = 1; j <= nChunks; j++)
+        {
+            double chunkEnd = j == nChunks ? endTime : startTime + span * j / nChunks;
+            states.emplace_back(searches[i], i, chunkStart, chunkEnd,
+                                startTime, endTime, precision, minStep, rates[i]);
+            chunkStart = chunkEnd;
+        }
+    }
+
+    vector<vector<Event>> found(states.size());
+    size_t firstEvent = events.size();
+
+    // Advance all chunks by a slice of their span in parallel, then report
+    // the events found and the progress from this thread. No search runs
+    // while the watcher is called, so it may use the objects searched freely.
+    for (int slice = 1; slice <= SearchSliceCount; slice++)
+    {
+        threadPool.parallelFor(states.size(), [&](size_t i, unsigned int)
+        {
+            EventSearch& state = states[i];
+            double until = state.getEndTime();
+            if (slice < SearchSliceCount)
+                until = state.getStartTime() + (until - state.getStartTime()) * slice / SearchSliceCount;
+            state.advance(until, found[i]);
+        });
+
+        for (auto& searchEvents : found)
+        {
+            for (const auto& event : searchEvents)
+            {
+                events.push_back(event);
+                if (watcher != nullptr)
+                    watcher->eventFound(event);
+            }
+            searchEvents.clear();
+        }
+
+        if (watcher != nullptr)
+        {
+            double progress = slice == SearchSliceCount ? endTime
+                            : startTime + (endTime - startTime) * slice / SearchSliceCount;
+            if (watcher->eventFinderProgressUpdate(progress) == EventFinderWatcher::AbortOperation)
+                break;
+        }
+    }
+
+    sort(events.begin() + firstEvent, events.end(),
+         [](const Event& e0, const Event& e1) { return e0.startTime < e1.startTime; });
+}
+
+
+EventFinder::Function
+EventFinder::distance(const Selection& a, const Selection& b)
+{
+    return [a, b](double t) { return relativePosition(a, b, t).norm(); };
+}
+
+
+EventFinder::Function
+EventFinder::separation(const Selection& observer,
+                        const Selection& a, const Selection& b)
+{
+    return [observer, a, b](double t)
+    {
+        Vector3d va = relativePosition(observer, a, t);
+        Vector3d vb = relativePosition(observer, b, t);
+        // More accurate than acos for small angles
+        return atan2(va.cross(vb).norm(), va.dot(vb));
+    };
+}
+
+
+EventFinder::Function
+EventFinder::discSeparation(const Selection& observer,
+                            const Selection& a, const Selection& b)
+{
+    return [observer, a, b](double t)
+    {
+        Vector3d va = relativePosition(observer, a, t);
+        Vector3d vb = relativePosition(observer, b, t);
+        return atan2(va.cross(vb).norm(), va.dot(vb)) -
+               apparentRadius(va, a.radius()) - apparentRadius(vb, b.radius());
+    };
+}
+
+
+EventFinder::Search
+EventFinder::closestApproaches(const Selection& a, const Selection& b,
+                               double maxStep, double maxDistance)
+{
+    Search search;
+    search.function = distance(a, b);
+    search.type = Minimum;
+    search.threshold = maxDistance;
+    search.maxStep = maxStep;
+    return search;
+}
+
+
+EventFinder::Search
+EventFinder::conjunctions(const Selection& observer,
+                          const Selection& a, const Selection& b,
+                          double maxStep, double maxSeparation)
+{
+    Search search;
+    search.function = separation(observer, a, b);
+    search.type = Minimum;
+    search.threshold = maxSeparation;
+    search.maxStep = maxStep;
+    return search;
+}
+
+
+EventFinder::Search
+EventFinder::occultations(const Selection& observer,
+                          const Selection& front, const Selection& back,
+                          double maxStep)
+{
+    Search search;
+    search.function = discSeparation(observer, front, back);
+    search.type = BelowThreshold;
+    search.threshold = 0.0;
+    search.maxStep = maxStep;
+    search.accept = [observer, front, back](const Event& event)
+    {
+        return relativePosition(observer, front, event.time).norm() <
+               relativePosition(observer, back, event.time).norm();
+    };
+    return search;
+}
+
+
+EventFinder::Search
+EventFinder::transits(const Selection& observer,
+                      const Selection& front, const Selection& back,
+                      double maxStep)
+{
+    Search search = occultations(observer, front, back, maxStep);
+    search.accept = [observer, front, back](const Event& event)
+    {
+        Vector3d vFront = relativePosition(observer, front, event.time);
+        Vector3d vBack = relativePosition(observer, back, event.time);
+        return vFront.norm() < vBack.norm() &&
+               apparentRadius(vFront, front.radius()) < apparentRadius(vBack, back.radius());
+    };
+    return search;
+}
@@ -0,0 +1,153 @@
+// eventfinder.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// Search for events such as conjunctions, occultations, transits and close
+// approaches.
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <functional>
+#include <limits>
+#include <vector>
+#include <celengine/selection.h>
+
+class EventFinderWatcher;
+
+// Find the times at which functions of time drop below a threshold or reach
+// a minimum. The search steps through time with steps bounded by how fast
+// each function can change, so that steps are long far from an event and
+// short close to it, and refines the events found to a given precision.
+// The time span of each search is split in chunks, which are searched in
+// parallel on a pool of threads along with those of other searches.
+class EventFinder
+{
+ public:
+    // A function of time (TDB). Searches run on several threads, so the
+    // function must be safe to call from several threads at once.
+    typedef std::function<double(double)> Function;
+
+    enum EventType
+    {
+        // Spans of time during which the function is below the threshold,
+        // such as occultations
+        BelowThreshold = 0,
+        // Minima of the function below the threshold, such as conjunctions
+        // and closest approaches
+        Minimum        = 1,
+    };
+
+    struct Event
+    {
+        size_t search{ 0 };         // index of the search which found it
+        double startTime{ 0.0 };    // span during which the function is
+        double endTime{ 0.0 };      // below the threshold
+        double time{ 0.0 };         // time of the minimum or middle of the span
+        double value{ 0.0 };        // value of the function at time
+    };
+
+    struct Search
+    {
+        Function function;
+        EventType type{ BelowThreshold };
+        double threshold{ 0.0 };
+
+        // Bound on the rate of change of the function per day. If zero, it
+        // is estimated by sampling the function, and raised when the search
+        // finds it changing faster.
+        double maxRate{ 0.0 };
+
+        // Longest step of the search in days. Minima closer together than
+        // this may be missed.
+        double maxStep{ 1.0 };
+
+        // Optional test of the events found, rejecting those returning false
+        std::function<bool(const Event&)> accept;
+    };
+
+    // Create a finder using nThreads threads; zero uses one per processor
+    // core, and one runs searches in the calling thread only.
+    explicit EventFinder(EventFinderWatcher* _watcher = nullptr,
+                         unsigned int _nThreads = 0);
+
+    // Set the precision of event times, in days
+    void setPrecision(double _precision) { precision = _precision; }
+    double getPrecision() const { return precision; }
+
+    // Set the shortest step of searches in days; spans shorter than this
+    // may be missed.
+    void setMinStep(double _minStep) { minStep = _minStep; }
+    double getMinStep() const { return minStep; }
+
+    // Add a search, returning its index
+    size_t addSearch(const Search& search);
+    size_t getSearchCount() const { return searches.size(); }
+
+    // Find the events starting between startTime and endTime for all
+    // searches, sorted by time.
+    void findEvents(double startTime, double endTime, std::vector<Event>& events);
+
+    // Distance between two objects in kilometers
+    static Function distance(const Selection& a, const Selection& b);
+
+    // Angle in radians between two objects as seen from an observer
+    static Function separation(const Selection& observer,
+                               const Selection& a, const Selection& b);
+
+    // Angle in radians between the edges of the discs of two objects as
+    // seen from an observer, negative when they overlap
+    static Function discSeparation(const Selection& observer,
+                                   const Selection& a, const Selection& b);
+
+    // Searches for common kinds of events. Closest approaches and
+    // conjunctions with a distance or separation above the limit are
+    // ignored.
+    static Search closestApproaches(const Selection& a, const Selection& b,
+                                    double maxStep,
+                                    double maxDistance = std::numeric_limits<double>::infinity());
+    static Search conjunctions(const Selection& observer,
+                               const Selection& a, const Selection& b,
+                               double maxStep,
+                               double maxSeparation = std::numeric_limits<double>::infinity());
+    // Occultations of the back object by the front object, and transits,
+    // which are occultations by an object whose disc is the smaller one
+    static Search occultations(const Selection& observer,
+                               const Selection& front, const Selection& back,
+                               double maxStep);
+    static Search transits(const Selection& observer,
+                           const Selection& front, const Selection& back,
+                           double maxStep);
+
+ private:
+    EventFinderWatcher* watcher;
+    unsigned int nThreads;
+    double precision;
+    double minStep;
+    std::vector<Search> searches;
+};
+
+
+class EventFinderWatcher
+{
+ public:
+    enum Status
+    {
+        ContinueOperation = 0,
+        AbortOperation = 1,
+    };
+
+    // Called as the search goes on with a time between the start and end of
+    // the search, as far from the start as the part of it done; the search
+    // stops if AbortOperation is returned.
+    virtual Status eventFinderProgressUpdate(double t) = 0;
+
+    // Called with each event as soon as it is found, not necessarily in
+    // order of time. All calls to the watcher are made from the thread
+    // calling findEvents(), while no search is running.
+    virtual void eventFound(const EventFinder::Event& /*event*/) {};
+};
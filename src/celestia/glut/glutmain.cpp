@@ -527,6 +527,7 @@ int main(int argc, char* argv[])
 
     appCore->getRenderer()->setSolarSystemMaxDistance(appCore->getConfig()->SolarSystemMaxDistance);
     appCore->getRenderer()->setShadowMapSize(appCore->getConfig()->ShadowMapSize);
+    appCore->getRenderer()->setRenderThreadCount(appCore->getConfig()->RenderThreads);
 
     // Set the simulation starting time to the current system time
     appCore->start();
@@ -408,6 +408,7 @@ int main(int argc, char* argv[])
 
     app->renderer->setSolarSystemMaxDistance(app->core->getConfig()->SolarSystemMaxDistance);
     app->renderer->setShadowMapSize(app->core->getConfig()->ShadowMapSize);
+    app->renderer->setRenderThreadCount(app->core->getConfig()->RenderThreads);
 
     #ifdef GNOME
     /* Create the main window (GNOME) */
@@ -75,6 +75,7 @@ public:
     void sort(int column, Qt::SortOrder order) override;
 
     void setEclipses(const vector<Eclipse>& _eclipses);
+    void addEclipse(const Eclipse& eclipse);
 
     const Eclipse* eclipseAtIndex(const QModelIndex& index) const;
 
@@ -201,6 +202,15 @@ void EventTableModel::setEclipses(const vector<Eclipse>& _eclipses)
 }
 
 
+void EventTableModel::addEclipse(const Eclipse& eclipse)
+{
+    int row = (int) eclipses.size();
+    beginInsertRows(QModelIndex(), row, row);
+    eclipses.push_back(eclipse);
+    endInsertRows();
+}
+
+
 const Eclipse* EventTableModel::eclipseAtIndex(const QModelIndex& index) const
 {
     int row = index.row();
@@ -297,6 +307,12 @@ EventFinder::EventFinder(CelestiaCore* _appCore,
 }
 
 
+void EventFinder::eclipseFound(const Eclipse& eclipse)
+{
+    model->addEclipse(eclipse);
+}
+
+
 EclipseFinderWatcher::Status EventFinder::eclipseFinderProgressUpdate(double t)
 {
     if (progress != nullptr)
@@ -362,6 +378,11 @@ void EventFinder::slotFindEclipses()
     progress->show();
 
 
+    // Eclipses are shown as they are found, then sorted once the search
+    // completes.
+    activeEclipse = nullptr;
+    model->setEclipses(vector<Eclipse>());
+
     vector<Eclipse> eclipses;
     finder.findEclipses(startTimeTDB, endTimeTDB,
                         eclipseTypeMask,
@@ -35,6 +35,7 @@ class EventFinder : public QDockWidget, EclipseFinderWatcher
     ~EventFinder() = default;
 
     EclipseFinderWatcher::Status eclipseFinderProgressUpdate(double t);
+    void eclipseFound(const Eclipse& eclipse);
 
  public slots:
     void slotFindEclipses();
@@ -161,6 +161,7 @@ void CelestiaGlWidget::initializeGL()
 
     appRenderer->setSolarSystemMaxDistance(appCore->getConfig()->SolarSystemMaxDistance);
     appRenderer->setShadowMapSize(appCore->getConfig()->ShadowMapSize);
+    appRenderer->setRenderThreadCount(appCore->getConfig()->RenderThreads);
 }
 
 
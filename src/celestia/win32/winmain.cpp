@@ -3264,6 +3264,7 @@ int APIENTRY WinMain(HINSTANCE hInstance,
 
         appCore->getRenderer()->setSolarSystemMaxDistance(appCore->getConfig()->SolarSystemMaxDistance);
         appCore->getRenderer()->setShadowMapSize(appCore->getConfig()->ShadowMapSize);
+        appCore->getRenderer()->setRenderThreadCount(appCore->getConfig()->RenderThreads);
     }
 
     cursorHandler = new WinCursorHandler(hDefaultCursor);
@@ -11,6 +11,7 @@
 #define _CELMATH_MATHLIB_H_
 
 #include <cmath>
+#include <cstdint>
 #include <cstdlib>
 #include <Eigen/Core>
 
@@ -36,6 +37,18 @@ template<typename T> inline T sfrand()
     return (T) (rand() & 0x7fff) / (T) 32767 * 2 - 1;
 }
 
+// The same, drawn from a random number generator such as std::mt19937, for
+// repeatable sequences
+template<typename T, typename G> inline T frand(G& rng)
+{
+    return (T) (rng() & 0x7fff) / (T) 32767;
+}
+
+template<typename T, typename G> inline T sfrand(G& rng)
+{
+    return (T) (rng() & 0x7fff) / (T) 32767 * 2 - 1;
+}
+
 #ifndef HAVE_LERP
 template<typename T> constexpr T lerp(T t, T a, T b)
 {
@@ -82,6 +95,48 @@ template<typename T> inline constexpr T sign(T x)
     return (x < 0) ? -1 : ((x > 0) ? 1 : 0);
 }
 
+// cos(x) without branches or table lookups, so that loops applying it to
+// arrays are vectorized. x is reduced to [-pi/4, pi/4] by subtracting the
+// nearest multiple q of pi/2 in three parts (Cody-Waite), and the sine or
+// cosine of the remainder is given by the polynomials of the Cephes
+// library. The reduction is exact while q * PiOver2A is, that is for |x|
+// below 2^22 * pi/2 (about 6.6e6), over which the error grows from 2e-16
+// to 1e-14 with |x|. Beyond, it's much larger: about 1e-9 at 1e7.
+inline double branchlessCos(double x)
+{
+    constexpr const double TwoOverPi = 0.63661977236758134308;
+    constexpr const double PiOver2A = 1.5707963267341256141662597656250;
+    constexpr const double PiOver2B = 6.0771005065061922773791276477277e-11;
+    constexpr const double PiOver2C = 2.0222662487959506315227533226e-21;
+    // Adding and subtracting 1.5 * 2^52 rounds to the nearest integer
+    constexpr const double RoundShift = 6755399441055744.0;
+
+    double q = (x * TwoOverPi + RoundShift) - RoundShift;
+    double r = ((x - q * PiOver2A) - q * PiOver2B) - q * PiOver2C;
+    int32_t quadrant = (int32_t) q;
+
+    double r2 = r * r;
+    double s = r + r * r2 * (((((1.58962301576546568060e-10 * r2
+                                - 2.50507477628578072866e-8) * r2
+                               + 2.75573136213857245213e-6) * r2
+                              - 1.98412698295895385996e-4) * r2
+                             + 8.33333333332211858878e-3) * r2
+                            - 1.66666666666666307295e-1);
+    double c = 1.0 - 0.5 * r2 + r2 * r2 * (((((-1.13585365213876817300e-11 * r2
+                                               + 2.08757008419747316778e-9) * r2
+                                              - 2.75573141792967388112e-7) * r2
+                                             + 2.48015872888517045348e-5) * r2
+                                            - 1.38888888888730564116e-3) * r2
+                                           + 4.16666666666665929218e-2);
+
+    // cos(x) is -sin(r) in the first quadrant, -cos(r) in the second and
+    // sin(r) in the third. Selecting by multiplication keeps the loop free
+    // of branches, and is exact as one of the products is zero.
+    double odd = (double) (quadrant & 1);
+    double sign = 1.0 - (double) ((quadrant + 1) & 2);
+    return (odd * s + (1.0 - odd) * c) * sign;
+}
+
 // This function is like fmod except that it always returns
 // a positive value in the range [ 0, y )
 template<typename T> T pfmod(T x, T y)
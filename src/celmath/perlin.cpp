@@ -1,6 +1,8 @@
 #include <cstdlib>
 #include <cstdio>
 #include <cmath>
+#include <mutex>
+#include <random>
 
 #include "mathlib.h"
 #include "perlin.h"
@@ -154,7 +156,9 @@ static float g3[B + B + 2][3];
 static float g2[B + B + 2][2];
 static float g1[B + B + 2];
 
-static bool initialized = false;
+// The tables are filled when noise is first needed, which may happen on
+// several threads at once, as when models are loaded in the background.
+static std::once_flag initialized;
 
 static void init();
 
@@ -169,8 +173,7 @@ static void init();
 
 float noise1(float arg)
 {
-    if (!initialized)
-        init();
+    std::call_once(initialized, init);
 
     int bx0, bx1;
     float rx0, rx1, t, u, v, vec[1];
@@ -191,8 +194,7 @@ float noise2(const float vec[2])
     float rx0, rx1, ry0, ry1, *q, sx, sy, a, b, t, u, v;
     int i, j;
 
-    if (!initialized)
-        init();
+    std::call_once(initialized, init);
 
     setup(0, bx0,bx1, rx0,rx1);
     setup(1, by0,by1, ry0,ry1);
@@ -223,8 +225,7 @@ float noise2(const float vec[2])
 
 float noise3(const float vec[3])
 {
-    if (!initialized)
-        init();
+    std::call_once(initialized, init);
 
     int bx0, bx1, by0, by1, bz0, bz1, b00, b10, b01, b11;
     float rx0, rx1, ry0, ry1, rz0, rz1, *q, sy, sz, a, b, c, d, t, u, v;
@@ -287,21 +288,25 @@ static void normalize3(float v[3])
 }
 
 
+// The tables are filled from a generator of their own with a fixed seed,
+// so that the noise, and the forms of irregular galaxies made from it, are
+// the same from one run to the next.
 static void init()
 {
     int i, j, k;
+    std::mt19937 rng(1);
 
     for (i = 0; i < B; i++)
     {
-        g1[i]    = sfrand<float>();
+        g1[i]    = sfrand<float>(rng);
 
-        g2[i][0] = sfrand<float>();
-        g2[i][1] = sfrand<float>();
+        g2[i][0] = sfrand<float>(rng);
+        g2[i][1] = sfrand<float>(rng);
         normalize2(g2[i]);
 
-        g3[i][0] = sfrand<float>();
-        g3[i][1] = sfrand<float>();
-        g3[i][2] = sfrand<float>();
+        g3[i][0] = sfrand<float>(rng);
+        g3[i][1] = sfrand<float>(rng);
+        g3[i][2] = sfrand<float>(rng);
         normalize3(g3[i]);
     }
 
@@ -313,7 +318,7 @@ static void init()
     for (i = 0; i < B; i++)
     {
         k = p[i];
-        j = rand() % B;
+        j = (int) (rng() % B);
         p[i] = p[j];
         p[j] = k;
     }
@@ -329,7 +334,5 @@ static void init()
         g3[B + i][1] = g3[i][1];
         g3[B + i][2] = g3[i][2];
     }
-
-    initialized = true;
 }
 
@@ -7,6 +7,9 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <algorithm>
+#include <cmath>
+#include <limits>
 #include <utility>
 
 #pragma once
@@ -40,6 +43,136 @@ template<class T, class F> std::pair<T, T> solve_bisection(F f,
 }
 
 
+// Find a root of a function in an interval where it changes sign using
+// Brent's method, which combines bisection with secant and inverse quadratic
+// interpolation steps. It converges much faster than bisection for smooth
+// functions while never doing worse. The values of the function at the
+// bounds must be given, as callers have usually computed them to find the
+// interval. Returns a pair with the solution as the first element and the
+// error as the second.
+template<class T, class F> std::pair<T, T> solve_brent(F f,
+                                                       T lower, T upper,
+                                                       T fLower, T fUpper,
+                                                       T err,
+                                                       int maxIter = 100)
+{
+    T a = lower, fa = fLower;
+    T b = upper, fb = fUpper;
+    T c = a, fc = fa;
+    T d = b - a;
+    T e = d;
+
+    for (int i = 0; i < maxIter; i++)
+    {
+        // Keep the root between b and c, with b the best estimate
+        if ((fb > 0) == (fc > 0))
+        {
+            c = a;
+            fc = fa;
+            d = e = b - a;
+        }
+        if (std::abs(fc) < std::abs(fb))
+        {
+            a = b; b = c; c = a;
+            fa = fb; fb = fc; fc = fa;
+        }
+
+        T tol = 2 * std::numeric_limits<T>::epsilon() * std::abs(b) + err / 2;
+        T m = (c - b) / 2;
+        if (std::abs(m) <= tol || fb == 0)
+            break;
+
+        if (std::abs(e) < tol || std::abs(fa) <= std::abs(fb))
+        {
+            // Bisection
+            d = e = m;
+        }
+        else
+        {
+            T s = fb / fa;
+            T p, q;
+            if (a == c)
+            {
+                // Secant
+                p = 2 * m * s;
+                q = 1 - s;
+            }
+            else
+            {
+                // Inverse quadratic interpolation
+                T r = fb / fc;
+                q = fa / fc;
+                p = s * (2 * m * q * (q - r) - (b - a) * (r - 1));
+                q = (q - 1) * (r - 1) * (s - 1);
+            }
+
+            if (p > 0)
+                q = -q;
+            else
+                p = -p;
+
+            // Only accept the interpolation if it falls well inside the
+            // interval and converges faster than bisection would
+            if (2 * p < std::min(3 * m * q - std::abs(tol * q), std::abs(e * q)))
+            {
+                e = d;
+                d = p / q;
+            }
+            else
+            {
+                d = e = m;
+            }
+        }
+
+        a = b;
+        fa = fb;
+        b += std::abs(d) > tol ? d : (m > 0 ? tol : -tol);
+        fb = f(b);
+    }
+
+    return std::make_pair(b, fb == 0 ? T(0) : std::abs(c - b));
+}
+
+
+// Find the minimum of a function in an interval with golden section search.
+// The function must have a single minimum in the interval. Returns a pair
+// with the position of the minimum as the first element and the value of
+// the function there as the second.
+template<class T, class F> std::pair<T, T> minimize_golden_section(F f,
+                                                                   T lower, T upper,
+                                                                   T err,
+                                                                   int maxIter = 100)
+{
+    const T r = (T) 0.61803398874989485; // (sqrt(5) - 1) / 2
+    T x1 = upper - r * (upper - lower);
+    T x2 = lower + r * (upper - lower);
+    T f1 = f(x1);
+    T f2 = f(x2);
+
+    for (int i = 0; i < maxIter && upper - lower > err; i++)
+    {
+        if (f1 < f2)
+        {
+            upper = x2;
+            x2 = x1;
+            f2 = f1;
+            x1 = upper - r * (upper - lower);
+            f1 = f(x1);
+        }
+        else
+        {
+            lower = x1;
+            x1 = x2;
+            f1 = f2;
+            x2 = lower + r * (upper - lower);
+            f2 = f(x2);
+        }
+    }
+
+    return f1 < f2 ? std::make_pair(x1, f1) : std::make_pair(x2, f2);
+}
+
+
 // Solve using iteration; terminate when error is below err or the maximum
 // number of iterations is reached.
 template<class T, class F> std::pair<T, T> solve_iteration(F f,
@@ -12,8 +12,11 @@
 #define _CELMODEL_MESH_H_
 
 #include "material.h"
+#include "meshbvh.h"
 #include <Eigen/Core>
 #include <Eigen/Geometry>
+#include <memory>
+#include <mutex>
 #include <vector>
 #include <string>
 
@@ -179,6 +182,13 @@ class Mesh
     bool pick(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, PickResult* result) const;
     bool pick(const Eigen::Vector3d& origin, const Eigen::Vector3d& direction, double& distance) const;
 
+    /*! Return the bounding volume hierarchy of the triangles, for ray
+     *  queries. It's built on first use, once even if several threads
+     *  query the mesh at the same time, and discarded when the vertices
+     *  or primitive groups are changed through the methods of the mesh.
+     */
+    const MeshBVH& getBVH() const;
+
     Eigen::AlignedBox<float, 3> getBoundingBox() const;
     void transform(const Eigen::Vector3f& translation, float scale);
 
@@ -195,6 +205,7 @@ class Mesh
 
  private:
     void recomputeBoundingBox();
+    void invalidateBVH();
 
  private:
     VertexDescription vertexDesc{ 0, 0, nullptr };
@@ -206,6 +217,9 @@ class Mesh
     std::vector<PrimitiveGroup*> groups;
 
     std::string name;
+
+    mutable std::unique_ptr<MeshBVH> bvh;
+    std::unique_ptr<std::once_flag> bvhBuilt{ new std::once_flag };
 };
 
 } // namespace cmod
@@ -0,0 +1,482 @@
+// meshbvh.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <cstring>
+#include <limits>
+#include <numeric>
+#include <Eigen/Geometry>
+#include "mesh.h"
+#include "meshbvh.h"
+
+using namespace cmod;
+using namespace Eigen;
+using namespace std;
+
+
+namespace
+{
+// Centroids are sorted into this many bins along an axis to choose where
+// to split a node
+constexpr unsigned int BinCount = 16;
+
+// Nodes with this many triangles or fewer are always leaves
+constexpr unsigned int MinSplitCount = 4;
+
+// The depth is limited so that traversal can use a fixed size stack
+constexpr unsigned int MaxDepth = 64;
+
+// The cost of visiting a node relative to that of testing a triangle
+constexpr float TraversalCost = 1.0f;
+
+float surfaceArea(const AlignedBox3f& box)
+{
+    Vector3f d = box.sizes();
+    return 2.0f * (d.x() * d.y() + d.y() * d.z() + d.z() * d.x());
+}
+
+// Return true if the ray hits the box between zero and maxDistance
+bool intersectBox(const float lower[3],
+                  const float upper[3],
+                  const Vector3d& origin,
+                  const Vector3d& invDirection,
+                  double maxDistance)
+{
+    double tmin = 0.0;
+    double tmax = maxDistance;
+    for (int i = 0; i < 3; i++)
+    {
+        double t0 = (lower[i] - origin[i]) * invDirection[i];
+        double t1 = (upper[i] - origin[i]) * invDirection[i];
+        if (t0 > t1)
+            std::swap(t0, t1);
+
+        // A NaN from a ray parallel to and on a face of the box is ignored
+        if (t0 > tmin)
+            tmin = t0;
+        if (t1 < tmax)
+            tmax = t1;
+    }
+
+    return tmin <= tmax;
+}
+} // anonymous namespace
+
+
+MeshBVH::MeshBVH(const Mesh& mesh)
+{
+    collectTriangles(mesh);
+    build();
+}
+
+
+// Collect the triangles of the mesh in the order they are drawn, which is
+// also the order of their primitive indices.
+void MeshBVH::collectTriangles(const Mesh& mesh)
+{
+    const Mesh::VertexDescription& vertexDesc = mesh.getVertexDescription();
+
+    // Picking will automatically fail without vertex positions--no
+    // reasonable mesh should lack these.
+    if (vertexDesc.getAttribute(Mesh::Position).semantic != Mesh::Position ||
+        vertexDesc.getAttribute(Mesh::Position).format != Mesh::Float3)
+    {
+        return;
+    }
+
+    unsigned int posOffset = vertexDesc.getAttribute(Mesh::Position).offset;
+    auto* vdata = static_cast<const char*>(mesh.getVertexData());
+    unsigned int nVertices = mesh.getVertexCount();
+
+    for (unsigned int groupIndex = 0; groupIndex < mesh.getGroupCount(); groupIndex++)
+    {
+        const Mesh::PrimitiveGroup* group = mesh.getGroup(groupIndex);
+        Mesh::PrimitiveGroupType primType = group->prim;
+        Mesh::index32 nIndices = group->nIndices;
+
+        // Only triangle groups can be hit by a ray
+        if (!((primType == Mesh::TriList || primType == Mesh::TriStrip || primType == Mesh::TriFan) &&
+              (nIndices >= 3) &&
+              !(primType == Mesh::TriList && nIndices % 3 != 0)))
+        {
+            continue;
+        }
+
+        unsigned int primitiveIndex = 0;
+        Mesh::index32 index = 0;
+        Mesh::index32 i0 = group->indices[0];
+        Mesh::index32 i1 = group->indices[1];
+        Mesh::index32 i2 = group->indices[2];
+
+        // Iterate over the triangles in the primitive group
+        do
+        {
+            if (i0 < nVertices && i1 < nVertices && i2 < nVertices)
+            {
+                Triangle tri;
+                memcpy(tri.vertices[0], vdata + i0 * vertexDesc.stride + posOffset, sizeof(tri.vertices[0]));
+                memcpy(tri.vertices[1], vdata + i1 * vertexDesc.stride + posOffset, sizeof(tri.vertices[1]));
+                memcpy(tri.vertices[2], vdata + i2 * vertexDesc.stride + posOffset, sizeof(tri.vertices[2]));
+                tri.group = groupIndex;
+                tri.primitiveIndex = primitiveIndex;
+                triangles.push_back(tri);
+            }
+
+            // Get the indices for the next triangle
+            if (primType == Mesh::TriList)
+            {
+                index += 3;
+                if (index < nIndices)
+                {
+                    i0 = group->indices[index + 0];
+                    i1 = group->indices[index + 1];
+                    i2 = group->indices[index + 2];
+                }
+            }
+            else if (primType == Mesh::TriStrip)
+            {
+                index += 1;
+                if (index < nIndices)
+                {
+                    i0 = i1;
+                    i1 = i2;
+                    i2 = group->indices[index];
+                }
+            }
+            else // primType == TriFan
+            {
+                index += 1;
+                if (index < nIndices)
+                {
+                    index += 1;
+                    i1 = i2;
+                    i2 = group->indices[index];
+                }
+            }
+
+            primitiveIndex++;
+        } while (index < nIndices);
+    }
+}
+
+
+void MeshBVH::build()
+{
+    auto nTriangles = (uint32_t) triangles.size();
+    if (nTriangles == 0)
+        return;
+
+    vector<AlignedBox3f> bounds(nTriangles);
+    vector<Vector3f> centroids(nTriangles);
+    AlignedBox3f rootBox;
+    for (uint32_t i = 0; i < nTriangles; i++)
+    {
+        for (const auto& v : triangles[i].vertices)
+            bounds[i].extend(Map<const Vector3f>(v));
+        centroids[i] = bounds[i].center();
+        rootBox.extend(bounds[i]);
+    }
+
+    // Node boxes are slightly enlarged so that rounding errors can't cull
+    // triangles hit on their edges.
+    float padding = 1.0e-5f * max(rootBox.min().cwiseAbs().maxCoeff(),
+                                  rootBox.max().cwiseAbs().maxCoeff());
+
+    // The triangles are sorted in place as nodes are split
+    vector<uint32_t> order(nTriangles);
+    iota(order.begin(), order.end(), 0);
+
+    struct Job
+    {
+        uint32_t first;
+        uint32_t count;
+        uint32_t parent;
+        unsigned int depth;
+        bool secondChild;
+    };
+    vector<Job> jobs;
+    jobs.push_back({ 0, nTriangles, 0, 0, false });
+
+    while (!jobs.empty())
+    {
+        Job job = jobs.back();
+        jobs.pop_back();
+
+        auto nodeIndex = (uint32_t) nodes.size();
+        nodes.emplace_back();
+        if (job.secondChild)
+            nodes[job.parent].offset = nodeIndex;
+
+        AlignedBox3f box;
+        AlignedBox3f centroidBox;
+        for (uint32_t i = job.first; i < job.first + job.count; i++)
+        {
+            box.extend(bounds[order[i]]);
+            centroidBox.extend(centroids[order[i]]);
+        }
+
+        Node& node = nodes.back();
+        for (int i = 0; i < 3; i++)
+        {
+            node.lower[i] = box.min()[i] - padding;
+            node.upper[i] = box.max()[i] + padding;
+        }
+        node.offset = job.first;
+        node.count = job.count;
+        node.axis = 0;
+
+        if (job.count <= MinSplitCount || job.depth == MaxDepth)
+            continue;
+
+        // Find the split between bins with the lowest surface area
+        // heuristic cost
+        Vector3f extent = centroidBox.sizes();
+        float bestCost = numeric_limits<float>::max();
+        int bestAxis = -1;
+        unsigned int bestSplit = 0;
+        for (int axis = 0; axis < 3; axis++)
+        {
+            if (extent[axis] <= 0.0f)
+                continue;
+
+            float binScale = BinCount / extent[axis];
+            float axisMin = centroidBox.min()[axis];
+            AlignedBox3f binBoxes[BinCount];
+            uint32_t binCounts[BinCount] = {};
+            for (uint32_t i = job.first; i < job.first + job.count; i++)
+            {
+                auto bin = min((unsigned int) ((centroids[order[i]][axis] - axisMin) * binScale), BinCount - 1);
+                binBoxes[bin].extend(bounds[order[i]]);
+                binCounts[bin]++;
+            }
+
+            float aboveAreas[BinCount];
+            uint32_t aboveCounts[BinCount];
+            AlignedBox3f above;
+            uint32_t aboveCount = 0;
+            for (unsigned int bin = BinCount - 1; bin > 0; bin--)
+            {
+                above.extend(binBoxes[bin]);
+                aboveCount += binCounts[bin];
+                aboveAreas[bin] = aboveCount == 0 ? 0.0f : surfaceArea(above);
+                aboveCounts[bin] = aboveCount;
+            }
+
+            AlignedBox3f below;
+            uint32_t belowCount = 0;
+            for (unsigned int split = 1; split < BinCount; split++)
+            {
+                below.extend(binBoxes[split - 1]);
+                belowCount += binCounts[split - 1];
+                if (belowCount == 0 || aboveCounts[split] == 0)
+                    continue;
+
+                float cost = surfaceArea(below) * belowCount + aboveAreas[split] * aboveCounts[split];
+                if (cost < bestCost)
+                {
+                    bestCost = cost;
+                    bestAxis = axis;
+                    bestSplit = split;
+                }
+            }
+        }
+
+        // All the centroids are at the same point
+        if (bestAxis < 0)
+            continue;
+
+        // Keep a leaf when splitting it costs more than testing all of its
+        // triangles
+        float area = surfaceArea(box);
+        if (area > 0.0f && TraversalCost + bestCost / area >= (float) job.count &&
+            job.count <= 4 * MinSplitCount)
+        {
+            continue;
+        }
+
+        float binScale = BinCount / extent[bestAxis];
+        float axisMin = centroidBox.min()[bestAxis];
+        auto middle = partition(order.begin() + job.first, order.begin() + job.first + job.count,
+                                [&](uint32_t i)
+                                {
+                                    auto bin = min((unsigned int) ((centroids[i][bestAxis] - axisMin) * binScale), BinCount - 1);
+                                    return bin < bestSplit;
+                                });
+        auto firstCount = (uint32_t) (middle - order.begin()) - job.first;
+
+        node.count = 0;
+        node.axis = bestAxis;
+        jobs.push_back({ job.first + firstCount, job.count - firstCount, nodeIndex, job.depth + 1, true });
+        jobs.push_back({ job.first, firstCount, nodeIndex, job.depth + 1, false });
+    }
+
+    vector<Triangle> sorted;
+    sorted.reserve(nTriangles);
+    for (uint32_t i : order)
+        sorted.push_back(triangles[i]);
+    triangles.swap(sorted);
+}
+
+
+// Visit the triangles in the leaves hit by the ray, nearest first, until
+// the visitor returns false. The visitor may lower maxDistance to cull the
+// nodes farther than a hit.
+template<class VISITOR> void
+MeshBVH::traverse(const Vector3d& origin,
+                  const Vector3d& direction,
+                  double& maxDistance,
+                  VISITOR visitor) const
+{
+    if (nodes.empty())
+        return;
+
+    Vector3d invDirection = direction.cwiseInverse();
+    uint32_t stack[MaxDepth];
+    unsigned int stackSize = 0;
+    uint32_t nodeIndex = 0;
+
+    for (;;)
+    {
+        const Node& node = nodes[nodeIndex];
+        if (intersectBox(node.lower, node.upper, origin, invDirection, maxDistance))
+        {
+            if (node.count == 0)
+            {
+                uint32_t nearChild = nodeIndex + 1;
+                uint32_t farChild = node.offset;
+                if (direction[node.axis] < 0.0)
+                    std::swap(nearChild, farChild);
+
+                stack[stackSize++] = farChild;
+                nodeIndex = nearChild;
+                continue;
+            }
+
+            for (uint32_t i = node.offset; i < node.offset + node.count; i++)
+            {
+                if (!visitor(triangles[i]))
+                    return;
+            }
+        }
+
+        if (stackSize == 0)
+            return;
+        nodeIndex = stack[--stackSize];
+    }
+}
+
+
+// Compute the distance to the intersection of the ray with a triangle, if
+// it's greater than zero and not greater than maxDistance.
+static bool intersectTriangle(const float vertices[3][3],
+                              const Vector3d& rayOrigin,
+                              const Vector3d& rayDirection,
+                              double maxDistance,
+                              double& distance)
+{
+    // Get the triangle vertices v0, v1, and v2
+    Vector3d v0 = Map<const Vector3f>(vertices[0]).cast<double>();
+    Vector3d v1 = Map<const Vector3f>(vertices[1]).cast<double>();
+    Vector3d v2 = Map<const Vector3f>(vertices[2]).cast<double>();
+
+    // Compute the edge vectors e0 and e1, and the normal n
+    Vector3d e0 = v1 - v0;
+    Vector3d e1 = v2 - v0;
+    Vector3d n = e0.cross(e1);
+
+    // c is the cosine of the angle between the ray and triangle normal
+    double c = n.dot(rayDirection);
+
+    // If the ray is parallel to the triangle, it either misses the
+    // triangle completely, or is contained in the triangle's plane.
+    // If it's contained in the plane, we'll still call it a miss.
+    if (c == 0.0)
+        return false;
+
+    double t = (n.dot(v0 - rayOrigin)) / c;
+    if (!(t <= maxDistance && t > 0.0))
+        return false;
+
+    double m00 = e0.dot(e0);
+    double m01 = e0.dot(e1);
+    double m10 = e1.dot(e0);
+    double m11 = e1.dot(e1);
+    double det = m00 * m11 - m01 * m10;
+    if (det == 0.0)
+        return false;
+
+    Vector3d p = rayOrigin + rayDirection * t;
+    Vector3d q = p - v0;
+    double q0 = e0.dot(q);
+    double q1 = e1.dot(q);
+    double d = 1.0 / det;
+    double s0 = (m11 * q0 - m01 * q1) * d;
+    double s1 = (m00 * q1 - m10 * q0) * d;
+    if (s0 >= 0.0 && s1 >= 0.0 && s0 + s1 <= 1.0)
+    {
+        distance = t;
+        return true;
+    }
+
+    return false;
+}
+
+
+bool
+MeshBVH::pick(const Vector3d& origin,
+              const Vector3d& direction,
+              Hit& hit,
+              double maxDistance) const
+{
+    double closest = maxDistance;
+    const Triangle* closestTriangle = nullptr;
+
+    traverse(origin, direction, closest, [&](const Triangle& tri)
+    {
+        double t;
+        if (intersectTriangle(tri.vertices, origin, direction, closest, t))
+        {
+            // Triangles aren't visited in mesh order, so break ties here
+            if (t < closest ||
+                (closestTriangle != nullptr &&
+                 (tri.group < closestTriangle->group ||
+                  (tri.group == closestTriangle->group && tri.primitiveIndex < closestTriangle->primitiveIndex))))
+            {
+                closest = t;
+                closestTriangle = &tri;
+            }
+        }
+        return true;
+    });
+
+    if (closestTriangle == nullptr)
+        return false;
+
+    hit.group = closestTriangle->group;
+    hit.primitiveIndex = closestTriangle->primitiveIndex;
+    hit.distance = closest;
+    return true;
+}
+
+
+bool
+MeshBVH::intersects(const Vector3d& origin,
+                    const Vector3d& direction,
+                    double maxDistance) const
+{
+    bool found = false;
+    traverse(origin, direction, maxDistance, [&](const Triangle& tri)
+    {
+        double t;
+        found = intersectTriangle(tri.vertices, origin, direction, maxDistance, t) && t < maxDistance;
+        return !found;
+    });
+
+    return found;
+}
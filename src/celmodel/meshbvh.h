@@ -0,0 +1,95 @@
+// meshbvh.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+
+
+namespace cmod
+{
+
+class Mesh;
+
+// A bounding volume hierarchy of the triangles of a mesh, used to find the
+// triangles hit by a ray by visiting a number of nodes logarithmic in the
+// triangle count. It is built with the surface area heuristic over binned
+// triangle centroids, and its nodes are stored depth first in an array.
+//
+// The hierarchy holds a copy of the triangles, so it must be rebuilt when
+// the vertices or primitive groups of the mesh change.
+class MeshBVH
+{
+ public:
+    struct Hit
+    {
+        unsigned int group;           // index of the primitive group
+        unsigned int primitiveIndex;  // index of the triangle in the group
+        double distance;
+    };
+
+    explicit MeshBVH(const Mesh& mesh);
+
+    // Find the closest triangle hit by the ray at a distance greater than
+    // zero and less than maxDistance, in units of the length of direction.
+    // Among triangles hit at the same distance, the first in the mesh is
+    // chosen.
+    bool pick(const Eigen::Vector3d& origin,
+              const Eigen::Vector3d& direction,
+              Hit& hit,
+              double maxDistance = 1.0e30) const;
+
+    // Return true if the ray hits any triangle at a distance greater than
+    // zero and less than maxDistance, as needed for shadow and visibility
+    // tests. This stops at the first triangle found.
+    bool intersects(const Eigen::Vector3d& origin,
+                    const Eigen::Vector3d& direction,
+                    double maxDistance) const;
+
+    size_t getTriangleCount() const { return triangles.size(); }
+    size_t getMemoryUsage() const
+    {
+        return triangles.capacity() * sizeof(Triangle) + nodes.capacity() * sizeof(Node);
+    }
+
+ private:
+    struct Triangle
+    {
+        float vertices[3][3];
+        uint32_t group;
+        uint32_t primitiveIndex;
+    };
+
+    // Interior nodes are followed by their first child and refer to the
+    // second one; leaf nodes refer to a range of triangles. Children are
+    // visited nearest first along the axis the node was split on.
+    struct Node
+    {
+        float lower[3];
+        float upper[3];
+        uint32_t offset;            // second child or first triangle
+        uint32_t count : 30;        // number of triangles, zero if interior
+        uint32_t axis : 2;
+    };
+
+    void collectTriangles(const Mesh& mesh);
+    void build();
+
+    template<class VISITOR> void traverse(const Eigen::Vector3d& origin,
+                                          const Eigen::Vector3d& direction,
+                                          double& maxDistance,
+                                          VISITOR visitor) const;
+
+    std::vector<Triangle> triangles;
+    std::vector<Node> nodes;
+};
+
+} // namespace cmod
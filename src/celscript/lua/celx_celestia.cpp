@@ -9,6 +9,7 @@
 // as published by the Free Software Foundation; either version 2
 // of the License, or (at your option) any later version.
 
+#include <cstring>
 #include <celutil/debug.h>
 #include <celutil/gettext.h>
 #if NO_TTF
@@ -19,6 +20,7 @@
 #include <fmt/printf.h>
 #include <celengine/category.h>
 #include <celengine/texture.h>
+#include <celmath/mathlib.h>
 #include <celcompat/filesystem.h>
 #include "celx.h"
 #include "celx_internal.h"
@@ -33,6 +35,7 @@
 #include "celx_category.h"
 #include <celestia/url.h>
 #include <celestia/celestiacore.h>
+#include <celestia/eventfinder.h>
 #include <celestia/view.h>
 #include <celscript/common/scriptmaps.h>
 
@@ -2473,6 +2476,163 @@ static int celestia_bindtranslationdomain(lua_State *l)
 #endif
 }
 
+// Find events such as conjunctions, either of a type between two objects
+//   celestia:findevents(type, object1, object2 [, options])
+// where type is "approach", "conjunction", "occultation" or "transit", or
+// when a Lua function of time drops below a threshold or reaches a minimum
+//   celestia:findevents(function, options)
+// The options table may contain the fields starttime and endtime (TDB, by
+// default the current time and a year later), step (the longest step in
+// days), precision (in seconds), observer (an object, by default the Earth),
+// limit (the greatest distance in km or separation in degrees of approaches
+// and conjunctions), and for functions kind ("minimum" or "below") and
+// threshold. Searches between objects run on several threads, while Lua
+// functions are called from the script thread.
+static int celestia_findevents(lua_State* l)
+{
+    CelxLua celx(l);
+    celx.checkArgs(2, 5, "One to four arguments expected for celestia:findevents()");
+
+    CelestiaCore* appCore = this_celestia(l);
+    Simulation* sim = appCore->getSimulation();
+
+    bool isFunction = lua_isfunction(l, 2);
+    int optionsIndex = isFunction ? 3 : 5;
+    bool hasOptions = lua_istable(l, optionsIndex);
+
+    // Push the value of an option on the stack, which is nil if it's missing
+    auto getOption = [l, optionsIndex, hasOptions](const char* name)
+    {
+        if (hasOptions)
+        {
+            lua_pushstring(l, name);
+            lua_gettable(l, optionsIndex);
+        }
+        else
+        {
+            lua_pushnil(l);
+        }
+        return lua_gettop(l);
+    };
+
+    int top = lua_gettop(l);
+    double startTime = celx.safeGetNumber(getOption("starttime"), WrongType,
+                                          "starttime must be a number", sim->getTime());
+    double endTime = celx.safeGetNumber(getOption("endtime"), WrongType,
+                                        "endtime must be a number", startTime + 365.25);
+    double maxStep = celx.safeGetNumber(getOption("step"), WrongType,
+                                        "step must be a number", 1.0);
+    double precision = celx.safeGetNumber(getOption("precision"), WrongType,
+                                          "precision must be a number", 1.0);
+    double limit = celx.safeGetNumber(getOption("limit"), WrongType,
+                                      "limit must be a number", -1.0);
+    Selection* observerOption = celx.toObject(getOption("observer"));
+    Selection observer = observerOption != nullptr ? *observerOption
+                                                   : sim->findObjectFromPath("Sol/Earth");
+    lua_settop(l, top);
+
+    if (maxStep <= 0.0 || precision <= 0.0)
+    {
+        celx.doError("step and precision for celestia:findevents() must be positive");
+        return 0;
+    }
+
+    EventFinder::Search search;
+    string error;
+    double valueScale = 1.0;
+    if (isFunction)
+    {
+        const char* kind = celx.safeGetString(getOption("kind"), NoErrors);
+        search.type = kind != nullptr && !strcmp(kind, "minimum") ? EventFinder::Minimum
+                                                                 : EventFinder::BelowThreshold;
+        search.threshold = celx.safeGetNumber(getOption("threshold"), WrongType,
+                                              "threshold must be a number",
+                                              search.type == EventFinder::Minimum ? numeric_limits<double>::infinity() : 0.0);
+        search.maxStep = maxStep;
+        lua_settop(l, top);
+
+        search.function = [l, &error](double t)
+        {
+            lua_pushvalue(l, 2);
+            lua_pushnumber(l, t);
+            if (lua_pcall(l, 1, 1, 0) != 0)
+            {
+                if (error.empty())
+                    error = lua_tostring(l, -1);
+                lua_pop(l, 1);
+                return numeric_limits<double>::quiet_NaN();
+            }
+            double value = lua_tonumber(l, -1);
+            lua_pop(l, 1);
+            return value;
+        };
+    }
+    else
+    {
+        const char* type = celx.safeGetString(2, AllErrors, "First argument to celestia:findevents() must be an event type or a function");
+        Selection* a = celx.toObject(3);
+        Selection* b = celx.toObject(4);
+        if (type == nullptr || a == nullptr || b == nullptr)
+        {
+            celx.doError("Event type and two objects expected for celestia:findevents()");
+            return 0;
+        }
+
+        if (!strcmp(type, "approach"))
+        {
+            search = EventFinder::closestApproaches(*a, *b, maxStep);
+            if (limit >= 0.0)
+                search.threshold = limit;
+        }
+        else if (!strcmp(type, "conjunction"))
+        {
+            search = EventFinder::conjunctions(observer, *a, *b, maxStep);
+            if (limit >= 0.0)
+                search.threshold = celmath::degToRad(limit);
+            valueScale = celmath::radToDeg(1.0);
+        }
+        else if (!strcmp(type, "occultation"))
+        {
+            search = EventFinder::occultations(observer, *a, *b, maxStep);
+        }
+        else if (!strcmp(type, "transit"))
+        {
+            search = EventFinder::transits(observer, *a, *b, maxStep);
+        }
+        else
+        {
+            celx.doError("Unknown event type for celestia:findevents()");
+            return 0;
+        }
+    }
+
+    // Lua functions may only be called from this thread
+    EventFinder finder(nullptr, isFunction ? 1 : 0);
+    finder.setPrecision(astro::secsToDays(precision));
+    finder.addSearch(search);
+
+    vector<EventFinder::Event> events;
+    finder.findEvents(startTime, endTime, events);
+    if (!error.empty())
+    {
+        celx.doError(error.c_str());
+        return 0;
+    }
+
+    lua_newtable(l);
+    for (unsigned int i = 0; i < events.size(); i++)
+    {
+        lua_newtable(l);
+        celx.setTable("starttime", events[i].startTime);
+        celx.setTable("endtime", events[i].endTime);
+        celx.setTable("time", events[i].time);
+        celx.setTable("value", events[i].value * valueScale);
+        lua_rawseti(l, -2, i + 1);
+    }
+
+    return 1;
+}
+
 void ExtendCelestiaMetaTable(lua_State* l)
 {
     CelxLua celx(l);
@@ -2482,6 +2642,7 @@ void ExtendCelestiaMetaTable(lua_State* l)
     if (lua_type(l, -1) != LUA_TTABLE)
         cout << "Metatable for " << CelxLua::ClassNames[Celx_Celestia] << " not found!\n";
     celx.registerMethod("log", celestia_log);
+    celx.registerMethod("findevents", celestia_findevents);
     celx.registerMethod("settimeslice", celestia_settimeslice);
     celx.registerMethod("setluahook", celestia_setluahook);
     celx.registerMethod("getparamstring", celestia_getparamstring);
@@ -0,0 +1,116 @@
+// mappedfile.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <cstdint>
+#include <fstream>
+#include <iterator>
+#ifdef _WIN32
+#include <windows.h>
+#else
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#endif
+#include "mappedfile.h"
+
+
+MappedFile::MappedFile(const fs::path& path)
+{
+    m_open = map(path) || read(path);
+}
+
+
+MappedFile::~MappedFile()
+{
+    if (m_mapping == nullptr)
+        return;
+
+#ifdef _WIN32
+    UnmapViewOfFile(m_mapping);
+#else
+    munmap(m_mapping, m_size);
+#endif
+}
+
+
+bool MappedFile::map(const fs::path& path)
+{
+#ifdef _WIN32
+    HANDLE file = CreateFileW(path.c_str(), GENERIC_READ, FILE_SHARE_READ, nullptr,
+                              OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr);
+    if (file == INVALID_HANDLE_VALUE)
+        return false;
+
+    LARGE_INTEGER size;
+    if (!GetFileSizeEx(file, &size) || size.QuadPart == 0 ||
+        (unsigned long long) size.QuadPart > SIZE_MAX)
+    {
+        CloseHandle(file);
+        return false;
+    }
+
+    // The view keeps the file open after the handles are closed
+    HANDLE mapping = CreateFileMappingW(file, nullptr, PAGE_READONLY, 0, 0, nullptr);
+    CloseHandle(file);
+    if (mapping == nullptr)
+        return false;
+
+    m_mapping = MapViewOfFile(mapping, FILE_MAP_READ, 0, 0, 0);
+    CloseHandle(mapping);
+    if (m_mapping == nullptr)
+        return false;
+
+    m_size = (size_t) size.QuadPart;
+#else
+    int fd = open(path.c_str(), O_RDONLY);
+    if (fd == -1)
+        return false;
+
+    struct stat st;
+    if (fstat(fd, &st) == -1 || !S_ISREG(st.st_mode) || st.st_size == 0 ||
+        (unsigned long long) st.st_size > SIZE_MAX)
+    {
+        close(fd);
+        return false;
+    }
+
+    // The mapping keeps the file open after the descriptor is closed
+    void* addr = mmap(nullptr, (size_t) st.st_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    close(fd);
+    if (addr == MAP_FAILED)
+        return false;
+
+    posix_madvise(addr, (size_t) st.st_size, POSIX_MADV_SEQUENTIAL);
+    m_mapping = addr;
+    m_size = (size_t) st.st_size;
+#endif
+    m_data = static_cast<const char*>(m_mapping);
+    return true;
+}
+
+
+// Read files which can't be mapped, such as empty ones
+bool MappedFile::read(const fs::path& path)
+{
+    std::ifstream in(path.string(), std::ios::in | std::ios::binary);
+    if (!in.good())
+        return false;
+
+    m_buffer.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+    if (in.bad())
+        return false;
+
+    if (!m_buffer.empty())
+    {
+        m_data = m_buffer.data();
+        m_size = m_buffer.size();
+    }
+    return true;
+}
@@ -0,0 +1,40 @@
+// mappedfile.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <cstddef>
+#include <vector>
+#include <celcompat/filesystem.h>
+
+// The contents of a file for reading, mapped into memory where the system
+// allows it and otherwise read into a buffer. Mapping avoids copying the
+// file, and pages are only read as they are used.
+class MappedFile
+{
+ public:
+    explicit MappedFile(const fs::path& path);
+    ~MappedFile();
+    MappedFile(const MappedFile&) = delete;
+    MappedFile& operator=(const MappedFile&) = delete;
+
+    bool isOpen() const { return m_open; }
+    const char* data() const { return m_data; }
+    size_t size() const { return m_size; }
+
+ private:
+    bool map(const fs::path& path);
+    bool read(const fs::path& path);
+
+    bool m_open{ false };
+    const char* m_data{ "" };
+    size_t m_size{ 0 };
+    void* m_mapping{ nullptr };
+    std::vector<char> m_buffer;
+};
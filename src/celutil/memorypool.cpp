@@ -46,33 +46,43 @@ MemoryPool::MemoryPool(unsigned int alignment, unsigned int blockSize) :
 MemoryPool::~MemoryPool()
 {
     for (const auto& block : m_blockList)
-        delete block.m_memory;
+        delete[] block.m_memory;
+    for (const auto& block : m_largeBlocks)
+        delete[] block.m_memory;
 }
 
 
 /*! Allocate size bytes from the memory pool and return a pointer to
  *  the newly allocated memory. The pointer is valid until the next time
- *  freeAll() is called for the pool. Returns nullptr if the requested size
- *  is larger than the block size of the pool, or if a new block is
+ *  freeAll() is called for the pool. Requests larger than the block size
+ *  of the pool get a block of their own. Returns nullptr if a new block is
  *  required but cannot be allocated (out of memory.)
  */
 void*
 MemoryPool::allocate(unsigned int size)
 {
     if (size > m_blockSize)
-        return nullptr;
+    {
+        Block block;
+        block.m_memory = new (nothrow) char[size];
+        if (block.m_memory == nullptr)
+            return nullptr;
+        m_largeBlocks.push_back(block);
+        return block.m_memory;
+    }
 
     // See if the current block has enough room
-    if (m_blockOffset + size > m_blockSize)
+    if (m_currentBlock != m_blockList.end() && m_blockOffset + size > m_blockSize)
     {
         m_currentBlock++;
+        m_blockOffset = 0;
     }
 
     // See if we need to allocate a new block
     if (m_currentBlock == m_blockList.end())
     {
         Block block;
-        block.m_memory = new char[m_blockSize];
+        block.m_memory = new (nothrow) char[m_blockSize];
         if (block.m_memory == nullptr)
             return nullptr;
         m_currentBlock = m_blockList.insert(m_currentBlock, block);
@@ -106,6 +116,10 @@ MemoryPool::freeAll()
 #endif
     m_currentBlock = m_blockList.begin();
     m_blockOffset = 0;
+
+    for (const auto& block : m_largeBlocks)
+        delete[] block.m_memory;
+    m_largeBlocks.clear();
 }
 
 
@@ -14,13 +14,17 @@
 #ifndef _CELUTIL_MEMORYPOOL_H_
 #define _CELUTIL_MEMORYPOOL_H_
 
+#include <cstddef>
 #include <list>
+#include <new>
 
 class MemoryPool
 {
 public:
     MemoryPool(unsigned int alignment, unsigned int blockSize);
     ~MemoryPool();
+    MemoryPool(const MemoryPool&) = delete;
+    MemoryPool& operator=(const MemoryPool&) = delete;
 
     void* allocate(unsigned int size);
     void freeAll();
@@ -40,7 +44,59 @@ private:
     std::list<Block> m_blockList;
     std::list<Block>::iterator m_currentBlock;
     unsigned int m_blockOffset;
+
+    // Allocations larger than the block size, which aren't reused
+    std::list<Block> m_largeBlocks;
 };
 
+
+// An allocator for standard containers which takes memory from a pool,
+// or from the heap when it has no pool. Memory from a pool is only
+// released when the pool is freed, so containers using it should be
+// built once and not grown or shrunk much.
+template <class T> class PoolAllocator
+{
+public:
+    typedef T value_type;
+
+    PoolAllocator() = default;
+    explicit PoolAllocator(MemoryPool* pool) : m_pool(pool) {}
+    template <class U> PoolAllocator(const PoolAllocator<U>& other) : m_pool(other.pool()) {}
+
+    T* allocate(std::size_t n)
+    {
+        if (m_pool == nullptr)
+            return static_cast<T*>(::operator new(n * sizeof(T)));
+
+        void* memory = m_pool->allocate(n * sizeof(T));
+        if (memory == nullptr)
+            throw std::bad_alloc();
+        return static_cast<T*>(memory);
+    }
+
+    void deallocate(T* p, std::size_t)
+    {
+        if (m_pool == nullptr)
+            ::operator delete(p);
+    }
+
+    MemoryPool* pool() const { return m_pool; }
+
+private:
+    MemoryPool* m_pool{ nullptr };
+};
+
+template <class T, class U>
+bool operator==(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return a.pool() == b.pool();
+}
+
+template <class T, class U>
+bool operator!=(const PoolAllocator<T>& a, const PoolAllocator<U>& b)
+{
+    return a.pool() != b.pool();
+}
+
 #endif // _CELUTIL_MEMORYPOOL_H_
 
@@ -0,0 +1,270 @@
+// profiler.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include <iomanip>
+#include <ostream>
+#include "profiler.h"
+
+using namespace std;
+
+std::atomic<bool> Profiler::enabled{ false };
+
+
+// Small integers identifying threads in traces, in order of first use
+static unsigned int currentThreadIndex()
+{
+    static atomic<unsigned int> nThreads{ 0 };
+    thread_local unsigned int index = nThreads++;
+    return index;
+}
+
+
+static void writeJSONString(ostream& out, const string& s)
+{
+    out << '"';
+    for (char c : s)
+    {
+        if (c == '"' || c == '\\')
+            out << '\\' << c;
+        else if ((unsigned char) c >= 0x20)
+            out << c;
+    }
+    out << '"';
+}
+
+
+Profiler::Profiler() :
+    frames(FrameHistory),
+    epoch(Clock::now())
+{
+}
+
+
+Profiler& Profiler::get()
+{
+    static Profiler profiler;
+    return profiler;
+}
+
+
+void Profiler::setEnabled(bool enable)
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    if (enable && !isEnabled())
+    {
+        // Forget the frames recorded before the profiler was last disabled
+        for (auto& frame : frames)
+        {
+            frame.zoneTimes.clear();
+            frame.counters.clear();
+            frame.events.clear();
+        }
+        currentFrame = 0;
+        nFrames = 0;
+        frames[0].start = toMicroseconds(Clock::now());
+        frames[0].thread = currentThreadIndex();
+    }
+
+    enabled.store(enable, memory_order_relaxed);
+}
+
+
+unsigned int Profiler::addZone(const char* name)
+{
+    lock_guard<std::mutex> lock(mutex);
+    auto iter = find(zoneNames.begin(), zoneNames.end(), name);
+    if (iter != zoneNames.end())
+        return (unsigned int) (iter - zoneNames.begin());
+
+    zoneNames.push_back(name);
+    return (unsigned int) zoneNames.size() - 1;
+}
+
+
+unsigned int Profiler::addCounter(const char* name)
+{
+    lock_guard<std::mutex> lock(mutex);
+    auto iter = find(counterNames.begin(), counterNames.end(), name);
+    if (iter != counterNames.end())
+        return (unsigned int) (iter - counterNames.begin());
+
+    counterNames.push_back(name);
+    return (unsigned int) counterNames.size() - 1;
+}
+
+
+double Profiler::toMicroseconds(Clock::time_point t) const
+{
+    return chrono::duration<double, micro>(t - epoch).count();
+}
+
+
+void Profiler::record(unsigned int zone, Clock::time_point start, Clock::time_point end)
+{
+    Event event;
+    event.zone = zone;
+    event.thread = currentThreadIndex();
+    event.start = toMicroseconds(start);
+    event.duration = chrono::duration<double, micro>(end - start).count();
+
+    lock_guard<std::mutex> lock(mutex);
+    Frame& frame = frames[currentFrame];
+    if (frame.zoneTimes.size() <= zone)
+        frame.zoneTimes.resize(zoneNames.size(), 0.0);
+    frame.zoneTimes[zone] += event.duration;
+    if (frame.events.size() < MaxEventsPerFrame)
+        frame.events.push_back(event);
+}
+
+
+void Profiler::count(unsigned int counter, int64_t n)
+{
+    lock_guard<std::mutex> lock(mutex);
+    Frame& frame = frames[currentFrame];
+    if (frame.counters.size() <= counter)
+        frame.counters.resize(counterNames.size(), 0);
+    frame.counters[counter] += n;
+}
+
+
+void Profiler::nextFrame()
+{
+    if (!isEnabled())
+        return;
+
+    lock_guard<std::mutex> lock(mutex);
+    double now = toMicroseconds(Clock::now());
+    frames[currentFrame].duration = now - frames[currentFrame].start;
+
+    // One slot of the ring buffer always holds the current frame
+    currentFrame = (currentFrame + 1) % FrameHistory;
+    nFrames = min(nFrames + 1, FrameHistory - 1);
+
+    Frame& frame = frames[currentFrame];
+    frame.start = now;
+    frame.duration = 0.0;
+    frame.thread = currentThreadIndex();
+    frame.zoneTimes.clear();
+    frame.counters.clear();
+    frame.events.clear();
+}
+
+
+// The ith completed frame, oldest first; the current one isn't included
+const Profiler::Frame& Profiler::recordedFrame(unsigned int i) const
+{
+    return frames[(currentFrame + FrameHistory - nFrames + i) % FrameHistory];
+}
+
+
+void Profiler::getZoneSummary(vector<Summary>& zones) const
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    zones.clear();
+    for (const auto& name : zoneNames)
+        zones.push_back({ name, 0.0, 0.0 });
+
+    for (unsigned int i = 0; i < nFrames; i++)
+    {
+        const Frame& frame = recordedFrame(i);
+        for (size_t zone = 0; zone < frame.zoneTimes.size(); zone++)
+        {
+            double t = frame.zoneTimes[zone] * 0.001;
+            zones[zone].average += t;
+            zones[zone].maximum = max(zones[zone].maximum, t);
+        }
+    }
+
+    for (auto& zone : zones)
+        zone.average /= max(nFrames, 1u);
+}
+
+
+void Profiler::getCounterSummary(vector<Summary>& counters) const
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    counters.clear();
+    for (const auto& name : counterNames)
+        counters.push_back({ name, 0.0, 0.0 });
+
+    for (unsigned int i = 0; i < nFrames; i++)
+    {
+        const Frame& frame = recordedFrame(i);
+        for (size_t counter = 0; counter < frame.counters.size(); counter++)
+        {
+            auto n = (double) frame.counters[counter];
+            counters[counter].average += n;
+            counters[counter].maximum = max(counters[counter].maximum, n);
+        }
+    }
+
+    for (auto& counter : counters)
+        counter.average /= max(nFrames, 1u);
+}
+
+
+// Average frame time in milliseconds
+double Profiler::getAverageFrameTime() const
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    double total = 0.0;
+    for (unsigned int i = 0; i < nFrames; i++)
+        total += recordedFrame(i).duration;
+
+    return nFrames > 0 ? total * 0.001 / nFrames : 0.0;
+}
+
+
+bool Profiler::writeChromeTrace(ostream& out) const
+{
+    lock_guard<std::mutex> lock(mutex);
+
+    ios_base::fmtflags flags = out.flags();
+    streamsize precision = out.precision();
+    out << fixed << setprecision(3);
+
+    out << "{\"traceEvents\":[\n";
+    out << "{\"name\":\"process_name\",\"ph\":\"M\",\"pid\":1,\"args\":{\"name\":\"Celestia\"}}";
+
+    for (unsigned int i = 0; i < nFrames; i++)
+    {
+        const Frame& frame = recordedFrame(i);
+
+        out << ",\n{\"name\":\"Frame\",\"cat\":\"frame\",\"ph\":\"X\",\"pid\":1,\"tid\":" << frame.thread
+            << ",\"ts\":" << frame.start << ",\"dur\":" << frame.duration << '}';
+
+        for (const auto& event : frame.events)
+        {
+            out << ",\n{\"name\":";
+            writeJSONString(out, zoneNames[event.zone]);
+            out << ",\"cat\":\"zone\",\"ph\":\"X\",\"pid\":1,\"tid\":" << event.thread
+                << ",\"ts\":" << event.start << ",\"dur\":" << event.duration << '}';
+        }
+
+        for (size_t counter = 0; counter < frame.counters.size(); counter++)
+        {
+            out << ",\n{\"name\":";
+            writeJSONString(out, counterNames[counter]);
+            out << ",\"ph\":\"C\",\"pid\":1,\"ts\":" << frame.start
+                << ",\"args\":{\"value\":" << frame.counters[counter] << "}}";
+        }
+    }
+
+    out << "\n]}\n";
+
+    out.flags(flags);
+    out.precision(precision);
+
+    return out.good();
+}
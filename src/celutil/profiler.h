@@ -0,0 +1,144 @@
+// profiler.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <iosfwd>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// Instrumentation of the per frame hot paths: timed zones and counters,
+// kept for the most recent frames. Zones and counters are declared
+// where they're used with the PROFILE_SCOPE() and PROFILE_COUNT() macros;
+// while the profiler is disabled they cost a single test of a flag.
+class Profiler
+{
+ public:
+    typedef std::chrono::steady_clock Clock;
+
+    static const unsigned int FrameHistory = 120;
+    static const size_t MaxEventsPerFrame = 8192;
+
+    static Profiler& get();
+
+    static bool isEnabled() { return enabled.load(std::memory_order_relaxed); }
+    void setEnabled(bool);
+
+    // Register a zone or counter name, returning its index; sites using the
+    // same name share the zone or counter.
+    unsigned int addZone(const char* name);
+    unsigned int addCounter(const char* name);
+
+    void record(unsigned int zone, Clock::time_point start, Clock::time_point end);
+    void count(unsigned int counter, int64_t n);
+
+    // Finish the current frame and start recording the next one
+    void nextFrame();
+
+    // Average and maximum time per frame spent in a zone, and the average
+    // value per frame of a counter, over the recorded frames.
+    struct Summary
+    {
+        std::string name;
+        double average;
+        double maximum;
+    };
+    void getZoneSummary(std::vector<Summary>& zones) const;
+    void getCounterSummary(std::vector<Summary>& counters) const;
+    double getAverageFrameTime() const;
+
+    // Write the recorded frames in the Chrome trace event format, which can
+    // be viewed with chrome://tracing or Perfetto.
+    bool writeChromeTrace(std::ostream& out) const;
+
+ private:
+    Profiler();
+
+    struct Event
+    {
+        unsigned int zone;
+        unsigned int thread;
+        double start;       // microseconds since the profiler was created
+        double duration;
+    };
+
+    struct Frame
+    {
+        double start{ 0.0 };
+        double duration{ 0.0 };
+        unsigned int thread{ 0 };
+        std::vector<double> zoneTimes;
+        std::vector<int64_t> counters;
+        std::vector<Event> events;
+    };
+
+    double toMicroseconds(Clock::time_point t) const;
+    const Frame& recordedFrame(unsigned int i) const;
+
+    static std::atomic<bool> enabled;
+
+    mutable std::mutex mutex;
+    std::vector<std::string> zoneNames;
+    std::vector<std::string> counterNames;
+    std::vector<Frame> frames;
+    unsigned int currentFrame{ 0 };
+    unsigned int nFrames{ 0 };
+    Clock::time_point epoch;
+};
+
+
+// Record the time from construction to destruction in a zone
+class ProfileScope
+{
+ public:
+    explicit ProfileScope(unsigned int _zone) :
+        zone(_zone),
+        active(Profiler::isEnabled())
+    {
+        if (active)
+            start = Profiler::Clock::now();
+    }
+
+    ~ProfileScope()
+    {
+        if (active)
+            Profiler::get().record(zone, start, Profiler::Clock::now());
+    }
+
+    ProfileScope(const ProfileScope&) = delete;
+    ProfileScope& operator=(const ProfileScope&) = delete;
+
+ private:
+    unsigned int zone;
+    bool active;
+    Profiler::Clock::time_point start;
+};
+
+
+#define PROFILE_CONCAT_(a, b) a##b
+#define PROFILE_CONCAT(a, b) PROFILE_CONCAT_(a, b)
+
+// Time the rest of the enclosing block as zone name
+#define PROFILE_SCOPE(name) \
+    static const unsigned int PROFILE_CONCAT(profileZone_, __LINE__) = Profiler::get().addZone(name); \
+    ProfileScope PROFILE_CONCAT(profileScope_, __LINE__)(PROFILE_CONCAT(profileZone_, __LINE__))
+
+// Add n to the counter name for the current frame
+#define PROFILE_COUNT(name, n) \
+    do { \
+        if (Profiler::isEnabled()) \
+        { \
+            static const unsigned int profileCounter = Profiler::get().addCounter(name); \
+            Profiler::get().count(profileCounter, (int64_t) (n)); \
+        } \
+    } while (false)
@@ -10,8 +10,17 @@
 #ifndef _CELUTIL_RESMANAGER_H_
 #define _CELUTIL_RESMANAGER_H_
 
-#include <vector>
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <cstdint>
+#include <deque>
 #include <map>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+#include <utility>
+#include <vector>
 #include <celutil/reshandle.h>
 #include <celcompat/filesystem.h>
 
@@ -20,6 +29,7 @@ enum ResourceState {
     ResourceNotLoaded     = 0,
     ResourceLoaded        = 1,
     ResourceLoadingFailed = 2,
+    ResourceLoading       = 3,
 };
 
 
@@ -32,13 +42,43 @@ template<class T> class ResourceInfo
     virtual fs::path resolve(const fs::path&) = 0;
     virtual T* load(const fs::path&) = 0;
 
+    // Resources loaded in the background are loaded in two steps: prepare()
+    // reads the file on the loading thread, and create() makes the resource
+    // from what was read on the thread calling finishLoading(), which may
+    // be the only one allowed to, as with OpenGL objects. By default all
+    // the work is done by create().
+    virtual bool prepare(const fs::path&) { return true; };
+    virtual T* create(const fs::path& name) { return load(name); };
+
+    // Approximate memory used by the loaded resource, counted against the
+    // memory budget of the resource manager. Resources reporting none are
+    // never unloaded.
+    virtual size_t getMemoryUsage() const { return 0; };
+
     typedef T ResourceType;
     ResourceState state;
     fs::path resolvedName;
     T* resource;
+    float priority{ 0.0f };
+    unsigned int lastUsed{ 0 }; // the frame the resource was last found in
+};
+
+
+struct ResourceStatistics
+{
+    uint64_t hits{ 0 };         // resources found already loaded
+    uint64_t misses{ 0 };       // resources loaded when found
+    uint64_t evictions{ 0 };    // resources unloaded to stay within budget
+    size_t memoryUsage{ 0 };    // bytes used by the loaded resources
 };
 
 
+// Resources may be requested from any thread. They're loaded when first
+// found, either at once or, with background loading enabled, on a thread
+// of their own. With a memory budget set, the least recently used ones are
+// unloaded again by nextFrame(), and reloaded when they're next found; the
+// pointers returned by find() are then only valid until the next call to
+// nextFrame().
 template<class T> class ResourceManager
 {
  private:
@@ -47,14 +87,24 @@ template<class T> class ResourceManager
  public:
     ResourceManager();
     ResourceManager(const fs::path& _baseDir) : baseDir(_baseDir) {};
-    ~ResourceManager();
+    ~ResourceManager()
+    {
+        stopLoader();
+    }
 
     typedef typename T::ResourceType ResourceType;
 
  private:
-    typedef std::vector<T> ResourceTable;
+    // A deque so that the loading thread may work on an entry while
+    // others are added
+    typedef std::deque<T> ResourceTable;
     typedef std::map<T, ResourceHandle> ResourceHandleMap;
-    typedef std::map<fs::path, ResourceType*> NameMap;
+    struct LoadedResource
+    {
+        ResourceType* resource;
+        size_t memoryUsage;
+    };
+    typedef std::map<fs::path, LoadedResource> NameMap;
 
     typedef typename ResourceHandleMap::value_type ResourceHandleMapValue;
     typedef typename NameMap::value_type NameMapValue;
@@ -63,9 +113,26 @@ template<class T> class ResourceManager
     ResourceHandleMap handles;
     NameMap loadedResources;
 
+    std::mutex mutex;
+    std::condition_variable loaderCondition;
+    std::thread loader;
+    bool backgroundLoading{ false };
+    bool stopping{ false };
+    std::vector<ResourceHandle> queued;   // waiting for the loading thread
+    std::vector<ResourceHandle> prepared; // waiting for finishLoading()
+
+    size_t memoryBudget{ 0 };
+    unsigned int evictionAge{ 0 };
+    unsigned int nextEviction{ 0 }; // no resource can be unloaded before
+    unsigned int frame{ 1 };
+    ResourceStatistics statistics;
+    ResourceStatistics frameStartStatistics;
+
  public:
     ResourceHandle getHandle(const T& info)
     {
+        std::lock_guard<std::mutex> lock(mutex);
+
         typename ResourceHandleMap::iterator iter = handles.find(info);
         if (iter != handles.end())
         {
@@ -80,54 +147,325 @@ template<class T> class ResourceManager
         }
     }
 
-    ResourceType* find(ResourceHandle h)
+    // Return the resource, or nullptr if it couldn't be loaded or is still
+    // being loaded in the background. Resources are loaded in the
+    // background in order of priority, such as their size on screen.
+    ResourceType* find(ResourceHandle h, float priority = 0.0f)
     {
+        std::unique_lock<std::mutex> lock(mutex);
+
         if (h >= (int) handles.size() || h < 0)
         {
             return nullptr;
         }
         else
         {
-            if (resources[h].state == ResourceNotLoaded)
+            T& info = resources[h];
+            if (info.state == ResourceNotLoaded)
             {
-                resources[h].resolvedName = resources[h].resolve(baseDir);
+                info.resolvedName = info.resolve(baseDir);
                 typename NameMap::iterator iter =
-                    loadedResources.find(resources[h].resolvedName);
+                    loadedResources.find(info.resolvedName);
                 if (iter != loadedResources.end())
                 {
-                    resources[h].resource = iter->second;
-                    resources[h].state = ResourceLoaded;
+                    info.resource = iter->second.resource;
+                    info.state = ResourceLoaded;
+                    statistics.hits++;
+                }
+                else if (backgroundLoading)
+                {
+                    info.state = ResourceLoading;
+                    info.priority = priority;
+                    queued.push_back(h);
+                    loaderCondition.notify_one();
+                    statistics.misses++;
                 }
                 else
                 {
-                    resources[h].resource = resources[h].load(resources[h].resolvedName);
-                    if (resources[h].resource == nullptr)
-                    {
-                        resources[h].state = ResourceLoadingFailed;
-                    }
+                    // Other threads find the resource loading meanwhile
+                    info.state = ResourceLoading;
+                    lock.unlock();
+                    ResourceType* resource = info.load(info.resolvedName);
+                    lock.lock();
+
+                    info.resource = resource;
+                    if (info.resource == nullptr)
+                        info.state = ResourceLoadingFailed;
                     else
-                    {
-                        resources[h].state = ResourceLoaded;
-                        loadedResources.insert(NameMapValue(resources[h].resolvedName, resources[h].resource));
-                    }
+                        addLoadedResource(info);
+                    statistics.misses++;
                 }
             }
+            else if (info.state == ResourceLoading)
+            {
+                info.priority = std::max(info.priority, priority);
+            }
+            else if (info.state == ResourceLoaded)
+            {
+                statistics.hits++;
+            }
 
-            if (resources[h].state == ResourceLoaded)
-                return resources[h].resource;
+            if (info.state == ResourceLoaded)
+            {
+                info.lastUsed = frame;
+                return info.resource;
+            }
             else
+            {
                 return nullptr;
+            }
         }
     }
 
+    ResourceState getState(ResourceHandle h)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (h >= (int) handles.size() || h < 0)
+            return ResourceLoadingFailed;
+        else
+            return resources[h].state;
+    }
+
     const T* getResourceInfo(ResourceHandle h)
     {
+        std::lock_guard<std::mutex> lock(mutex);
+
         if (h >= (int) handles.size() || h < 0)
             return nullptr;
         else
             return &resources[h];
     }
+
+    // With background loading, the resources found that aren't loaded yet
+    // are read on another thread, and made available by finishLoading().
+    // When it's turned off, the resources read are created at once.
+    void setBackgroundLoading(bool enable)
+    {
+        if (enable == loader.joinable())
+            return;
+
+        if (enable)
+        {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                backgroundLoading = true;
+                stopping = false;
+            }
+            loader = std::thread([this]() { loadInBackground(); });
+        }
+        else
+        {
+            stopLoader();
+
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                for (ResourceHandle h : queued)
+                    resources[h].state = ResourceNotLoaded;
+                queued.clear();
+            }
+            finishLoading(std::chrono::steady_clock::time_point::max());
+        }
+    }
+
+    // Create the resources read in the background, those with the highest
+    // priority first, until the deadline passes. At least one is created
+    // in each call so that loading always progresses.
+    void finishLoading(std::chrono::steady_clock::time_point deadline)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        while (!prepared.empty())
+        {
+            auto next = takeHighestPriority(prepared);
+            T& info = resources[next];
+
+            info.resource = info.create(info.resolvedName);
+            if (info.resource == nullptr)
+            {
+                info.state = ResourceLoadingFailed;
+            }
+            else
+            {
+                addLoadedResource(info);
+            }
+
+            if (std::chrono::steady_clock::now() >= deadline)
+                break;
+        }
+    }
+
+    // Unload the least recently used resources that weren't found in the
+    // last frames frames (at least the current one) while the memory they
+    // use exceeds bytes. A budget of zero, the default, keeps all resources
+    // loaded.
+    void setMemoryBudget(size_t bytes, unsigned int frames)
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        memoryBudget = bytes;
+        evictionAge = std::max(frames, 1u);
+        nextEviction = 0;
+    }
+
+    // Finish a frame, unloading resources if over budget, and return the
+    // statistics of the frame: what was found and unloaded during it, and
+    // the memory used at its end.
+    ResourceStatistics nextFrame()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+
+        if (memoryBudget != 0 && statistics.memoryUsage > memoryBudget && frame >= nextEviction)
+            evict();
+        frame++;
+
+        ResourceStatistics frameStatistics;
+        frameStatistics.hits = statistics.hits - frameStartStatistics.hits;
+        frameStatistics.misses = statistics.misses - frameStartStatistics.misses;
+        frameStatistics.evictions = statistics.evictions - frameStartStatistics.evictions;
+        frameStatistics.memoryUsage = statistics.memoryUsage;
+        frameStartStatistics = statistics;
+
+        return frameStatistics;
+    }
+
+    // Totals since the resource manager was created
+    ResourceStatistics getStatistics()
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        return statistics;
+    }
+
+ private:
+    void addLoadedResource(T& info)
+    {
+        // With background loading, another handle may have loaded the same
+        // file meanwhile
+        auto inserted = loadedResources.insert(NameMapValue(info.resolvedName, { info.resource, 0 }));
+        if (inserted.second)
+        {
+            inserted.first->second.memoryUsage = info.getMemoryUsage();
+            statistics.memoryUsage += inserted.first->second.memoryUsage;
+        }
+        else
+        {
+            delete info.resource;
+            info.resource = inserted.first->second.resource;
+        }
+        info.state = ResourceLoaded;
+        info.lastUsed = frame;
+    }
+
+    void evict()
+    {
+        // Several handles may share a resource, so find when each resource
+        // was last used by any of them.
+        std::map<ResourceType*, std::pair<unsigned int, const fs::path*>> lastUsed;
+        for (const T& info : resources)
+        {
+            if (info.state != ResourceLoaded)
+                continue;
+            auto& used = lastUsed[info.resource];
+            if (used.second == nullptr || info.lastUsed > used.first)
+                used = std::make_pair(info.lastUsed, &info.resolvedName);
+        }
+
+        // Resources kept can only be used more recently since, so while
+        // over budget there's nothing to unload until the oldest has aged.
+        std::vector<std::pair<unsigned int, const fs::path*>> candidates;
+        unsigned int oldestKept = frame;
+        for (const auto& used : lastUsed)
+        {
+            if (frame - used.second.first >= evictionAge)
+                candidates.push_back(used.second);
+            else
+                oldestKept = std::min(oldestKept, used.second.first);
+        }
+        nextEviction = oldestKept + evictionAge;
+        std::sort(candidates.begin(), candidates.end(),
+                  [](const std::pair<unsigned int, const fs::path*>& c0,
+                     const std::pair<unsigned int, const fs::path*>& c1)
+                  { return c0.first < c1.first; });
+
+        std::unordered_set<ResourceType*> evicted;
+        for (const auto& candidate : candidates)
+        {
+            if (statistics.memoryUsage <= memoryBudget)
+            {
+                nextEviction = 0;
+                break;
+            }
+
+            auto iter = loadedResources.find(*candidate.second);
+            if (iter->second.memoryUsage == 0)
+                continue;
+
+            statistics.memoryUsage -= iter->second.memoryUsage;
+            statistics.evictions++;
+            evicted.insert(iter->second.resource);
+            loadedResources.erase(iter);
+        }
+
+        if (evicted.empty())
+            return;
+
+        for (T& info : resources)
+        {
+            if (info.state == ResourceLoaded && evicted.count(info.resource) != 0)
+            {
+                info.state = ResourceNotLoaded;
+                info.resource = nullptr;
+            }
+        }
+        for (ResourceType* resource : evicted)
+            delete resource;
+    }
+
+    ResourceHandle takeHighestPriority(std::vector<ResourceHandle>& list)
+    {
+        auto iter = std::max_element(list.begin(), list.end(),
+                                     [this](ResourceHandle h0, ResourceHandle h1)
+                                     { return resources[h0].priority < resources[h1].priority; });
+        ResourceHandle h = *iter;
+        list.erase(iter);
+        return h;
+    }
+
+    void loadInBackground()
+    {
+        std::unique_lock<std::mutex> lock(mutex);
+        for (;;)
+        {
+            loaderCondition.wait(lock, [this]() { return stopping || !queued.empty(); });
+            if (stopping)
+                return;
+
+            // Nothing else touches the entry while it's loading
+            ResourceHandle h = takeHighestPriority(queued);
+            T& info = resources[h];
+            lock.unlock();
+            bool ok = info.prepare(info.resolvedName);
+            lock.lock();
+
+            if (ok)
+                prepared.push_back(h);
+            else
+                info.state = ResourceLoadingFailed;
+        }
+    }
+
+    void stopLoader()
+    {
+        if (!loader.joinable())
+            return;
+
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            backgroundLoading = false;
+            stopping = true;
+        }
+        loaderCondition.notify_one();
+        loader.join();
+    }
 };
 
 #endif // _CELUTIL_RESMANAGER_H_
-
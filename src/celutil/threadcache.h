@@ -0,0 +1,56 @@
+// threadcache.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <vector>
+#include <Eigen/Core>
+
+// A cache of the values last computed by a class of objects, kept
+// separately by each thread so that the objects may be used from several
+// threads at once without locking, and without threads working at
+// different times evicting each other's values.
+//
+// Each object takes a key from newKey() when it's created. Keys are never
+// reused, so an object allocated where a deleted one was won't find its
+// values. The cache is direct mapped: objects whose keys are a multiple of
+// Size apart share an entry. Entries may hold fixed size Eigen types.
+template<typename T, size_t Size = 256> class ThreadLocalCache
+{
+ public:
+    static uint64_t newKey()
+    {
+        static std::atomic<uint64_t> nextKey{ 1 };
+        return nextKey++;
+    }
+
+    // Return the entry of the calling thread for key, reset to T() if it
+    // held the values of another object. The reference is only valid until
+    // the next call, as code called in between may take the entry over.
+    static T& entry(uint64_t key)
+    {
+        static thread_local std::vector<Slot, Eigen::aligned_allocator<Slot>> slots(Size);
+        Slot& slot = slots[key % Size];
+        if (slot.key != key)
+        {
+            slot.key = key;
+            slot.value = T();
+        }
+        return slot.value;
+    }
+
+ private:
+    struct Slot
+    {
+        uint64_t key{ 0 };
+        T value;
+    };
+};
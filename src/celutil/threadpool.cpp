@@ -0,0 +1,96 @@
+// threadpool.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#include <algorithm>
+#include "threadpool.h"
+
+
+ThreadPool::ThreadPool(unsigned int nThreads)
+{
+    if (nThreads == 0)
+        nThreads = std::max(std::thread::hardware_concurrency(), 1u);
+
+    for (unsigned int i = 1; i < nThreads; i++)
+        workers.emplace_back(&ThreadPool::workerMain, this, i);
+}
+
+
+ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        quit = true;
+    }
+    jobReady.notify_all();
+
+    for (auto& worker : workers)
+        worker.join();
+}
+
+
+void ThreadPool::parallelFor(size_t nTasks, const TaskFunction& func)
+{
+    if (workers.empty() || nTasks <= 1)
+    {
+        for (size_t i = 0; i < nTasks; i++)
+            func(i, 0);
+        return;
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(mutex);
+        job = &func;
+        nJobTasks = nTasks;
+        nextTask = 0;
+        nBusy = (unsigned int) workers.size();
+        generation++;
+    }
+    jobReady.notify_all();
+
+    runTasks(0);
+
+    // The job must stay alive until every worker is done with it
+    std::unique_lock<std::mutex> lock(mutex);
+    jobDone.wait(lock, [this]() { return nBusy == 0; });
+    job = nullptr;
+}
+
+
+void ThreadPool::workerMain(unsigned int thread)
+{
+    unsigned long lastGeneration = 0;
+
+    for (;;)
+    {
+        {
+            std::unique_lock<std::mutex> lock(mutex);
+            jobReady.wait(lock, [&]() { return quit || generation != lastGeneration; });
+            if (quit)
+                return;
+            lastGeneration = generation;
+        }
+
+        runTasks(thread);
+
+        bool last;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            last = --nBusy == 0;
+        }
+        if (last)
+            jobDone.notify_one();
+    }
+}
+
+
+void ThreadPool::runTasks(unsigned int thread)
+{
+    for (size_t i = nextTask++; i < nJobTasks; i = nextTask++)
+        (*job)(i, thread);
+}
@@ -0,0 +1,58 @@
+// threadpool.h
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+
+#pragma once
+
+#include <atomic>
+#include <condition_variable>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+// A fixed set of worker threads used to split work that must complete
+// before the caller goes on, such as parts of the rendering of a frame.
+class ThreadPool
+{
+ public:
+    typedef std::function<void(size_t task, unsigned int thread)> TaskFunction;
+
+    // Create a pool with nThreads threads in total, counting the thread
+    // calling parallelFor(); zero creates one thread per processor core.
+    explicit ThreadPool(unsigned int nThreads = 0);
+    ~ThreadPool();
+    ThreadPool(const ThreadPool&) = delete;
+    ThreadPool& operator=(const ThreadPool&) = delete;
+
+    unsigned int getThreadCount() const { return (unsigned int) workers.size() + 1; }
+
+    // Call func(task, thread) for each task in [0, nTasks), and return once
+    // all of them have completed. The tasks are run by the pool threads and
+    // the calling thread; thread is an index in [0, getThreadCount())
+    // identifying the thread, so that tasks can use per thread data.
+    void parallelFor(size_t nTasks, const TaskFunction& func);
+
+ private:
+    void workerMain(unsigned int thread);
+    void runTasks(unsigned int thread);
+
+    std::vector<std::thread> workers;
+
+    std::mutex mutex;
+    std::condition_variable jobReady;
+    std::condition_variable jobDone;
+
+    // The current job; generation changes each time a job is started
+    const TaskFunction* job{ nullptr };
+    size_t nJobTasks{ 0 };
+    std::atomic<size_t> nextTask{ 0 };
+    unsigned long generation{ 0 };
+    unsigned int nBusy{ 0 };
+    bool quit{ false };
+};
@@ -607,6 +607,36 @@ int UTF8StringCompare(const std::string& s0, const std::string& s1, size_t n, bo
 }
 
 
+//! Normalize and lower case a UTF-8 string the same way as
+//! UTF8StringCompare() does when ignoring case, so that such comparisons
+//! can be done with plain byte comparisons of the folded strings.  Invalid
+//! sequences are copied unchanged.
+std::string UTF8FoldCase(const std::string& s)
+{
+    std::string folded;
+    folded.reserve(s.length());
+
+    char buf[7];
+    int len = s.length();
+    int i = 0;
+    while (i < len)
+    {
+        wchar_t ch = 0;
+        if (!UTF8Decode(s, i, ch))
+        {
+            folded.append(s, i, std::string::npos);
+            break;
+        }
+
+        i += UTF8EncodedSize(ch);
+        ch = std::tolower(UTF8Normalize(ch));
+        folded.append(buf, UTF8Encode(ch, buf));
+    }
+
+    return folded;
+}
+
+
 #if 0
 //! Currently incomplete, but could be a helpful class for dealing with
 //! UTF-8 streams
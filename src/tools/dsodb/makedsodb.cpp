@@ -0,0 +1,361 @@
+// makedsodb.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Convert a text deep sky catalog (.dsc) to a binary deep sky catalog,
+// which DSODatabase::loadBinary reads without going through the parser.
+
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <cstring>
+#include <celutil/bytes.h>
+#include <celutil/util.h>
+#include <celengine/astro.h>
+#include <celengine/dsodb.h>
+#include <celengine/opencluster.h>
+#include <celengine/parser.h>
+#include <celengine/tokenizer.h>
+
+using namespace Eigen;
+using namespace std;
+
+
+static string inputFilename;
+static string outputFilename;
+
+
+void Usage()
+{
+    cerr << "Usage: makedsodb <input deep sky catalog> <output binary catalog>\n";
+}
+
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    int fileCount = 0;
+
+    for (int i = 1; i < argc; i++)
+    {
+        if (argv[i][0] == '-')
+        {
+            cerr << "Unknown command line switch: " << argv[i] << '\n';
+            return false;
+        }
+
+        if (fileCount == 0)
+            inputFilename = string(argv[i]);
+        else if (fileCount == 1)
+            outputFilename = string(argv[i]);
+        else
+            return false;
+        fileCount++;
+    }
+
+    return fileCount == 2;
+}
+
+
+static void writeUbyte(ostream& out, uint8_t n)
+{
+    out.put((char) n);
+}
+
+static void writeUshort(ostream& out, uint16_t n)
+{
+    LE_TO_CPU_INT16(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+static void writeUint(ostream& out, uint32_t n)
+{
+    LE_TO_CPU_INT32(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+static void writeFloat(ostream& out, float f)
+{
+    LE_TO_CPU_FLOAT(f, f);
+    out.write(reinterpret_cast<char*>(&f), sizeof f);
+}
+
+static void writeDouble(ostream& out, double d)
+{
+    LE_TO_CPU_DOUBLE(d, d);
+    out.write(reinterpret_cast<char*>(&d), sizeof d);
+}
+
+static bool writeString(ostream& out, const string& s)
+{
+    if (s.size() > UINT16_MAX)
+    {
+        cerr << "String too long: " << s.substr(0, 40) << "...\n";
+        return false;
+    }
+
+    writeUshort(out, (uint16_t) s.size());
+    out.write(s.data(), s.size());
+    return true;
+}
+
+
+// The categories added by AstroObject::loadCategories()
+static vector<string> getCategories(const Hash* params)
+{
+    vector<string> categories;
+
+    string category;
+    if (params->getString("Category", category))
+    {
+        if (!category.empty())
+            categories.push_back(category);
+        return categories;
+    }
+
+    Value* value = params->getValue("Category");
+    if (value == nullptr || value->getType() != Value::ArrayType)
+        return categories;
+
+    for (const auto* v : *value->getArray())
+    {
+        if (v->getType() == Value::StringType)
+            categories.push_back(v->getString());
+    }
+
+    return categories;
+}
+
+
+// Write the fields of one object; the values are computed the same way
+// as in the load() methods of the deep sky object classes.
+static bool WriteDSO(ostream& out,
+                     DSODatabase::BinaryObjectType objType,
+                     AstroCatalog::IndexNumber catalogNumber,
+                     const string& names,
+                     const Hash* params)
+{
+    // The fields common to all deep sky objects
+    OpenCluster dso;
+    if (!dso.load(const_cast<Hash*>(params), fs::path()))
+        return false;
+
+    uint8_t flags = 0;
+    if (dso.isVisible())
+        flags |= DSODatabase::BinaryVisible;
+    if (dso.isClickable())
+        flags |= DSODatabase::BinaryClickable;
+
+    string infoURL;
+    if (params->getString("InfoURL", infoURL))
+        flags |= DSODatabase::BinaryHasInfoURL;
+
+    string customTmpName;
+    if (objType == DSODatabase::BinaryGalaxy && params->getString("CustomTemplate", customTmpName))
+        flags |= DSODatabase::BinaryHasCustomTemplate;
+
+    double coreRadius = 0.0;
+    if (objType == DSODatabase::BinaryGlobular &&
+        params->getAngle("CoreRadius", coreRadius, 1.0 / MINUTES_PER_DEG))
+    {
+        flags |= DSODatabase::BinaryHasCoreRadius;
+    }
+
+    float concentration = 0.0f;
+    if (objType == DSODatabase::BinaryGlobular &&
+        params->getNumber("KingConcentration", concentration))
+    {
+        flags |= DSODatabase::BinaryHasConcentration;
+    }
+
+    string mesh;
+    if (objType == DSODatabase::BinaryNebula && params->getString("Mesh", mesh))
+        flags |= DSODatabase::BinaryHasMesh;
+
+    vector<string> categories = getCategories(params);
+    if (categories.size() > UINT8_MAX)
+    {
+        cerr << "Too many categories for " << names << '\n';
+        return false;
+    }
+
+    writeUbyte(out, objType);
+    writeUint(out, catalogNumber);
+    if (!writeString(out, names))
+        return false;
+
+    Vector3d position = dso.getPosition();
+    writeDouble(out, position.x());
+    writeDouble(out, position.y());
+    writeDouble(out, position.z());
+    Quaternionf orientation = dso.getOrientation();
+    writeFloat(out, orientation.w());
+    writeFloat(out, orientation.x());
+    writeFloat(out, orientation.y());
+    writeFloat(out, orientation.z());
+    writeFloat(out, dso.getRadius());
+    writeFloat(out, dso.getAbsoluteMagnitude());
+
+    writeUbyte(out, flags);
+    if ((flags & DSODatabase::BinaryHasInfoURL) != 0 && !writeString(out, infoURL))
+        return false;
+
+    writeUbyte(out, (uint8_t) categories.size());
+    for (const auto& category : categories)
+    {
+        if (!writeString(out, category))
+            return false;
+    }
+
+    switch (objType)
+    {
+    case DSODatabase::BinaryGalaxy:
+        {
+            double detail = 1.0;
+            params->getNumber("Detail", detail);
+            writeFloat(out, (float) detail);
+
+            string typeName;
+            params->getString("Type", typeName);
+            if (!writeString(out, typeName))
+                return false;
+            if ((flags & DSODatabase::BinaryHasCustomTemplate) != 0 && !writeString(out, customTmpName))
+                return false;
+        }
+        break;
+
+    case DSODatabase::BinaryGlobular:
+        {
+            float detail = 1.0f;
+            params->getNumber("Detail", detail);
+            writeFloat(out, detail);
+            writeFloat(out, (float) coreRadius);
+            writeFloat(out, concentration);
+        }
+        break;
+
+    case DSODatabase::BinaryNebula:
+        if ((flags & DSODatabase::BinaryHasMesh) != 0 && !writeString(out, mesh))
+            return false;
+        break;
+
+    case DSODatabase::BinaryOpenCluster:
+        break;
+    }
+
+    return out.good();
+}
+
+
+bool WriteDSODatabase(istream& in, ostream& out)
+{
+    Tokenizer tokenizer(&in);
+    Parser    parser(&tokenizer);
+
+    // The records are buffered as the object count comes first
+    ostringstream records(ios::out | ios::binary);
+    uint32_t nDSOs = 0;
+
+    while (tokenizer.nextToken() != Tokenizer::TokenEnd)
+    {
+        if (tokenizer.getTokenType() != Tokenizer::TokenName)
+        {
+            cerr << "Error parsing deep sky catalog, line " << tokenizer.getLineNumber() << '\n';
+            return false;
+        }
+
+        string objTypeName = tokenizer.getNameValue();
+        DSODatabase::BinaryObjectType objType;
+        if (compareIgnoringCase(objTypeName, "Galaxy") == 0)
+            objType = DSODatabase::BinaryGalaxy;
+        else if (compareIgnoringCase(objTypeName, "Globular") == 0)
+            objType = DSODatabase::BinaryGlobular;
+        else if (compareIgnoringCase(objTypeName, "Nebula") == 0)
+            objType = DSODatabase::BinaryNebula;
+        else if (compareIgnoringCase(objTypeName, "OpenCluster") == 0)
+            objType = DSODatabase::BinaryOpenCluster;
+        else
+        {
+            cerr << "Unknown deep sky object type " << objTypeName
+                 << ", line " << tokenizer.getLineNumber() << '\n';
+            return false;
+        }
+
+        AstroCatalog::IndexNumber catalogNumber = AstroCatalog::InvalidIndex;
+        if (tokenizer.nextToken() == Tokenizer::TokenNumber)
+        {
+            catalogNumber = (AstroCatalog::IndexNumber) tokenizer.getNumberValue();
+            tokenizer.nextToken();
+        }
+
+        if (tokenizer.getTokenType() != Tokenizer::TokenString)
+        {
+            cerr << "Error parsing deep sky catalog: bad name, line " << tokenizer.getLineNumber() << '\n';
+            return false;
+        }
+        string names = tokenizer.getStringValue();
+
+        Value* paramsValue = parser.readValue();
+        if (paramsValue == nullptr || paramsValue->getType() != Value::HashType)
+        {
+            cerr << "Error parsing deep sky catalog entry " << names << '\n';
+            delete paramsValue;
+            return false;
+        }
+
+        bool ok = WriteDSO(records, objType, catalogNumber, names, paramsValue->getHash());
+        delete paramsValue;
+        if (!ok)
+        {
+            cerr << "Error writing deep sky object " << names << '\n';
+            return false;
+        }
+
+        nDSOs++;
+    }
+
+    // Write the header
+    out.write("CEL_DSOs", 8);
+
+    // Write the version
+    writeUshort(out, DSODatabase::BinaryFileVersion);
+
+    writeUint(out, nDSOs);
+    out << records.str();
+
+    cerr << nDSOs << " deep sky objects written\n";
+
+    return out.good();
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
+    {
+        Usage();
+        return 1;
+    }
+
+    ifstream inputFile(inputFilename, ios::in);
+    if (!inputFile.good())
+    {
+        cerr << "Error opening input file " << inputFilename << '\n';
+        return 1;
+    }
+
+    ofstream dsodbFile(outputFilename, ios::out | ios::binary);
+    if (!dsodbFile.good())
+    {
+        cerr << "Error opening deep sky database file " << outputFilename << '\n';
+        return 1;
+    }
+
+    bool success = WriteDSODatabase(inputFile, dsodbFile);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,262 @@
+// findevents.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Find closest approaches, conjunctions, occultations and transits of
+// objects in the Celestia universe over a span of time.
+
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <iostream>
+#include <string>
+#include <celcompat/filesystem.h>
+#include <celengine/astro.h>
+#include <celestia/celestiacore.h>
+#include <celestia/eventfinder.h>
+#include <celmath/mathlib.h>
+
+using namespace std;
+using namespace celmath;
+
+
+static string eventType;
+static string objectNames[2];
+static string observerName = "Sol/Earth";
+static string dataDir;
+static string configFilename;
+static string startDate;
+static string endDate;
+static double maxStep = 1.0;
+static double limit = -1.0;
+static double precision = 1.0;
+static unsigned int nThreads = 0;
+
+
+void Usage()
+{
+    cerr << "Usage: findevents [options] <event type> <object> <object>\n"
+         << "Event types:\n"
+         << "  approach      closest approaches of the objects\n"
+         << "  conjunction   conjunctions of the objects seen from the observer\n"
+         << "  occultation   occultations of the second object by the first one\n"
+         << "  transit       transits of the first object across the second one\n"
+         << "Options:\n"
+         << "  --dir <dir>           Celestia data directory\n"
+         << "  --config <file>       configuration file\n"
+         << "  --observer <object>   observer of conjunctions, occultations and\n"
+         << "                        transits (default Sol/Earth)\n"
+         << "  --start <date>        start date, as YYYY-MM-DD [hh:mm[:ss]] UTC\n"
+         << "  --end <date>          end date (default one year after the start)\n"
+         << "  --step <days>         longest search step (default 1)\n"
+         << "  --limit <value>       greatest distance in km of approaches or\n"
+         << "                        separation in degrees of conjunctions\n"
+         << "  --precision <secs>    precision of event times (default 1)\n"
+         << "  --threads <count>     number of threads (default one per core)\n"
+         << "Approaches and conjunctions are printed with their time and distance\n"
+         << "or separation, occultations and transits with their start, end and\n"
+         << "duration in minutes.\n";
+}
+
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    int i = 1;
+    int nameCount = 0;
+
+    while (i < argc)
+    {
+        if (argv[i][0] == '-' && argv[i][1] == '-')
+        {
+            if (i + 1 == argc)
+            {
+                cerr << "Missing value for " << argv[i] << '\n';
+                return false;
+            }
+
+            const char* value = argv[i + 1];
+            if (!strcmp(argv[i], "--dir"))
+                dataDir = value;
+            else if (!strcmp(argv[i], "--config"))
+                configFilename = value;
+            else if (!strcmp(argv[i], "--observer"))
+                observerName = value;
+            else if (!strcmp(argv[i], "--start"))
+                startDate = value;
+            else if (!strcmp(argv[i], "--end"))
+                endDate = value;
+            else if (!strcmp(argv[i], "--step"))
+                maxStep = atof(value);
+            else if (!strcmp(argv[i], "--limit"))
+                limit = atof(value);
+            else if (!strcmp(argv[i], "--precision"))
+                precision = atof(value);
+            else if (!strcmp(argv[i], "--threads"))
+                nThreads = (unsigned int) atoi(value);
+            else
+            {
+                cerr << "Unknown command line switch: " << argv[i] << '\n';
+                return false;
+            }
+            i += 2;
+        }
+        else
+        {
+            if (eventType.empty())
+                eventType = argv[i];
+            else if (nameCount < 2)
+                objectNames[nameCount++] = argv[i];
+            else
+                return false;
+            i++;
+        }
+    }
+
+    return nameCount == 2 && maxStep > 0.0 && precision > 0.0;
+}
+
+
+// Parse a date given as YYYY-MM-DD [hh:mm[:ss]] or in the format used by
+// astro::parseDate(), returning it as TDB.
+static bool parseTDB(string s, double& tdb)
+{
+    for (size_t i = 1; i < s.size(); i++)
+    {
+        if (s[i] == '-' || s[i] == 'T')
+            s[i] = ' ';
+    }
+
+    astro::Date date;
+    if (!astro::parseDate(s, date))
+        return false;
+    tdb = astro::UTCtoTDB(date);
+    return true;
+}
+
+
+static void printDate(double tdb)
+{
+    astro::Date date = astro::TDBtoUTC(tdb);
+    printf("%04d-%02d-%02d %02d:%02d:%02d",
+           date.year, date.month, date.day, date.hour, date.minute,
+           (int) date.seconds);
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
+    {
+        Usage();
+        return 1;
+    }
+
+    if (!dataDir.empty())
+    {
+        std::error_code ec;
+        fs::current_path(dataDir, ec);
+        if (ec)
+        {
+            cerr << "Error changing to data directory " << dataDir << '\n';
+            return 1;
+        }
+    }
+
+    double startTime = astro::UTCtoTDB(astro::Date::systemDate());
+    if (!startDate.empty() && !parseTDB(startDate, startTime))
+    {
+        cerr << "Invalid start date " << startDate << '\n';
+        return 1;
+    }
+    double endTime = startTime + 365.25;
+    if (!endDate.empty() && !parseTDB(endDate, endTime))
+    {
+        cerr << "Invalid end date " << endDate << '\n';
+        return 1;
+    }
+
+    CelestiaCore appCore;
+    if (!appCore.initSimulation(configFilename))
+    {
+        cerr << "Error loading the Celestia data\n";
+        return 1;
+    }
+
+    Simulation* sim = appCore.getSimulation();
+    Selection objects[2];
+    for (int i = 0; i < 2; i++)
+    {
+        objects[i] = sim->findObjectFromPath(objectNames[i], true);
+        if (objects[i].empty())
+        {
+            cerr << "Object " << objectNames[i] << " not found\n";
+            return 1;
+        }
+    }
+    Selection observer = sim->findObjectFromPath(observerName, true);
+    if (observer.empty())
+    {
+        cerr << "Observer " << observerName << " not found\n";
+        return 1;
+    }
+
+    EventFinder::Search search;
+    double valueScale = 1.0;
+    if (eventType == "approach")
+    {
+        search = EventFinder::closestApproaches(objects[0], objects[1], maxStep);
+        if (limit >= 0.0)
+            search.threshold = limit;
+    }
+    else if (eventType == "conjunction")
+    {
+        search = EventFinder::conjunctions(observer, objects[0], objects[1], maxStep);
+        if (limit >= 0.0)
+            search.threshold = degToRad(limit);
+        valueScale = radToDeg(1.0);
+    }
+    else if (eventType == "occultation")
+    {
+        search = EventFinder::occultations(observer, objects[0], objects[1], maxStep);
+    }
+    else if (eventType == "transit")
+    {
+        search = EventFinder::transits(observer, objects[0], objects[1], maxStep);
+    }
+    else
+    {
+        cerr << "Unknown event type " << eventType << '\n';
+        Usage();
+        return 1;
+    }
+
+    EventFinder finder(nullptr, nThreads);
+    finder.setPrecision(astro::secsToDays(precision));
+    finder.addSearch(search);
+
+    vector<EventFinder::Event> events;
+    finder.findEvents(startTime, endTime, events);
+
+    for (const auto& event : events)
+    {
+        if (search.type == EventFinder::Minimum)
+        {
+            printDate(event.time);
+            printf(" %.6f\n", event.value * valueScale);
+        }
+        else
+        {
+            printDate(event.startTime);
+            printf(" ");
+            printDate(event.endTime);
+            printf(" %.1f\n", astro::daysToSecs(event.endTime - event.startTime) / 60.0);
+        }
+    }
+
+    return 0;
+}
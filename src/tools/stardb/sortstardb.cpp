@@ -0,0 +1,238 @@
+// sortstardb.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Convert a Celestia star database to a database with the stars sorted
+// into octree order, and the octree itself stored after the header. Such
+// a database can be loaded without rebuilding the octree.
+
+#include <iostream>
+#include <fstream>
+#include <string>
+#include <cstring>
+#include <map>
+#include <vector>
+#include <celutil/bytes.h>
+#include <celengine/stardb.h>
+
+using namespace std;
+
+
+static string inputFilename;
+static string outputFilename;
+
+
+void Usage()
+{
+    cerr << "Usage: sortstardb <input star database> <output star database>\n";
+}
+
+
+bool parseCommandLine(int argc, char* argv[])
+{
+    int i = 1;
+    int fileCount = 0;
+
+    while (i < argc)
+    {
+        if (argv[i][0] == '-')
+        {
+            cerr << "Unknown command line switch: " << argv[i] << '\n';
+            return false;
+        }
+        else
+        {
+            if (fileCount == 0)
+            {
+                // input filename first
+                inputFilename = string(argv[i]);
+                fileCount++;
+            }
+            else if (fileCount == 1)
+            {
+                // output filename second
+                outputFilename = string(argv[i]);
+                fileCount++;
+            }
+            else
+            {
+                // more than two filenames on the command line is an error
+                return false;
+            }
+            i++;
+        }
+    }
+
+    return fileCount == 2;
+}
+
+
+static void writeUint(ostream& out, uint32_t n)
+{
+    LE_TO_CPU_INT32(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+static void writeFloat(ostream& out, float f)
+{
+    LE_TO_CPU_FLOAT(f, f);
+    out.write(reinterpret_cast<char*>(&f), sizeof f);
+}
+
+static void writeUshort(ostream& out, uint16_t n)
+{
+    LE_TO_CPU_INT16(n, n);
+    out.write(reinterpret_cast<char*>(&n), sizeof n);
+}
+
+
+// The spectral types are not kept by the star database, so they are
+// read directly from the input file.
+bool ReadSpectralTypes(istream& in, map<uint32_t, uint16_t>& spectralTypes)
+{
+    char header[8];
+    in.read(header, sizeof header);
+    if (strncmp(header, "CELSTARS", sizeof header))
+    {
+        cerr << "Missing header in star database.\n";
+        return false;
+    }
+
+    uint16_t version;
+    in.read(reinterpret_cast<char*>(&version), sizeof version);
+    LE_TO_CPU_INT16(version, version);
+    if (version != 0x0100)
+    {
+        cerr << "Unsupported star database version.\n";
+        return false;
+    }
+
+    uint32_t nStarsInFile;
+    in.read(reinterpret_cast<char*>(&nStarsInFile), sizeof nStarsInFile);
+    LE_TO_CPU_INT32(nStarsInFile, nStarsInFile);
+
+    for (uint32_t i = 0; i < nStarsInFile; i++)
+    {
+        char record[20];
+        in.read(record, sizeof record);
+        if (!in.good())
+        {
+            cerr << "Error reading record #" << i << '\n';
+            return false;
+        }
+
+        uint32_t catalogNumber;
+        uint16_t spectralType;
+        memcpy(&catalogNumber, record, sizeof catalogNumber);
+        LE_TO_CPU_INT32(catalogNumber, catalogNumber);
+        memcpy(&spectralType, record + 18, sizeof spectralType);
+        LE_TO_CPU_INT16(spectralType, spectralType);
+
+        if (!spectralTypes.insert(make_pair(catalogNumber, spectralType)).second)
+        {
+            cerr << "Duplicate catalog number " << catalogNumber << '\n';
+            return false;
+        }
+    }
+
+    return true;
+}
+
+
+bool WriteSortedStarDatabase(const StarDatabase& starDB,
+                             const map<uint32_t, uint16_t>& spectralTypes,
+                             ostream& out)
+{
+    const vector<StarOctree::Node>& nodes = starDB.getOctree()->getNodes();
+
+    // Write the header
+    out.write("CELSTARS", 8);
+
+    // Write the version
+    writeUshort(out, 0x0200);
+
+    writeUint(out, starDB.size());
+    writeUint(out, (uint32_t) nodes.size());
+
+    for (const auto& node : nodes)
+    {
+        writeFloat(out, node.cellCenterPos.x());
+        writeFloat(out, node.cellCenterPos.y());
+        writeFloat(out, node.cellCenterPos.z());
+        writeFloat(out, node.exclusionFactor);
+        writeUint(out, node.firstObject);
+        writeUint(out, node.nObjects);
+        writeUint(out, node.firstChild);
+    }
+
+    for (uint32_t i = 0; i < starDB.size(); i++)
+    {
+        const Star* star = starDB.getStar(i);
+        Eigen::Vector3f pos = star->getPosition();
+
+        writeUint(out, star->getIndex());
+        writeFloat(out, pos.x());
+        writeFloat(out, pos.y());
+        writeFloat(out, pos.z());
+        writeUshort(out, (uint16_t) (int16_t) (star->getAbsoluteMagnitude() * 256.0f));
+        writeUshort(out, spectralTypes.find(star->getIndex())->second);
+    }
+
+    return out.good();
+}
+
+
+int main(int argc, char* argv[])
+{
+    if (!parseCommandLine(argc, argv))
+    {
+        Usage();
+        return 1;
+    }
+
+    map<uint32_t, uint16_t> spectralTypes;
+    {
+        ifstream inputFile(inputFilename, ios::in | ios::binary);
+        if (!inputFile.good())
+        {
+            cerr << "Error opening input file " << inputFilename << '\n';
+            return 1;
+        }
+
+        if (!ReadSpectralTypes(inputFile, spectralTypes))
+            return 1;
+    }
+
+    StarDatabase starDB;
+    {
+        ifstream inputFile(inputFilename, ios::in | ios::binary);
+        if (!starDB.loadBinary(inputFile))
+        {
+            cerr << "Error reading star database " << inputFilename << '\n';
+            return 1;
+        }
+    }
+    starDB.finish();
+
+    if (starDB.size() == 0)
+    {
+        cerr << "Star database " << inputFilename << " is empty\n";
+        return 1;
+    }
+
+    ofstream stardbFile(outputFilename, ios::out | ios::binary);
+    if (!stardbFile.good())
+    {
+        cerr << "Error opening star database file " << outputFilename << '\n';
+        return 1;
+    }
+
+    bool success = WriteSortedStarDatabase(starDB, spectralTypes, stardbFile);
+
+    return success ? 0 : 1;
+}
@@ -0,0 +1,280 @@
+// galaxysprites_bench.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Compare the CPU cost of drawing galaxies, which only computes the
+// parameters the shader needs, with building the vertices of every blob
+// drawn as it was done before the forms were kept in vertex buffers. No
+// OpenGL context is needed: only the work preceding the draw calls is
+// measured. Each galaxy of the catalog is viewed from a range of
+// distances.
+//
+// Usage: galaxysprites [deep sky catalog] [views per galaxy]
+// Galaxy templates are loaded relative to the current directory, so it
+// should be run from the Celestia data directory.
+
+#include <celengine/galaxy.h>
+#include <celengine/dsodb.h>
+#include <celmath/mathlib.h>
+#include <celutil/timer.h>
+#include <chrono>
+#include <cstdlib>
+#include <cmath>
+#include <cstring>
+#include <fstream>
+#include <iomanip>
+#include <iostream>
+#include <random>
+#include <thread>
+#include <vector>
+
+using namespace Eigen;
+using namespace std;
+using namespace celmath;
+
+static const int   WINDOW_HEIGHT = 1080;
+static const float FOV           = degToRad(45.0f);
+static const int   REPEATS       = 3;
+
+// Distances of the viewer in units of the galaxy radius
+static const float Distances[] = { 1.5f, 3.0f, 10.0f, 100.0f, 1.0e4f };
+
+
+struct View
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+
+    Galaxy*     galaxy;
+    Vector3f    offset;
+    Quaternionf orientation;
+};
+
+
+struct OldGalaxyVertex
+{
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+
+    Vector4f position;
+    Matrix<short, 4, 1> texCoord;
+};
+
+// The per blob loop of the galaxy rendering before the forms were kept in
+// vertex buffers, without the draw calls. Returns the number of blobs
+// drawn.
+static size_t buildVerticesOld(const GalaxyDrawParams& params,
+                               const Vector3f& offset,
+                               float minimumFeatureSize,
+                               unsigned int nPoints,
+                               vector<OldGalaxyVertex, aligned_allocator<OldGalaxyVertex>>& vertices,
+                               vector<short>& indices)
+{
+    float size = params.size;
+    Vector4f v0(Vector4f::Zero());
+    Vector4f v1(Vector4f::Zero());
+    Vector4f v2(Vector4f::Zero());
+    Vector4f v3(Vector4f::Zero());
+    v0.head(3) = params.viewMat * Vector3f(-1, -1, 0) * size;
+    v1.head(3) = params.viewMat * Vector3f( 1, -1, 0) * size;
+    v2.head(3) = params.viewMat * Vector3f( 1,  1, 0) * size;
+    v3.head(3) = params.viewMat * Vector3f(-1,  1, 0) * size;
+
+    Matrix4f m = Matrix4f::Identity();
+    m.topLeftCorner(3,3) = params.m;
+    m.block<3,1>(0, 3) = offset;
+
+    const float spriteScaleFactor = 1.0f / 1.55f;
+    const BlobVector& points = params.form->blobs;
+    int pow2 = 1;
+    unsigned short j = 0;
+    size_t nDrawn = 0;
+
+    for (unsigned int i = 0; i < nPoints; ++i)
+    {
+        if ((i & pow2) != 0)
+        {
+            pow2 <<= 1;
+            size *= spriteScaleFactor;
+            v0 *= spriteScaleFactor;
+            v1 *= spriteScaleFactor;
+            v2 *= spriteScaleFactor;
+            v3 *= spriteScaleFactor;
+            if (size < minimumFeatureSize)
+                break;
+        }
+
+        const Blob& b  = points[i];
+        Vector4f    p  = m * b.position;
+        float       br = b.brightness / 255.0f;
+
+        float screenFrac = size / p.norm();
+        if (screenFrac < 0.1f)
+        {
+            float a = params.alphaScale * (0.1f - screenFrac) * br;
+            short alpha = (short) (a * 65535.99f);
+            short color = (short) b.colorIndex;
+            OldGalaxyVertex vtx;
+            vtx.position = p + v0;
+            vtx.texCoord = { 0, 0, color, alpha };
+            vertices.push_back(vtx);
+            vtx.position = p + v1;
+            vtx.texCoord = { 1, 0, color, alpha };
+            vertices.push_back(vtx);
+            vtx.position = p + v2;
+            vtx.texCoord = { 1, 1, color, alpha };
+            vertices.push_back(vtx);
+            vtx.position = p + v3;
+            vtx.texCoord = { 0, 1, color, alpha };
+            vertices.push_back(vtx);
+
+            indices.push_back(j+0);
+            indices.push_back(j+1);
+            indices.push_back(j+2);
+            indices.push_back(j+0);
+            indices.push_back(j+2);
+            indices.push_back(j+3);
+            j += 4;
+            nDrawn++;
+
+            if ((vertices.size() + 4) * sizeof(OldGalaxyVertex) > 4096)
+            {
+                vertices.clear();
+                indices.clear();
+                j = 0;
+            }
+        }
+    }
+
+    vertices.clear();
+    indices.clear();
+    return nDrawn;
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* catalogFile = argc > 1 ? argv[1] : "data/galaxies.dsc";
+    int viewsPerGalaxy      = argc > 2 ? atoi(argv[2]) : 2;
+    if (viewsPerGalaxy <= 0)
+    {
+        cerr << "Usage: galaxysprites [deep sky catalog] [views per galaxy]\n";
+        return 1;
+    }
+
+    DSODatabase dsoDB;
+    ifstream in(catalogFile, ios::in);
+    if (!in.good() || !dsoDB.load(in))
+    {
+        cerr << "Error reading deep sky catalog " << catalogFile << '\n';
+        return 1;
+    }
+    dsoDB.finish();
+
+    vector<Galaxy*> galaxies;
+    for (uint32_t i = 0; i < dsoDB.size(); i++)
+    {
+        DeepSkyObject* dso = dsoDB.getDSO(i);
+        if (strcmp(dso->getObjTypeName(), "galaxy") == 0)
+            galaxies.push_back(static_cast<Galaxy*>(dso));
+    }
+    if (galaxies.empty())
+    {
+        cerr << "No galaxies in " << catalogFile << '\n';
+        return 1;
+    }
+
+    // Wait for the forms, which are generated in the background
+    Timer timer;
+    for (Galaxy* galaxy : galaxies)
+    {
+        while (galaxy->getForm() == nullptr)
+        {
+            this_thread::sleep_for(chrono::milliseconds(1));
+            Galaxy::finishLoadingForms();
+        }
+    }
+    cout << galaxies.size() << " galaxies, forms ready after "
+         << fixed << setprecision(1) << timer.getTime() * 1000.0 << " ms\n";
+
+    mt19937 rng(1);
+    uniform_real_distribution<float> angle(0.0f, 2.0f * (float) PI);
+    uniform_real_distribution<float> height(-1.0f, 1.0f);
+    vector<View, aligned_allocator<View>> views;
+    for (Galaxy* galaxy : galaxies)
+    {
+        for (float distance : Distances)
+        {
+            for (int i = 0; i < viewsPerGalaxy; i++)
+            {
+                float phi = angle(rng);
+                float z = height(rng);
+                float r = sqrt(1.0f - z * z);
+                Vector3f direction(r * cos(phi), r * sin(phi), z);
+                Quaternionf orientation = Quaternionf::FromTwoVectors(-Vector3f::UnitZ(), direction);
+                views.push_back({ galaxy, direction * galaxy->getRadius() * distance, orientation });
+            }
+        }
+    }
+
+    float pixelSize = 2.0f * tan(FOV / 2.0f) / WINDOW_HEIGHT;
+
+    // Only the parameters of the shader are computed
+    size_t nDrawn = 0, nBlobsDrawn = 0;
+    double newTime = 0.0;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        nDrawn = nBlobsDrawn = 0;
+        timer.reset();
+        for (const View& view : views)
+        {
+            GalaxyDrawParams params;
+            if (view.galaxy->getDrawParams(view.offset, view.orientation, 1.0f, pixelSize, params))
+            {
+                nDrawn++;
+                nBlobsDrawn += params.nBlobs;
+            }
+        }
+        newTime += timer.getTime();
+    }
+
+    // The vertices of every blob are built
+    vector<OldGalaxyVertex, aligned_allocator<OldGalaxyVertex>> vertices;
+    vertices.reserve(4096 / sizeof(OldGalaxyVertex));
+    vector<short> indices;
+    indices.reserve(4096 / sizeof(OldGalaxyVertex) / 4 * 6);
+    size_t nOldBlobsDrawn = 0;
+    double oldTime = 0.0;
+    for (int r = 0; r < REPEATS; r++)
+    {
+        nOldBlobsDrawn = 0;
+        timer.reset();
+        for (const View& view : views)
+        {
+            GalaxyDrawParams params;
+            if (!view.galaxy->getDrawParams(view.offset, view.orientation, 1.0f, pixelSize, params))
+                continue;
+
+            float distanceToDSO = max(view.offset.norm() - view.galaxy->getRadius(), 0.0f);
+            auto nPoints = (unsigned int) (params.form->blobs.size() * clamp(view.galaxy->getDetail()));
+            nOldBlobsDrawn += buildVerticesOld(params, view.offset, pixelSize * distanceToDSO,
+                                               nPoints, vertices, indices);
+        }
+        oldTime += timer.getTime();
+    }
+
+    size_t nViews = views.size() * REPEATS;
+    cout << views.size() << " views, " << nDrawn << " drawn, "
+         << nBlobsDrawn / max(nDrawn, (size_t) 1) << " blobs per galaxy drawn, "
+         << nOldBlobsDrawn / max(nDrawn, (size_t) 1) << " of them visible\n\n";
+    cout << setw(20) << left << "per galaxy (us)" << right << setw(10) << "mean" << '\n';
+    cout << setw(20) << left << "shader parameters" << right << fixed << setprecision(3)
+         << setw(10) << newTime * 1.0e6 / nViews << '\n';
+    cout << setw(20) << left << "blob vertices" << right << fixed << setprecision(3)
+         << setw(10) << oldTime * 1.0e6 / nViews << '\n';
+
+    return 0;
+}
@@ -0,0 +1,236 @@
+// renderlists_bench.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Measure the CPU side of rendering a frame without an OpenGL context:
+// building the render, orbit and label lists of the nearby solar systems,
+// and finding the visible stars and deep sky objects. The observer follows
+// a scripted path around a few solar system bodies, a nearby star and
+// two galaxies.
+//
+// Usage: renderlists [config file] [frames per target]
+// The catalogs are loaded relative to the current directory, so it should
+// be run from the Celestia data directory.
+
+#include <celestia/celestiacore.h>
+#include <celengine/astro.h>
+#include <celmath/geomutil.h>
+#include <celutil/timer.h>
+#include <algorithm>
+#include <iomanip>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <string>
+#include <vector>
+
+using namespace Eigen;
+using namespace std;
+using namespace celmath;
+
+static const int    WINDOW_WIDTH  = 1920;
+static const int    WINDOW_HEIGHT = 1080;
+static const double START_TIME    = astro::J2000;
+
+
+// A target of the camera path: the observer circles around it at a
+// distance given in units of the object radius.
+struct Target
+{
+    const char* path;
+    double      distance;
+};
+
+static const Target CameraPath[] =
+{
+    { "Sol/Earth",        4.0 },
+    { "Sol/Earth/Moon",   6.0 },
+    { "Sol/Jupiter",     30.0 },
+    { "Sol/Saturn",      12.0 },
+    { "Sol",           1.0e4 },
+    { "Sirius",        1.0e6 },
+    { "M 31",            3.0 },
+    { "Milky Way",       2.5 },
+};
+
+
+class CountingStarHandler : public StarHandler
+{
+ public:
+    void process(const Star& /*star*/, float /*distance*/, float /*appMag*/) override
+    {
+        ++nProcessed;
+    }
+
+    size_t nProcessed{ 0 };
+};
+
+class CountingDSOHandler : public DSOHandler
+{
+ public:
+    void process(DeepSkyObject* const & /*dso*/, double /*distance*/, float /*appMag*/) override
+    {
+        ++nProcessed;
+    }
+
+    size_t nProcessed{ 0 };
+};
+
+
+// Frame times of a stage, in milliseconds
+struct StageTimes
+{
+    const char*    name;
+    vector<double> times;
+};
+
+static void printStage(StageTimes& stage)
+{
+    vector<double>& t = stage.times;
+    sort(t.begin(), t.end());
+    auto percentile = [&t](double p) { return t[min(t.size() - 1, (size_t) (p * t.size()))]; };
+
+    double total = 0.0;
+    for (double x : t)
+        total += x;
+
+    cout << setw(14) << left << stage.name << right << fixed << setprecision(3)
+         << setw(10) << total / t.size()
+         << setw(10) << percentile(0.5)
+         << setw(10) << percentile(0.9)
+         << setw(10) << percentile(0.99)
+         << setw(10) << t.back() << '\n';
+}
+
+
+int main(int argc, char* argv[])
+{
+    string configFile   = argc > 1 ? argv[1] : "celestia.cfg";
+    int framesPerTarget = argc > 2 ? atoi(argv[2]) : 100;
+    if (framesPerTarget <= 0)
+    {
+        cerr << "Usage: renderlists [config file] [frames per target]\n";
+        return 1;
+    }
+
+    CelestiaCore appCore;
+    if (!appCore.initSimulation(configFile, {}, nullptr))
+    {
+        cerr << "Error loading the catalogs with " << configFile << '\n';
+        return 1;
+    }
+
+    Simulation* sim = appCore.getSimulation();
+    Renderer* renderer = appCore.getRenderer();
+    const Universe& universe = *sim->getUniverse();
+    const StarDatabase& starDB = *universe.getStarCatalog();
+    const DSODatabase& dsoDB = *universe.getDSOCatalog();
+
+    renderer->resize(WINDOW_WIDTH, WINDOW_HEIGHT);
+    renderer->setRenderFlags(Renderer::DefaultRenderFlags | Renderer::ShowOrbits);
+    renderer->setLabelMode(Renderer::BodyLabelMask);
+    renderer->setOrbitMask(Body::Planet | Body::DwarfPlanet | Body::Moon | Body::Stellar);
+
+    Observer& observer = *sim->getActiveObserver();
+    float aspectRatio = (float) WINDOW_WIDTH / (float) WINDOW_HEIGHT;
+
+    StageTimes renderLists { "render lists", {} };
+    StageTimes orbitLists  { "orbit lists",  {} };
+    StageTimes labelLists  { "label lists",  {} };
+    StageTimes stars       { "stars",        {} };
+    StageTimes dsos        { "DSOs",         {} };
+    StageTimes total       { "total",        {} };
+    size_t nRenderListEntries = 0, nOrbitPaths = 0, nLabels = 0;
+    size_t nStars = 0, nStarsExamined = 0, nStarNodes = 0;
+    size_t nDSOs = 0, nDSOsExamined = 0, nDSONodes = 0;
+    int nFrames = 0;
+
+    for (const auto& target : CameraPath)
+    {
+        Selection sel = sim->findObjectFromPath(target.path);
+        if (sel.empty())
+        {
+            cerr << "Object " << target.path << " not found, skipping\n";
+            continue;
+        }
+
+        for (int i = 0; i < framesPerTarget; i++, nFrames++)
+        {
+            double now = START_TIME + nFrames / 1440.0;
+            sim->setTime(now);
+
+            double angle = 2.0 * PI * i / framesPerTarget;
+            Vector3d offset = Vector3d(cos(angle), 0.3, sin(angle)).normalized() * sel.radius() * target.distance;
+            UniversalCoord center = sel.getPosition(now);
+            observer.setPosition(center.offsetKm(offset));
+            observer.setOrientation(LookAt<double>(Vector3d::Zero(), -offset, Vector3d::UnitY()));
+            float faintestMag = sim->getFaintestVisible();
+
+            Timer frameTimer;
+            Renderer::FrameListStats listStats;
+            renderer->buildFrameLists(observer, universe, faintestMag, sel, &listStats);
+            renderLists.times.push_back(listStats.renderListTime * 1000.0);
+            orbitLists.times.push_back(listStats.orbitListTime * 1000.0);
+            labelLists.times.push_back(listStats.labelListTime * 1000.0);
+            nRenderListEntries += listStats.nRenderListEntries;
+            nOrbitPaths += listStats.nOrbitPaths;
+            nLabels += listStats.nLabels;
+
+            Vector3d obsPos = observer.getPosition().toLy();
+            float fovY = observer.getFOV();
+
+            Timer timer;
+            CountingStarHandler starHandler;
+            OctreeProcStats starStats;
+            starDB.findVisibleStars(starHandler, obsPos.cast<float>(), observer.getOrientationf(),
+                                    fovY, aspectRatio, faintestMag, &starStats);
+            stars.times.push_back(timer.getTime() * 1000.0);
+            nStars += starHandler.nProcessed;
+            nStarsExamined += starStats.objects;
+            nStarNodes += starStats.nodes;
+
+            timer.reset();
+            CountingDSOHandler dsoHandler;
+            OctreeProcStats dsoStats;
+            dsoDB.findVisibleDSOs(dsoHandler, obsPos, observer.getOrientationf(),
+                                  fovY, aspectRatio, 2 * faintestMag, &dsoStats);
+            dsos.times.push_back(timer.getTime() * 1000.0);
+            nDSOs += dsoHandler.nProcessed;
+            nDSOsExamined += dsoStats.objects;
+            nDSONodes += dsoStats.nodes;
+
+            total.times.push_back(frameTimer.getTime() * 1000.0);
+        }
+    }
+
+    if (nFrames == 0)
+    {
+        cerr << "No frames rendered\n";
+        return 1;
+    }
+
+    cout << nFrames << " frames\n\n";
+    cout << setw(14) << left << "stage (ms)" << right
+         << setw(10) << "mean" << setw(10) << "p50" << setw(10) << "p90"
+         << setw(10) << "p99" << setw(10) << "max" << '\n';
+    for (StageTimes* stage : { &renderLists, &orbitLists, &labelLists, &stars, &dsos, &total })
+        printStage(*stage);
+
+    cout << "\nper frame:\n"
+         << "  render list entries " << nRenderListEntries / nFrames << '\n'
+         << "  orbit paths         " << nOrbitPaths / nFrames << '\n'
+         << "  labels              " << nLabels / nFrames << '\n'
+         << "  stars               " << nStars / nFrames << " visible, "
+         << nStarsExamined / nFrames << " examined, "
+         << nStarNodes / nFrames << " nodes\n"
+         << "  DSOs                " << nDSOs / nFrames << " visible, "
+         << nDSOsExamined / nFrames << " examined, "
+         << nDSONodes / nFrames << " nodes\n";
+
+    return 0;
+}
@@ -0,0 +1,188 @@
+// starcull_bench.cpp
+//
+// Copyright (C) 2020, the Celestia Development Team
+//
+// This program is free software; you can redistribute it and/or
+// modify it under the terms of the GNU General Public License
+// as published by the Free Software Foundation; either version 2
+// of the License, or (at your option) any later version.
+//
+// Compare the visible star traversal, which culls the stars of a node
+// using the packed star data kept by the octree, with a traversal
+// testing the Star objects one at a time.
+//
+// Usage: starcull [star database] [limiting magnitude]
+
+#include <celengine/stardb.h>
+#include <celengine/astro.h>
+#include <celutil/timer.h>
+#include <fstream>
+#include <iostream>
+#include <cstdlib>
+#include <cmath>
+#include <vector>
+
+using namespace Eigen;
+using namespace std;
+
+static const float STAR_OCTREE_ROOT_SIZE = 1000000000.0f;
+static const float MAX_STAR_ORBIT_RADIUS = 1.0f;
+static const int   FRAMES                = 200;
+static const int   REPEATS               = 10;
+
+
+class CountingStarHandler : public StarHandler
+{
+ public:
+    void process(const Star& /*star*/, float /*distance*/, float /*appMag*/) override
+    {
+        ++nProcessed;
+    }
+
+    size_t nProcessed{ 0 };
+};
+
+
+// The per star loop of the traversal before the packed star data was
+// introduced.
+static void processNodeAoS(const StarOctree::Node& node,
+                           const vector<StarOctree::Node>& nodes,
+                           const Star* stars,
+                           StarHandler& processor,
+                           const Vector3f& obsPosition,
+                           const OctreeFrustum<float>& frustum,
+                           float limitingFactor,
+                           float scale,
+                           size_t& nExamined)
+{
+    if (frustum.cullsNode(node.cellCenterPos, scale))
+        return;
+
+    float minDistance = (obsPosition - node.cellCenterPos).norm() - scale * (float) sqrt(3.0);
+    float dimmest     = minDistance > 0 ? astro::appToAbsMag(limitingFactor, minDistance) : 1000;
+
+    nExamined += node.nObjects;
+    for (uint32_t i = node.firstObject; i < node.firstObject + node.nObjects; ++i)
+    {
+        const Star& obj = stars[i];
+
+        if (obj.getAbsoluteMagnitude() < dimmest)
+        {
+            float distance    = (obsPosition - obj.getPosition()).norm();
+            float appMag      = astro::absToAppMag(obj.getAbsoluteMagnitude(), distance);
+
+            if (appMag < limitingFactor || (distance < MAX_STAR_ORBIT_RADIUS && obj.getOrbit()))
+                processor.process(obj, distance, appMag);
+        }
+    }
+
+    if (node.firstChild != 0 &&
+        (minDistance <= 0 || astro::absToAppMag(node.exclusionFactor, minDistance) <= limitingFactor))
+    {
+        for (uint32_t i = node.firstChild; i < node.firstChild + 8; ++i)
+        {
+            processNodeAoS(nodes[i], nodes, stars, processor, obsPosition,
+                           frustum, limitingFactor, scale * 0.5f, nExamined);
+        }
+    }
+}
+
+
+// Same frustum as StarDatabase::findVisibleStars()
+static void getFrustumPlanes(Hyperplane<float, 3>* frustumPlanes,
+                             const Vector3f& position,
+                             const Quaternionf& orientation,
+                             float fovY,
+                             float aspectRatio)
+{
+    Matrix3f rot = orientation.toRotationMatrix();
+    float h = (float) tan(fovY / 2);
+    float w = h * aspectRatio;
+
+    Vector3f planeNormals[5];
+    planeNormals[0] = Vector3f(0.0f, 1.0f, -h);
+    planeNormals[1] = Vector3f(0.0f, -1.0f, -h);
+    planeNormals[2] = Vector3f(1.0f, 0.0f, -w);
+    planeNormals[3] = Vector3f(-1.0f, 0.0f, -w);
+    planeNormals[4] = Vector3f(0.0f, 0.0f, -1.0f);
+    for (int i = 0; i < 5; i++)
+    {
+        planeNormals[i] = rot.transpose() * planeNormals[i].normalized();
+        frustumPlanes[i] = Hyperplane<float, 3>(planeNormals[i], position);
+    }
+}
+
+
+static void getView(int frame, Vector3f& position, Quaternionf& orientation)
+{
+    position = Vector3f(frame * 0.3f - 30.0f, frame * 0.05f, frame * -0.1f);
+    orientation = Quaternionf(AngleAxisf(frame * 0.37f, Vector3f(0.3f, 1.0f, 0.2f).normalized()));
+}
+
+
+int main(int argc, char* argv[])
+{
+    const char* starsFile = argc > 1 ? argv[1] : "data/stars.dat";
+    float limitingMag     = argc > 2 ? (float) atof(argv[2]) : 12.0f;
+    const float fovY        = 0.8f;
+    const float aspectRatio = 1.5f;
+
+    StarDatabase starDB;
+    ifstream in(starsFile, ios::in | ios::binary);
+    if (!in.good() || !starDB.loadBinary(in))
+    {
+        cerr << "Error reading star database " << starsFile << '\n';
+        return 1;
+    }
+    starDB.finish();
+
+    const StarOctree* octree = starDB.getOctree();
+    const vector<StarOctree::Node>& nodes = octree->getNodes();
+
+    CountingStarHandler aosHandler;
+    size_t nExamined = 0;
+    Timer timer;
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        Vector3f position;
+        Quaternionf orientation;
+        getView(frame, position, orientation);
+
+        Hyperplane<float, 3> frustumPlanes[5];
+        getFrustumPlanes(frustumPlanes, position, orientation, fovY, aspectRatio);
+        OctreeFrustum<float> frustum(frustumPlanes);
+
+        for (int i = 0; i < REPEATS; i++)
+        {
+            processNodeAoS(nodes[0], nodes, starDB.getStar(0), aosHandler, position,
+                           frustum, limitingMag, STAR_OCTREE_ROOT_SIZE, nExamined);
+        }
+    }
+    double aosTime = timer.getTime();
+
+    CountingStarHandler soaHandler;
+    timer.reset();
+    for (int frame = 0; frame < FRAMES; frame++)
+    {
+        Vector3f position;
+        Quaternionf orientation;
+        getView(frame, position, orientation);
+
+        for (int i = 0; i < REPEATS; i++)
+            starDB.findVisibleStars(soaHandler, position, orientation, fovY, aspectRatio, limitingMag);
+    }
+    double soaTime = timer.getTime();
+
+    // The packed path computes magnitudes with a vectorized logarithm, so
+    // stars right at the limiting magnitude may occasionally differ.
+    cout << starDB.size() << " stars, limiting magnitude " << limitingMag << '\n';
+    cout << nExamined / (FRAMES * REPEATS) << " stars examined per frame, "
+         << aosHandler.nProcessed / (FRAMES * REPEATS) << " (AoS) and "
+         << soaHandler.nProcessed / (FRAMES * REPEATS) << " (SoA) visible\n";
+    cout << "AoS: " << nExamined / aosTime * 1.0e-6 << " Mstars/s, "
+         << aosTime * 1000.0 / (FRAMES * REPEATS) << " ms/frame\n";
+    cout << "SoA: " << nExamined / soaTime * 1.0e-6 << " Mstars/s, "
+         << soaTime * 1000.0 / (FRAMES * REPEATS) << " ms/frame\n";
+
+    return 0;
+}
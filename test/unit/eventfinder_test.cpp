@@ -0,0 +1,131 @@
+#include <cmath>
+#include <mutex>
+#include <set>
+#include <thread>
+#include <vector>
+#include <celestia/eventfinder.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+static const double Precision = 1.0e-6;
+
+TEST_CASE("EventFinder", "[EventFinder]")
+{
+    EventFinder finder(nullptr, 2);
+    finder.setPrecision(Precision);
+    std::vector<EventFinder::Event> events;
+
+    SECTION("Spans below the threshold")
+    {
+        // Below zero over (1.25, 3.75) + 5k
+        EventFinder::Search search;
+        search.function = [](double t) { return std::cos(2.0 * M_PI * t / 5.0); };
+        search.type = EventFinder::BelowThreshold;
+        search.threshold = 0.0;
+        search.maxStep = 0.5;
+        finder.addSearch(search);
+
+        finder.findEvents(0.0, 20.0, events);
+        REQUIRE(events.size() == 4);
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            REQUIRE(std::abs(events[i].startTime - (1.25 + 5.0 * i)) <= 2.0 * Precision);
+            REQUIRE(std::abs(events[i].endTime - (3.75 + 5.0 * i)) <= 2.0 * Precision);
+            REQUIRE(events[i].time == Approx(2.5 + 5.0 * i));
+            REQUIRE(events[i].value == Approx(-1.0));
+        }
+    }
+
+    SECTION("Spans in progress at the start and end")
+    {
+        EventFinder::Search search;
+        search.function = [](double t) { return std::abs(t - 10.0) - 1.0; };
+        search.type = EventFinder::BelowThreshold;
+        search.threshold = 0.0;
+        search.maxStep = 1.0;
+        finder.addSearch(search);
+
+        finder.findEvents(9.5, 10.5, events);
+        REQUIRE(events.size() == 1);
+        REQUIRE(std::abs(events[0].startTime - 9.0) <= 2.0 * Precision);
+        REQUIRE(std::abs(events[0].endTime - 11.0) <= 2.0 * Precision);
+    }
+
+    SECTION("Minima below the threshold")
+    {
+        // Minima of 0.5 at 7 and of 3 at 17, above the threshold
+        EventFinder::Search search;
+        search.function = [](double t) { return t < 12.0 ? (t - 7.0) * (t - 7.0) + 0.5 : (t - 17.0) * (t - 17.0) + 3.0; };
+        search.type = EventFinder::Minimum;
+        search.threshold = 2.0;
+        search.maxStep = 0.25;
+        finder.addSearch(search);
+
+        finder.findEvents(0.0, 20.0, events);
+        REQUIRE(events.size() == 1);
+        REQUIRE(std::abs(events[0].time - 7.0) <= 1.0e-3);
+        REQUIRE(events[0].value == Approx(0.5));
+    }
+
+    SECTION("Events of several searches are sorted by time")
+    {
+        EventFinder::Search first;
+        first.function = [](double t) { return std::abs(t - 8.0) - 0.5; };
+        first.maxStep = 1.0;
+        EventFinder::Search second;
+        second.function = [](double t) { return std::abs(t - 3.0) - 0.5; };
+        second.maxStep = 1.0;
+        finder.addSearch(first);
+        finder.addSearch(second);
+
+        finder.findEvents(0.0, 10.0, events);
+        REQUIRE(events.size() == 2);
+        REQUIRE(events[0].search == 1);
+        REQUIRE(std::abs(events[0].startTime - 2.5) <= 2.0 * Precision);
+        REQUIRE(events[1].search == 0);
+        REQUIRE(std::abs(events[1].startTime - 7.5) <= 2.0 * Precision);
+    }
+
+    SECTION("Searches split in chunks find the events of a single one")
+    {
+        // Spans over (1, 3) + 4k and minima at 2 + 4k, some across or at
+        // the ends of the chunks of [0, 40]
+        std::mutex mutex;
+        std::set<std::thread::id> threads;
+        EventFinder::Search spans;
+        spans.function = [&](double t)
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            threads.insert(std::this_thread::get_id());
+            return std::cos(2.0 * M_PI * t / 4.0);
+        };
+        spans.maxStep = 0.5;
+        EventFinder::Search minima = spans;
+        minima.type = EventFinder::Minimum;
+
+        EventFinder single(nullptr, 1);
+        single.setPrecision(Precision);
+        single.addSearch(spans);
+        single.addSearch(minima);
+        std::vector<EventFinder::Event> expected;
+        single.findEvents(0.0, 40.0, expected);
+        REQUIRE(expected.size() == 20);
+
+        EventFinder chunked(nullptr, 4);
+        chunked.setPrecision(Precision);
+        chunked.addSearch(spans);
+        chunked.addSearch(minima);
+        threads.clear();
+        chunked.findEvents(0.0, 40.0, events);
+        REQUIRE(threads.size() > 1);
+
+        REQUIRE(events.size() == expected.size());
+        for (size_t i = 0; i < events.size(); i++)
+        {
+            REQUIRE(events[i].search == expected[i].search);
+            REQUIRE(std::abs(events[i].startTime - expected[i].startTime) <= 2.0 * Precision);
+            REQUIRE(std::abs(events[i].endTime - expected[i].endTime) <= 2.0 * Precision);
+        }
+    }
+}
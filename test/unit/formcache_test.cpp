@@ -0,0 +1,123 @@
+#include <cstdint>
+#include <cstdio>
+#include <fstream>
+#include <iterator>
+#include <vector>
+#include <celengine/formcache.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+TEST_CASE("FormCache", "[FormCache]")
+{
+    const char* filename = "formcache_test.dat";
+    std::remove(filename);
+
+    FormCache& cache = FormCache::get();
+    std::vector<float> a{ 1.0f, 2.0f, 3.0f };
+    std::vector<float> b{ -0.5f, 255.0f };
+    std::vector<float> values;
+
+    SECTION("Forms are only cached with a file")
+    {
+        cache.setFile("");
+        cache.save("a", 1, a);
+        REQUIRE(!cache.load("a", 1, values));
+    }
+
+    SECTION("Forms are read back with their key")
+    {
+        cache.setFile(filename);
+        cache.save("a", 1, a);
+        cache.save("b", 2, b);
+        cache.save("a", 3, b);
+
+        // Read the file again
+        cache.setFile(filename);
+        REQUIRE(cache.load("b", 2, values));
+        REQUIRE(values == b);
+        REQUIRE(cache.load("a", 3, values));
+        REQUIRE(values == b);
+        REQUIRE(!cache.load("a", 1, values));
+        REQUIRE(!cache.load("c", 1, values));
+    }
+
+    SECTION("A damaged file is written again")
+    {
+        cache.setFile(filename);
+        cache.save("a", 1, a);
+        {
+            std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::app);
+            out.write("xx", 2);
+        }
+
+        cache.setFile(filename);
+        REQUIRE(cache.load("a", 1, values));
+        cache.save("b", 2, b);
+
+        cache.setFile(filename);
+        REQUIRE(cache.load("a", 1, values));
+        REQUIRE(values == a);
+        REQUIRE(cache.load("b", 2, values));
+        REQUIRE(values == b);
+    }
+
+    SECTION("Lengths past the end of the file make it invalid")
+    {
+        // A record claiming a name of 4G characters, then one with as many values
+        const char bigName[] = "CELFORMS\x01\x00\xff\xff\xff\xff";
+        const char bigValues[] = "CELFORMS\x01\x00\x01\x00\x00\x00" "a" "\x01\x00\x00\x00\x00\x00\x00\x00" "\xff\xff\xff\xff";
+        for (const auto& contents : { std::string(bigName, sizeof bigName - 1),
+                                      std::string(bigValues, sizeof bigValues - 1) })
+        {
+            {
+                std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+                out.write(contents.data(), contents.size());
+            }
+
+            cache.setFile(filename);
+            REQUIRE(!cache.load("a", 1, values));
+            cache.save("b", 2, b);
+
+            cache.setFile(filename);
+            REQUIRE(!cache.load("a", 1, values));
+            REQUIRE(cache.load("b", 2, values));
+            REQUIRE(values == b);
+        }
+    }
+
+    SECTION("Files are written again when mostly stale")
+    {
+        cache.setFile(filename);
+        cache.save("b", 2, b);
+        for (uint64_t key = 0; key < 100; key++)
+            cache.save("a", key, a);
+
+        // Header, a record of b and at most about 3 of a
+        std::ifstream in(filename, std::ios::in | std::ios::binary | std::ios::ate);
+        REQUIRE((size_t) in.tellg() <= 10 + 25 + 4 * 29);
+        in.close();
+
+        cache.setFile(filename);
+        REQUIRE(cache.load("a", 99, values));
+        REQUIRE(values == a);
+        REQUIRE(cache.load("b", 2, values));
+        REQUIRE(values == b);
+        REQUIRE(!cache.load("a", 98, values));
+    }
+
+    SECTION("Keys are stored little-endian")
+    {
+        cache.setFile(filename);
+        cache.save("a", UINT64_C(0x0102030405060708), a);
+
+        std::ifstream in(filename, std::ios::in | std::ios::binary);
+        std::vector<char> data((std::istreambuf_iterator<char>(in)), std::istreambuf_iterator<char>());
+        REQUIRE(data.size() == 10 + 29);
+        for (int i = 0; i < 8; i++)
+            REQUIRE(data[10 + 4 + 1 + i] == (char) (8 - i));
+    }
+
+    cache.setFile("");
+    std::remove(filename);
+}
@@ -0,0 +1,262 @@
+#include <cmath>
+#include <cstdint>
+#include <cstdio>
+#include <cstring>
+#include <fstream>
+#include <memory>
+#include <random>
+#include <vector>
+#include <celephem/jpleph.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace Eigen;
+
+// A small ephemeris in the layout of DE405, written big-endian, with random
+// Chebyshev coefficients. The positions it gives are computed directly from
+// the coefficients to check those of JPLEphemeris.
+class SyntheticEphemeris
+{
+ public:
+    static const unsigned int RecordSize = 1018;
+    static const unsigned int NRecords = 4;
+    static const unsigned int NItems = 13; // with nutations
+
+    SyntheticEphemeris()
+    {
+        unsigned int offset = 3;
+        for (unsigned int i = 0; i < NItems; i++)
+        {
+            info[i].offset = offset;
+            info[i].nCoeffs = 5 + i % 3;
+            info[i].nGranules = 1 << (i % 3);
+            offset += info[i].nCoeffs * 3 * info[i].nGranules;
+        }
+
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<double> coeff(-1.0, 1.0);
+        records.resize(NRecords * RecordSize);
+        for (unsigned int r = 0; r < NRecords; r++)
+        {
+            double* record = &records[r * RecordSize];
+            record[0] = startDate + r * daysPerInterval;
+            record[1] = record[0] + daysPerInterval;
+            for (unsigned int j = 2; j < RecordSize; j++)
+                record[j] = coeff(rng) * 1.0e8 / (double) (j % 8 + 1);
+        }
+    }
+
+    double getEndDate() const { return startDate + NRecords * daysPerInterval; }
+
+    // Position of an item stored in the ephemeris at t inside its span
+    Vector3d position(JPLEphemItem item, double t) const
+    {
+        if (item == JPLEph_SSB)
+            return Vector3d::Zero();
+        if (item == JPLEph_Earth)
+            return position(JPLEph_EarthMoonBary, t) - position(JPLEph_Moon, t) / (earthMoonMassRatio + 1.0);
+
+        auto r = std::min((unsigned int) ((t - startDate) / daysPerInterval), NRecords - 1);
+        const double* record = &records[r * RecordSize];
+        const Info& itemInfo = info[item];
+        double granuleLength = daysPerInterval / itemInfo.nGranules;
+        auto g = std::min((unsigned int) ((t - record[0]) / granuleLength), itemInfo.nGranules - 1);
+        double u = 2.0 * (t - (record[0] + g * granuleLength)) / granuleLength - 1.0;
+
+        const double* c = record + itemInfo.offset - 1 + g * itemInfo.nCoeffs * 3;
+        Vector3d pos = Vector3d::Zero();
+        for (unsigned int j = 0; j < itemInfo.nCoeffs; j++)
+        {
+            double T = std::cos(j * std::acos(std::max(-1.0, std::min(u, 1.0))));
+            for (int k = 0; k < 3; k++)
+                pos[k] += c[k * itemInfo.nCoeffs + j] * T;
+        }
+        return pos;
+    }
+
+    void write(const char* filename) const
+    {
+        std::vector<char> data((NRecords + 2) * RecordSize * sizeof(double), 0);
+        char* p = data.data() + 84 * 3 + 400 * 6;
+        putDouble(p, startDate);
+        putDouble(p, getEndDate());
+        putDouble(p, daysPerInterval);
+        putUint(p, 0);
+        putDouble(p, 149597870.691);
+        putDouble(p, earthMoonMassRatio);
+        for (unsigned int i = 0; i < NItems - 1; i++)
+        {
+            putUint(p, info[i].offset);
+            putUint(p, info[i].nCoeffs);
+            putUint(p, info[i].nGranules);
+        }
+        putUint(p, 405);
+        const Info& nutations = info[NItems - 1];
+        putUint(p, nutations.offset);
+        putUint(p, nutations.nCoeffs);
+        putUint(p, nutations.nGranules);
+
+        p = data.data() + 2 * RecordSize * sizeof(double);
+        for (double d : records)
+            putDouble(p, d);
+
+        std::ofstream out(filename, std::ios::out | std::ios::binary);
+        out.write(data.data(), data.size());
+    }
+
+    struct Info
+    {
+        unsigned int offset;
+        unsigned int nCoeffs;
+        unsigned int nGranules;
+    };
+
+    Info info[NItems];
+    std::vector<double> records;
+    double startDate{ 2451536.5 };
+    double daysPerInterval{ 32.0 };
+    double earthMoonMassRatio{ 81.30056 };
+
+ private:
+    static void putUint(char*& p, uint32_t u)
+    {
+        for (int i = 3; i >= 0; i--)
+            *p++ = (char) ((u >> (i * 8)) & 0xff);
+    }
+
+    static void putDouble(char*& p, double d)
+    {
+        uint64_t u;
+        std::memcpy(&u, &d, sizeof(double));
+        for (int i = 7; i >= 0; i--)
+            *p++ = (char) ((u >> (i * 8)) & 0xff);
+    }
+};
+
+
+static void requireClose(const Vector3d& a, const Vector3d& b)
+{
+    REQUIRE((a - b).norm() <= 1.0e-6 * b.norm() + 1.0e-6);
+}
+
+
+TEST_CASE("JPLEphemeris", "[JPLEphemeris]")
+{
+    const char* filename = "jpleph_test.dat";
+    SyntheticEphemeris synthetic;
+
+    const JPLEphemItem items[] =
+    {
+        JPLEph_Mercury, JPLEph_Venus, JPLEph_EarthMoonBary, JPLEph_Mars,
+        JPLEph_Jupiter, JPLEph_Saturn, JPLEph_Uranus, JPLEph_Neptune,
+        JPLEph_Pluto, JPLEph_Moon, JPLEph_Sun, JPLEph_Earth, JPLEph_SSB
+    };
+    const size_t nItems = sizeof(items) / sizeof(items[0]);
+
+    // Times within granules and at the ends of the granules and records
+    std::vector<double> times;
+    for (double t = synthetic.startDate; t < synthetic.getEndDate(); t += 1.375)
+        times.push_back(t);
+    for (unsigned int r = 1; r < SyntheticEphemeris::NRecords; r++)
+        times.push_back(synthetic.startDate + r * synthetic.daysPerInterval);
+    times.push_back(synthetic.startDate + synthetic.daysPerInterval * 0.5);
+    times.push_back(synthetic.getEndDate());
+
+    SECTION("Positions are those of the Chebyshev series")
+    {
+        synthetic.write(filename);
+        std::unique_ptr<JPLEphemeris> eph(JPLEphemeris::load(filename));
+        REQUIRE(eph != nullptr);
+        REQUIRE(eph->getDENumber() == 405);
+        REQUIRE(eph->getStartDate() == synthetic.startDate);
+        REQUIRE(eph->getEndDate() == synthetic.getEndDate());
+
+        for (double t : times)
+        {
+            for (JPLEphemItem item : items)
+                requireClose(eph->getPlanetPosition(item, t), synthetic.position(item, t));
+        }
+    }
+
+    SECTION("Batches give the positions of single items and times")
+    {
+        synthetic.write(filename);
+        std::unique_ptr<JPLEphemeris> eph(JPLEphemeris::load(filename));
+        REQUIRE(eph != nullptr);
+
+        std::vector<Vector3d> positions(std::max(times.size(), nItems));
+        for (double t : times)
+        {
+            eph->getPlanetPositions(t, celestia::compat::span<const JPLEphemItem>(items, nItems),
+                                    celestia::compat::span<Vector3d>(positions.data(), nItems));
+            for (size_t i = 0; i < nItems; i++)
+                REQUIRE(positions[i] == eph->getPlanetPosition(items[i], t));
+        }
+
+        for (JPLEphemItem item : items)
+        {
+            eph->getPlanetPositions(item, times,
+                                    celestia::compat::span<Vector3d>(positions.data(), times.size()));
+            for (size_t i = 0; i < times.size(); i++)
+                REQUIRE(positions[i] == eph->getPlanetPosition(item, times[i]));
+        }
+    }
+
+    SECTION("Times at and beyond the end use the last granule")
+    {
+        synthetic.write(filename);
+        std::unique_ptr<JPLEphemeris> eph(JPLEphemeris::load(filename));
+        REQUIRE(eph != nullptr);
+
+        double endDate = synthetic.getEndDate();
+        for (JPLEphemItem item : items)
+        {
+            Vector3d end = synthetic.position(item, endDate);
+            requireClose(eph->getPlanetPosition(item, endDate), end);
+            REQUIRE(eph->getPlanetPosition(item, endDate + 100.0) == eph->getPlanetPosition(item, endDate));
+            REQUIRE(eph->getPlanetPosition(item, synthetic.startDate - 100.0) ==
+                    eph->getPlanetPosition(item, synthetic.startDate));
+        }
+    }
+
+    SECTION("Files with coefficients outside the records are rejected")
+    {
+        SyntheticEphemeris::Info& mars = synthetic.info[JPLEph_Mars];
+
+        // One coefficient past the end of the records
+        mars.offset = SyntheticEphemeris::RecordSize + 2 - mars.nCoeffs * 3 * mars.nGranules;
+        synthetic.write(filename);
+        REQUIRE(JPLEphemeris::load(filename) == nullptr);
+
+        mars.offset = 4;
+        synthetic.write(filename);
+        REQUIRE(JPLEphemeris::load(filename) == nullptr);
+
+        mars.offset = 3;
+        mars.nCoeffs = 0;
+        synthetic.write(filename);
+        REQUIRE(JPLEphemeris::load(filename) == nullptr);
+
+        mars.nCoeffs = 5;
+        mars.nGranules = 1000;
+        synthetic.write(filename);
+        REQUIRE(JPLEphemeris::load(filename) == nullptr);
+    }
+
+    SECTION("Files shorter than their records are rejected")
+    {
+        synthetic.write(filename);
+        std::vector<char> data;
+        {
+            std::ifstream in(filename, std::ios::in | std::ios::binary);
+            data.assign(std::istreambuf_iterator<char>(in), std::istreambuf_iterator<char>());
+        }
+        std::ofstream out(filename, std::ios::out | std::ios::binary | std::ios::trunc);
+        out.write(data.data(), data.size() - 8);
+        out.close();
+        REQUIRE(JPLEphemeris::load(filename) == nullptr);
+    }
+
+    std::remove(filename);
+}
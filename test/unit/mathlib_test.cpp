@@ -0,0 +1,36 @@
+#include <cmath>
+#include <random>
+#include <celmath/mathlib.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace celmath;
+
+TEST_CASE("branchlessCos", "[mathlib]")
+{
+    SECTION("Exact at multiples of pi/2")
+    {
+        REQUIRE(branchlessCos(0.0) == 1.0);
+        REQUIRE(std::abs(branchlessCos(PI / 2.0)) < 1.0e-16);
+        REQUIRE(branchlessCos(PI) == -1.0);
+        REQUIRE(branchlessCos(-PI) == -1.0);
+        REQUIRE(branchlessCos(2.0 * PI) == 1.0);
+    }
+
+    SECTION("Matches std::cos over its accurate range")
+    {
+        std::mt19937_64 rng(1);
+        for (double limit : { 1.0, 1.0e3, 1.0e6, 6.5e6 })
+        {
+            std::uniform_real_distribution<double> angle(-limit, limit);
+            double maxError = 0.0;
+            for (int i = 0; i < 100000; i++)
+            {
+                double x = angle(rng);
+                maxError = std::max(maxError, std::abs(branchlessCos(x) - std::cos(x)));
+            }
+            REQUIRE(maxError < 3.0e-16 + 1.5e-21 * limit);
+        }
+    }
+}
@@ -0,0 +1,229 @@
+#include <cstring>
+#include <random>
+#include <thread>
+#include <vector>
+#include <celmodel/mesh.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace Eigen;
+using namespace cmod;
+
+struct Triangle
+{
+    Vector3d v0, v1, v2;
+};
+
+// The ray triangle test of the mesh before it had a hierarchy
+static bool intersectTriangle(const Triangle& tri,
+                              const Vector3d& origin,
+                              const Vector3d& direction,
+                              double& distance)
+{
+    Vector3d e0 = tri.v1 - tri.v0;
+    Vector3d e1 = tri.v2 - tri.v0;
+    Vector3d n = e0.cross(e1);
+    double c = n.dot(direction);
+    if (c == 0.0)
+        return false;
+
+    double t = n.dot(tri.v0 - origin) / c;
+    if (!(t > 0.0))
+        return false;
+
+    double m00 = e0.dot(e0);
+    double m01 = e0.dot(e1);
+    double m11 = e1.dot(e1);
+    double det = m00 * m11 - m01 * m01;
+    if (det == 0.0)
+        return false;
+
+    Vector3d q = origin + direction * t - tri.v0;
+    double q0 = e0.dot(q);
+    double q1 = e1.dot(q);
+    double s0 = (m11 * q0 - m01 * q1) / det;
+    double s1 = (m00 * q1 - m01 * q0) / det;
+    if (s0 >= 0.0 && s1 >= 0.0 && s0 + s1 <= 1.0)
+    {
+        distance = t;
+        return true;
+    }
+    return false;
+}
+
+// A mesh of random triangles in the unit cube, in a triangle list group
+// followed by a triangle strip group
+class RandomMesh
+{
+ public:
+    explicit RandomMesh(unsigned int nTriangles)
+    {
+        std::mt19937 rng(1);
+        std::uniform_real_distribution<float> coord(-1.0f, 1.0f);
+        std::uniform_real_distribution<float> offset(-0.1f, 0.1f);
+
+        unsigned int nVertices = nTriangles * 3;
+        auto* vertices = new char[nVertices * 3 * sizeof(float)];
+        auto* positions = reinterpret_cast<float*>(vertices);
+        for (unsigned int i = 0; i < nVertices; i += 3)
+        {
+            // Small triangles, so that the hierarchy culls most of them
+            Vector3f center(coord(rng), coord(rng), coord(rng));
+            for (unsigned int j = 0; j < 3; j++)
+            {
+                Vector3f v = center + Vector3f(offset(rng), offset(rng), offset(rng));
+                std::memcpy(positions + (i + j) * 3, v.data(), sizeof(float) * 3);
+            }
+        }
+
+        Mesh::VertexAttribute attribute(Mesh::Position, Mesh::Float3, 0);
+        mesh.setVertexDescription(Mesh::VertexDescription(3 * sizeof(float), 1, &attribute));
+        mesh.setVertices(nVertices, vertices);
+
+        unsigned int nListVertices = nVertices / 2 / 3 * 3;
+        for (unsigned int i = 0; i < nListVertices; i++)
+            listIndices.push_back(i);
+        for (unsigned int i = nListVertices; i < nVertices; i++)
+            stripIndices.push_back(i);
+        mesh.addGroup(Mesh::TriList, 0, listIndices.size(), listIndices.data());
+        mesh.addGroup(Mesh::TriStrip, 0, stripIndices.size(), stripIndices.data());
+
+        auto vertex = [positions](Mesh::index32 i)
+        {
+            return Map<const Vector3f>(positions + i * 3).cast<double>().eval();
+        };
+        for (size_t i = 0; i < listIndices.size(); i += 3)
+            triangles.push_back({ vertex(listIndices[i]), vertex(listIndices[i + 1]), vertex(listIndices[i + 2]) });
+        for (size_t i = 2; i < stripIndices.size(); i++)
+            triangles.push_back({ vertex(stripIndices[i - 2]), vertex(stripIndices[i - 1]), vertex(stripIndices[i]) });
+    }
+
+    // Test every triangle, returning the index of the closest one hit
+    bool pick(const Vector3d& origin, const Vector3d& direction, size_t& index, double& distance) const
+    {
+        bool hit = false;
+        for (size_t i = 0; i < triangles.size(); i++)
+        {
+            double t;
+            if (intersectTriangle(triangles[i], origin, direction, t) && (!hit || t < distance))
+            {
+                hit = true;
+                index = i;
+                distance = t;
+            }
+        }
+        return hit;
+    }
+
+    // Index of the triangle in triangles. In strips, the mesh counts two
+    // degenerate triangles after the first one, as picking always has.
+    size_t triangleIndex(const Mesh::PickResult& result) const
+    {
+        if (result.group == mesh.getGroup(0))
+            return result.primitiveIndex;
+        size_t stripIndex = result.primitiveIndex == 0 ? 0 : result.primitiveIndex - 2;
+        return listIndices.size() / 3 + stripIndex;
+    }
+
+    std::vector<Mesh::index32> listIndices;
+    std::vector<Mesh::index32> stripIndices;
+    std::vector<Triangle> triangles;
+    Mesh mesh;
+};
+
+struct Ray
+{
+    Vector3d origin;
+    Vector3d direction;
+};
+
+static std::vector<Ray> randomRays(unsigned int nRays)
+{
+    std::mt19937 rng(2);
+    std::uniform_real_distribution<double> coord(-1.5, 1.5);
+    std::vector<Ray> rays;
+    for (unsigned int i = 0; i < nRays; i++)
+    {
+        // Rays from inside and around the mesh, through points inside it
+        Vector3d origin(coord(rng), coord(rng), coord(rng));
+        Vector3d target(coord(rng) * 0.5, coord(rng) * 0.5, coord(rng) * 0.5);
+        rays.push_back({ origin, target - origin });
+    }
+    return rays;
+}
+
+TEST_CASE("MeshBVH", "[MeshBVH]")
+{
+    RandomMesh random(2000);
+    std::vector<Ray> rays = randomRays(2000);
+
+    SECTION("Picking finds the closest triangle hit")
+    {
+        unsigned int nHits = 0;
+        for (const auto& ray : rays)
+        {
+            size_t index = 0;
+            double distance = 0.0;
+            bool hit = random.pick(ray.origin, ray.direction, index, distance);
+
+            Mesh::PickResult result;
+            REQUIRE(random.mesh.pick(ray.origin, ray.direction, &result) == hit);
+            if (hit)
+            {
+                REQUIRE(random.triangleIndex(result) == index);
+                REQUIRE(result.distance == Approx(distance));
+                nHits++;
+            }
+        }
+
+        // Most rays hit a triangle, but not all
+        REQUIRE(nHits > rays.size() / 2);
+        REQUIRE(nHits < rays.size());
+    }
+
+    SECTION("Rays pointing away from the mesh miss it")
+    {
+        Mesh::PickResult result;
+        REQUIRE(!random.mesh.pick(Vector3d(0.0, 0.0, 5.0), Vector3d(0.0, 0.0, 1.0), &result));
+        REQUIRE(!random.mesh.pick(Vector3d(5.0, 5.0, 5.0), Vector3d(1.0, -1.0, 0.0), &result));
+    }
+
+    SECTION("The hierarchy is built once for concurrent picks")
+    {
+        const unsigned int nThreads = 4;
+        std::vector<std::vector<double>> distances(nThreads);
+        std::vector<std::thread> threads;
+        for (unsigned int i = 0; i < nThreads; i++)
+        {
+            threads.emplace_back([&random, &rays, &distances, i]()
+            {
+                for (const auto& ray : rays)
+                {
+                    double distance = -1.0;
+                    random.mesh.pick(ray.origin, ray.direction, distance);
+                    distances[i].push_back(distance);
+                }
+            });
+        }
+        for (auto& thread : threads)
+            thread.join();
+
+        for (unsigned int i = 1; i < nThreads; i++)
+            REQUIRE(distances[i] == distances[0]);
+    }
+
+    SECTION("The hierarchy follows changes of the mesh")
+    {
+        const Ray& ray = rays.front();
+        double before = -1.0;
+        random.mesh.pick(ray.origin, ray.direction, before);
+
+        random.mesh.transform(Vector3f::Zero(), 2.0f);
+        double after = -1.0;
+        bool hit = random.mesh.pick(ray.origin * 2.0, ray.direction, after);
+        REQUIRE(hit == (before > 0.0));
+        if (hit)
+            REQUIRE(after == Approx(before * 2.0));
+    }
+}
@@ -0,0 +1,123 @@
+#include <celengine/name.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+TEST_CASE("NameDatabase", "[NameDatabase]")
+{
+    NameDatabase db;
+    db.add(1, "Sirius");
+    db.add(2, "Sirrah");
+    db.add(3, "Sol");
+    db.add(4, "Sirius B");
+    db.add(5, "ALF Cen");
+    db.add(6, "Ächernar");
+
+    SECTION("Completion ignores case")
+    {
+        auto completion = db.getCompletion("sir", false);
+        REQUIRE(completion.size() == 3);
+        REQUIRE(completion[0] == "Sirius");
+        REQUIRE(completion[1] == "Sirrah");
+        REQUIRE(completion[2] == "Sirius B");
+    }
+
+    SECTION("Completion of non-ASCII names")
+    {
+        auto completion = db.getCompletion("ä", false);
+        REQUIRE(completion.size() == 1);
+        REQUIRE(completion[0] == "Ächernar");
+    }
+
+    SECTION("Completion with Greek letters")
+    {
+        auto completion = db.getCompletion("alpha c");
+        REQUIRE(completion.size() == 1);
+        REQUIRE(completion[0] == ReplaceGreekLetterAbbr("ALF Cen"));
+    }
+
+    SECTION("Completion is limited to the shortest names")
+    {
+        auto completion = db.getCompletion("S", false, 2);
+        REQUIRE(completion.size() == 2);
+        REQUIRE(completion[0] == "Sol");
+        REQUIRE(completion[1] == "Sirius");
+    }
+
+    SECTION("Names added after a completion are found")
+    {
+        REQUIRE(db.getCompletion("Vega", false).empty());
+        db.add(7, "Vega");
+        REQUIRE(db.getCompletion("vEGA", false).size() == 1);
+    }
+}
+
+TEST_CASE("NameDatabase lookups", "[NameDatabase]")
+{
+    NameDatabase db;
+    db.add(3, "Sol");
+    db.add(1, "Sirius");
+    db.add(2, "Sirrah");
+    db.add(1, "ALF CMa");
+    db.add(1, "Dog Star");
+
+    SECTION("Names are found ignoring case")
+    {
+        AstroCatalog::IndexNumber notFound = AstroCatalog::InvalidIndex;
+        REQUIRE(db.getCatalogNumberByName("sirius") == 1);
+        REQUIRE(db.getCatalogNumberByName("SIRRAH") == 2);
+        REQUIRE(db.getCatalogNumberByName("dog star") == 1);
+        REQUIRE(db.getCatalogNumberByName("Siriu") == notFound);
+        REQUIRE(db.getCatalogNumberByName("Vega") == notFound);
+    }
+
+    SECTION("Names are found with Greek letters spelt out")
+    {
+        REQUIRE(db.getCatalogNumberByName("ALF CMa") == 1);
+        REQUIRE(db.getCatalogNumberByName("Alpha CMa") == 1);
+    }
+
+    SECTION("Names are found in catalog number order")
+    {
+        std::vector<AstroCatalog::IndexNumber> numbers;
+        std::vector<std::string> names;
+        for (auto iter = db.getFirstNameIter(1); iter != db.getFinalNameIter(); ++iter)
+        {
+            numbers.push_back(iter->catalogNumber);
+            names.push_back(db.getName(*iter));
+        }
+        REQUIRE(numbers == std::vector<AstroCatalog::IndexNumber>{ 1, 1, 1, 2, 3 });
+
+        // The names of an object are kept in the order they were added
+        REQUIRE(names[0] == "Sirius");
+        REQUIRE(names[1] == ReplaceGreekLetterAbbr("ALF CMa"));
+        REQUIRE(names[2] == "Dog Star");
+        REQUIRE(db.getNameByCatalogNumber(1) == "Sirius");
+        REQUIRE(db.getNameByCatalogNumber(3) == "Sol");
+        REQUIRE(db.getFirstNameIter(4) == db.getFinalNameIter());
+    }
+
+    SECTION("Erased names can be added again")
+    {
+        REQUIRE(db.getNameByCatalogNumber(1) == "Sirius");
+        db.erase(1);
+        REQUIRE(db.getFirstNameIter(1) == db.getFinalNameIter());
+        REQUIRE(db.getNameByCatalogNumber(2) == "Sirrah");
+
+        db.add(1, "Dog Star");
+        db.add(1, "Sirius");
+        REQUIRE(db.getNameByCatalogNumber(1) == "Dog Star");
+        auto iter = db.getFirstNameIter(1);
+        REQUIRE(std::distance(iter, db.getFinalNameIter()) == 4);
+        REQUIRE(db.getCatalogNumberByName("Sirius") == 1);
+    }
+
+    SECTION("Names of erased objects added again to others")
+    {
+        db.erase(2);
+        db.add(4, "Sirrah");
+        REQUIRE(db.getCatalogNumberByName("Sirrah") == 4);
+        REQUIRE(db.getNameByCatalogNumber(2) == "");
+        REQUIRE(db.getNameByCatalogNumber(4) == "Sirrah");
+    }
+}
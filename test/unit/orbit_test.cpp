@@ -0,0 +1,86 @@
+#include <thread>
+#include <vector>
+#include <celephem/vsop87.h>
+#include <celephem/orbit.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace Eigen;
+
+TEST_CASE("Orbit", "[Orbit]")
+{
+    Orbit* orbit = CreateVSOP87Orbit("vsop87-mars");
+    REQUIRE(orbit != nullptr);
+
+    SECTION("Batch positions match single positions")
+    {
+        // Sorted, unsorted and outside the valid range of the series, which
+        // is covered by approximations
+        std::vector<double> times;
+        for (int i = 0; i < 150; i++)
+            times.push_back(2451545.0 + i * 3.7);
+        times.push_back(2400000.0);
+        times.push_back(3000000.0);
+        times.push_back(-10000.0);
+        times.push_back(2451545.0);
+
+        // Single positions are given by polynomials fitted to the series,
+        // within ten metres of them
+        std::vector<Vector3d> positions(times.size());
+        orbit->positionsAtTimes(times, positions);
+        for (size_t i = 0; i < times.size(); i++)
+        {
+            Vector3d p = orbit->positionAtTime(times[i]);
+            REQUIRE((positions[i] - p).norm() < 1.0e-2);
+        }
+    }
+
+    SECTION("Fitted positions are within ten metres of the series")
+    {
+        // Many fit windows, over the years the series are used for
+        std::vector<double> times;
+        for (int i = 0; i < 20000; i++)
+            times.push_back(2451545.0 - 2000.0 * 365.25 + i * 73.13);
+
+        std::vector<Vector3d> positions(times.size());
+        orbit->positionsAtTimes(times, positions);
+        double maxError = 0.0;
+        for (size_t i = 0; i < times.size(); i++)
+            maxError = std::max(maxError, (orbit->positionAtTime(times[i]) - positions[i]).norm());
+        REQUIRE(maxError < 1.0e-2);
+    }
+
+    SECTION("Positions don't depend on those computed before")
+    {
+        Orbit* other = CreateVSOP87Orbit("vsop87-mars");
+        Vector3d p = other->positionAtTime(2451545.3);
+
+        // Computed after other positions close in time
+        for (int i = 0; i < 100; i++)
+            orbit->positionAtTime(2451545.0 + i * 0.01);
+        REQUIRE(orbit->positionAtTime(2451545.3) == p);
+
+        // and in another thread
+        Vector3d q;
+        std::thread thread([&]() { q = orbit->positionAtTime(2451545.3); });
+        thread.join();
+        REQUIRE(q == p);
+
+        delete other;
+    }
+
+    SECTION("Threads evaluating at different times use their own cache")
+    {
+        Vector3d p0 = orbit->positionAtTime(2451545.0);
+        Vector3d p1;
+        std::thread thread([&]() { p1 = orbit->positionAtTime(2451645.0); });
+        thread.join();
+
+        REQUIRE(orbit->positionAtTime(2451545.0) == p0);
+        REQUIRE(orbit->positionAtTime(2451645.0) == p1);
+        REQUIRE(p0 != p1);
+    }
+
+    delete orbit;
+}
@@ -0,0 +1,92 @@
+#include <chrono>
+#include <memory>
+#include <thread>
+#include <celengine/orbitpathcache.h>
+#include <celephem/orbit.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace Eigen;
+
+// Wait for the path to be sampled to the tolerance, failing the test if
+// that takes more than 30 seconds
+static std::shared_ptr<const CurvePlot> waitForPath(OrbitPathCache& cache,
+                                                    const Orbit* orbit,
+                                                    double startTime,
+                                                    double endTime,
+                                                    double tolerance)
+{
+    auto deadline = std::chrono::steady_clock::now() + std::chrono::seconds(30);
+    while (std::chrono::steady_clock::now() < deadline)
+    {
+        auto plot = cache.find(orbit, startTime, endTime, tolerance);
+        if (plot != nullptr && plot->startTime() <= startTime && plot->endTime() >= endTime)
+        {
+            // Until the path has been refined the one found may be coarser
+            bool fineEnough = true;
+            const auto& samples = plot->samples();
+            for (size_t i = 0; i + 1 < samples.size(); i++)
+            {
+                const CurvePlotSample& s0 = samples[i];
+                const CurvePlotSample& s1 = samples[i + 1];
+                double dt = s1.t - s0.t;
+                Vector3d p = (s0.position + s1.position) * 0.5 + (s0.velocity - s1.velocity) * (dt / 8.0);
+                if ((p - orbit->positionAtTime(s0.t + dt * 0.5)).norm() > tolerance)
+                    fineEnough = false;
+            }
+            if (fineEnough)
+                return plot;
+        }
+        std::this_thread::sleep_for(std::chrono::milliseconds(1));
+    }
+
+    FAIL("The path wasn't sampled to a tolerance of " << tolerance << " km in time");
+    return nullptr;
+}
+
+TEST_CASE("OrbitPathCache", "[OrbitPathCache]")
+{
+    EllipticalOrbit orbit(1.0e6, 0.3, 0.2, 0.5, 1.0, 0.0, 10.0, 0.0);
+    OrbitPathCache cache;
+
+    SECTION("Paths are refined to the tolerance requested")
+    {
+        auto coarse = waitForPath(cache, &orbit, 0.0, 10.0, 10.0);
+        auto fine = waitForPath(cache, &orbit, 0.0, 10.0, 0.1);
+        REQUIRE(fine->sampleCount() > coarse->sampleCount());
+
+        // A coarser path is found in the finer one
+        REQUIRE(cache.find(&orbit, 0.0, 10.0, 10.0) == fine);
+
+        OrbitPathStatistics stats = cache.nextFrame();
+        REQUIRE(stats.hits >= 1);
+        REQUIRE(stats.misses >= 2);
+        REQUIRE(stats.pathsSampled >= 2);
+        REQUIRE(stats.samplesComputed >= fine->sampleCount());
+        REQUIRE(stats.samples == fine->sampleCount());
+    }
+
+    SECTION("Paths of periodic orbits follow the time span requested")
+    {
+        waitForPath(cache, &orbit, 0.0, 10.0, 1.0);
+        auto later = waitForPath(cache, &orbit, 25.0, 35.0, 1.0);
+        REQUIRE(later->startTime() < 25.0);
+        REQUIRE(later->endTime() > 35.0);
+    }
+
+    SECTION("Paths unused over budget are unloaded")
+    {
+        waitForPath(cache, &orbit, 0.0, 10.0, 1.0);
+        cache.setMaxSamples(0);
+
+        // Found during the frame
+        OrbitPathStatistics stats = cache.nextFrame();
+        REQUIRE(stats.evictions == 0);
+        REQUIRE(stats.samples > 0);
+
+        stats = cache.nextFrame();
+        REQUIRE(stats.evictions == 1);
+        REQUIRE(stats.samples == 0);
+    }
+}
@@ -0,0 +1,140 @@
+#include <chrono>
+#include <string>
+#include <thread>
+#include <celutil/resmanager.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace std::chrono;
+
+struct Value
+{
+    int n;
+};
+
+class ValueInfo : public ResourceInfo<Value>
+{
+ public:
+    ValueInfo(int _n) : n(_n) {};
+
+    fs::path resolve(const fs::path&) override
+    {
+        return std::to_string(n);
+    }
+
+    Value* load(const fs::path&) override
+    {
+        return n < 0 ? nullptr : new Value{ n };
+    }
+
+    bool prepare(const fs::path&) override
+    {
+        prepared = n >= 0;
+        return prepared;
+    }
+
+    Value* create(const fs::path& name) override
+    {
+        return prepared ? load(name) : nullptr;
+    }
+
+    size_t getMemoryUsage() const override
+    {
+        return 100;
+    }
+
+    int n;
+    bool prepared{ false };
+};
+
+bool operator<(const ValueInfo& v0, const ValueInfo& v1)
+{
+    return v0.n < v1.n;
+}
+
+// Create the resources read in the background until the one given is done
+static ResourceState waitForLoading(ResourceManager<ValueInfo>& manager, ResourceHandle h)
+{
+    auto timeout = steady_clock::now() + seconds(10);
+    while (manager.getState(h) == ResourceLoading && steady_clock::now() < timeout)
+    {
+        manager.finishLoading(steady_clock::now());
+        std::this_thread::sleep_for(milliseconds(1));
+    }
+    return manager.getState(h);
+}
+
+TEST_CASE("ResourceManager", "[ResourceManager]")
+{
+    ResourceManager<ValueInfo> manager("");
+    ResourceHandle h1 = manager.getHandle(ValueInfo(1));
+    ResourceHandle h2 = manager.getHandle(ValueInfo(2));
+    ResourceHandle bad = manager.getHandle(ValueInfo(-1));
+    REQUIRE(manager.getHandle(ValueInfo(1)) == h1);
+
+    SECTION("Resources are loaded when found")
+    {
+        REQUIRE(manager.find(h1) != nullptr);
+        REQUIRE(manager.find(h1)->n == 1);
+        REQUIRE(manager.find(bad) == nullptr);
+        REQUIRE(manager.getState(bad) == ResourceLoadingFailed);
+        REQUIRE(manager.find(InvalidResource) == nullptr);
+    }
+
+    SECTION("Resources are loaded in the background")
+    {
+        manager.setBackgroundLoading(true);
+
+        REQUIRE(manager.find(h1, 10.0f) == nullptr);
+        REQUIRE(manager.find(h2) == nullptr);
+        REQUIRE(manager.find(bad) == nullptr);
+        REQUIRE(manager.getState(h1) == ResourceLoading);
+
+        REQUIRE(waitForLoading(manager, h1) == ResourceLoaded);
+        REQUIRE(waitForLoading(manager, h2) == ResourceLoaded);
+        REQUIRE(waitForLoading(manager, bad) == ResourceLoadingFailed);
+        REQUIRE(manager.find(h1)->n == 1);
+        REQUIRE(manager.find(h2)->n == 2);
+        REQUIRE(manager.find(bad) == nullptr);
+    }
+
+    SECTION("Resources queued are loaded at once when background loading stops")
+    {
+        manager.setBackgroundLoading(true);
+        manager.find(h1);
+        manager.find(h2);
+        manager.setBackgroundLoading(false);
+
+        REQUIRE(manager.find(h1)->n == 1);
+        REQUIRE(manager.find(h2)->n == 2);
+    }
+
+    SECTION("Least recently used resources are unloaded when over budget")
+    {
+        manager.setMemoryBudget(150, 2);
+
+        manager.find(h1);
+        manager.find(h2);
+        ResourceStatistics stats = manager.nextFrame();
+        REQUIRE(stats.misses == 2);
+        REQUIRE(stats.memoryUsage == 200);
+
+        manager.find(h2);
+        stats = manager.nextFrame();
+        REQUIRE(stats.hits == 1);
+        REQUIRE(stats.evictions == 0);
+
+        manager.find(h2);
+        stats = manager.nextFrame();
+        REQUIRE(stats.evictions == 1);
+        REQUIRE(stats.memoryUsage == 100);
+        REQUIRE(manager.getState(h1) == ResourceNotLoaded);
+        REQUIRE(manager.getState(h2) == ResourceLoaded);
+
+        // Unloaded resources are loaded again when they're next found
+        REQUIRE(manager.find(h1)->n == 1);
+        REQUIRE(manager.getStatistics().misses == 3);
+        REQUIRE(manager.getStatistics().evictions == 1);
+    }
+}
@@ -0,0 +1,103 @@
+#include <cmath>
+#include <celmath/solve.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+using namespace celmath;
+
+template<class F> static std::pair<double, double> brent(F f, double lower, double upper, double err)
+{
+    return solve_brent(f, lower, upper, f(lower), f(upper), err);
+}
+
+TEST_CASE("solve_brent", "[solve]")
+{
+    const double err = 1.0e-10;
+
+    SECTION("Roots of smooth functions")
+    {
+        auto cubic = [](double x) { return x * x * x - 2.0 * x - 5.0; };
+        auto root = brent(cubic, 2.0, 3.0, err);
+        REQUIRE(std::abs(root.first - 2.0945514815423265) <= err);
+        REQUIRE(root.second <= err);
+
+        auto cosine = [](double x) { return std::cos(x) - x; };
+        root = brent(cosine, 0.0, 1.0, err);
+        REQUIRE(std::abs(root.first - 0.7390851332151607) <= err);
+    }
+
+    SECTION("Roots of decreasing functions")
+    {
+        auto f = [](double x) { return 1.0 - x * x; };
+        auto root = brent(f, 0.0, 2.0, err);
+        REQUIRE(std::abs(root.first - 1.0) <= err);
+    }
+
+    SECTION("Roots at the bounds")
+    {
+        auto f = [](double x) { return x; };
+        auto root = brent(f, 0.0, 1.0, err);
+        REQUIRE(root.first == 0.0);
+        REQUIRE(root.second == 0.0);
+
+        auto g = [](double x) { return x - 1.0; };
+        root = brent(g, 0.0, 1.0, err);
+        REQUIRE(root.first == 1.0);
+        REQUIRE(root.second == 0.0);
+    }
+
+    SECTION("Steps of discontinuous functions")
+    {
+        auto step = [](double x) { return x < 0.3 ? -1.0 : 1.0; };
+        auto root = brent(step, 0.0, 1.0, err);
+        REQUIRE(std::abs(root.first - 0.3) <= err);
+    }
+
+    SECTION("Functions evaluated few times")
+    {
+        int nCalls = 0;
+        auto f = [&nCalls](double x) { nCalls++; return std::exp(x) - 2.0; };
+        auto root = brent(f, 0.0, 1.0, err);
+        REQUIRE(std::abs(root.first - std::log(2.0)) <= err);
+
+        // Bisection would take about 33 steps
+        REQUIRE(nCalls < 15);
+    }
+}
+
+TEST_CASE("minimize_golden_section", "[solve]")
+{
+    const double err = 1.0e-8;
+
+    SECTION("Minimum inside the interval")
+    {
+        // Close to a smooth minimum the function is flat to within rounding
+        // errors, so it can only be located to about the square root of the
+        // machine precision
+        const double smoothErr = 1.0e-6;
+        auto f = [](double x) { return (x - 0.3) * (x - 0.3) + 2.0; };
+        auto minimum = minimize_golden_section(f, 0.0, 1.0, smoothErr);
+        REQUIRE(std::abs(minimum.first - 0.3) <= smoothErr);
+        REQUIRE(minimum.second == f(minimum.first));
+        REQUIRE(minimum.second == Approx(2.0));
+    }
+
+    SECTION("Minimum of a non-smooth function")
+    {
+        auto f = [](double x) { return std::abs(x + 1.25); };
+        auto minimum = minimize_golden_section(f, -2.0, 3.0, err);
+        REQUIRE(std::abs(minimum.first + 1.25) <= err);
+    }
+
+    SECTION("Minima at the bounds")
+    {
+        auto increasing = [](double x) { return x; };
+        auto minimum = minimize_golden_section(increasing, 0.0, 1.0, err);
+        REQUIRE(minimum.first <= err);
+
+        auto decreasing = [](double x) { return -x; };
+        minimum = minimize_golden_section(decreasing, 0.0, 1.0, err);
+        REQUIRE(minimum.first >= 1.0 - err);
+    }
+}
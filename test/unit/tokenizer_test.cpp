@@ -0,0 +1,75 @@
+#include <sstream>
+#include <string>
+#include <celengine/tokenizer.h>
+
+#define CATCH_CONFIG_MAIN
+#include <catch.hpp>
+
+static const char text[] =
+    "# A comment\n"
+    "Modify 42 \"Sol/Earth\" {\n"
+    "    Radius 6378.14 <km>\n"
+    "    Color [ 0.85 .5 -1e-3 +2.5E+2 ]\n"
+    "    Visible true\n"
+    "    Text \"tab\\\\ \\\"quoted\\\" \\u00e9\\n\"\n"
+    "    Numbers [ 1234567890123456789 0.1234567890123456789 5e300 ]\n"
+    "}\n"
+    "x = 1 | 2 # end";
+
+// Read all tokens as a string describing them, so that both tokenizers can
+// be compared
+static std::string readTokens(Tokenizer& tok)
+{
+    std::ostringstream out;
+    out.precision(17);
+    Tokenizer::TokenType type;
+    do
+    {
+        type = tok.nextToken();
+        out << type << ':' << tok.getLineNumber();
+        if (type == Tokenizer::TokenNumber)
+            out << ' ' << tok.getNumberValue();
+        else if (type == Tokenizer::TokenName || type == Tokenizer::TokenString)
+            out << " '" << tok.getStringValue() << '\'';
+        out << '\n';
+    }
+    while (type != Tokenizer::TokenEnd && type != Tokenizer::TokenError);
+    return out.str();
+}
+
+TEST_CASE("Tokenizer", "[Tokenizer]")
+{
+    SECTION("Reading text in memory gives the same tokens as reading a stream")
+    {
+        std::istringstream in(text);
+        Tokenizer streamTokenizer(&in);
+        Tokenizer memoryTokenizer(text, sizeof(text) - 1);
+        REQUIRE(readTokens(memoryTokenizer) == readTokens(streamTokenizer));
+    }
+
+    SECTION("Names and strings are views of the text")
+    {
+        Tokenizer tok(text, sizeof(text) - 1);
+        REQUIRE(tok.nextToken() == Tokenizer::TokenName);
+        REQUIRE(tok.getNameView() == "Modify");
+        REQUIRE(tok.getNameView().data() == text + 12);
+        REQUIRE(tok.nextToken() == Tokenizer::TokenNumber);
+        REQUIRE(tok.getNumberValue() == 42.0);
+        REQUIRE(tok.nextToken() == Tokenizer::TokenString);
+        REQUIRE(tok.getStringView() == "Sol/Earth");
+        REQUIRE(tok.getStringView().data() == text + 23);
+        tok.pushBack();
+        REQUIRE(tok.nextToken() == Tokenizer::TokenString);
+        REQUIRE(tok.getStringValue() == "Sol/Earth");
+    }
+
+    SECTION("Errors")
+    {
+        const char* bad[] = { "12abc", "1.2.3", "1e", "\"unterminated", "\"\\q\"", "\"\\u00g0\"", "@" };
+        for (const char* s : bad)
+        {
+            Tokenizer tok(s, std::char_traits<char>::length(s));
+            REQUIRE(tok.nextToken() == Tokenizer::TokenError);
+        }
+    }
+}